@@ -0,0 +1,162 @@
+#ifndef BENCH_JSON_H
+#define BENCH_JSON_H
+
+// Just enough JSON for the benchmark results/baseline files: an object of
+// scenes, each an object of numeric metrics.
+//
+// {
+//     "scenes": {
+//         "scene01": { "mean_ms": 1.2, "p95_ms": 1.9, ... },
+//         ...
+//     }
+// }
+
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+using Metrics = std::vector<std::pair<std::string, double>>;
+using SceneMetrics = std::map<std::string, Metrics>;
+
+inline bool writeResults(const std::string& path, const SceneMetrics& scenes) {
+    std::ofstream file {path};
+    if (!file) {
+        std::cout << "ERROR::BENCH::JSON::CANNOT_WRITE " << path << std::endl;
+        return false;
+    }
+    file << std::setprecision(6);
+    file << "{\n    \"scenes\": {\n";
+    size_t sceneNr {0};
+    for (const auto& [scene, metrics] : scenes) {
+        file << "        \"" << scene << "\": {\n";
+        for (size_t i = 0; i < metrics.size(); i++) {
+            file << "            \"" << metrics[i].first << "\": " << metrics[i].second
+                 << ((i + 1 < metrics.size()) ? ",\n" : "\n");
+        }
+        file << "        }" << ((++sceneNr < scenes.size()) ? ",\n" : "\n");
+    }
+    file << "    }\n}\n";
+    return true;
+}
+
+class JsonReader {
+public:
+    JsonReader(const std::string& text)
+    : m_text {text}
+    , m_pos {0}
+    {
+    }
+
+    // returns false if the text isn't in the shape writeResults produces
+    bool readScenes(SceneMetrics& scenes) {
+        if (!expect('{')) return false;
+        while (true) {
+            std::string key;
+            if (!readString(key) || !expect(':')) return false;
+            if (key == "scenes") {
+                if (!readSceneObject(scenes)) return false;
+            }
+            else if (!skipValue()) return false;
+            if (peek() == ',') { m_pos++; continue; }
+            return expect('}');
+        }
+    }
+
+private:
+    bool readSceneObject(SceneMetrics& scenes) {
+        if (!expect('{')) return false;
+        if (peek() == '}') { m_pos++; return true; }
+        while (true) {
+            std::string scene;
+            if (!readString(scene) || !expect(':') || !expect('{')) return false;
+            Metrics& metrics {scenes[scene]};
+            if (peek() != '}') {
+                while (true) {
+                    std::string metric;
+                    double value {};
+                    if (!readString(metric) || !expect(':') || !readNumber(value)) return false;
+                    metrics.push_back({metric, value});
+                    if (peek() == ',') { m_pos++; continue; }
+                    break;
+                }
+            }
+            if (!expect('}')) return false;
+            if (peek() == ',') { m_pos++; continue; }
+            return expect('}');
+        }
+    }
+
+    char peek() {
+        while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos]))) m_pos++;
+        return (m_pos < m_text.size()) ? m_text[m_pos] : '\0';
+    }
+
+    bool expect(char c) {
+        if (peek() != c) return false;
+        m_pos++;
+        return true;
+    }
+
+    bool readString(std::string& out) {
+        if (!expect('"')) return false;
+        size_t end {m_text.find('"', m_pos)};
+        if (end == std::string::npos) return false;
+        out = m_text.substr(m_pos, end - m_pos);
+        m_pos = end + 1;
+        return true;
+    }
+
+    bool readNumber(double& out) {
+        peek();
+        const char* begin {m_text.c_str() + m_pos};
+        char* end {nullptr};
+        out = std::strtod(begin, &end);
+        if (end == begin) return false;
+        m_pos += static_cast<size_t>(end - begin);
+        return true;
+    }
+
+    // skip over a value we don't care about (numbers, strings, nested objects)
+    bool skipValue() {
+        char c {peek()};
+        if (c == '"') {
+            std::string ignored;
+            return readString(ignored);
+        }
+        if (c == '{' || c == '[') {
+            int depth {0};
+            do {
+                if (m_text[m_pos] == '{' || m_text[m_pos] == '[') depth++;
+                if (m_text[m_pos] == '}' || m_text[m_pos] == ']') depth--;
+                m_pos++;
+            } while (depth > 0 && m_pos < m_text.size());
+            return depth == 0;
+        }
+        double ignored {};
+        return readNumber(ignored);
+    }
+
+    const std::string& m_text;
+    size_t m_pos;
+};
+
+inline bool readResults(const std::string& path, SceneMetrics& scenes) {
+    std::ifstream file {path};
+    if (!file) return false;
+    std::stringstream stream;
+    stream << file.rdbuf();
+    std::string text {stream.str()};
+    JsonReader reader {text};
+    return reader.readScenes(scenes);
+}
+
+}
+#endif
@@ -0,0 +1,1062 @@
+#ifndef BENCH_SCENES_H
+#define BENCH_SCENES_H
+
+// Non-interactive versions of the demo scenes for the benchmark runner. Each one
+// mirrors the setup of its demo (code/scene/scene01.cpp, code/scene/scene02.cpp,
+// demos/instancing/asteroid.cpp, demos/model/model.cpp) but takes its animation
+// time and camera from the runner instead of glfwGetTime() and live input.
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <sjd/shader.h>
+#include <sjd/camera.h>
+#include <sjd/camera_path.h>
+#include <sjd/texture.h>
+#include <sjd/shadow_cascades.h>
+#include <sjd/shadow_atlas.h>
+#include <sjd/skybox.h>
+#include <sjd/light.h>
+#include <sjd/deferred_shading.h>
+#include <sjd/hiz_culler.h>
+#include <sjd/occlusion_raster.h>
+#include <sjd/render_target.h>
+#include <sjd/gaussian_blur.h>
+#include <sjd/hdr_pipeline.h>
+#include <sjd/dynamic_resolution.h>
+#include <sjd/temporal_aa.h>
+#include <sjd/post_antialiasing.h>
+#include <sjd/scene.h>
+#include <sjd/transform_hierarchy.h>
+#include <sjd/asteroid_field.h>
+#include <sjd/stream_ring.h>
+#include <sjd/worker_pool.h>
+#include <sjd/impostor.h>
+#include <sjd/instance_culler.h>
+#include <sjd/model.h>
+#include <sjd/meshes/cube.h>
+#include <sjd/meshes/quad.h>
+#include <sjd/profiling.h>
+
+namespace bench {
+
+class BenchScene {
+public:
+    virtual ~BenchScene() = default;
+
+    virtual const char* name() const = 0;
+
+    // set the global GL state the demo sets up before its render loop
+    virtual void begin() {}
+
+    // advance animations to `time` seconds since the start of the run
+    virtual void update([[maybe_unused]] float time) {}
+
+    virtual void render(sjd::Camera& camera, float aspect) = 0;
+
+    // scene specific numbers for the frame just rendered; the runner reports their mean
+    virtual std::vector<std::pair<std::string, double>> frameMetrics() const {
+        return {};
+    }
+
+    const sjd::CameraPath& cameraPath() const {
+        return m_cameraPath;
+    }
+
+protected:
+    sjd::CameraPath m_cameraPath;
+};
+
+// models are loaded with flipped uvs like the demos' createCoreWindow sets up,
+// without leaving the flag on for the sjd::Texture based scenes
+inline sjd::Model loadFlippedModel(const std::string& path, unsigned int lodLevels=1) {
+    stbi_set_flip_vertically_on_load(true);
+    sjd::Model model {path, lodLevels};
+    stbi_set_flip_vertically_on_load(false);
+    return model;
+}
+
+// code/scene/scene01.cpp
+class Scene01: public BenchScene {
+public:
+    Scene01()
+    :   m_shader {"../code/shaders/lighting.vert.glsl",
+                  "../code/shaders/blinn_phong16.frag.glsl"}
+    ,   m_containerDiffuseMap {"../data/container2.jpg", true}
+    ,   m_containerSpecularMap {"../data/container2_specular.png"}
+    ,   m_floorDiffuseMap {"../data/wood.png", true}
+    ,   m_floor({-25,-0.5,25},
+                {25,-0.5,25},
+                {25,-0.5,-25},
+                {-25,-0.5,-25})
+    ,   m_scene({m_cube, m_floor})
+    ,   m_dirLight {glm::normalize(glm::vec3{1, 2, 1})}
+    ,   m_pointLight01({4, 0.5, -2}, glm::vec3(1.0f), true)
+    ,   m_pointLight02({2, 0.5, 2}, glm::vec3(1.0f), true)
+    {
+        m_floorDiffuseMap.setTextureParameter(GL_TEXTURE_WRAP_S, GL_REPEAT);
+        m_floorDiffuseMap.setTextureParameter(GL_TEXTURE_WRAP_T, GL_REPEAT);
+        m_cube.setDiffuseMap(&m_containerDiffuseMap);
+        m_cube.setSpecularMap(&m_containerSpecularMap);
+        m_floor.setDiffuseMap(&m_floorDiffuseMap);
+        m_scene.setDirLight(&m_dirLight);
+        m_scene.setPointLights({m_pointLight01, m_pointLight02});
+
+        m_cameraPath.addKeyframe(0.0f,  {0.0f, 2.0f, 3.0f},   {0.0f, 0.0f, -3.0f});
+        m_cameraPath.addKeyframe(4.0f,  {4.0f, 1.5f, -1.0f},  {0.0f, 0.0f, -3.0f});
+        m_cameraPath.addKeyframe(8.0f,  {2.0f, 3.0f, -7.0f},  {0.0f, 0.0f, -3.0f});
+        m_cameraPath.addKeyframe(12.0f, {-4.0f, 1.0f, -4.0f}, {0.0f, 0.0f, -3.0f});
+        m_cameraPath.addKeyframe(16.0f, {0.0f, 2.0f, 3.0f},   {0.0f, 0.0f, -3.0f});
+    }
+
+    const char* name() const { return "scene01"; }
+
+    void begin() {
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_FRAMEBUFFER_SRGB);
+        glDisable(GL_CULL_FACE);
+    }
+
+    void update([[maybe_unused]] float time) {
+        m_cube.reset();
+        m_cube.move(glm::vec3(0, 0, -3));
+    }
+
+    void render(sjd::Camera& camera, float aspect) {
+        glClearColor(0.01f, 0.01f, 0.01f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        m_scene.m_projection = glm::perspective(glm::radians(camera.zoom), aspect, 0.1f, 1000.0f);
+        m_scene.m_view = camera.getViewMatrix();
+        m_scene.m_viewPos = camera.pos;
+        m_scene.draw(m_shader);
+    }
+
+private:
+    sjd::Shader m_shader;
+    sjd::Texture m_containerDiffuseMap;
+    sjd::Texture m_containerSpecularMap;
+    sjd::Texture m_floorDiffuseMap;
+    sjd::Cube m_cube;
+    sjd::Quad m_floor;
+    sjd::Scene m_scene;
+    sjd::DirLight m_dirLight;
+    sjd::PointLight m_pointLight01;
+    sjd::PointLight m_pointLight02;
+};
+
+// code/scene/scene02.cpp
+//
+// Optionally with sjd::Scene's depth pre-pass, to compare colour pass time and
+// shaded samples with and without it, or drawn in HDR through sjd::HdrPipeline
+// with bloom, to see what each stage of that costs. The _taa, _fxaa and _smaa
+// variants anti-alias it with sjd::TemporalAA or sjd::PostAntiAliasing instead
+// of relying on the window's samples.
+class Scene02: public BenchScene {
+public:
+    Scene02(bool depthPrepass=false, bool hdr=false, bool temporalAA=false, sjd::AntiAliasing postAA=sjd::MSAA)
+    :   m_shader {"../code/shaders/lighting_wShadow_map.vert.glsl",
+                  "../code/shaders/blph_wShadow_map.frag.glsl"}
+    ,   m_depthShader {"../code/shaders/simple_depth_shader.vert.glsl",
+                       "../code/shaders/simple_depth_shader.frag.glsl"}
+    ,   m_prepassShader {"../code/shaders/depth_prepass.vert.glsl",
+                         "../code/shaders/simple_depth_shader.frag.glsl"}
+    ,   m_cubeDiffuseMap {"../data/container2.png", true}
+    ,   m_cubeSpecularMap {"../data/container2_specular.png", true}
+    ,   m_floorDiffuseMap {"../data/wood.png", true}
+    ,   m_depthMap({4, 2048})
+    ,   m_skybox({
+            "../data/skybox/right.jpg",
+            "../data/skybox/left.jpg",
+            "../data/skybox/top.jpg",
+            "../data/skybox/bottom.jpg",
+            "../data/skybox/front.jpg",
+            "../data/skybox/back.jpg"
+        })
+    ,   m_floor({-25,-0.5,25},
+                {25,-0.5,25},
+                {25,-0.5,-25},
+                {-25,-0.5,-25})
+    ,   m_scene({m_cube01, m_cube02, m_cube03, m_floor})
+    ,   m_dirLight(glm::vec3(-2.0f, 2.8f, -3.0f))
+    ,   m_pointLight01(glm::vec3(1.5f, 1.0f, -1.5f), glm::vec3(1.0f, 0.6f, 0.3f), true)
+    ,   m_pointLight02(glm::vec3(-2.0f, 1.5f, 1.0f), glm::vec3(0.3f, 0.5f, 1.0f), true)
+    ,   m_depthPrepass {depthPrepass}
+    {
+        m_floorDiffuseMap.setTextureParameter(GL_TEXTURE_WRAP_S, GL_REPEAT);
+        m_floorDiffuseMap.setTextureParameter(GL_TEXTURE_WRAP_T, GL_REPEAT);
+        for (sjd::Cube* cube : {&m_cube01, &m_cube02, &m_cube03}) {
+            cube->setDiffuseMap(&m_cubeDiffuseMap);
+            cube->setSpecularMap(&m_cubeSpecularMap);
+        }
+        m_transforms.setPosition(m_cube01Node, glm::vec3(0, 1.5f, 0));
+        m_transforms.setScale(m_cube01Node, glm::vec3(0.5f));
+        m_transforms.setPosition(m_cube02Node, glm::vec3(2, 0.5f, 1));
+        m_transforms.setScale(m_cube02Node, glm::vec3(0.5f));
+        m_cube03.move(glm::vec3(-1, 0, 2));
+        m_cube03.rotateX(glm::radians(30.0f));
+        m_cube03.rotateZ(glm::radians(30.0f));
+        m_cube03.scale(glm::vec3(0.25f));
+        m_cube03.setStatic(true);
+        m_floor.setDiffuseMap(&m_floorDiffuseMap);
+        m_floor.setStatic(true);
+        m_scene.setSkyBox(&m_skybox);
+        m_dirLight.enableShadowMap(&m_depthShader, &m_depthMap);
+        m_scene.setDirLight(&m_dirLight);
+        m_pointLight01.enableShadows();
+        m_pointLight02.enableShadows();
+        m_scene.setPointLights({m_pointLight01, m_pointLight02});
+        m_scene.setPointShadows(&m_shadowAtlas, &m_depthShader);
+        if (depthPrepass) m_scene.setDepthPrepass(&m_prepassShader);
+        if (hdr) m_hdr = std::make_unique<sjd::HdrPipeline>();
+        if (temporalAA) {
+            m_taa = std::make_unique<sjd::TemporalAA>();
+            m_scene.setTemporalAA(m_taa.get());
+        }
+        if (postAA != sjd::MSAA) m_postAA = std::make_unique<sjd::PostAntiAliasing>(postAA);
+
+        m_cameraPath.addKeyframe(0.0f,  {-1.0f, 2.0f, 5.0f},  {0.0f, 0.5f, 0.0f});
+        m_cameraPath.addKeyframe(5.0f,  {5.0f, 3.0f, 2.0f},   {0.0f, 0.5f, 0.0f});
+        m_cameraPath.addKeyframe(10.0f, {3.0f, 6.0f, -6.0f},  {0.0f, 0.5f, 0.0f});
+        m_cameraPath.addKeyframe(15.0f, {-8.0f, 1.5f, -2.0f}, {0.0f, 0.5f, 0.0f});
+        m_cameraPath.addKeyframe(20.0f, {-1.0f, 2.0f, 5.0f},  {0.0f, 0.5f, 0.0f});
+    }
+
+    const char* name() const {
+        if (m_hdr) return "scene02_hdr";
+        if (m_taa) return "scene02_taa";
+        if (m_postAA) return (m_postAA->mode() == sjd::FXAA) ? "scene02_fxaa" : "scene02_smaa";
+        return m_depthPrepass ? "scene02_prepass" : "scene02";
+    }
+
+    std::vector<std::pair<std::string, double>> frameMetrics() const {
+        std::vector<std::pair<std::string, double>> metrics {
+            {"shadow_ms",          m_scene.shadowPassMs()},
+            {"point_shadow_ms",    m_scene.pointShadowPassMs()},
+            {"point_shadow_faces", static_cast<double>(m_scene.pointShadowFacesRendered())},
+            {"depth_prepass_ms",   m_scene.depthPrepassMs()},
+            {"colour_pass_ms",     m_scene.colourPassMs()},
+            {"samples_shaded",     static_cast<double>(m_scene.samplesShaded())},
+        };
+        if (m_hdr) {
+            metrics.push_back({"hdr_scene_ms",     m_hdr->sceneMs()});
+            metrics.push_back({"bloom_down_ms",    m_hdr->downsampleMs()});
+            metrics.push_back({"bloom_up_ms",      m_hdr->upsampleMs()});
+            metrics.push_back({"hdr_composite_ms", m_hdr->compositeMs()});
+        }
+        if (m_taa) {
+            metrics.push_back({"taa_motion_ms",  m_taa->motionMs()});
+            metrics.push_back({"taa_resolve_ms", m_taa->resolveMs()});
+            metrics.push_back({"taa_mb",         static_cast<double>(m_taa->bytes()) / (1024.0 * 1024.0)});
+        }
+        if (m_postAA) {
+            metrics.push_back({"post_aa_ms", m_postAA->lastMs()});
+            metrics.push_back({"post_aa_mb", static_cast<double>(m_postAA->bytes()) / (1024.0 * 1024.0)});
+        }
+        return metrics;
+    }
+
+    void begin() {
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_FRAMEBUFFER_SRGB);
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_BACK);
+    }
+
+    void update(float time) {
+        m_transforms.setPosition(m_cube01Node, glm::vec3(0, 1.5f + 1.5f*sinf(0.5f*time), 0));
+        m_transforms.setRotation(m_cube02Node, glm::angleAxis(time, glm::vec3(1.0f, 0.0f, 0.0f))
+                                             * glm::angleAxis(time, glm::vec3(0.0f, 0.0f, 1.0f)));
+        m_transforms.update();
+        if (m_transforms.changed(m_cube01Node)) m_cube01.setModel(m_transforms.world(m_cube01Node));
+        if (m_transforms.changed(m_cube02Node)) m_cube02.setModel(m_transforms.world(m_cube02Node));
+    }
+
+    void render(sjd::Camera& camera, float aspect) {
+        glClearColor(0.01f, 0.01f, 0.01f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        m_scene.m_projection = glm::perspective(glm::radians(camera.zoom), aspect, 0.1f, 1000.0f);
+        m_scene.m_view = camera.getViewMatrix();
+        m_scene.m_viewPos = camera.pos;
+        GLint viewport[4] {};
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        if (m_taa) {
+            m_scene.m_projection = m_taa->begin(camera, m_scene.m_projection, static_cast<unsigned int>(viewport[2]),
+                                                static_cast<unsigned int>(viewport[3]), glm::vec4(0.01f, 0.01f, 0.01f, 1.0f));
+            m_scene.draw(m_shader);
+            m_taa->end();
+            return;
+        }
+        if (m_postAA) {
+            m_postAA->begin(static_cast<unsigned int>(viewport[2]), static_cast<unsigned int>(viewport[3]),
+                            glm::vec4(0.01f, 0.01f, 0.01f, 1.0f));
+            m_scene.draw(m_shader);
+            m_postAA->end();
+            return;
+        }
+        if (!m_hdr) {
+            m_scene.draw(m_shader);
+            return;
+        }
+        // about the window's clear colour once it's sRGB encoded
+        m_hdr->begin(static_cast<unsigned int>(viewport[2]), static_cast<unsigned int>(viewport[3]),
+                     glm::vec4(glm::vec3(0.0001f), 1.0f));
+        m_scene.draw(m_shader);
+        m_hdr->end();
+    }
+
+private:
+    sjd::Shader m_shader;
+    sjd::Shader m_depthShader;
+    sjd::Shader m_prepassShader;
+    sjd::Texture m_cubeDiffuseMap;
+    sjd::Texture m_cubeSpecularMap;
+    sjd::Texture m_floorDiffuseMap;
+    sjd::ShadowCascades m_depthMap;
+    sjd::ShadowAtlas m_shadowAtlas;
+    sjd::Skybox m_skybox;
+    sjd::Cube m_cube01;
+    sjd::Cube m_cube02;
+    sjd::Cube m_cube03;
+    sjd::Quad m_floor;
+    sjd::TransformHierarchy m_transforms;
+    sjd::TransformHierarchy::Node m_cube01Node {m_transforms.create()};
+    sjd::TransformHierarchy::Node m_cube02Node {m_transforms.create()};
+    sjd::Scene m_scene;
+    sjd::DirLight m_dirLight;
+    sjd::PointLight m_pointLight01;
+    sjd::PointLight m_pointLight02;
+    bool m_depthPrepass;
+    std::unique_ptr<sjd::HdrPipeline> m_hdr;
+    std::unique_ptr<sjd::TemporalAA> m_taa;
+    std::unique_ptr<sjd::PostAntiAliasing> m_postAA;
+};
+
+// Not a demo: a floor with a grid of crates under `lightCount` small coloured
+// point lights drifting over it, shaded either forward (every fragment loops
+// over every light, from a texture buffer) or with sjd::DeferredShading (each
+// light only touches the pixels inside its range), to compare the two as the
+// light count grows. Forward shading can add the depth pre-pass, so the costly
+// shader runs once per pixel.
+class ManyLights: public BenchScene {
+public:
+    ManyLights(unsigned int lightCount, bool deferred, bool depthPrepass=false, bool dynamicResolution=false)
+    :   m_shader {"../code/shaders/lighting.vert.glsl",
+                  "../code/shaders/blinn_phong_buffered.frag.glsl"}
+    ,   m_prepassShader {"../code/shaders/depth_prepass.vert.glsl",
+                         "../code/shaders/simple_depth_shader.frag.glsl"}
+    ,   m_containerDiffuseMap {"../data/container2.png", true}
+    ,   m_containerSpecularMap {"../data/container2_specular.png"}
+    ,   m_floorDiffuseMap {"../data/wood.png", true}
+    ,   m_floor({-25,-0.5,25},
+                {25,-0.5,25},
+                {25,-0.5,-25},
+                {-25,-0.5,-25})
+    ,   m_scene({m_floor})
+    ,   m_dirLight {glm::normalize(glm::vec3{1, 2, 1})}
+    ,   m_name {"lights_" + std::to_string(lightCount) + (deferred ? "_deferred" : depthPrepass ? "_prepass" : "")
+                + (dynamicResolution ? "_dynres" : "")}
+    {
+        m_floorDiffuseMap.setTextureParameter(GL_TEXTURE_WRAP_S, GL_REPEAT);
+        m_floorDiffuseMap.setTextureParameter(GL_TEXTURE_WRAP_T, GL_REPEAT);
+        m_floor.setDiffuseMap(&m_floorDiffuseMap);
+        for (int x = -3; x <= 3; x++) {
+            for (int z = -3; z <= 3; z++) {
+                m_cubes.push_back(std::make_unique<sjd::Cube>());
+                sjd::Cube& cube {*m_cubes.back()};
+                cube.setDiffuseMap(&m_containerDiffuseMap);
+                cube.setSpecularMap(&m_containerSpecularMap);
+                cube.move(glm::vec3(x * 6.0f, 0.5f, z * 6.0f));
+                m_scene.addMesh(cube);
+            }
+        }
+
+        // fixed seed so every run places the same lights; dimmer as there are
+        // more of them so the floor doesn't just turn white
+        std::mt19937 random {7};
+        std::uniform_real_distribution<float> unit {0.0f, 1.0f};
+        float brightness {std::min(1.0f, 4.0f / std::sqrt(static_cast<float>(lightCount)))};
+        std::vector<std::reference_wrapper<sjd::PointLight>> lights;
+        for (unsigned int i = 0; i < lightCount; i++) {
+            glm::vec3 position {unit(random) * 48.0f - 24.0f, 0.2f + unit(random) * 2.0f, unit(random) * 48.0f - 24.0f};
+            glm::vec3 colour {unit(random), unit(random), unit(random)};
+            m_lights.push_back(std::make_unique<sjd::PointLight>(position, brightness * colour, true));
+            // about a 5 unit reach
+            m_lights.back()->setAttenuation(1.0f, 0.7f, 1.8f);
+            m_lightOrigins.push_back(position);
+            m_lightPhases.push_back(unit(random) * 6.2831853f);
+            lights.push_back(*m_lights.back());
+        }
+        m_scene.setDirLight(&m_dirLight);
+        m_scene.setPointLights(lights);
+        m_scene.setBufferedPointLights(true);
+        m_scene.setLightCubes(false);
+        if (deferred) {
+            m_deferred = std::make_unique<sjd::DeferredShading>();
+            m_scene.setDeferred(m_deferred.get());
+        }
+        else if (depthPrepass) {
+            m_scene.setDepthPrepass(&m_prepassShader);
+        }
+        if (dynamicResolution) {
+            // half a 60 Hz frame, so there's something to scale on a fast GPU too
+            sjd::DynamicResolutionSettings settings;
+            settings.targetFrameMs = 8.0f;
+            m_resolution = std::make_unique<sjd::DynamicResolution>(settings);
+        }
+
+        m_cameraPath.addKeyframe(0.0f,  {0.0f, 8.0f, 30.0f},   {0.0f, 0.0f, 0.0f});
+        m_cameraPath.addKeyframe(5.0f,  {30.0f, 6.0f, 0.0f},   {0.0f, 0.0f, 0.0f});
+        m_cameraPath.addKeyframe(10.0f, {0.0f, 4.0f, -20.0f},  {0.0f, 0.0f, 0.0f});
+        m_cameraPath.addKeyframe(15.0f, {-12.0f, 2.0f, 4.0f},  {0.0f, 0.0f, 0.0f});
+        m_cameraPath.addKeyframe(20.0f, {0.0f, 8.0f, 30.0f},   {0.0f, 0.0f, 0.0f});
+    }
+
+    const char* name() const { return m_name.c_str(); }
+
+    std::vector<std::pair<std::string, double>> frameMetrics() const {
+        std::vector<std::pair<std::string, double>> metrics;
+        if (!m_deferred) {
+            metrics = {
+                {"depth_prepass_ms", m_scene.depthPrepassMs()},
+                {"colour_pass_ms",   m_scene.colourPassMs()},
+                {"samples_shaded",   static_cast<double>(m_scene.samplesShaded())},
+            };
+        }
+        else {
+            metrics = {
+                {"geometry_pass_ms", m_deferred->geometryPassMs()},
+                {"light_pass_ms",    m_deferred->lightPassMs()},
+            };
+        }
+        if (m_resolution) {
+            metrics.push_back({"resolution_scale", m_resolution->scale()});
+            metrics.push_back({"scaled_frame_ms",  m_resolution->frameMs()});
+            metrics.push_back({"upscale_ms",       m_resolution->upscaleMs()});
+        }
+        return metrics;
+    }
+
+    void begin() {
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_FRAMEBUFFER_SRGB);
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_BACK);
+    }
+
+    // each light circles its starting point
+    void update(float time) {
+        for (size_t i = 0; i < m_lights.size(); i++) {
+            float angle {0.5f * time + m_lightPhases[i]};
+            m_lights[i]->moveTo(m_lightOrigins[i] + glm::vec3(std::cos(angle), 0.0f, std::sin(angle)));
+        }
+    }
+
+    void render(sjd::Camera& camera, float aspect) {
+        glClearColor(0.01f, 0.01f, 0.01f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        m_scene.m_projection = glm::perspective(glm::radians(camera.zoom), aspect, 0.1f, 1000.0f);
+        m_scene.m_view = camera.getViewMatrix();
+        m_scene.m_viewPos = camera.pos;
+        if (!m_resolution) {
+            m_scene.draw(m_shader);
+            return;
+        }
+        GLint viewport[4] {};
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        m_resolution->begin(static_cast<unsigned int>(viewport[2]), static_cast<unsigned int>(viewport[3]),
+                            glm::vec4(0.01f, 0.01f, 0.01f, 1.0f));
+        m_scene.draw(m_shader);
+        m_resolution->end();
+    }
+
+private:
+    sjd::Shader m_shader;
+    sjd::Shader m_prepassShader;
+    sjd::Texture m_containerDiffuseMap;
+    sjd::Texture m_containerSpecularMap;
+    sjd::Texture m_floorDiffuseMap;
+    sjd::Quad m_floor;
+    std::vector<std::unique_ptr<sjd::Cube>> m_cubes;
+    sjd::Scene m_scene;
+    sjd::DirLight m_dirLight;
+    std::vector<std::unique_ptr<sjd::PointLight>> m_lights;
+    std::vector<glm::vec3> m_lightOrigins;
+    std::vector<float> m_lightPhases;
+    std::unique_ptr<sjd::DeferredShading> m_deferred;
+    std::unique_ptr<sjd::DynamicResolution> m_resolution;
+    std::string m_name;
+};
+
+// Not a demo: a dense grid of city blocks, each its own sjd::Cube, walked
+// through at street level where nearly everything is behind the nearest
+// buildings, then seen from above where little is. With occlusion culling the
+// scene's meshes go through an sjd::HiZCuller on the GPU or the CPU, or, for
+// SOFTWARE_OCCLUSION, are tested against the buildings and ground rasterized by
+// an sjd::SoftwareOcclusion on every core.
+class City: public BenchScene {
+public:
+    enum Occlusion {
+        NO_OCCLUSION,
+        CPU_OCCLUSION,
+        GPU_OCCLUSION,
+        SOFTWARE_OCCLUSION
+    };
+
+    City(Occlusion occlusion=NO_OCCLUSION)
+    :   m_shader {"../code/shaders/lighting.vert.glsl",
+                  "../code/shaders/blinn_phong16.frag.glsl"}
+    ,   m_buildingDiffuseMap {"../data/container2.png", true}
+    ,   m_buildingSpecularMap {"../data/container2_specular.png"}
+    ,   m_groundDiffuseMap {"../data/wood.png", true}
+    ,   m_ground({-100,-0.5,100},
+                 {100,-0.5,100},
+                 {100,-0.5,-100},
+                 {-100,-0.5,-100})
+    ,   m_scene({m_ground})
+    ,   m_dirLight {glm::normalize(glm::vec3{1, 2, 1})}
+    ,   m_name {"city"}
+    {
+        m_groundDiffuseMap.setTextureParameter(GL_TEXTURE_WRAP_S, GL_REPEAT);
+        m_groundDiffuseMap.setTextureParameter(GL_TEXTURE_WRAP_T, GL_REPEAT);
+        m_ground.setDiffuseMap(&m_groundDiffuseMap);
+        m_ground.setStatic(true);
+        // fixed seed so every run builds the same city; blocks 3 wide on a 6 unit
+        // grid, leaving streets along x and z = 3 + 6n
+        std::mt19937 random {11};
+        std::uniform_real_distribution<float> height {2.0f, 12.0f};
+        for (int x = -16; x < 16; x++) {
+            for (int z = -16; z < 16; z++) {
+                m_buildings.push_back(std::make_unique<sjd::Cube>());
+                sjd::Cube& building {*m_buildings.back()};
+                float h {height(random)};
+                building.move(glm::vec3(x * 6.0f, h - 0.5f, z * 6.0f));
+                building.scale(glm::vec3(1.5f, h, 1.5f));
+                building.setDiffuseMap(&m_buildingDiffuseMap);
+                building.setSpecularMap(&m_buildingSpecularMap);
+                building.setStatic(true);
+                m_scene.addMesh(building);
+                m_scene.addOccluder(building);
+            }
+        }
+        m_scene.addOccluder(m_ground);
+        m_scene.setDirLight(&m_dirLight);
+        if (occlusion == SOFTWARE_OCCLUSION) {
+            m_pool = std::make_unique<sjd::WorkerPool>();
+            m_softwareOcclusion = std::make_unique<sjd::SoftwareOcclusion>(*m_pool);
+            m_scene.setSoftwareOcclusion(m_softwareOcclusion.get());
+            m_name += "_soft";
+        }
+        else if (occlusion != NO_OCCLUSION) {
+            m_culler = std::make_unique<sjd::HiZCuller>((occlusion == GPU_OCCLUSION) ? sjd::HiZCuller::GPU
+                                                                                     : sjd::HiZCuller::CPU);
+            m_scene.setOcclusionCuller(m_culler.get());
+            // the culler says which it ended up with; no compute shaders means CPU
+            m_name += (m_culler->mode() == sjd::HiZCuller::GPU) ? "_hiz_gpu" : "_hiz_cpu";
+        }
+
+        m_cameraPath.addKeyframe(0.0f,  {3.0f, 1.7f, 90.0f},   {3.0f, 1.7f, 0.0f});
+        m_cameraPath.addKeyframe(6.0f,  {3.0f, 1.7f, 3.0f},    {3.0f, 1.7f, -90.0f});
+        m_cameraPath.addKeyframe(9.0f,  {3.0f, 1.7f, 3.0f},    {90.0f, 1.7f, 3.0f});
+        m_cameraPath.addKeyframe(15.0f, {81.0f, 1.7f, 3.0f},   {200.0f, 1.7f, 3.0f});
+        m_cameraPath.addKeyframe(20.0f, {60.0f, 40.0f, 60.0f}, {0.0f, 0.0f, 0.0f});
+        m_cameraPath.addKeyframe(25.0f, {3.0f, 1.7f, 90.0f},   {3.0f, 1.7f, 0.0f});
+    }
+
+    const char* name() const { return m_name.c_str(); }
+
+    std::vector<std::pair<std::string, double>> frameMetrics() const {
+        // the baseline gate takes every metric as lower is better, so culling is
+        // reported as what got through it: every building and the ground, less
+        // what the last test found hidden
+        double occluded {m_culler ? static_cast<double>(m_culler->occludedCount())
+                                  : m_softwareOcclusion ? static_cast<double>(m_softwareOcclusion->occludedCount())
+                                                        : 0.0};
+        return {
+            {"meshes_drawn",         static_cast<double>(m_scene.meshesDrawn())},
+            {"meshes_visible",       static_cast<double>(m_buildings.size() + 1) - occluded},
+            {"hiz_ms",               m_culler ? m_culler->cullMs() : 0.0},
+            {"raster_ms",            m_softwareOcclusion ? m_softwareOcclusion->rasterMs() : 0.0},
+            {"occlusion_test_ms",    m_softwareOcclusion ? m_softwareOcclusion->testMs() : 0.0},
+            // the inverse of triangles per ms, so a faster rasterizer is a smaller number
+            {"raster_ms_per_ktri",   (m_softwareOcclusion && m_softwareOcclusion->trianglesRasterized() > 0)
+                                         ? m_softwareOcclusion->rasterMs() * 1000.0
+                                               / static_cast<double>(m_softwareOcclusion->trianglesRasterized())
+                                         : 0.0},
+        };
+    }
+
+    void begin() {
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_FRAMEBUFFER_SRGB);
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_BACK);
+    }
+
+    void render(sjd::Camera& camera, float aspect) {
+        glClearColor(0.01f, 0.01f, 0.01f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        m_scene.m_projection = glm::perspective(glm::radians(camera.zoom), aspect, 0.1f, 1000.0f);
+        m_scene.m_view = camera.getViewMatrix();
+        m_scene.m_viewPos = camera.pos;
+        m_scene.draw(m_shader);
+    }
+
+private:
+    sjd::Shader m_shader;
+    sjd::Texture m_buildingDiffuseMap;
+    sjd::Texture m_buildingSpecularMap;
+    sjd::Texture m_groundDiffuseMap;
+    sjd::Quad m_ground;
+    std::vector<std::unique_ptr<sjd::Cube>> m_buildings;
+    sjd::Scene m_scene;
+    sjd::DirLight m_dirLight;
+    std::unique_ptr<sjd::HiZCuller> m_culler;
+    std::unique_ptr<sjd::WorkerPool> m_pool;
+    std::unique_ptr<sjd::SoftwareOcclusion> m_softwareOcclusion;
+    std::string m_name;
+};
+
+// demos/instancing/asteroid.cpp
+//
+// The lit variants shade the rocks with a directional light, either inverting
+// each instance matrix per vertex for the normal matrix (LIT_INVERSE) or reading
+// one precomputed on the CPU from a per-instance attribute (LIT), to compare
+// vertex stage cost.
+//
+// The culled variants frustum cull the rocks and pick their level of detail
+// before drawing, with sjd::InstanceCuller on the CPU or in a compute shader,
+// optionally crossfading between levels. They only support UNLIT, whose
+// instance data is just the model matrix. The rock gets four levels of detail
+// whenever it's culled.
+//
+// An impostor distance bakes an sjd::Impostor of the rock and draws the culled
+// rocks beyond that depth as impostor quads.
+//
+// A camera distance replaces the flythrough with a fixed camera that far
+// outside the ring, to compare triangle counts and frame times as the rocks
+// shrink on screen.
+class Asteroids: public BenchScene {
+public:
+    enum Shading {
+        UNLIT,
+        LIT_INVERSE,
+        LIT
+    };
+
+    enum Culling {
+        NO_CULLING,
+        CPU_CULLING,
+        GPU_CULLING
+    };
+
+    // threads = 0 animates on every core
+    Asteroids(Shading shading=UNLIT, unsigned int amount=100000, unsigned int threads=0,
+              Culling culling=NO_CULLING, float crossfadeBand=0.0f, float cameraDistance=0.0f,
+              float impostorDistance=0.0f)
+    :   m_shader {"../demos/instancing/3.3.vert.glsl",
+                  "../code/shaders/model_unlit.frag.glsl"}
+    ,   m_instanceShader {instanceVertexShader(shading, crossfadeBand > 0.0f),
+                          instanceFragmentShader(shading, crossfadeBand > 0.0f)}
+    ,   m_rock {loadFlippedModel("../demos/instancing/model_asteroid/rock.obj", (culling == NO_CULLING) ? 1 : 4)}
+    ,   m_planet {loadFlippedModel("../demos/instancing/model_planet/planet.obj")}
+    ,   m_amount {amount}
+    ,   m_shading {shading}
+    ,   m_field {amount, 1}     // fixed seed so every run lays out the same field
+    ,   m_pool {threads}
+    ,   m_modelRing {GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(amount * sizeof(glm::mat4))}
+    ,   m_updateMs {0.0}
+    ,   m_waitMs {0.0}
+    {
+        m_name = (shading == LIT_INVERSE) ? "asteroids_lit_inverse" : (shading == LIT) ? "asteroids_lit" : "asteroids";
+        if (amount != 100000) {
+            m_name += "_" + ((amount % 1000000 == 0) ? std::to_string(amount / 1000000) + "m"
+                           : (amount % 1000 == 0)    ? std::to_string(amount / 1000) + "k"
+                                                     : std::to_string(amount));
+        }
+        if (culling != NO_CULLING) {
+            if (impostorDistance > 0.0f) {
+                m_impostor = std::make_unique<sjd::Impostor>(m_rock);
+                m_impostorShader = std::make_unique<sjd::Shader>("../code/shaders/impostor.vert.glsl",
+                                                                 "../code/shaders/impostor.frag.glsl");
+            }
+            m_culler = std::make_unique<sjd::InstanceCuller>(
+                m_rock, amount,
+                (culling == GPU_CULLING) ? sjd::InstanceCuller::GPU : sjd::InstanceCuller::CPU,
+                sjd::InstanceCuller::Settings {{}, 1.0f, 1.0f, crossfadeBand, impostorDistance},
+                m_impostor.get());
+            // the culler says which it ended up with; no compute shaders means CPU
+            m_name += (m_culler->mode() == sjd::InstanceCuller::GPU) ? "_cull_gpu" : "_cull_cpu";
+            if (crossfadeBand > 0.0f) m_name += "_fade";
+            if (m_impostor) m_name += "_imp";
+            if (m_culler->mode() == sjd::InstanceCuller::CPU) m_cpuModels.resize(amount);
+        }
+        for (const sjd::ModelMesh& mesh : m_rock.m_meshes) m_rockTriangles += mesh.m_lods[0].indexCount / 3;
+        if (m_shading == LIT) {
+            m_normalRing = std::make_unique<sjd::StreamRing>(GL_ARRAY_BUFFER,
+                                                             static_cast<GLsizeiptr>(amount * sizeof(glm::mat3)));
+        }
+        for (unsigned int i = 0; i < m_rock.m_meshes.size(); i++) {
+            glBindVertexArray(m_rock.m_meshes[i].VAO);
+            for (unsigned int column = 0; column < 4; column++) {
+                glEnableVertexAttribArray(3 + column);
+                glVertexAttribDivisor(3 + column, 1);
+            }
+            for (unsigned int column = 0; m_normalRing && column < 3; column++) {
+                glEnableVertexAttribArray(7 + column);
+                glVertexAttribDivisor(7 + column, 1);
+            }
+            glBindVertexArray(0);
+        }
+        // the attribute pointers themselves are set each frame, to that frame's ring region
+
+        if (cameraDistance > 0.0f) {
+            m_name += "_d" + std::to_string(static_cast<int>(cameraDistance));
+            // looking at the near edge of the ring, from slightly above it
+            m_cameraPath.addKeyframe(0.0f, {0.0f, cameraDistance * 0.25f, 150.0f + cameraDistance},
+                                     {0.0f, 0.0f, 150.0f});
+        }
+        else {
+            m_cameraPath.addKeyframe(0.0f,  {0.0f, 0.0f, 110.0f},   {0.0f, 0.0f, 0.0f});
+            m_cameraPath.addKeyframe(6.0f,  {110.0f, 20.0f, 0.0f},  {0.0f, 0.0f, 0.0f});
+            m_cameraPath.addKeyframe(12.0f, {150.0f, 2.0f, 40.0f},  {100.0f, 0.0f, 110.0f});
+            m_cameraPath.addKeyframe(18.0f, {0.0f, 60.0f, -200.0f}, {0.0f, 0.0f, 0.0f});
+            m_cameraPath.addKeyframe(24.0f, {0.0f, 0.0f, 110.0f},   {0.0f, 0.0f, 0.0f});
+        }
+    }
+
+    const char* name() const {
+        return m_name.c_str();
+    }
+
+    std::vector<std::pair<std::string, double>> frameMetrics() const {
+        return {
+            {"instances_gpu_ms",    m_instanceTimer.lastMs()},
+            {"instance_update_ms",  m_updateMs},
+            {"instance_wait_ms",    m_waitMs},
+            {"cull_cpu_ms",         m_cullMs},
+            {"cull_gpu_ms",         m_cullTimer.lastMs()},
+            {"instances_drawn",     m_culler ? m_culler->visibleCount() : m_amount},
+            {"impostors_drawn",     m_culler ? m_culler->impostorCount() : 0},
+            {"instance_triangles",  static_cast<double>(m_culler ? m_culler->trianglesDrawn()
+                                                                 : uint64_t {m_amount} * m_rockTriangles)},
+        };
+    }
+
+    void begin() {
+        glEnable(GL_DEPTH_TEST);
+        glDisable(GL_FRAMEBUFFER_SRGB);
+        glDisable(GL_CULL_FACE);
+    }
+
+    // Rebuild every rock's matrices on the worker pool, straight into this frame's
+    // region of the instance ring, then point the rock's attributes at it. CPU
+    // culling reads the matrices back, so they go to ordinary memory instead.
+    void update(float time) {
+        auto start {std::chrono::steady_clock::now()};
+        if (!m_cpuModels.empty()) {
+            m_pool.parallelFor(m_amount, 4096, [&](size_t first, size_t count) {
+                m_field.update(time, m_cpuModels.data() + first, first, count);
+            });
+            auto end {std::chrono::steady_clock::now()};
+            m_updateMs = std::chrono::duration<double, std::milli>(end - start).count();
+            return;
+        }
+        glm::mat4* models {static_cast<glm::mat4*>(m_modelRing.map())};
+        glm::mat3* normals {m_normalRing ? static_cast<glm::mat3*>(m_normalRing->map()) : nullptr};
+        m_waitMs = (m_modelRing.lastWaitNs() + (m_normalRing ? m_normalRing->lastWaitNs() : 0)) / 1.0e6;
+        if (models && (normals || !m_normalRing)) {
+            m_pool.parallelFor(m_amount, 4096, [&](size_t first, size_t count) {
+                m_field.update(time, models + first, first, count);
+                if (normals) m_field.normalMatrices(normals + first, first, count);
+            });
+        }
+        m_modelRing.unmap();
+        if (m_normalRing) m_normalRing->unmap();
+        auto end {std::chrono::steady_clock::now()};
+        m_updateMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+        for (unsigned int i = 0; i < m_rock.m_meshes.size(); i++) {
+            glBindVertexArray(m_rock.m_meshes[i].VAO);
+            glBindBuffer(GL_ARRAY_BUFFER, m_modelRing.id());
+            for (unsigned int column = 0; column < 4; column++) {
+                glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                                      (void*)(m_modelRing.offset() + column * sizeof(glm::vec4)));
+            }
+            if (m_normalRing) {
+                glBindBuffer(GL_ARRAY_BUFFER, m_normalRing->id());
+                for (unsigned int column = 0; column < 3; column++) {
+                    glVertexAttribPointer(7 + column, 3, GL_FLOAT, GL_FALSE, sizeof(glm::mat3),
+                                          (void*)(m_normalRing->offset() + column * sizeof(glm::vec3)));
+                }
+            }
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void render(sjd::Camera& camera, float aspect) {
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 projection = glm::perspective(glm::radians(camera.zoom), aspect, 0.1f, 1000.0f);
+        glm::mat4 view = camera.getViewMatrix();
+        m_instanceShader.use();
+        m_instanceShader.setMat4("projection", projection);
+        m_instanceShader.setMat4("view", view);
+        m_shader.use();
+        m_shader.setMat4("projection", projection);
+        m_shader.setMat4("view", view);
+
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, glm::vec3(0.0f, -3.0f, 0.0f));
+        model = glm::scale(model, glm::vec3(4.0f, 4.0f, 4.0f));
+        m_shader.setMat4("model", model);
+        m_planet.Draw(m_shader);
+
+        m_instanceShader.use();
+        m_instanceShader.setVec3("lightDirection", glm::vec3(-0.2f, -1.0f, -0.3f));
+        if (m_culler) {
+            GLint viewport[4];
+            glGetIntegerv(GL_VIEWPORT, viewport);
+            auto start {std::chrono::steady_clock::now()};
+            m_cullTimer.begin();
+            if (m_cpuModels.empty()) {
+                m_culler->cull(m_modelRing.id(), m_modelRing.offset(), m_amount, view, projection,
+                               static_cast<float>(viewport[3]));
+            }
+            else {
+                m_culler->cull(m_cpuModels.data(), m_amount, view, projection, static_cast<float>(viewport[3]));
+            }
+            m_cullTimer.end();
+            auto end {std::chrono::steady_clock::now()};
+            m_cullMs = std::chrono::duration<double, std::milli>(end - start).count();
+            m_instanceShader.use();
+        }
+        m_instanceTimer.begin();
+        if (m_culler) m_culler->draw(m_instanceShader);
+        else          m_rock.DrawInstanced(m_instanceShader, m_amount);
+        if (m_impostor) {
+            m_impostorShader->use();
+            m_impostorShader->setMat4("projection", projection);
+            m_impostorShader->setMat4("view", view);
+            m_impostorShader->setVec3("viewPos", camera.pos);
+            m_impostorShader->setBool("lit", m_shading != UNLIT);
+            m_impostorShader->setVec3("lightDirection", glm::vec3(-0.2f, -1.0f, -0.3f));
+            m_culler->drawImpostors(*m_impostorShader);
+        }
+        m_instanceTimer.end();
+        m_modelRing.fence();
+        if (m_normalRing) m_normalRing->fence();
+    }
+
+private:
+    static const char* instanceVertexShader(Shading shading, bool crossfade) {
+        if (crossfade) return "../code/shaders/instancing_fade.vert.glsl";
+        switch (shading) {
+            case LIT_INVERSE: return "../code/shaders/instancing_lit_inverse.vert.glsl";
+            case LIT:         return "../code/shaders/instancing_lit.vert.glsl";
+            default:          return "../demos/instancing/3.3.instancing.vert.glsl";
+        }
+    }
+
+    static const char* instanceFragmentShader(Shading shading, bool crossfade) {
+        if (crossfade) return "../code/shaders/model_unlit_dither.frag.glsl";
+        return (shading == UNLIT) ? "../code/shaders/model_unlit.frag.glsl" : "../code/shaders/model_lit.frag.glsl";
+    }
+
+    sjd::Shader m_shader;
+    sjd::Shader m_instanceShader;
+    sjd::Model m_rock;
+    sjd::Model m_planet;
+    unsigned int m_amount;
+    Shading m_shading;
+    std::string m_name;
+    sjd::AsteroidField m_field;
+    sjd::WorkerPool m_pool;
+    sjd::StreamRing m_modelRing;
+    std::unique_ptr<sjd::StreamRing> m_normalRing;
+    double m_updateMs;
+    double m_waitMs;
+    sjd::GpuTimer m_instanceTimer;
+    std::unique_ptr<sjd::Impostor> m_impostor;
+    std::unique_ptr<sjd::Shader> m_impostorShader;
+    std::unique_ptr<sjd::InstanceCuller> m_culler;
+    std::vector<glm::mat4> m_cpuModels;
+    double m_cullMs {0.0};
+    sjd::GpuTimer m_cullTimer;
+    uint64_t m_rockTriangles {0};
+};
+
+// demos/model/model.cpp
+class Backpack: public BenchScene {
+public:
+    Backpack()
+    :   m_shader {"../demos/model/lighting.vert.glsl",
+                  "../demos/model/lighting.frag.glsl"}
+    ,   m_backpack {loadFlippedModel("../demos/model/model_backpack/backpack.obj")}
+    {
+        m_shader.use();
+        m_shader.setFloat("material.shininess", 32.0f);
+
+        m_cameraPath.addKeyframe(0.0f,  {0.0f, 0.0f, 3.0f},   {0.0f, 0.0f, 0.0f});
+        m_cameraPath.addKeyframe(3.0f,  {3.0f, 1.0f, 0.0f},   {0.0f, 0.0f, 0.0f});
+        m_cameraPath.addKeyframe(6.0f,  {0.0f, 2.0f, -3.0f},  {0.0f, 0.0f, 0.0f});
+        m_cameraPath.addKeyframe(9.0f,  {-3.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 0.0f});
+        m_cameraPath.addKeyframe(12.0f, {0.0f, 0.0f, 3.0f},   {0.0f, 0.0f, 0.0f});
+    }
+
+    const char* name() const { return "model"; }
+
+    void begin() {
+        glEnable(GL_DEPTH_TEST);
+        glDisable(GL_FRAMEBUFFER_SRGB);
+        glDisable(GL_CULL_FACE);
+    }
+
+    void render(sjd::Camera& camera, float aspect) {
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        m_shader.use();
+        m_shader.setVec3("viewPos", camera.pos);
+        m_shader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
+        m_shader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
+        m_shader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
+        m_shader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
+        m_shader.setMat4("model", glm::mat4(1.0f));
+        m_shader.setMat3("normalMatrix", glm::mat3(1.0f));
+        m_shader.setMat4("view", camera.getViewMatrix());
+        m_shader.setMat4("projection", glm::perspective(glm::radians(camera.zoom), aspect, 0.1f, 100.0f));
+
+        m_backpack.Draw(m_shader);
+    }
+
+private:
+    sjd::Shader m_shader;
+    sjd::Model m_backpack;
+};
+
+// scene01 drawn at 1080p into an RGBA16F target, which is then blurred with
+// sjd::GaussianBlur at each radius from 2 to 64 in turn, every frame. Reports
+// the GPU cost of each radius in nanoseconds per pixel. The blurs only go to
+// offscreen targets; nothing is shown in the window.
+class BlurSweep: public BenchScene {
+public:
+    static constexpr std::array<unsigned int, 6> radii {2, 4, 8, 16, 32, 64};
+
+    BlurSweep(sjd::GaussianBlur::Method method)
+    :   m_blur {method}
+    ,   m_sceneTarget {1920, 1080, {{sjd::RenderTarget::RGBA16F}, sjd::RenderTarget::DEPTH24}}
+    ,   m_target {1920, 1080, {{sjd::RenderTarget::RGBA16F}, sjd::RenderTarget::NO_DEPTH}}
+    ,   m_scratch {1920, 1080, {{sjd::RenderTarget::RGBA16F}, sjd::RenderTarget::NO_DEPTH}}
+    {
+        m_cameraPath = m_scene01.cameraPath();
+    }
+
+    const char* name() const {
+        return (m_blur.method() == sjd::GaussianBlur::COMPUTE) ? "blur_compute" : "blur_fragment";
+    }
+
+    void begin() {
+        m_scene01.begin();
+    }
+
+    void update(float time) {
+        m_scene01.update(time);
+    }
+
+    void render(sjd::Camera& camera, [[maybe_unused]] float aspect) {
+        m_sceneTarget.bind();
+        m_scene01.render(camera, 1920.0f / 1080.0f);
+        m_sceneTarget.release();
+        for (size_t i = 0; i < radii.size(); i++) {
+            m_sceneTarget.blit(m_target);
+            m_timers[i].begin();
+            m_blur.blur(m_target, m_scratch, radii[i]);
+            m_timers[i].end();
+        }
+    }
+
+    std::vector<std::pair<std::string, double>> frameMetrics() const {
+        std::vector<std::pair<std::string, double>> metrics;
+        double pixels {static_cast<double>(m_target.width()) * m_target.height()};
+        for (size_t i = 0; i < radii.size(); i++) {
+            metrics.push_back({"r" + std::to_string(radii[i]) + "_ns_per_pixel", m_timers[i].lastMs() * 1.0e6 / pixels});
+        }
+        return metrics;
+    }
+
+private:
+    Scene01 m_scene01;
+    sjd::GaussianBlur m_blur;
+    sjd::RenderTarget m_sceneTarget;
+    sjd::RenderTarget m_target;
+    sjd::RenderTarget m_scratch;
+    std::array<sjd::GpuTimer, radii.size()> m_timers;
+};
+
+inline std::unique_ptr<BenchScene> makeScene(const std::string& name) {
+    if (name == "scene01") return std::make_unique<Scene01>();
+    if (name == "scene02") return std::make_unique<Scene02>();
+    if (name == "scene02_prepass") return std::make_unique<Scene02>(true);
+    if (name == "scene02_hdr") return std::make_unique<Scene02>(false, true);
+    if (name == "scene02_taa") return std::make_unique<Scene02>(false, false, true);
+    if (name == "scene02_fxaa") return std::make_unique<Scene02>(false, false, false, sjd::FXAA);
+    if (name == "scene02_smaa") return std::make_unique<Scene02>(false, false, false, sjd::SMAA);
+    for (unsigned int lights : {16u, 256u, 4096u}) {
+        if (name == "lights_" + std::to_string(lights)) return std::make_unique<ManyLights>(lights, false);
+        if (name == "lights_" + std::to_string(lights) + "_deferred") return std::make_unique<ManyLights>(lights, true);
+        if (name == "lights_" + std::to_string(lights) + "_prepass") return std::make_unique<ManyLights>(lights, false, true);
+        if (name == "lights_" + std::to_string(lights) + "_deferred_dynres") {
+            return std::make_unique<ManyLights>(lights, true, false, true);
+        }
+    }
+    if (name == "city") return std::make_unique<City>();
+    if (name == "city_hiz_cpu") return std::make_unique<City>(City::CPU_OCCLUSION);
+    if (name == "city_hiz_gpu") return std::make_unique<City>(City::GPU_OCCLUSION);
+    if (name == "city_soft") return std::make_unique<City>(City::SOFTWARE_OCCLUSION);
+    if (name == "asteroids") return std::make_unique<Asteroids>();
+    if (name == "asteroids_lit_inverse") return std::make_unique<Asteroids>(Asteroids::LIT_INVERSE);
+    if (name == "asteroids_lit") return std::make_unique<Asteroids>(Asteroids::LIT);
+    if (name == "asteroids_1m") return std::make_unique<Asteroids>(Asteroids::UNLIT, 1000000);
+    if (name == "asteroids_cull_cpu") return std::make_unique<Asteroids>(Asteroids::UNLIT, 100000, 0, Asteroids::CPU_CULLING);
+    if (name == "asteroids_cull_gpu") return std::make_unique<Asteroids>(Asteroids::UNLIT, 100000, 0, Asteroids::GPU_CULLING);
+    if (name == "asteroids_cull_gpu_fade") {
+        return std::make_unique<Asteroids>(Asteroids::UNLIT, 100000, 0, Asteroids::GPU_CULLING, 0.25f);
+    }
+    if (name == "asteroids_cull_gpu_imp") {
+        return std::make_unique<Asteroids>(Asteroids::UNLIT, 100000, 0, Asteroids::GPU_CULLING, 0.0f, 0.0f, 200.0f);
+    }
+    // full detail against culled levels of detail, and impostors past 200 units,
+    // from near, middling and far away
+    for (int distance : {40, 150, 600}) {
+        if (name == "asteroids_d" + std::to_string(distance)) {
+            return std::make_unique<Asteroids>(Asteroids::UNLIT, 100000, 0, Asteroids::NO_CULLING, 0.0f, distance);
+        }
+        if (name == "asteroids_cull_gpu_fade_d" + std::to_string(distance)) {
+            return std::make_unique<Asteroids>(Asteroids::UNLIT, 100000, 0, Asteroids::GPU_CULLING, 0.25f, distance);
+        }
+        if (name == "asteroids_cull_gpu_imp_d" + std::to_string(distance)) {
+            return std::make_unique<Asteroids>(Asteroids::UNLIT, 100000, 0, Asteroids::GPU_CULLING, 0.0f, distance,
+                                               200.0f);
+        }
+    }
+    if (name == "model") return std::make_unique<Backpack>();
+    if (name == "blur_fragment") return std::make_unique<BlurSweep>(sjd::GaussianBlur::FRAGMENT);
+    if (name == "blur_compute") return std::make_unique<BlurSweep>(sjd::GaussianBlur::COMPUTE);
+    return nullptr;
+}
+
+}
+#endif
@@ -0,0 +1,322 @@
+// Deterministic benchmark runner over the demo scenes.
+//
+// Every scene is driven by a scripted camera path and a fixed simulation timestep,
+// so two runs render exactly the same frames. After N warmup frames it measures M
+// frames and reports frame time (mean/p50/p95/p99), GPU time, draw calls, state
+// changes, process memory and any per-scene numbers (e.g. scene02's shadow pass
+// GPU time), then compares against a stored baseline.
+//
+// usage: benchmark [--scene name]... [--warmup N] [--frames M]
+//                  [--baseline file] [--threshold percent]
+//                  [--out file] [--update-baseline] [--replay file]
+//                  [--samples N]
+//
+// --replay drives the camera from an input recording (see sjd/input.h, made
+// with a scene's --record option) instead of each scene's scripted path, from
+// the pose it was recorded at. A run stops early when the recording runs out.
+//
+// --samples sets the window's MSAA sample count, 4 by default. To weigh TAA,
+// FXAA or SMAA against MSAA, compare scene02_taa, scene02_fxaa or scene02_smaa
+// run with --samples 1 to scene02 with the default; framebuffer_mb is what the
+// window's own buffers take.
+//
+// Exits with 1 if any metric regressed by more than the threshold.
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <sjd/glfw_setup.h>
+#include <sjd/camera.h>
+#include <sjd/input.h>
+#include <sjd/player.h>
+#include <sjd/profiling.h>
+
+#include "bench_json.h"
+#include "bench_scenes.h"
+
+namespace globals {
+    constexpr uint32_t windowWidth {1200};
+    constexpr uint32_t windowHeight {900};
+    // simulation step used for animation and camera paths, independent of real time
+    constexpr float timeStep {1.0f / 60.0f};
+}
+
+struct Options {
+    std::vector<std::string> scenes;
+    unsigned int warmupFrames {60};
+    unsigned int measuredFrames {600};
+    std::string baselinePath {"../code/bench/baseline.json"};
+    std::string outPath {"bench_results.json"};
+    std::string replayPath {};
+    double thresholdPercent {10.0};
+    bool updateBaseline {false};
+    unsigned int samples {4};
+};
+
+bool parseOptions(int argc, char** argv, Options& options);
+double processMemoryMB();
+double windowFramebufferMB(GLFWwindow* window);
+bench::Metrics runScene(bench::BenchScene& scene, GLFWwindow* window, const Options& options);
+int compareToBaseline(const bench::SceneMetrics& results, const bench::SceneMetrics& baseline, double thresholdPercent);
+bool higherIsBetter(const std::string& metric);
+
+int main(int argc, char** argv) {
+    Options options {};
+    if (!parseOptions(argc, argv, options)) return 2;
+    if (options.scenes.empty()) {
+        options.scenes = {"scene01", "scene02", "scene02_prepass", "scene02_hdr", "lights_16", "lights_16_deferred",
+                           "lights_16_prepass", "lights_256", "lights_256_deferred", "lights_256_prepass",
+                           "lights_4096", "lights_4096_deferred", "lights_4096_prepass",
+                           "lights_4096_deferred_dynres",
+                           "city", "city_hiz_cpu", "city_hiz_gpu", "city_soft",
+                           "asteroids", "asteroids_lit_inverse", "asteroids_lit", "asteroids_1m",
+                           "asteroids_cull_cpu", "asteroids_cull_gpu", "asteroids_cull_gpu_fade",
+                           "asteroids_d40", "asteroids_cull_gpu_fade_d40", "asteroids_d150",
+                           "asteroids_cull_gpu_fade_d150", "asteroids_d600", "asteroids_cull_gpu_fade_d600",
+                           "asteroids_cull_gpu_imp", "asteroids_cull_gpu_imp_d40", "asteroids_cull_gpu_imp_d150",
+                           "asteroids_cull_gpu_imp_d600", "model", "blur_fragment", "blur_compute", "scene02_taa",
+                           "scene02_fxaa", "scene02_smaa"};
+    }
+
+    // INIT WINDOW
+    GLFWwindow* window {sjd::createCoreWindow(globals::windowWidth, globals::windowHeight,
+                                                   static_cast<uint16_t>(options.samples), true)};
+    if (!window) return -1;
+    glfwSwapInterval(0);    // don't let vsync hide frame time
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+    // ---
+
+    bench::SceneMetrics results;
+    for (const std::string& name : options.scenes) {
+        std::unique_ptr<bench::BenchScene> scene {bench::makeScene(name)};
+        if (!scene) {
+            std::cout << "ERROR::BENCH::UNKNOWN_SCENE " << name << std::endl;
+            continue;
+        }
+        std::cout << "running " << name << " ..." << std::endl;
+        results[name] = runScene(*scene, window, options);
+        if (glfwWindowShouldClose(window)) break;
+    }
+
+    // REPORT
+    std::cout << std::endl << std::fixed << std::setprecision(3);
+    for (const auto& [name, metrics] : results) {
+        std::cout << name << std::endl;
+        for (const auto& [metric, value] : metrics) {
+            std::cout << "    " << std::left << std::setw(18) << metric << value << std::endl;
+        }
+    }
+    bench::writeResults(options.outPath, results);
+    std::cout << std::endl << "results written to " << options.outPath << std::endl;
+
+    int exitCode {0};
+    if (options.updateBaseline) {
+        bench::SceneMetrics baseline;
+        bench::readResults(options.baselinePath, baseline);   // keep scenes we didn't run
+        for (const auto& [name, metrics] : results) baseline[name] = metrics;
+        bench::writeResults(options.baselinePath, baseline);
+        std::cout << "baseline updated: " << options.baselinePath << std::endl;
+    }
+    else {
+        bench::SceneMetrics baseline;
+        if (bench::readResults(options.baselinePath, baseline)) {
+            exitCode = compareToBaseline(results, baseline, options.thresholdPercent);
+        }
+        else {
+            std::cout << "no baseline at " << options.baselinePath
+                      << " (run with --update-baseline to record one)" << std::endl;
+        }
+    }
+
+    glfwTerminate();
+    return exitCode;
+}
+
+bench::Metrics runScene(bench::BenchScene& scene, GLFWwindow* window, const Options& options) {
+    sjd::Camera camera {};
+    sjd::GpuTimer gpuTimer {};
+    sjd::FrameStats frameTimes {};
+    sjd::FrameStats gpuTimes {};
+    double drawCalls {0.0};
+    double stateChanges {0.0};
+    double triangles {0.0};
+    bench::Metrics sceneMetrics;
+    float aspect {static_cast<float>(globals::windowWidth) / globals::windowHeight};
+
+    // a replay starts from the pose it was recorded from and takes over from there
+    std::unique_ptr<sjd::InputReplay> replay;
+    std::unique_ptr<sjd::Player> player;
+    if (!options.replayPath.empty()) {
+        replay = std::make_unique<sjd::InputReplay>(options.replayPath);
+        player = std::make_unique<sjd::Player>(camera, *replay);
+    }
+
+    scene.begin();
+    unsigned int totalFrames {options.warmupFrames + options.measuredFrames};
+    for (unsigned int frame = 0; frame < totalFrames && !glfwWindowShouldClose(window); frame++) {
+        float time {frame * globals::timeStep};
+        if (player) {
+            player->processInput(globals::timeStep);
+            // measuring a camera that's stopped would only dilute the numbers
+            if (player->inputFinished()) {
+                std::cout << "    replay ended after " << frame << " of " << totalFrames
+                          << " frames; measured " << frameTimes.count() << std::endl;
+                break;
+            }
+        }
+        else scene.cameraPath().apply(camera, time);
+        sjd::stats::reset();
+
+        auto start {std::chrono::steady_clock::now()};
+        scene.update(time);
+        gpuTimer.begin();
+        scene.render(camera, aspect);
+        gpuTimer.end();
+        glfwSwapBuffers(window);
+        glFinish();     // include the GPU work for this frame in its frame time
+        auto end {std::chrono::steady_clock::now()};
+        glfwPollEvents();
+
+        if (frame < options.warmupFrames) continue;
+        frameTimes.add(std::chrono::duration<double, std::milli>(end - start).count());
+        gpuTimes.add(gpuTimer.lastMs());
+        drawCalls += static_cast<double>(sjd::stats::drawCalls);
+        stateChanges += static_cast<double>(sjd::stats::stateChanges);
+        triangles += static_cast<double>(sjd::stats::triangles);
+        for (const auto& [metric, value] : scene.frameMetrics()) {
+            auto sum {std::find_if(sceneMetrics.begin(), sceneMetrics.end(),
+                                   [&](const auto& entry) { return entry.first == metric; })};
+            if (sum == sceneMetrics.end()) sceneMetrics.push_back({metric, value});
+            else sum->second += value;
+        }
+    }
+
+    double frames {static_cast<double>(std::max<size_t>(frameTimes.count(), 1))};
+    bench::Metrics metrics {
+        {"mean_ms",       frameTimes.mean()},
+        {"p50_ms",        frameTimes.percentile(50.0)},
+        {"p95_ms",        frameTimes.percentile(95.0)},
+        {"p99_ms",        frameTimes.percentile(99.0)},
+        {"max_ms",        frameTimes.max()},
+        {"gpu_mean_ms",   gpuTimes.mean()},
+        {"draw_calls",    drawCalls / frames},
+        {"state_changes", stateChanges / frames},
+        {"triangles",     triangles / frames},
+        {"memory_mb",     processMemoryMB()},   // with the scene still loaded, after its measured frames
+        {"framebuffer_mb", windowFramebufferMB(window)},
+    };
+    for (const auto& [metric, sum] : sceneMetrics) metrics.push_back({metric, sum / frames});
+    return metrics;
+}
+
+// Flag anything that moved the wrong way past the threshold: grew, for all but
+// the few higherIsBetter() metrics, which regress when they drop.
+int compareToBaseline(const bench::SceneMetrics& results, const bench::SceneMetrics& baseline, double thresholdPercent) {
+    int regressions {0};
+    std::cout << std::endl << "comparing against baseline (threshold "
+              << thresholdPercent << "%)" << std::endl;
+    for (const auto& [name, metrics] : results) {
+        auto baseScene {baseline.find(name)};
+        if (baseScene == baseline.end()) {
+            std::cout << "    " << name << ": not in baseline" << std::endl;
+            continue;
+        }
+        for (const auto& [metric, value] : metrics) {
+            for (const auto& [baseMetric, baseValue] : baseScene->second) {
+                if (baseMetric != metric || baseValue <= 0.0) continue;
+                double change {(value - baseValue) / baseValue * 100.0};
+                bool higher {higherIsBetter(metric)};
+                if ((higher ? -change : change) > thresholdPercent) {
+                    std::cout << "    REGRESSION " << name << "." << metric << ": "
+                              << baseValue << " -> " << value
+                              << " (" << (higher ? "" : "+") << change << "%)" << std::endl;
+                    regressions++;
+                }
+            }
+        }
+    }
+    if (regressions == 0) std::cout << "    no regressions" << std::endl;
+    return (regressions > 0) ? 1 : 0;
+}
+
+// e.g. the dynamic resolution scale: holding a bigger one is the improvement
+bool higherIsBetter(const std::string& metric) {
+    return metric == "resolution_scale";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg {argv[i]};
+        bool hasValue {i + 1 < argc};
+        if (arg == "--scene" && hasValue) options.scenes.push_back(argv[++i]);
+        else if (arg == "--warmup" && hasValue) options.warmupFrames = std::stoul(argv[++i]);
+        else if (arg == "--frames" && hasValue) options.measuredFrames = std::stoul(argv[++i]);
+        else if (arg == "--baseline" && hasValue) options.baselinePath = argv[++i];
+        else if (arg == "--out" && hasValue) options.outPath = argv[++i];
+        else if (arg == "--threshold" && hasValue) options.thresholdPercent = std::stod(argv[++i]);
+        else if (arg == "--replay" && hasValue) options.replayPath = argv[++i];
+        else if (arg == "--samples" && hasValue) options.samples = std::stoul(argv[++i]);
+        else if (arg == "--update-baseline") options.updateBaseline = true;
+        else {
+            std::cout << "ERROR::BENCH::BAD_ARGUMENT " << arg << std::endl;
+            std::cout << "usage: benchmark [--scene name]... [--warmup N] [--frames M] "
+                         "[--baseline file] [--threshold percent] [--out file] [--update-baseline] "
+                         "[--replay file] [--samples N]"
+                      << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// The window's colour and depth at its sample count, taking 4 bytes a sample
+// each (RGBA8 and 24 bit depth with 8 of stencil or padding), in MB; the swap
+// chain's extra colour buffers aren't counted.
+double windowFramebufferMB(GLFWwindow* window) {
+    int width {0};
+    int height {0};
+    glfwGetFramebufferSize(window, &width, &height);
+    GLint samples {0};
+    glGetIntegerv(GL_SAMPLES, &samples);
+    double pixels {static_cast<double>(width) * height * std::max(samples, 1)};
+    return pixels * 8.0 / (1024.0 * 1024.0);
+}
+
+// Resident memory of the process right now, in MB. Not the peak: every scene
+// runs in the same process, so the peak would be the largest of all the scenes
+// run before, and depend on which ones those were.
+double processMemoryMB() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<double>(counters.WorkingSetSize) / (1024.0 * 1024.0);
+    }
+    return 0.0;
+#else
+    std::ifstream status {"/proc/self/status"};
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmRSS:", 0) == 0) {
+            return std::stod(line.substr(6)) / 1024.0;
+        }
+    }
+    return 0.0;
+#endif
+}
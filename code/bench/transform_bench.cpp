@@ -0,0 +1,389 @@
+// CPU benchmarks for transform code.
+//
+// Hierarchy: builds a random forest of sjd::TransformHierarchy nodes (fixed seed,
+// so every run builds the same one), then repeatedly touches a fraction of the
+// nodes and times update(). A touched node also drags its whole subtree along,
+// so the number of matrices actually recomputed is reported next to the number
+// touched.
+//
+// Batch kernels: runs each sjd::simd kernel and a full sjd::AsteroidField update
+// over --batch elements at every ISA level the CPU supports, in millions of
+// results per second.
+//
+// Threads: animates --rocks asteroids on a sjd::WorkerPool of 1, 2, 4, ... up to
+// every core, and reports the update time for each.
+//
+// Occlusion: rasterizes a grid of --occluders box buildings with
+// sjd::SoftwareOcclusion from street level and from above, at every ISA level on
+// one thread and on every core, in triangles per millisecond, along with the
+// share of the buildings the result culls.
+//
+// Post-processing: runs a sharpen, tonemap, colour grade, vignette and gamma
+// sjd::PostProcessStack on the CPU over a float frame at 1080p and 4K, once as a
+// pass per effect and once fused into one pass, on one thread and on every core.
+// Reports frame time, megapixels per second and the bytes each way reads and
+// writes, and checks both ways give the same picture.
+//
+// usage: transform_bench [--nodes N] [--iterations N] [--batch N] [--rocks N] [--occluders N]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <sjd/profiling.h>
+#include <sjd/simd_math.h>
+#include <sjd/asteroid_field.h>
+#include <sjd/worker_pool.h>
+#include <sjd/occlusion_raster.h>
+#include <sjd/post_process.h>
+#include <sjd/transform_hierarchy.h>
+
+struct Options {
+    unsigned int nodes {100000};
+    unsigned int iterations {200};
+    unsigned int batch {1000000};
+    unsigned int rocks {1000000};
+    unsigned int occluders {4096};
+};
+
+bool parseOptions(int argc, char** argv, Options& options);
+void benchmarkHierarchy(const Options& options);
+void benchmarkKernels(const Options& options);
+void benchmarkThreads(const Options& options);
+void benchmarkOcclusion(const Options& options);
+void benchmarkPostProcess(const Options& options);
+
+int main(int argc, char** argv) {
+    Options options {};
+    if (!parseOptions(argc, argv, options)) return 2;
+    std::cout << std::fixed << std::setprecision(3);
+    benchmarkHierarchy(options);
+    std::cout << std::endl;
+    benchmarkKernels(options);
+    std::cout << std::endl;
+    benchmarkThreads(options);
+    std::cout << std::endl;
+    benchmarkOcclusion(options);
+    std::cout << std::endl;
+    benchmarkPostProcess(options);
+    return 0;
+}
+
+void benchmarkHierarchy(const Options& options) {
+    // Roughly scene-graph shaped: trees of 256 nodes where every node hangs off a
+    // random earlier node of its tree, so most subtrees are small and a few are big.
+    std::mt19937 random {1234};
+    std::uniform_real_distribution<float> unit {-1.0f, 1.0f};
+    sjd::TransformHierarchy transforms {options.nodes};
+    std::vector<sjd::TransformHierarchy::Node> nodes;
+    nodes.reserve(options.nodes);
+    for (unsigned int i = 0; i < options.nodes; i++) {
+        sjd::TransformHierarchy::Node parent {sjd::TransformHierarchy::noParent};
+        unsigned int inTree {i % 256};
+        if (inTree != 0) parent = nodes[i - inTree + random() % inTree];
+        sjd::TransformHierarchy::Node node {transforms.create(parent)};
+        transforms.setPosition(node, glm::vec3(unit(random), unit(random), unit(random)) * 4.0f);
+        transforms.setRotation(node, glm::angleAxis(unit(random) * 3.14159f,
+                                                    glm::normalize(glm::vec3(unit(random), unit(random), 1.0f))));
+        transforms.setScale(node, glm::vec3(1.0f + 0.1f * unit(random)));
+        nodes.push_back(node);
+    }
+    transforms.update();
+
+    std::cout << transforms.size() << " nodes, " << options.iterations << " iterations" << std::endl << std::endl;
+    std::cout << std::left << std::setw(8) << "dirty" << std::setw(12) << "touched"
+              << std::setw(14) << "recomputed" << std::setw(12) << "mean_ms"
+              << std::setw(12) << "p95_ms" << "Mnodes/s" << std::endl;
+
+    float checksum {0.0f};
+    for (double fraction : {0.01, 0.10, 1.00}) {
+        unsigned int touched {static_cast<unsigned int>(fraction * options.nodes)};
+        sjd::FrameStats times {};
+        double recomputed {0.0};
+        for (unsigned int iteration = 0; iteration < options.iterations; iteration++) {
+            // pick the nodes outside the timed region; 100% touches every node
+            for (unsigned int i = 0; i < touched; i++) {
+                sjd::TransformHierarchy::Node node {(touched == options.nodes) ? nodes[i] : nodes[random() % options.nodes]};
+                transforms.setPosition(node, transforms.position(node) + glm::vec3(0.001f));
+            }
+            auto start {std::chrono::steady_clock::now()};
+            size_t updated {transforms.update()};
+            auto end {std::chrono::steady_clock::now()};
+            times.add(std::chrono::duration<double, std::milli>(end - start).count());
+            recomputed += static_cast<double>(updated);
+            checksum += transforms.world(nodes[iteration % options.nodes])[3][0];
+        }
+        recomputed /= options.iterations;
+        double mean {times.mean()};
+        std::cout << std::left << std::setw(8) << (std::to_string(static_cast<int>(fraction * 100.0)) + "%")
+                  << std::setw(12) << touched << std::setw(14) << std::setprecision(0) << recomputed
+                  << std::setprecision(3) << std::setw(12) << mean << std::setw(12) << times.percentile(95.0)
+                  << ((mean > 0.0) ? recomputed / (mean * 1000.0) : 0.0) << std::endl;
+    }
+    // keeps the updates from being optimised away
+    std::cout << std::endl << "checksum " << checksum << std::endl;
+}
+
+// best of `repeats` runs of work(), in millions of results per second
+template <typename Work>
+double throughput(unsigned int results, unsigned int repeats, Work work) {
+    double best {0.0};
+    for (unsigned int i = 0; i < repeats; i++) {
+        auto start {std::chrono::steady_clock::now()};
+        work();
+        auto end {std::chrono::steady_clock::now()};
+        double seconds {std::chrono::duration<double>(end - start).count()};
+        if (seconds > 0.0) best = std::max(best, results / seconds / 1.0e6);
+    }
+    return best;
+}
+
+void benchmarkKernels(const Options& options) {
+    unsigned int count {options.batch};
+    unsigned int repeats {std::max(1u, options.iterations / 20)};
+    namespace simd = sjd::simd;
+
+    std::vector<float> px(count), py(count), pz(count), qx(count), qy(count), qz(count), qw(count), scale(count);
+    simd::Random random {1234};
+    random.uniform(px.data(), count, -100.0f, 100.0f);
+    random.uniform(py.data(), count, -100.0f, 100.0f);
+    random.uniform(pz.data(), count, -100.0f, 100.0f);
+    random.uniform(scale.data(), count, 0.05f, 0.25f);
+    random.uniform(qx.data(), count, -1.0f, 1.0f);
+    for (unsigned int i = 0; i < count; i++) {
+        glm::quat q {glm::angleAxis(qx[i] * 3.14159f, glm::vec3(0.0f, 1.0f, 0.0f))};
+        qx[i] = q.x; qy[i] = q.y; qz[i] = q.z; qw[i] = q.w;
+    }
+    simd::TRSArrays trs {px.data(), py.data(), pz.data(), qx.data(), qy.data(), qz.data(), qw.data(),
+                         scale.data(), scale.data(), scale.data()};
+    std::vector<glm::mat4> matrices(count), products(count);
+    std::vector<glm::vec4> vectors(count, glm::vec4(1.0f)), transformed(count);
+    std::vector<float> sines(count), cosines(count);
+    sjd::AsteroidField field {count};
+
+    std::cout << count << " elements per batch, millions per second (best of " << repeats << ")" << std::endl;
+    std::cout << std::left << std::setw(8) << "isa" << std::setw(12) << "compose"
+              << std::setw(12) << "mat*mat" << std::setw(12) << "mat*vec" << std::setw(12) << "random"
+              << std::setw(12) << "sincos" << "asteroids" << std::endl;
+    float checksum {0.0f};
+    for (simd::Isa isa : {simd::Isa::SCALAR, simd::Isa::SSE2, simd::Isa::AVX2}) {
+        if (static_cast<int>(isa) > static_cast<int>(simd::supportedIsa())) break;
+        simd::setIsa(isa);
+        double compose {throughput(count, repeats, [&]() { simd::composeTRS(trs, matrices.data(), count); })};
+        double multiply {throughput(count, repeats, [&]() {
+            simd::multiply(matrices.data(), matrices.data(), products.data(), count); })};
+        double transform {throughput(count, repeats, [&]() {
+            simd::transform(matrices.data(), vectors.data(), transformed.data(), count); })};
+        double randoms {throughput(count, repeats, [&]() { random.uniform(sines.data(), count, 0.0f, 1.0f); })};
+        double sinCos {throughput(count, repeats, [&]() {
+            simd::sinCos(px.data(), sines.data(), cosines.data(), count); })};
+        double asteroids {throughput(count, repeats, [&]() { field.update(1.0f, matrices.data()); })};
+        checksum += products[count / 2][3][0] + transformed[count / 3].x + cosines[count / 4] + matrices[count - 1][3][2];
+        std::cout << std::left << std::setw(8) << simd::isaName(isa) << std::setprecision(1)
+                  << std::setw(12) << compose << std::setw(12) << multiply << std::setw(12) << transform
+                  << std::setw(12) << randoms << std::setw(12) << sinCos << asteroids
+                  << std::setprecision(3) << std::endl;
+    }
+    simd::setIsa(simd::supportedIsa());
+    std::cout << std::endl << "checksum " << checksum << std::endl;
+}
+
+void benchmarkThreads(const Options& options) {
+    sjd::AsteroidField field {options.rocks};
+    std::vector<glm::mat4> models(options.rocks);
+    unsigned int cores {std::max(1u, std::thread::hardware_concurrency())};
+    unsigned int frames {std::max(1u, options.iterations / 4)};
+
+    std::cout << options.rocks << " asteroids, " << sjd::simd::isaName(sjd::simd::activeIsa())
+              << ", " << frames << " frames" << std::endl;
+    std::cout << std::left << std::setw(10) << "threads" << std::setw(12) << "mean_ms"
+              << std::setw(12) << "p95_ms" << "speedup" << std::endl;
+    double single {0.0};
+    float checksum {0.0f};
+    for (unsigned int threads = 1; ; threads = std::min(threads * 2, cores)) {
+        sjd::WorkerPool pool {threads};
+        sjd::FrameStats times {};
+        for (unsigned int frame = 0; frame < frames; frame++) {
+            float time {frame / 60.0f};
+            auto start {std::chrono::steady_clock::now()};
+            pool.parallelFor(options.rocks, 4096, [&](size_t first, size_t count) {
+                field.update(time, models.data() + first, first, count);
+            });
+            auto end {std::chrono::steady_clock::now()};
+            times.add(std::chrono::duration<double, std::milli>(end - start).count());
+            checksum += models[frame % options.rocks][3][0];
+        }
+        if (threads == 1) single = times.mean();
+        std::cout << std::left << std::setw(10) << threads << std::setw(12) << times.mean()
+                  << std::setw(12) << times.percentile(95.0)
+                  << ((times.mean() > 0.0) ? single / times.mean() : 0.0) << std::endl;
+        if (threads == cores) break;
+    }
+    std::cout << std::endl << "checksum " << checksum << std::endl;
+}
+
+void benchmarkOcclusion(const Options& options) {
+    // blocks 3 wide on a 6 unit grid with streets between, like the city scene
+    std::mt19937 random {11};
+    std::uniform_real_distribution<float> height {2.0f, 12.0f};
+    int side {std::max(1, static_cast<int>(std::sqrt(static_cast<double>(options.occluders))))};
+    const sjd::AABB unitBox {glm::vec3(-1.0f), glm::vec3(1.0f)};
+    std::vector<glm::mat4> buildings;
+    std::vector<sjd::AABB> boxes;
+    for (int x = -side / 2; x < side - side / 2; x++) {
+        for (int z = -side / 2; z < side - side / 2; z++) {
+            float h {height(random)};
+            glm::mat4 model {glm::translate(glm::mat4(1.0f), glm::vec3(x * 6.0f, h - 0.5f, z * 6.0f))};
+            model = glm::scale(model, glm::vec3(1.5f, h, 1.5f));
+            buildings.push_back(model);
+            boxes.push_back(unitBox.transformed(model));
+        }
+    }
+    glm::mat4 projection {glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f)};
+    const std::pair<const char*, glm::mat4> views[] {
+        {"street", projection * glm::lookAt(glm::vec3(3.0f, 1.7f, side * 3.0f), glm::vec3(3.0f, 1.7f, 0.0f),
+                                            glm::vec3(0.0f, 1.0f, 0.0f))},
+        {"above",  projection * glm::lookAt(glm::vec3(side * 2.0f, 40.0f, side * 2.0f), glm::vec3(0.0f),
+                                            glm::vec3(0.0f, 1.0f, 0.0f))},
+    };
+    unsigned int cores {std::max(1u, std::thread::hardware_concurrency())};
+    unsigned int frames {std::max(1u, options.iterations / 4)};
+    namespace simd = sjd::simd;
+
+    std::cout << buildings.size() << " box occluders, " << frames << " frames" << std::endl;
+    std::cout << std::left << std::setw(8) << "view" << std::setw(8) << "isa" << std::setw(10) << "threads"
+              << std::setw(12) << "triangles" << std::setw(12) << "raster_ms" << std::setw(12) << "test_ms"
+              << std::setw(12) << "tris/ms" << "culled" << std::endl;
+    float checksum {0.0f};
+    for (const std::pair<const char*, glm::mat4>& view : views) {
+        for (simd::Isa isa : {simd::Isa::SCALAR, simd::Isa::SSE2, simd::Isa::AVX2}) {
+            if (static_cast<int>(isa) > static_cast<int>(simd::supportedIsa())) break;
+            simd::setIsa(isa);
+            for (unsigned int threads : {1u, cores}) {
+                sjd::WorkerPool pool {threads};
+                sjd::SoftwareOcclusion occlusion {pool};
+                for (const glm::mat4& model : buildings) occlusion.addOccluder(unitBox, model);
+                sjd::FrameStats raster {};
+                sjd::FrameStats test {};
+                for (unsigned int frame = 0; frame < frames; frame++) {
+                    occlusion.render(view.second);
+                    occlusion.test(boxes);
+                    raster.add(occlusion.rasterMs());
+                    test.add(occlusion.testMs());
+                }
+                double triangles {static_cast<double>(occlusion.trianglesRasterized())};
+                checksum += occlusion.depth()[occlusion.depth().size() / 2];
+                std::cout << std::left << std::setw(8) << view.first << std::setw(8) << simd::isaName(isa)
+                          << std::setw(10) << threads << std::setw(12) << std::setprecision(0) << triangles
+                          << std::setprecision(3) << std::setw(12) << raster.mean() << std::setw(12) << test.mean()
+                          << std::setw(12) << std::setprecision(0) << ((raster.mean() > 0.0) ? triangles / raster.mean() : 0.0)
+                          << std::setprecision(1) << 100.0 * occlusion.occludedCount() / boxes.size() << "%"
+                          << std::setprecision(3) << std::endl;
+                if (threads == cores) break;
+            }
+        }
+    }
+    simd::setIsa(simd::supportedIsa());
+    std::cout << std::endl << "checksum " << checksum << std::endl;
+}
+
+void benchmarkPostProcess(const Options& options) {
+    const std::pair<unsigned int, unsigned int> sizes[] {{1920, 1080}, {3840, 2160}};
+    unsigned int cores {std::max(1u, std::thread::hardware_concurrency())};
+    unsigned int frames {std::max(1u, options.iterations / 40)};
+    auto makeStack {[](bool fuse) {
+        sjd::PostProcessSettings settings {};
+        settings.fuse = fuse;
+        auto stack {std::make_unique<sjd::PostProcessStack>(settings)};
+        stack->addKernel(sjd::PostProcessStack::sharpen());
+        stack->addTonemap(1.2f);
+        stack->addColourGrade(glm::vec3(1.05f, 1.0f, 0.95f), 1.1f, 1.05f);
+        stack->addVignette(0.4f, 0.5f);
+        stack->addGamma(2.2f);
+        return stack;
+    }};
+    std::unique_ptr<sjd::PostProcessStack> separate {makeStack(false)};
+    std::unique_ptr<sjd::PostProcessStack> fused {makeStack(true)};
+
+    std::cout << separate->effectCount() << " effects as " << separate->passCount() << " passes and as "
+              << fused->passCount() << ", float RGBA, " << frames << " frames" << std::endl;
+    std::cout << std::left << std::setw(12) << "size" << std::setw(10) << "passes" << std::setw(10) << "threads"
+              << std::setw(12) << "mean_ms" << std::setw(12) << "mpixels/s" << std::setw(12) << "traffic_mb"
+              << "max_diff" << std::endl;
+    std::mt19937 random {5};
+    std::uniform_real_distribution<float> radiance {0.0f, 4.0f};
+    float checksum {0.0f};
+    for (const std::pair<unsigned int, unsigned int>& size : sizes) {
+        size_t pixels {static_cast<size_t>(size.first) * size.second};
+        std::vector<glm::vec4> frame(pixels);
+        for (glm::vec4& pixel : frame) pixel = glm::vec4(radiance(random), radiance(random), radiance(random), 1.0f);
+        std::vector<glm::vec4> reference;
+        std::vector<glm::vec4> result;
+        for (unsigned int threads : {1u, cores}) {
+            sjd::WorkerPool pool {threads};
+            for (sjd::PostProcessStack* stack : {separate.get(), fused.get()}) {
+                sjd::FrameStats times {};
+                for (unsigned int i = 0; i < frames; i++) {
+                    auto start {std::chrono::steady_clock::now()};
+                    stack->process(frame, result, size.first, size.second, &pool);
+                    auto end {std::chrono::steady_clock::now()};
+                    times.add(std::chrono::duration<double, std::milli>(end - start).count());
+                }
+                // every pass reads and writes the whole frame once (kernel taps mostly hit cache)
+                double traffic {2.0 * stack->passCount() * pixels * sizeof(glm::vec4) / 1.0e6};
+                float difference {0.0f};
+                if (stack == separate.get()) reference = result;
+                for (size_t p = 0; p < pixels; p++) {
+                    glm::vec4 delta {glm::abs(result[p] - reference[p])};
+                    difference = std::max({difference, delta.x, delta.y, delta.z});
+                }
+                checksum += result[pixels / 2].x;
+                std::cout << std::left << std::setw(12) << (std::to_string(size.first) + "x" + std::to_string(size.second))
+                          << std::setw(10) << stack->passCount() << std::setw(10) << threads
+                          << std::setw(12) << times.mean() << std::setw(12) << std::setprecision(1)
+                          << ((times.mean() > 0.0) ? pixels / times.mean() / 1.0e3 : 0.0)
+                          << std::setw(12) << traffic << std::setprecision(6) << difference
+                          << std::setprecision(3) << std::endl;
+            }
+            if (threads == cores) break;
+        }
+    }
+    std::cout << std::endl << "checksum " << checksum << std::endl;
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg {argv[i]};
+        bool hasValue {i + 1 < argc};
+        if (arg == "--nodes" && hasValue) options.nodes = std::stoul(argv[++i]);
+        else if (arg == "--iterations" && hasValue) options.iterations = std::stoul(argv[++i]);
+        else if (arg == "--batch" && hasValue) options.batch = std::stoul(argv[++i]);
+        else if (arg == "--rocks" && hasValue) options.rocks = std::stoul(argv[++i]);
+        else if (arg == "--occluders" && hasValue) options.occluders = std::stoul(argv[++i]);
+        else {
+            std::cout << "ERROR::TRANSFORM_BENCH::BAD_ARGUMENT " << arg << std::endl;
+            std::cout << "usage: transform_bench [--nodes N] [--iterations N] [--batch N] [--rocks N] [--occluders N]"
+                      << std::endl;
+            return false;
+        }
+    }
+    if (options.nodes == 0 || options.iterations == 0 || options.batch == 0 || options.rocks == 0
+        || options.occluders == 0) {
+        std::cout << "ERROR::TRANSFORM_BENCH::EMPTY_RUN" << std::endl;
+        return false;
+    }
+    return true;
+}
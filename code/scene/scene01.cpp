@@ -1,4 +1,6 @@
 #include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include <glad/glad.h>
@@ -13,6 +15,7 @@
 #include <sjd/shader.h>
 #include <sjd/camera.h>
 #include <sjd/player.h>
+#include <sjd/input.h>
 #include <sjd/texture.h>
 #include <sjd/light.h>
 #include <sjd/meshes/cube.h>
@@ -28,7 +31,7 @@ namespace globals {
 
 void bonus_processInput(GLFWwindow* window);
 
-int main(void) {
+int main(int argc, char** argv) {
 
     // INIT WINDOW
     GLFWwindow* window {sjd::createCoreWindow(globals::windowWidth, globals::windowHeight, 4)};
@@ -42,6 +45,18 @@ int main(void) {
     // INIT PLAYER
     sjd::Camera playerCamera({0, 2.0f, 3});
     sjd::Player player(window, playerCamera);
+
+    // usage: --record <file> to capture this flythrough, --replay <file> to play one back
+    std::unique_ptr<sjd::InputRecorder> recorder;
+    std::unique_ptr<sjd::InputReplay> replay;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == "--record")
+            recorder = std::make_unique<sjd::InputRecorder>(argv[i + 1], playerCamera);
+        else if (std::string(argv[i]) == "--replay")
+            replay = std::make_unique<sjd::InputReplay>(argv[i + 1]);
+    }
+    if (recorder) player.setRecorder(recorder.get());
+    if (replay) player.setInput(replay.get());
     // ---
 
     // SHADERS
@@ -88,6 +103,7 @@ int main(void) {
 
         // PLAYER INPUTS
         player.processInput(timing.getDeltaTime());
+        if (player.inputFinished()) glfwSetWindowShouldClose(window, true);
         bonus_processInput(window);
 
         // ARRANGE SCENE
@@ -1,4 +1,6 @@
 #include <cstdint>
+#include <memory>
+#include <string>
 #include <ostream>
 
 #include <glad/glad.h>
@@ -13,11 +15,16 @@
 #include <sjd/shader.h>
 #include <sjd/camera.h>
 #include <sjd/player.h>
+#include <sjd/input.h>
 #include <sjd/texture.h>
-#include <sjd/framebuffer.h>
+#include <sjd/shadow_cascades.h>
+#include <sjd/shadow_atlas.h>
 #include <sjd/skybox.h>
 #include <sjd/light.h>
 #include <sjd/scene.h>
+#include <sjd/dynamic_resolution.h>
+#include <sjd/hdr_pipeline.h>
+#include <sjd/transform_hierarchy.h>
 #include <sjd/meshes/cube.h>
 #include <sjd/meshes/quad.h>
 
@@ -26,11 +33,16 @@ namespace globals {
     constexpr uint32_t windowHeight {900};
     bool actionKeyDown = false;
     bool shadowMapping = true;
+    unsigned int shadowCascades = 4;
+    bool hdrKeyDown = false;
+    bool hdr = true;
+    bool resolutionKeyDown = false;
+    bool dynamicResolution = true;
 }
 
 void bonus_processInput(GLFWwindow* window);
 
-int main(void) {
+int main(int argc, char** argv) {
 
     // INIT WINDOW
     GLFWwindow* window {sjd::createCoreWindow(globals::windowWidth, globals::windowHeight, 4)};
@@ -46,6 +58,18 @@ int main(void) {
     // INIT PLAYER
     sjd::Camera playerCamera({-1.0f, 2.0f, 5.0f});
     sjd::Player player(window, playerCamera);
+
+    // usage: --record <file> to capture this flythrough, --replay <file> to play one back
+    std::unique_ptr<sjd::InputRecorder> recorder;
+    std::unique_ptr<sjd::InputReplay> replay;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == "--record")
+            recorder = std::make_unique<sjd::InputRecorder>(argv[i + 1], playerCamera);
+        else if (std::string(argv[i]) == "--replay")
+            replay = std::make_unique<sjd::InputReplay>(argv[i + 1]);
+    }
+    if (recorder) player.setRecorder(recorder.get());
+    if (replay) player.setInput(replay.get());
     // ---
 
     // SHADERS
@@ -64,7 +88,9 @@ int main(void) {
     // ---
 
     // FRAMEBUFFERS
-    sjd::FBTexture depthMap(globals::windowWidth, globals::windowHeight);
+    // 1-4 switch the number of cascades at runtime
+    sjd::ShadowCascades depthMap({globals::shadowCascades, 2048});
+    sjd::ShadowAtlas shadowAtlas {};
     // ---
 
     // SKYBOX
@@ -85,20 +111,27 @@ int main(void) {
     sjd::Cube cube03(cube01);
 
     // ARRANGE SCENE
-    cube01.move(glm::vec3(0, 1.5f, 0));
-    cube01.scale(glm::vec3(0.5f));
-    cube02.move(glm::vec3(2, 0.5f, 1));
-    cube02.scale(glm::vec3(0.5f));
+    // the moving cubes are driven through a transform hierarchy
+    sjd::TransformHierarchy transforms {};
+    sjd::TransformHierarchy::Node cube01Node {transforms.create()};
+    sjd::TransformHierarchy::Node cube02Node {transforms.create()};
+    transforms.setPosition(cube01Node, glm::vec3(0, 1.5f, 0));
+    transforms.setScale(cube01Node, glm::vec3(0.5f));
+    transforms.setPosition(cube02Node, glm::vec3(2, 0.5f, 1));
+    transforms.setScale(cube02Node, glm::vec3(0.5f));
     cube03.move(glm::vec3(-1, 0, 2));
     cube03.rotateX(glm::radians(30.0f));
     cube03.rotateZ(glm::radians(30.0f));
     cube03.scale(glm::vec3(0.25f));
+    // only cube01 and cube02 move, everything else can keep its cached shadow
+    cube03.setStatic(true);
 
     sjd::Quad floor({-25,-0.5,25},
                     {25,-0.5,25},
                     {25,-0.5,-25},
                     {-25,-0.5,-25});
     floor.setDiffuseMap(&floorDiffuseMap);
+    floor.setStatic(true);
     sjd::Scene scene({cube01,
                       cube02,
                       cube03,
@@ -111,7 +144,24 @@ int main(void) {
     dirLight.enableShadowMap(&depthShader, &depthMap);
     scene.setDirLight(&dirLight);
 
+    sjd::PointLight pointLight01({1.5f, 1.0f, -1.5f}, glm::vec3(1.0f, 0.6f, 0.3f), true);
+    sjd::PointLight pointLight02({-2.0f, 1.5f, 1.0f}, glm::vec3(0.3f, 0.5f, 1.0f), true);
+    pointLight01.enableShadows();
+    pointLight02.enableShadows();
+    scene.setPointLights({pointLight01, pointLight02});
+    scene.setPointShadows(&shadowAtlas, &depthShader);
+
+    // drawn in HDR with bloom, then tonemapped to the window; H switches back
+    // to drawing straight to the window
+    sjd::HdrPipeline hdr;
+    // drawn at less than full resolution when the GPU can't keep up with the
+    // frame limit; R switches it off
+    sjd::DynamicResolutionSettings resolutionSettings;
+    resolutionSettings.targetFrameMs = 1000.0f * timing.getFrameTime();
+    sjd::DynamicResolution resolution {resolutionSettings};
+
     // RENDER LOOP
+    unsigned int frame {0};
     while(!glfwWindowShouldClose(window)) {
         // TIMING
         timing.processTiming();
@@ -119,20 +169,25 @@ int main(void) {
 
         // PLAYER INPUTS
         player.processInput(timing.getDeltaTime());
+        if (player.inputFinished()) glfwSetWindowShouldClose(window, true);
         bonus_processInput(window);
         if (globals::shadowMapping)
             dirLight.enableShadowMap(&depthShader, &depthMap);
         else dirLight.disableShadowMap();
+        if (depthMap.count() != globals::shadowCascades) {
+            sjd::ShadowCascadeSettings settings {depthMap.settings()};
+            settings.count = globals::shadowCascades;
+            depthMap.setSettings(settings);
+        }
 
         // MOVE OBJECTS
-        cube01.reset();
-        cube01.move(glm::vec3(0, 1.5f + 1.5f*sinf(0.5f*static_cast<float>(glfwGetTime())), 0));
-        cube01.scale(glm::vec3(0.5f));
-        cube02.reset();
-        cube02.move(glm::vec3(2, 0.5f, 1));
-        cube02.rotateX(static_cast<float>(glfwGetTime()));
-        cube02.rotateZ(static_cast<float>(glfwGetTime()));
-        cube02.scale(glm::vec3(0.5f));
+        float time {static_cast<float>(glfwGetTime())};
+        transforms.setPosition(cube01Node, glm::vec3(0, 1.5f + 1.5f*sinf(0.5f*time), 0));
+        transforms.setRotation(cube02Node, glm::angleAxis(time, glm::vec3(1.0f, 0.0f, 0.0f))
+                                         * glm::angleAxis(time, glm::vec3(0.0f, 0.0f, 1.0f)));
+        transforms.update();
+        if (transforms.changed(cube01Node)) cube01.setModel(transforms.world(cube01Node));
+        if (transforms.changed(cube02Node)) cube02.setModel(transforms.world(cube02Node));
 
         // CLEAR BUFFERS
         glClearColor(0.01f, 0.01f, 0.01f, 1.0f);
@@ -147,7 +202,34 @@ int main(void) {
         scene.m_viewPos = playerCamera.pos;
 
         // Draw objects
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        unsigned int drawWidth {static_cast<unsigned int>(framebufferWidth)};
+        unsigned int drawHeight {static_cast<unsigned int>(framebufferHeight)};
+        if (globals::dynamicResolution) {
+            resolution.begin(drawWidth, drawHeight, glm::vec4(0.01f, 0.01f, 0.01f, 1.0f));
+            drawWidth = resolution.width();
+            drawHeight = resolution.height();
+        }
+        if (globals::hdr) hdr.begin(drawWidth, drawHeight, glm::vec4(glm::vec3(0.0001f), 1.0f));
         scene.draw(shader);
+        if (globals::hdr) hdr.end();
+        if (globals::dynamicResolution) resolution.end();
+
+        // report the shadow pass cost about once a second
+        if (++frame % 60 == 0) {
+            std::string title {"LearnOpenGL: scene02 | " + std::to_string(depthMap.count())
+                               + " cascades, shadow pass " + std::to_string(scene.shadowPassMs()) + " ms"
+                               + ", point shadows " + std::to_string(scene.pointShadowPassMs()) + " ms"};
+            if (globals::hdr) {
+                title += ", bloom " + std::to_string(hdr.downsampleMs() + hdr.upsampleMs()) + " ms"
+                       + ", tonemap " + std::to_string(hdr.compositeMs()) + " ms";
+            }
+            if (globals::dynamicResolution) {
+                title += ", resolution " + std::to_string(static_cast<int>(100.0f * resolution.scale() + 0.5f)) + "%";
+            }
+            glfwSetWindowTitle(window, title.c_str());
+        }
 
         // End Frame Processing
         glfwSwapBuffers(window);
@@ -172,5 +254,24 @@ void bonus_processInput(GLFWwindow* window) {
         // Do action here...
         globals::shadowMapping = !globals::shadowMapping;
     }
+    if (glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS) {
+        globals::hdrKeyDown = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_H) == GLFW_RELEASE && globals::hdrKeyDown) {
+        globals::hdrKeyDown = false;
+        globals::hdr = !globals::hdr;
+    }
+    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS) {
+        globals::resolutionKeyDown = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_RELEASE && globals::resolutionKeyDown) {
+        globals::resolutionKeyDown = false;
+        globals::dynamicResolution = !globals::dynamicResolution;
+    }
+    for (unsigned int count = 1; count <= sjd::ShadowCascades::maxCascades; count++) {
+        if (glfwGetKey(window, GLFW_KEY_0 + count) == GLFW_PRESS) {
+            globals::shadowCascades = count;
+        }
+    }
 
 }
@@ -0,0 +1,91 @@
+#version 330 core
+// blinn_phong16.frag.glsl with the point lights read from a texture buffer
+// (sjd::PointLightBuffer) instead of a fixed array, so forward shading can be
+// compared with sjd::DeferredShading at any light count. Lights fade out at
+// their range as the deferred light volumes do.
+in vec2 texCoords;
+in vec3 fragNormal;
+in vec3 fragPos;
+
+out vec4 FragColor;
+
+struct Material {
+    sampler2D diffuse;
+    sampler2D specular;
+    float shininess;
+};
+
+struct DirLight {
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+uniform vec3 viewPos;
+uniform DirLight dirLight;
+uniform Material material;
+uniform samplerBuffer pointLightData;
+uniform int numPointLights;
+
+vec3 calcDirLight(DirLight light, vec3 normal, vec3 viewDir);
+vec3 calcPointLight(int index, vec3 normal, vec3 viewDir);
+
+void main()
+{
+    // properties
+    vec3 norm = normalize(fragNormal);
+    vec3 viewDir = normalize(viewPos - fragPos);
+
+    // phase 1: Directional lighting
+    vec3 dirResult = calcDirLight(dirLight, norm, viewDir);
+    // point lighting
+    vec3 pointResult = vec3(0.0);
+    for (int i = 0; i < numPointLights; i++) {
+        pointResult += calcPointLight(i, norm, viewDir);
+    }
+    FragColor = vec4(dirResult + pointResult, 1.0);
+}
+
+vec3 calcDirLight(DirLight light, vec3 normal, vec3 viewDir)
+{
+    vec3 lightDir = normalize(-light.direction);
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
+    // combine results
+    vec3 ambient = light.ambient * vec3(texture(material.diffuse, texCoords));
+    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, texCoords));
+    vec3 specular = light.specular * spec * vec3(texture(material.specular, texCoords).r);
+    return (ambient + diffuse + specular);
+}
+
+vec3 calcPointLight(int index, vec3 normal, vec3 viewDir) {
+    // layout from PointLight::packed()
+    vec4 positionRange = texelFetch(pointLightData, index * 4);
+    float distance = length(positionRange.xyz - fragPos);
+    if (distance >= positionRange.w) return vec3(0.0);
+    vec4 ambientConstant = texelFetch(pointLightData, index * 4 + 1);
+    vec4 diffuseLinear = texelFetch(pointLightData, index * 4 + 2);
+    vec4 specularQuadratic = texelFetch(pointLightData, index * 4 + 3);
+
+    vec3 lightDir = (positionRange.xyz - fragPos) / distance;
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
+    // attenuation
+    float attenuation = 1.0 /
+            (ambientConstant.w + diffuseLinear.w * distance + specularQuadratic.w * (distance * distance));
+    float window = clamp(1.0 - pow(distance / positionRange.w, 4.0), 0.0, 1.0);
+    attenuation *= window * window;
+    // combine results
+    vec3 ambient = ambientConstant.rgb * vec3(texture(material.diffuse, texCoords));
+    vec3 diffuse = diffuseLinear.rgb * diff * vec3(texture(material.diffuse, texCoords));
+    vec3 specular = specularQuadratic.rgb * spec * vec3(texture(material.specular, texCoords).r);
+    return (ambient + diffuse + specular) * attenuation;
+}
@@ -0,0 +1,49 @@
+#version 330 core
+// One step down sjd::HdrPipeline's bloom chain, drawn with
+// deferred_fullscreen.vert.glsl into a target half the size of `source`.
+// 13 taps: a 4x4 box at the centre and four overlapping 2x2 boxes around it,
+// which downsamples without the shimmer a plain 2x2 box gives moving highlights.
+// The first step weights each box by 1 / (1 + luma) (Karis' average) so single
+// very bright pixels don't bloom into flickering blobs.
+out vec4 FragColor;
+
+uniform sampler2D source;
+uniform vec2 outputSize;
+uniform bool karisAverage;
+
+float karisWeight(vec3 colour)
+{
+    return 1.0 / (1.0 + dot(colour, vec3(0.2126, 0.7152, 0.0722)));
+}
+
+vec3 box(vec3 a, vec3 b, vec3 c, vec3 d)
+{
+    vec3 average = (a + b + c + d) * 0.25;
+    return karisAverage ? average * karisWeight(average) : average;
+}
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy / outputSize;
+    vec2 texel = 1.0 / vec2(textureSize(source, 0));
+    float x = texel.x;
+    float y = texel.y;
+
+    vec3 a = texture(source, uv + vec2(-2.0 * x,  2.0 * y)).rgb;
+    vec3 b = texture(source, uv + vec2( 0.0,      2.0 * y)).rgb;
+    vec3 c = texture(source, uv + vec2( 2.0 * x,  2.0 * y)).rgb;
+    vec3 d = texture(source, uv + vec2(-2.0 * x,  0.0)).rgb;
+    vec3 e = texture(source, uv).rgb;
+    vec3 f = texture(source, uv + vec2( 2.0 * x,  0.0)).rgb;
+    vec3 g = texture(source, uv + vec2(-2.0 * x, -2.0 * y)).rgb;
+    vec3 h = texture(source, uv + vec2( 0.0,     -2.0 * y)).rgb;
+    vec3 i = texture(source, uv + vec2( 2.0 * x, -2.0 * y)).rgb;
+    vec3 j = texture(source, uv + vec2(-x,  y)).rgb;
+    vec3 k = texture(source, uv + vec2( x,  y)).rgb;
+    vec3 l = texture(source, uv + vec2(-x, -y)).rgb;
+    vec3 m = texture(source, uv + vec2( x, -y)).rgb;
+
+    vec3 colour = box(j, k, l, m) * 0.5
+                + (box(a, b, d, e) + box(b, c, e, f) + box(d, e, g, h) + box(e, f, h, i)) * 0.125;
+    FragColor = vec4(max(colour, vec3(0.0001)), 1.0);
+}
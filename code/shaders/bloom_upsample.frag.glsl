@@ -0,0 +1,28 @@
+#version 330 core
+// One step up sjd::HdrPipeline's bloom chain, drawn with
+// deferred_fullscreen.vert.glsl and added (GL_ONE, GL_ONE) into the level twice
+// the size of `source`: a 3x3 tent filter `filterRadius` texels of `source` wide.
+out vec4 FragColor;
+
+uniform sampler2D source;
+uniform vec2 outputSize;
+uniform float filterRadius;
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy / outputSize;
+    vec2 r = filterRadius / vec2(textureSize(source, 0));
+
+    vec3 a = texture(source, uv + vec2(-r.x,  r.y)).rgb;
+    vec3 b = texture(source, uv + vec2( 0.0,  r.y)).rgb;
+    vec3 c = texture(source, uv + vec2( r.x,  r.y)).rgb;
+    vec3 d = texture(source, uv + vec2(-r.x,  0.0)).rgb;
+    vec3 e = texture(source, uv).rgb;
+    vec3 f = texture(source, uv + vec2( r.x,  0.0)).rgb;
+    vec3 g = texture(source, uv + vec2(-r.x, -r.y)).rgb;
+    vec3 h = texture(source, uv + vec2( 0.0, -r.y)).rgb;
+    vec3 i = texture(source, uv + vec2( r.x, -r.y)).rgb;
+
+    vec3 colour = e * 4.0 + (b + d + f + h) * 2.0 + (a + c + g + i);
+    FragColor = vec4(colour / 16.0, 1.0);
+}
@@ -4,7 +4,6 @@ in VS_OUT {
     vec3 fragNormal;
     vec3 fragPos;
     vec2 texCoords;
-    vec4 fragPosLightSpace;
 } fs_in;
 
 out vec4 FragColor;
@@ -34,10 +33,30 @@ struct PointLight {
     float constant;
     float linear;
     float quadratic;
+
+    int shadow;     // slot in the point shadow atlas, -1 for none
 };
 const int NUM_POINT_LIGHTS = 16;
-
-uniform sampler2D shadowMap;
+const int MAX_CASCADES = 4;
+const int MAX_SHADOWED_POINT_LIGHTS = 8;
+
+// cube face bases, matching sjd::ShadowAtlas::faceView (+X, -X, +Y, -Y, +Z, -Z)
+const vec3 POINT_SHADOW_FORWARD[6] = vec3[](vec3( 1, 0, 0), vec3(-1, 0, 0), vec3(0,  1, 0),
+                                            vec3(0, -1, 0), vec3( 0, 0, 1), vec3(0,  0, -1));
+const vec3 POINT_SHADOW_RIGHT[6]   = vec3[](vec3( 0, 0, -1), vec3( 0, 0, 1), vec3(1, 0, 0),
+                                            vec3( 1, 0,  0), vec3( 1, 0, 0), vec3(-1, 0, 0));
+const vec3 POINT_SHADOW_UP[6]      = vec3[](vec3( 0, -1, 0), vec3( 0, -1, 0), vec3(0, 0, 1),
+                                            vec3( 0,  0, -1), vec3( 0, -1, 0), vec3(0, -1, 0));
+
+uniform sampler2DArray shadowMap;
+uniform int cascadeCount;
+uniform float cascadeSplits[MAX_CASCADES];      // view space depth each cascade ends at
+uniform float cascadeDepthBias[MAX_CASCADES];
+uniform mat4 lightSpaceMatrices[MAX_CASCADES];
+uniform mat4 view;
+uniform sampler2D pointShadowAtlas;
+uniform vec4 pointShadowTiles[MAX_SHADOWED_POINT_LIGHTS * 6];  // atlas uv x, y, uv size, texels
+uniform vec2 pointShadowPlanes[MAX_SHADOWED_POINT_LIGHTS];      // near, far
 uniform vec3 viewPos;
 uniform DirLight dirLight;
 uniform PointLight pointLights[NUM_POINT_LIGHTS];
@@ -46,14 +65,15 @@ uniform int numPointLights;
 
 vec3 calcDirLight(DirLight light, vec3 normal, vec3 viewDir, float shadow);
 vec3 calcPointLight(PointLight light, vec3 normal, vec3 viewDir);
-float ShadowCalculation(vec4 fragPosLightSpace);
+float ShadowCalculation(vec3 fragPos, vec3 normal);
+float PointShadowCalculation(int slot, vec3 lightPos, vec3 fragPos);
 
 void main()
 {
     // properties
     vec3 norm = normalize(fs_in.fragNormal);
     vec3 viewDir = normalize(viewPos - fs_in.fragPos);
-    float shadow = ShadowCalculation(fs_in.fragPosLightSpace);
+    float shadow = ShadowCalculation(fs_in.fragPos, norm);
 
     // phase 1: Directional lighting
     vec3 dirResult = calcDirLight(dirLight, norm, viewDir, shadow);
@@ -100,32 +120,92 @@ vec3 calcPointLight(PointLight light, vec3 normal, vec3 viewDir) {
     ambient *= attenuation;
     diffuse *= attenuation;
     specular *= attenuation;
-    return (ambient + diffuse + specular);
+    float shadow = (light.shadow >= 0) ? PointShadowCalculation(light.shadow, light.position, fs_in.fragPos) : 0.0;
+    return (ambient + (1.0 - shadow) * (diffuse + specular));
 }
 
-float ShadowCalculation(vec4 fragPosLightSpace) {
+float ShadowCalculation(vec3 fragPos, vec3 normal) {
+    // pick the first cascade that reaches this fragment's view depth
+    float depth = abs((view * vec4(fragPos, 1.0)).z);
+    if (cascadeCount == 0 || depth >= cascadeSplits[cascadeCount - 1]) {
+        return 0.0;
+    }
+    int layer = cascadeCount - 1;
+    for (int i = 0; i < cascadeCount; ++i) {
+        if (depth < cascadeSplits[i]) {
+            layer = i;
+            break;
+        }
+    }
+
     // perform perspective divide
+    vec4 fragPosLightSpace = lightSpaceMatrices[layer] * vec4(fragPos, 1.0);
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     projCoords = projCoords * 0.5 + 0.5; 
-    float closestDepth = texture(shadowMap, projCoords.xy).r;
+    if(projCoords.z > 1.0) {
+        return 0.0;
+    }
     float currentDepth = projCoords.z;
-    float bias = max(0.01 * (1.0 - dot(fs_in.fragNormal, normalize(-dirLight.direction))), 0.005);
-    // float shadow = currentDepth - bias > closestDepth ? 1.0 : 0.0;
+    // a texel's worth of bias, more on surfaces at a grazing angle to the light
+    float slope = 1.0 - max(dot(normal, normalize(-dirLight.direction)), 0.0);
+    float bias = cascadeDepthBias[layer] * (1.5 + 4.0 * slope);
     // PCF
     float shadow = 0.0;
-    vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
     for(int x = -1; x <= 1; ++x)
     {
         for(int y = -1; y <= 1; ++y)
         {
-            float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r; 
+            float pcfDepth = texture(shadowMap, vec3(projCoords.xy + vec2(x, y) * texelSize, layer)).r; 
             shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;        
         }    
     }
     shadow /= 9.0;
+    return shadow;
+}
 
-    if(projCoords.z > 1.0) {
-        shadow = 0.0;
+float PointShadowCalculation(int slot, vec3 lightPos, vec3 fragPos) {
+    // pick the cube face from the major axis of the light to fragment vector
+    vec3 toFrag = fragPos - lightPos;
+    vec3 absToFrag = abs(toFrag);
+    int face;
+    if (absToFrag.x >= absToFrag.y && absToFrag.x >= absToFrag.z) {
+        face = toFrag.x > 0.0 ? 0 : 1;
     }
-    return shadow;
+    else if (absToFrag.y >= absToFrag.z) {
+        face = toFrag.y > 0.0 ? 2 : 3;
+    }
+    else {
+        face = toFrag.z > 0.0 ? 4 : 5;
+    }
+    vec4 tile = pointShadowTiles[slot * 6 + face];
+    vec2 planes = pointShadowPlanes[slot];
+    float distance = dot(POINT_SHADOW_FORWARD[face], toFrag);
+    if (tile.w <= 0.0 || distance >= planes.y) {
+        return 0.0;     // face not rendered yet, or out of the light's reach
+    }
+
+    // the same 90 degree projection the face was rendered with
+    vec2 ndc = vec2(dot(POINT_SHADOW_RIGHT[face], toFrag), dot(POINT_SHADOW_UP[face], toFrag)) / distance;
+    float texelSize = tile.z / tile.w;
+    vec2 uv = tile.xy + (ndc * 0.5 + 0.5) * tile.z;
+    // stay a PCF kernel away from the neighbouring tiles
+    uv = clamp(uv, tile.xy + 1.5 * texelSize, tile.xy + tile.z - 1.5 * texelSize);
+
+    // bias by about a texel's footprint at this distance, then back to window depth
+    float biased = max(distance - 3.0 * distance / tile.w, planes.x);
+    float ndcDepth = (planes.y + planes.x) / (planes.y - planes.x)
+                     - 2.0 * planes.y * planes.x / ((planes.y - planes.x) * biased);
+    float currentDepth = ndcDepth * 0.5 + 0.5;
+    // PCF
+    float shadow = 0.0;
+    for(int x = -1; x <= 1; ++x)
+    {
+        for(int y = -1; y <= 1; ++y)
+        {
+            float pcfDepth = texture(pointShadowAtlas, uv + vec2(x, y) * texelSize).r;
+            shadow += currentDepth > pcfDepth ? 1.0 : 0.0;
+        }
+    }
+    return shadow / 9.0;
 }
@@ -0,0 +1,38 @@
+#version 430 core
+// One direction of sjd::GaussianBlur on a 4.3 context. A work group blurs a run
+// of 128 texels along the blur: it loads them and `radius` texels either side
+// into shared memory once, so every tap after that is a shared memory read
+// instead of a texture fetch.
+layout(local_size_x = 128) in;
+
+uniform sampler2D image;
+layout(binding = 0) writeonly uniform image2D result;
+uniform ivec2 direction;        // (1, 0) or (0, 1)
+uniform int radius;
+uniform float weights[65];      // for offsets 0 to radius, either side
+
+shared vec4 tile[128 + 2 * 64];
+
+void main()
+{
+    ivec2 across = ivec2(1) - direction;
+    int extent = int(dot(vec2(textureSize(image, 0)), vec2(direction)));
+    int runStart = int(gl_WorkGroupID.x) * 128;
+    int line = int(gl_WorkGroupID.y);
+    for (int i = int(gl_LocalInvocationID.x); i < 128 + 2 * radius; i += 128) {
+        int position = clamp(runStart + i - radius, 0, extent - 1);
+        tile[i] = texelFetch(image, direction * position + across * line, 0);
+    }
+    barrier();
+
+    int position = runStart + int(gl_LocalInvocationID.x);
+    if (position >= extent) {
+        return;
+    }
+    int centre = int(gl_LocalInvocationID.x) + radius;
+    vec4 colour = tile[centre] * weights[0];
+    for (int i = 1; i <= radius; i++) {
+        colour += (tile[centre - i] + tile[centre + i]) * weights[i];
+    }
+    imageStore(result, direction * position + across * line, colour);
+}
@@ -0,0 +1,22 @@
+#version 330 core
+// One direction of sjd::GaussianBlur, drawn with deferred_fullscreen.vert.glsl.
+// Neighbouring taps are merged into one bilinear fetch placed between them by
+// weight, so a radius r blur takes r / 2 + 1 fetches a side instead of r.
+out vec4 FragColor;
+
+uniform sampler2D image;
+uniform vec2 direction;         // one texel along the blur, in texture coordinates
+uniform float offsets[33];      // in texels; offsets[0] is the centre
+uniform float weights[33];
+uniform int tapCount;
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy / vec2(textureSize(image, 0));
+    vec4 colour = texture(image, uv) * weights[0];
+    for (int i = 1; i < tapCount; i++) {
+        vec2 offset = direction * offsets[i];
+        colour += (texture(image, uv + offset) + texture(image, uv - offset)) * weights[i];
+    }
+    FragColor = colour;
+}
@@ -0,0 +1,62 @@
+#version 330 core
+// Full screen pass of sjd::DeferredShading: the directional light, and the
+// G-buffer's depth copied into the target so later forward drawing can test
+// against it.
+out vec4 FragColor;
+
+struct DirLight {
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+uniform sampler2D gAlbedoSpec;
+uniform sampler2D gNormalShininess;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+uniform vec2 screenSize;
+uniform vec3 viewPos;
+uniform DirLight dirLight;
+uniform bool hasDirLight;
+
+vec3 decodeNormal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += (n.x >= 0.0) ? -t : t;
+    n.y += (n.y >= 0.0) ? -t : t;
+    return normalize(n);
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    // nothing drawn here, leave the background
+    if (depth == 1.0) discard;
+    gl_FragDepth = depth;
+
+    vec4 albedoSpec = texelFetch(gAlbedoSpec, pixel, 0);
+    vec4 normalShininess = texelFetch(gNormalShininess, pixel, 0);
+    if (!hasDirLight) {
+        FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+    vec4 ndc = vec4(gl_FragCoord.xy / screenSize * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec4 world = inverseViewProjection * ndc;
+    vec3 fragPos = world.xyz / world.w;
+
+    vec3 normal = decodeNormal(normalShininess.xy);
+    vec3 viewDir = normalize(viewPos - fragPos);
+    vec3 lightDir = normalize(-dirLight.direction);
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float diff = max(dot(normal, lightDir), 0.0);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), normalShininess.z * 256.0);
+    vec3 ambient = dirLight.ambient * albedoSpec.rgb;
+    vec3 diffuse = dirLight.diffuse * diff * albedoSpec.rgb;
+    vec3 specular = dirLight.specular * spec * albedoSpec.a;
+    FragColor = vec4(ambient + diffuse + specular, 1.0);
+}
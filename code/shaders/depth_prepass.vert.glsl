@@ -0,0 +1,17 @@
+#version 330 core
+// Depth pre-pass for sjd::Scene, with simple_depth_shader.frag.glsl. The
+// position maths matches lighting.vert.glsl exactly, and with both invariant
+// the colour pass can test GL_EQUAL against what this wrote.
+layout(location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+invariant gl_Position;
+
+void main()
+{
+    vec3 fragPos = vec3(model * vec4(aPos, 1.0));
+    gl_Position = projection * view * vec4(fragPos, 1.0);
+}
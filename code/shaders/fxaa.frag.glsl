@@ -0,0 +1,124 @@
+#version 330 core
+// sjd::PostAntiAliasing's FXAA pass, drawn with deferred_fullscreen.vert.glsl
+// into the output. Where the luma contrast around a pixel is high enough, it
+// works out whether the edge runs horizontally or vertically, walks along it
+// both ways to find its ends, and resamples half a pixel across the edge by as
+// much as the pixel's place along it calls for; lone bright pixels get a
+// smaller sub-pixel blend of their own.
+out vec4 FragColor;
+
+uniform sampler2D source;
+uniform vec2 outputSize;
+uniform bool linearInput;       // source is linear (sRGB decoded), so luma needs gamma
+
+const float edgeThresholdMin = 0.0312;
+const float edgeThresholdMax = 0.125;
+const float subpixelQuality = 0.75;
+const int searchSteps = 12;
+const float stepSizes[12] = float[](1.0, 1.0, 1.0, 1.0, 1.0, 1.5, 2.0, 2.0, 2.0, 2.0, 4.0, 8.0);
+
+float luma(vec3 colour)
+{
+    float l = dot(colour, vec3(0.299, 0.587, 0.114));
+    return linearInput ? sqrt(l) : l;
+}
+
+float lumaAt(vec2 uv)
+{
+    return luma(texture(source, uv).rgb);
+}
+
+void main()
+{
+    vec2 texel = 1.0 / outputSize;
+    vec2 uv = gl_FragCoord.xy * texel;
+    vec3 colour = texture(source, uv).rgb;
+
+    float lumaM = luma(colour);
+    float lumaN = lumaAt(uv + vec2(0.0, texel.y));
+    float lumaS = lumaAt(uv - vec2(0.0, texel.y));
+    float lumaE = lumaAt(uv + vec2(texel.x, 0.0));
+    float lumaW = lumaAt(uv - vec2(texel.x, 0.0));
+    float lowest = min(lumaM, min(min(lumaN, lumaS), min(lumaE, lumaW)));
+    float highest = max(lumaM, max(max(lumaN, lumaS), max(lumaE, lumaW)));
+    float range = highest - lowest;
+    if (range < max(edgeThresholdMin, highest * edgeThresholdMax)) {
+        FragColor = vec4(colour, 1.0);
+        return;
+    }
+
+    float lumaNE = lumaAt(uv + texel);
+    float lumaSW = lumaAt(uv - texel);
+    float lumaNW = lumaAt(uv + vec2(-texel.x, texel.y));
+    float lumaSE = lumaAt(uv + vec2(texel.x, -texel.y));
+
+    // which way the edge runs, from the second differences across each axis
+    float edgeHorizontal = abs(lumaNW + lumaSW - 2.0 * lumaW) + 2.0 * abs(lumaN + lumaS - 2.0 * lumaM)
+                         + abs(lumaNE + lumaSE - 2.0 * lumaE);
+    float edgeVertical = abs(lumaNW + lumaNE - 2.0 * lumaN) + 2.0 * abs(lumaW + lumaE - 2.0 * lumaM)
+                       + abs(lumaSW + lumaSE - 2.0 * lumaS);
+    bool horizontal = edgeHorizontal >= edgeVertical;
+
+    // and which side of this pixel it's on
+    float luma1 = horizontal ? lumaS : lumaW;
+    float luma2 = horizontal ? lumaN : lumaE;
+    float gradient1 = luma1 - lumaM;
+    float gradient2 = luma2 - lumaM;
+    bool steeper1 = abs(gradient1) >= abs(gradient2);
+    float gradientScaled = 0.25 * max(abs(gradient1), abs(gradient2));
+    float stepLength = horizontal ? texel.y : texel.x;
+    float lumaLocalAverage;
+    if (steeper1) {
+        stepLength = -stepLength;
+        lumaLocalAverage = 0.5 * (luma1 + lumaM);
+    }
+    else {
+        lumaLocalAverage = 0.5 * (luma2 + lumaM);
+    }
+
+    // walk both ways along the edge, half a pixel over, until the luma leaves it
+    vec2 edgeUv = uv;
+    if (horizontal) edgeUv.y += 0.5 * stepLength;
+    else edgeUv.x += 0.5 * stepLength;
+    vec2 along = horizontal ? vec2(texel.x, 0.0) : vec2(0.0, texel.y);
+    vec2 uv1 = edgeUv - along;
+    vec2 uv2 = edgeUv + along;
+    float lumaEnd1 = lumaAt(uv1) - lumaLocalAverage;
+    float lumaEnd2 = lumaAt(uv2) - lumaLocalAverage;
+    bool reached1 = abs(lumaEnd1) >= gradientScaled;
+    bool reached2 = abs(lumaEnd2) >= gradientScaled;
+    for (int i = 1; i < searchSteps && !(reached1 && reached2); i++) {
+        if (!reached1) {
+            uv1 -= along * stepSizes[i];
+            lumaEnd1 = lumaAt(uv1) - lumaLocalAverage;
+            reached1 = abs(lumaEnd1) >= gradientScaled;
+        }
+        if (!reached2) {
+            uv2 += along * stepSizes[i];
+            lumaEnd2 = lumaAt(uv2) - lumaLocalAverage;
+            reached2 = abs(lumaEnd2) >= gradientScaled;
+        }
+    }
+
+    float distance1 = horizontal ? (uv.x - uv1.x) : (uv.y - uv1.y);
+    float distance2 = horizontal ? (uv2.x - uv.x) : (uv2.y - uv.y);
+    bool nearer1 = distance1 < distance2;
+    float edgeLength = distance1 + distance2;
+    float pixelOffset = -min(distance1, distance2) / edgeLength + 0.5;
+
+    // only move towards the edge if the nearer end agrees about which side is darker
+    bool lumaMSmaller = lumaM < lumaLocalAverage;
+    bool correctVariation = ((nearer1 ? lumaEnd1 : lumaEnd2) < 0.0) != lumaMSmaller;
+    float finalOffset = correctVariation ? pixelOffset : 0.0;
+
+    // sub-pixel aliasing: how far this pixel is from the average of its neighbours
+    float lumaAverage = (2.0 * (lumaN + lumaS + lumaE + lumaW) + lumaNE + lumaNW + lumaSE + lumaSW) / 12.0;
+    float subpixel1 = clamp(abs(lumaAverage - lumaM) / range, 0.0, 1.0);
+    float subpixel2 = (-2.0 * subpixel1 + 3.0) * subpixel1 * subpixel1;
+    finalOffset = max(finalOffset, subpixel2 * subpixel2 * subpixelQuality);
+
+    vec2 finalUv = uv;
+    if (horizontal) finalUv.y += finalOffset * stepLength;
+    else finalUv.x += finalOffset * stepLength;
+    FragColor = vec4(texture(source, finalUv).rgb, 1.0);
+}
@@ -0,0 +1,35 @@
+#version 330 core
+// Geometry pass of sjd::DeferredShading, fed by lighting.vert.glsl.
+in vec2 texCoords;
+in vec3 fragNormal;
+in vec3 fragPos;
+
+layout(location = 0) out vec4 gAlbedoSpec;
+layout(location = 1) out vec4 gNormalShininess;
+
+struct Material {
+    sampler2D diffuse;
+    sampler2D specular;
+    float shininess;
+};
+
+uniform Material material;
+
+// unit vector to [0, 1]^2: the octahedron |x|+|y|+|z| = 1 unfolded into a square
+vec2 encodeNormal(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.xy;
+    if (n.z < 0.0) {
+        vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+        e = (1.0 - abs(n.yx)) * signs;
+    }
+    return e * 0.5 + 0.5;
+}
+
+void main()
+{
+    gAlbedoSpec = vec4(texture(material.diffuse, texCoords).rgb, texture(material.specular, texCoords).r);
+    // shininess up to 256 in the 10 bit blue channel
+    gNormalShininess = vec4(encodeNormal(normalize(fragNormal)), clamp(material.shininess / 256.0, 0.0, 1.0), 0.0);
+}
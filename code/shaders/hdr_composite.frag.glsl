@@ -0,0 +1,23 @@
+#version 330 core
+// sjd::HdrPipeline's last pass, drawn with deferred_fullscreen.vert.glsl: mix
+// the bloom into the HDR scene, then tonemap with an exposure. The result is
+// linear; with GL_FRAMEBUFFER_SRGB off it's gamma encoded here instead.
+out vec4 FragColor;
+
+uniform sampler2D hdr;
+uniform sampler2D bloom;
+uniform vec2 outputSize;
+uniform float exposure;
+uniform float bloomStrength;
+uniform bool encodeGamma;
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy / outputSize;
+    vec3 colour = mix(texture(hdr, uv).rgb, texture(bloom, uv).rgb, bloomStrength);
+    colour = vec3(1.0) - exp(-colour * exposure);
+    if (encodeGamma) {
+        colour = pow(colour, vec3(1.0 / 2.2));
+    }
+    FragColor = vec4(colour, 1.0);
+}
@@ -0,0 +1,68 @@
+#version 430 core
+// sjd::HiZCuller's occlusion test, one box per invocation; the same test as
+// HiZCuller::occluded().
+layout(local_size_x = 64) in;
+
+struct Box {
+    vec4 minimum;
+    vec4 maximum;
+};
+
+layout(std430, binding = 0) readonly buffer Boxes {
+    Box boxes[];
+};
+
+layout(std430, binding = 1) writeonly buffer Flags {
+    uint visible[];
+};
+
+uniform sampler2D pyramid;
+uniform mat4 viewProjection;
+uniform uint boxCount;
+uniform int levels;
+
+bool occluded(Box box)
+{
+    vec3 ndcMin = vec3(1.0e30);
+    vec3 ndcMax = vec3(-1.0e30);
+    for (int corner = 0; corner < 8; corner++) {
+        vec3 point = vec3((corner & 1) != 0 ? box.maximum.x : box.minimum.x,
+                          (corner & 2) != 0 ? box.maximum.y : box.minimum.y,
+                          (corner & 4) != 0 ? box.maximum.z : box.minimum.z);
+        vec4 clip = viewProjection * vec4(point, 1.0);
+        // reaching behind the camera, nothing to go on
+        if (clip.w <= 1.0e-5) return false;
+        vec3 ndc = clip.xyz / clip.w;
+        ndcMin = min(ndcMin, ndc);
+        ndcMax = max(ndcMax, ndc);
+    }
+    if (ndcMax.x < -1.0 || ndcMax.y < -1.0 || ndcMin.x > 1.0 || ndcMin.y > 1.0) return false;
+    float nearest = ndcMin.z * 0.5 + 0.5;
+    if (nearest <= 0.0) return false;
+
+    ivec2 baseSize = textureSize(pyramid, 0);
+    vec2 size = vec2(baseSize);
+    vec2 pixelMin = clamp(ndcMin.xy * 0.5 + 0.5, 0.0, 1.0) * size;
+    vec2 pixelMax = clamp(ndcMax.xy * 0.5 + 0.5, 0.0, 1.0) * size;
+    float extent = max(max(pixelMax.x - pixelMin.x, pixelMax.y - pixelMin.y), 1.0);
+    int level = min(int(ceil(log2(extent))), levels - 1);
+
+    ivec2 levelSize = max(baseSize >> level, ivec2(1));
+    float scale = 1.0 / float(1 << level);
+    ivec2 texelMin = min(ivec2(floor(pixelMin * scale)), levelSize - 1);
+    ivec2 texelMax = min(ivec2(floor(pixelMax * scale)), levelSize - 1);
+    float farthest = 0.0;
+    for (int y = texelMin.y; y <= texelMax.y; y++) {
+        for (int x = texelMin.x; x <= texelMax.x; x++) {
+            farthest = max(farthest, texelFetch(pyramid, ivec2(x, y), level).r);
+        }
+    }
+    return nearest > farthest;
+}
+
+void main()
+{
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= boxCount) return;
+    visible[index] = occluded(boxes[index]) ? 0u : 1u;
+}
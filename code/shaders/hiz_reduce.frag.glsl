@@ -0,0 +1,40 @@
+#version 330 core
+// One level of sjd::HiZCuller's depth pyramid, drawn with
+// deferred_fullscreen.vert.glsl: either a copy of the depth buffer, or the
+// farthest of the texels below this one in the previous level (which is the
+// only level `source` lets through).
+out vec4 FragColor;
+
+uniform sampler2D source;
+uniform bool copy;
+
+float fetch(ivec2 texel, ivec2 last)
+{
+    return texelFetch(source, min(texel, last), 0).r;
+}
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    if (copy) {
+        FragColor = vec4(texelFetch(source, texel, 0).r);
+        return;
+    }
+    ivec2 last = textureSize(source, 0) - 1;
+    ivec2 base = texel * 2;
+    float depth = max(max(fetch(base, last), fetch(base + ivec2(1, 0), last)),
+                      max(fetch(base + ivec2(0, 1), last), fetch(base + ivec2(1, 1), last)));
+    // an odd sized level leaves a last column or row for the last texel to take on
+    bool extraColumn = base.x + 2 == last.x;
+    bool extraRow = base.y + 2 == last.y;
+    if (extraColumn) {
+        depth = max(depth, max(fetch(base + ivec2(2, 0), last), fetch(base + ivec2(2, 1), last)));
+    }
+    if (extraRow) {
+        depth = max(depth, max(fetch(base + ivec2(0, 2), last), fetch(base + ivec2(1, 2), last)));
+    }
+    if (extraColumn && extraRow) {
+        depth = max(depth, fetch(base + ivec2(2, 2), last));
+    }
+    FragColor = vec4(depth);
+}
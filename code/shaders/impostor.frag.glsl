@@ -0,0 +1,47 @@
+#version 330 core
+// colour from the atlas, lit with its normal when `lit`, and depth pushed back
+// to where the model's surface was so impostors intersect the real meshes properly
+out vec4 FragColor;
+
+in vec2 atlasCoord;
+in vec3 worldPos;
+flat in mat3 rotation;
+flat in vec3 cellDirection;
+flat in float radius;
+
+struct Impostor {
+    sampler2D albedo;
+    sampler2D normalDepth;
+    int frames;
+    float border;
+    vec4 bounds;
+};
+
+uniform Impostor impostor;
+uniform mat4 view;
+uniform mat4 projection;
+uniform bool lit;
+uniform vec3 lightDirection;
+
+void main()
+{
+    vec4 albedo = texture(impostor.albedo, atlasCoord);
+    if (albedo.a < 0.5)
+        discard;
+    // the atlas is 0 where the model wasn't, so filtered texels are weighted by
+    // coverage; dividing it out leaves the surface's own values, not ones mixed
+    // with the background
+    vec4 normalDepth = texture(impostor.normalDepth, atlasCoord) / albedo.a;
+    albedo.rgb /= albedo.a;
+
+    vec3 surface = worldPos + cellDirection * radius * (1.0 - 2.0 * normalDepth.a);
+    vec4 clip = projection * view * vec4(surface, 1.0);
+    gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+
+    vec3 colour = albedo.rgb;
+    if (lit) {
+        vec3 normal = normalize(rotation * (normalDepth.xyz * 2.0 - 1.0));
+        colour *= 0.2 + 0.8 * max(dot(normal, normalize(-lightDirection)), 0.0);
+    }
+    FragColor = vec4(colour, 1.0);
+}
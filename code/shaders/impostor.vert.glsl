@@ -0,0 +1,72 @@
+#version 330 core
+// sjd::Impostor quads: each instance picks the atlas cell taken from nearest the
+// direction it's seen from, and lays the quad out the way that picture was taken
+layout(location = 0) in vec2 aCorner;
+layout(location = 3) in mat4 aInstanceMatrix;
+
+out vec2 atlasCoord;
+out vec3 worldPos;
+flat out mat3 rotation;
+flat out vec3 cellDirection;
+flat out float radius;
+
+struct Impostor {
+    sampler2D albedo;
+    sampler2D normalDepth;
+    int frames;
+    float border;       // gutter around each cell's view, as a fraction of the cell
+    vec4 bounds;        // model space bounding sphere: center, radius
+};
+
+uniform Impostor impostor;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;
+
+// the same mapping as sjd::Impostor's bake
+vec3 octahedralDirection(vec2 uv)
+{
+    vec3 n = vec3(uv.x, 1.0 - abs(uv.x) - abs(uv.y), uv.y);
+    if (n.y < 0.0) {
+        vec2 folded = (1.0 - abs(n.zx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.z >= 0.0 ? 1.0 : -1.0);
+        n.xz = folded;
+    }
+    return normalize(n);
+}
+
+vec2 octahedralCoord(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 uv = n.xz;
+    if (n.y < 0.0)
+        uv = (1.0 - abs(uv.yx)) * vec2(uv.x >= 0.0 ? 1.0 : -1.0, uv.y >= 0.0 ? 1.0 : -1.0);
+    return uv;
+}
+
+void main()
+{
+    mat4 model = aInstanceMatrix;
+    model[0][3] = 0.0;      // sjd::InstanceCuller's crossfade, unused here
+    float scale = length(model[0].xyz);
+    rotation = mat3(model) / scale;
+    vec3 center = (model * vec4(impostor.bounds.xyz, 1.0)).xyz;
+    radius = impostor.bounds.w * scale;
+
+    // the viewing direction in model space picks the cell
+    vec3 toCamera = transpose(rotation) * (viewPos - center);
+    vec2 uv = octahedralCoord(normalize(toCamera));
+    ivec2 cell = clamp(ivec2((uv * 0.5 + 0.5) * float(impostor.frames)), ivec2(0), ivec2(impostor.frames - 1));
+    vec3 direction = octahedralDirection((vec2(cell) + 0.5) / float(impostor.frames) * 2.0 - 1.0);
+
+    // the baking camera's axes, as glm::lookAt builds them
+    vec3 up = abs(direction.y) > 0.99 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(-direction, up));
+    up = cross(right, -direction);
+
+    cellDirection = rotation * direction;
+    worldPos = center + (aCorner.x * (rotation * right) + aCorner.y * (rotation * up)) * radius;
+    // the view inside the cell, never its gutter or the next cell
+    float inner = 0.5 - impostor.border;
+    atlasCoord = (vec2(cell) + 0.5 + clamp(aCorner * inner, -inner, inner)) / float(impostor.frames);
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
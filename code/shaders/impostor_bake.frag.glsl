@@ -0,0 +1,20 @@
+#version 330 core
+// colour to the first target; model space normal and depth through the
+// bounding sphere (orthographic, so already linear) to the second
+layout(location = 0) out vec4 albedo;
+layout(location = 1) out vec4 normalDepth;
+
+in vec3 normal;
+in vec2 texCoord;
+
+struct Material {
+    sampler2D texture_diffuse0;
+};
+
+uniform Material material;
+
+void main()
+{
+    albedo = vec4(texture(material.texture_diffuse0, texCoord).rgb, 1.0);
+    normalDepth = vec4(normalize(normal) * 0.5 + 0.5, gl_FragCoord.z);
+}
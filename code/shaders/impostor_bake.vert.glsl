@@ -0,0 +1,18 @@
+#version 330 core
+// renders one cell of an sjd::Impostor atlas
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoord;
+
+out vec3 normal;
+out vec2 texCoord;
+
+uniform mat4 model;
+uniform mat4 viewProjection;
+
+void main()
+{
+    normal = aNormal;
+    texCoord = aTexCoord;
+    gl_Position = viewProjection * model * vec4(aPos, 1.0);
+}
@@ -0,0 +1,143 @@
+#version 430 core
+// sjd::InstanceCuller's GPU path, run as three dispatches picked by `stage`:
+//   0: one invocation per instance culls it, picks its level of detail (or the
+//      impostor) and takes a slot in that range (and the next level's, while
+//      crossfading)
+//   1: a single invocation turns the counts into offsets and writes a draw
+//      command per mesh and level, then one for the impostor
+//   2: one invocation per instance copies its matrix into its slots
+layout (local_size_x = 256) in;
+
+const uint MAX_LODS = 5u;
+const uint MAX_BUCKETS = MAX_LODS + 1u;     // the levels, then the impostor
+const uint CULLED = 0xffffffffu;
+const float FLT_MAX = 3.402823466e+38;
+
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int  baseVertex;
+    uint baseInstance;
+};
+
+layout (std430, binding = 0) readonly buffer Instances { mat4 instances[]; };
+layout (std430, binding = 1) writeonly buffer Visible { mat4 visible[]; };
+// per instance: level, slot in it, slot in the next level, fade (as bits; 0 = none)
+layout (std430, binding = 2) buffer Slots { uvec4 slots[]; };
+layout (std430, binding = 3) buffer Counters {
+    uint lodCounts[MAX_BUCKETS];
+    uint lodOffsets[MAX_BUCKETS];
+    uint visibleCount;
+};
+layout (std430, binding = 4) writeonly buffer Commands { DrawCommand commands[]; };
+// (firstIndex, indexCount) per mesh and level, then the impostor's quad
+layout (std430, binding = 5) readonly buffer Ranges { uvec2 ranges[]; };
+
+uniform uint stage;
+uniform uint count;
+uniform uint levels;
+uniform uint meshCount;
+uniform vec4 bounds;            // model space bounding sphere: center, radius
+uniform mat4 view;
+uniform vec4 planes[6];
+uniform float pixelsPerUnit;
+uniform float minScreenSize;
+uniform float crossfadeBand;
+uniform uint impostorBucket;    // CULLED for no impostor
+uniform float impostorDistance;
+uniform float lodScreenSizes[MAX_LODS - 1u];
+
+// picks the level (or CULLED) and returns the fade; 0 when not crossfading
+float classify(mat4 model, out uint level)
+{
+    level = CULLED;
+    vec3 center = (model * vec4(bounds.xyz, 1.0)).xyz;
+    float scale = max(length(model[0].xyz), max(length(model[1].xyz), length(model[2].xyz)));
+    float radius = bounds.w * scale;
+    for (int i = 0; i < 6; i++) {
+        if (dot(planes[i].xyz, center) + planes[i].w < -radius * length(planes[i].xyz))
+            return 0.0;
+    }
+
+    float depth = -(view * vec4(center, 1.0)).z;
+    // inside the sphere counts as infinitely big
+    float size = (depth > radius) ? 2.0 * radius * pixelsPerUnit / depth : FLT_MAX;
+    if (size < minScreenSize)
+        return 0.0;
+    if (impostorBucket != CULLED && depth > impostorDistance) {
+        level = impostorBucket;
+        return 0.0;
+    }
+    level = 0u;
+    while (level + 1u < levels && size < lodScreenSizes[level])
+        level++;
+
+    float fade = 0.0;
+    if (level + 1u < levels && crossfadeBand > 0.0 && lodScreenSizes[level] < FLT_MAX) {
+        float band = lodScreenSizes[level] * crossfadeBand;
+        if (size < lodScreenSizes[level] + band)
+            fade = clamp((size - lodScreenSizes[level]) / band, 1.0 / 64.0, 63.0 / 64.0);
+    }
+    return fade;
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (stage == 1u) {
+        if (i != 0u)
+            return;
+        uint buckets = (impostorBucket != CULLED) ? levels + 1u : levels;
+        uint offset = 0u;
+        for (uint bucket = 0u; bucket < buckets; bucket++) {
+            lodOffsets[bucket] = offset;
+            offset += lodCounts[bucket];
+        }
+        visibleCount = offset;
+        for (uint mesh = 0u; mesh < meshCount; mesh++) {
+            for (uint level = 0u; level < levels; level++) {
+                uint command = mesh * levels + level;
+                commands[command] = DrawCommand(ranges[command].y, lodCounts[level], ranges[command].x,
+                                                0, lodOffsets[level]);
+            }
+        }
+        if (impostorBucket != CULLED) {
+            uint command = meshCount * levels;
+            commands[command] = DrawCommand(ranges[command].y, lodCounts[impostorBucket], ranges[command].x,
+                                            0, lodOffsets[impostorBucket]);
+        }
+        return;
+    }
+
+    if (i >= count)
+        return;
+    if (stage == 0u) {
+        uint level;
+        float fade = classify(instances[i], level);
+        uvec4 slot = uvec4(level, 0u, 0u, floatBitsToUint(fade));
+        if (level != CULLED) {
+            slot.y = atomicAdd(lodCounts[level], 1u);
+            if (fade > 0.0)
+                slot.z = atomicAdd(lodCounts[level + 1u], 1u);
+        }
+        slots[i] = slot;
+    }
+    else {
+        uvec4 slot = slots[i];
+        if (slot.x == CULLED)
+            return;
+        mat4 model = instances[i];
+        float fade = uintBitsToFloat(slot.w);
+        if (fade > 0.0) {
+            // the fade rides in the matrix's unused bottom row; the coarser copy gets it negated
+            model[0][3] = fade;
+            visible[lodOffsets[slot.x] + slot.y] = model;
+            model[0][3] = -fade;
+            visible[lodOffsets[slot.x + 1u] + slot.z] = model;
+        }
+        else {
+            visible[lodOffsets[slot.x] + slot.y] = model;
+        }
+    }
+}
@@ -0,0 +1,21 @@
+#version 330 core
+// demos/instancing/3.3.instancing.vert.glsl for sjd::InstanceCuller's crossfade:
+// the culler stores each instance's fade in the matrix's unused bottom row
+layout(location = 0) in vec3 aPos;
+layout(location = 2) in vec2 aTexCoord;
+layout(location = 3) in mat4 aInstanceMatrix;
+
+out vec2 texCoord;
+flat out float fade;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    mat4 model = aInstanceMatrix;
+    fade = model[0][3];
+    model[0][3] = 0.0;
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    texCoord = aTexCoord;
+}
@@ -0,0 +1,19 @@
+#version 330 core
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoord;
+layout(location = 3) in mat4 aInstanceMatrix;
+layout(location = 7) in mat3 aInstanceNormalMatrix;    // precomputed per instance on the CPU
+
+out vec3 fragNormal;
+out vec2 texCoord;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    fragNormal = aInstanceNormalMatrix * aNormal;
+    texCoord = aTexCoord;
+    gl_Position = projection * view * aInstanceMatrix * vec4(aPos, 1.0);
+}
@@ -0,0 +1,20 @@
+#version 330 core
+// Reference version of instancing_lit.vert.glsl that inverts the instance matrix
+// for every vertex, kept for the benchmark to compare against.
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoord;
+layout(location = 3) in mat4 aInstanceMatrix;
+
+out vec3 fragNormal;
+out vec2 texCoord;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    fragNormal = mat3(transpose(inverse(aInstanceMatrix))) * aNormal;
+    texCoord = aTexCoord;
+    gl_Position = projection * view * aInstanceMatrix * vec4(aPos, 1.0);
+}
@@ -0,0 +1,61 @@
+#version 330 core
+// One point light added to the surface under each pixel its volume covers.
+flat in int lightIndex;
+
+out vec4 FragColor;
+
+uniform sampler2D gAlbedoSpec;
+uniform sampler2D gNormalShininess;
+uniform sampler2D gDepth;
+uniform samplerBuffer pointLightData;
+uniform mat4 inverseViewProjection;
+uniform vec2 screenSize;
+uniform vec3 viewPos;
+
+vec3 decodeNormal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += (n.x >= 0.0) ? -t : t;
+    n.y += (n.y >= 0.0) ? -t : t;
+    return normalize(n);
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    vec4 ndc = vec4(gl_FragCoord.xy / screenSize * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec4 world = inverseViewProjection * ndc;
+    vec3 fragPos = world.xyz / world.w;
+
+    // layout from PointLight::packed()
+    vec4 positionRange = texelFetch(pointLightData, lightIndex * 4);
+    vec4 ambientConstant = texelFetch(pointLightData, lightIndex * 4 + 1);
+    vec4 diffuseLinear = texelFetch(pointLightData, lightIndex * 4 + 2);
+    vec4 specularQuadratic = texelFetch(pointLightData, lightIndex * 4 + 3);
+
+    float distance = length(positionRange.xyz - fragPos);
+    // surfaces in front of the volume still pass the depth test; skip them here
+    if (distance >= positionRange.w) discard;
+
+    vec4 albedoSpec = texelFetch(gAlbedoSpec, pixel, 0);
+    vec4 normalShininess = texelFetch(gNormalShininess, pixel, 0);
+    vec3 normal = decodeNormal(normalShininess.xy);
+    vec3 viewDir = normalize(viewPos - fragPos);
+    vec3 lightDir = (positionRange.xyz - fragPos) / distance;
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float diff = max(dot(normal, lightDir), 0.0);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), normalShininess.z * 256.0);
+    float attenuation = 1.0 /
+            (ambientConstant.w + diffuseLinear.w * distance + specularQuadratic.w * (distance * distance));
+    // fade to nothing at the edge of the volume instead of cutting off
+    float window = clamp(1.0 - pow(distance / positionRange.w, 4.0), 0.0, 1.0);
+    attenuation *= window * window;
+
+    vec3 ambient = ambientConstant.rgb * albedoSpec.rgb;
+    vec3 diffuse = diffuseLinear.rgb * diff * albedoSpec.rgb;
+    vec3 specular = specularQuadratic.rgb * spec * albedoSpec.a;
+    FragColor = vec4((ambient + diffuse + specular) * attenuation, 0.0);
+}
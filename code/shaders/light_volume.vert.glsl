@@ -0,0 +1,16 @@
+#version 330 core
+// Point light volumes of sjd::DeferredShading: one instance per light, the
+// unit sphere scaled to the light's range.
+layout(location = 0) in vec3 aPos;
+
+flat out int lightIndex;
+
+uniform samplerBuffer pointLightData;
+uniform mat4 viewProjection;
+
+void main()
+{
+    lightIndex = gl_InstanceID;
+    vec4 positionRange = texelFetch(pointLightData, gl_InstanceID * 4);
+    gl_Position = viewProjection * vec4(positionRange.xyz + aPos * positionRange.w, 1.0);
+}
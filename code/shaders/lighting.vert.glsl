@@ -8,13 +8,17 @@ out vec3 fragPos;
 out vec2 texCoords;
 
 uniform mat4 model;
+uniform mat3 normalMatrix;  // transpose(inverse(mat3(model))), computed once per draw on the CPU
 uniform mat4 view;
 uniform mat4 projection;
 
+// bit for bit the same depth as depth_prepass.vert.glsl, for GL_EQUAL after a pre-pass
+invariant gl_Position;
+
 void main()
 {
     fragPos = vec3(model * vec4(aPos, 1.0));
-    fragNormal = mat3(transpose(inverse(model))) * aNormal;
+    fragNormal = normalMatrix * aNormal;
     texCoords = aTexCoords;
     gl_Position = projection * view * vec4(fragPos, 1.0);
 }
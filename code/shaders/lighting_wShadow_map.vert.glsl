@@ -7,18 +7,19 @@ out VS_OUT {
     vec3 fragNormal;
     vec3 fragPos;
     vec2 texCoords;
-    vec4 fragPosLightSpace;
 } vs_out;
 
 uniform mat4 model;
+uniform mat3 normalMatrix;  // transpose(inverse(mat3(model))), computed once per draw on the CPU
 uniform mat4 view;
 uniform mat4 projection;
-uniform mat4 lightSpaceMatrix;
+
+// bit for bit the same depth as depth_prepass.vert.glsl, for GL_EQUAL after a pre-pass
+invariant gl_Position;
 
 void main() {
     vs_out.fragPos = vec3(model * vec4(aPos, 1.0));
-    vs_out.fragNormal = mat3(transpose(inverse(model))) * aNormal;
+    vs_out.fragNormal = normalMatrix * aNormal;
     vs_out.texCoords = aTexCoords;
-    vs_out.fragPosLightSpace = lightSpaceMatrix * vec4(vs_out.fragPos, 1.0);
     gl_Position = projection * view * vec4(vs_out.fragPos, 1.0);
 }
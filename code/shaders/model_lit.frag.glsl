@@ -0,0 +1,19 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 fragNormal;
+in vec2 texCoord;
+
+struct Material {
+    sampler2D texture_diffuse0;
+};
+
+uniform Material material;
+uniform vec3 lightDirection;
+
+void main()
+{
+    vec3 colour = texture(material.texture_diffuse0, texCoord).rgb;
+    float diff = max(dot(normalize(fragNormal), normalize(-lightDirection)), 0.0);
+    FragColor = vec4(colour * (0.15 + 0.85 * diff), 1.0);
+}
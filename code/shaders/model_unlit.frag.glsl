@@ -0,0 +1,15 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 texCoord;
+
+struct Material {
+    sampler2D texture_diffuse0;
+};
+
+uniform Material material;
+
+void main()
+{
+    FragColor = texture(material.texture_diffuse0, texCoord);
+}
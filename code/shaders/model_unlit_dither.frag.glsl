@@ -0,0 +1,32 @@
+#version 330 core
+// model_unlit.frag.glsl, dithered between two levels of detail by `fade`:
+// positive is the finer copy, kept on that share of the pixels, negative the
+// coarser copy, kept on the rest; 0 is an instance that isn't crossfading
+out vec4 FragColor;
+
+in vec2 texCoord;
+flat in float fade;
+
+struct Material {
+    sampler2D texture_diffuse0;
+};
+
+uniform Material material;
+
+const float bayer[16] = float[](
+     0.0,  8.0,  2.0, 10.0,
+    12.0,  4.0, 14.0,  6.0,
+     3.0, 11.0,  1.0,  9.0,
+    15.0,  7.0, 13.0,  5.0
+);
+
+void main()
+{
+    if (fade != 0.0) {
+        ivec2 pixel = ivec2(gl_FragCoord.xy) & 3;
+        float threshold = (bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0;
+        if ((threshold < abs(fade)) != (fade > 0.0))
+            discard;
+    }
+    FragColor = texture(material.texture_diffuse0, texCoord);
+}
@@ -0,0 +1,12 @@
+#version 330 core
+// How far the surface moved across the screen since the last frame, in texture
+// coordinates, into the second colour attachment of sjd::TemporalAA's target.
+in vec4 currentPosition;
+in vec4 previousPosition;
+
+layout(location = 1) out vec2 Motion;
+
+void main()
+{
+    Motion = (currentPosition.xy / currentPosition.w - previousPosition.xy / previousPosition.w) * 0.5;
+}
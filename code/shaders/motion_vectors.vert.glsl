@@ -0,0 +1,26 @@
+#version 330 core
+// sjd::TemporalAA's motion pass over meshes that moved since the last frame,
+// with motion_vectors.frag.glsl. The position maths matches lighting.vert.glsl
+// exactly, so with both invariant it can depth test GL_LEQUAL against the
+// colour pass and only write where the mesh is visible.
+layout(location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 previousModel;
+uniform mat4 viewProjection;            // without the jitter, this frame
+uniform mat4 previousViewProjection;    // without the jitter, last frame
+
+out vec4 currentPosition;
+out vec4 previousPosition;
+
+invariant gl_Position;
+
+void main()
+{
+    vec3 fragPos = vec3(model * vec4(aPos, 1.0));
+    gl_Position = projection * view * vec4(fragPos, 1.0);
+    currentPosition = viewProjection * vec4(fragPos, 1.0);
+    previousPosition = previousViewProjection * previousModel * vec4(aPos, 1.0);
+}
@@ -0,0 +1,40 @@
+#version 330 core
+// Last of sjd::PostAntiAliasing's SMAA passes, drawn with
+// deferred_fullscreen.vert.glsl into the output: each pixel mixed with its
+// neighbours by the weights of the pass before, its own (below, left) and the
+// ones the pixels above and to the right left for it. Only the direction with
+// more to blend is used, so a corner isn't blended twice.
+out vec4 FragColor;
+
+uniform sampler2D source;
+uniform sampler2D weights;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 last = textureSize(source, 0) - 1;
+    vec4 own = texelFetch(weights, pixel, 0);
+    float fromBelow = own.x;
+    float fromLeft = own.z;
+    float fromAbove = texelFetch(weights, min(pixel + ivec2(0, 1), last), 0).y;
+    float fromRight = texelFetch(weights, min(pixel + ivec2(1, 0), last), 0).w;
+
+    vec3 colour = texelFetch(source, pixel, 0).rgb;
+    float vertical = fromBelow + fromAbove;
+    float horizontal = fromLeft + fromRight;
+    if (max(vertical, horizontal) == 0.0) {
+        FragColor = vec4(colour, 1.0);
+        return;
+    }
+    if (vertical >= horizontal) {
+        vec3 below = texelFetch(source, max(pixel - ivec2(0, 1), ivec2(0)), 0).rgb;
+        vec3 above = texelFetch(source, min(pixel + ivec2(0, 1), last), 0).rgb;
+        colour = colour * (1.0 - vertical) + below * fromBelow + above * fromAbove;
+    }
+    else {
+        vec3 left = texelFetch(source, max(pixel - ivec2(1, 0), ivec2(0)), 0).rgb;
+        vec3 right = texelFetch(source, min(pixel + ivec2(1, 0), last), 0).rgb;
+        colour = colour * (1.0 - horizontal) + left * fromLeft + right * fromRight;
+    }
+    FragColor = vec4(colour, 1.0);
+}
@@ -0,0 +1,40 @@
+#version 330 core
+// First of sjd::PostAntiAliasing's SMAA passes, drawn with
+// deferred_fullscreen.vert.glsl into a target cleared to 0: luma edges between
+// each pixel and the one to its left (r) and below (g).
+//
+// An edge is also dropped when there's one twice as strong right next to it
+// (local contrast adaptation), so the softer lines running alongside a hard
+// edge aren't smoothed into it.
+layout(location = 0) out vec4 Edges;
+
+uniform sampler2D source;
+uniform bool linearInput;       // source is linear (sRGB decoded), so luma needs gamma
+uniform float threshold;
+
+float lumaAt(ivec2 pixel)
+{
+    pixel = clamp(pixel, ivec2(0), textureSize(source, 0) - 1);
+    float l = dot(texelFetch(source, pixel, 0).rgb, vec3(0.2126, 0.7152, 0.0722));
+    return linearInput ? sqrt(l) : l;
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float luma = lumaAt(pixel);
+    float lumaLeft = lumaAt(pixel - ivec2(1, 0));
+    float lumaBelow = lumaAt(pixel - ivec2(0, 1));
+    vec2 delta = abs(luma - vec2(lumaLeft, lumaBelow));
+    vec2 edges = step(threshold, delta);
+    if (edges.x + edges.y == 0.0) discard;
+
+    float strongest = max(delta.x, delta.y);
+    strongest = max(strongest, abs(luma - lumaAt(pixel + ivec2(1, 0))));
+    strongest = max(strongest, abs(luma - lumaAt(pixel + ivec2(0, 1))));
+    strongest = max(strongest, abs(lumaLeft - lumaAt(pixel - ivec2(2, 0))));
+    strongest = max(strongest, abs(lumaBelow - lumaAt(pixel - ivec2(0, 2))));
+    edges *= step(strongest, 2.0 * delta);
+
+    Edges = vec4(edges, 0.0, 0.0);
+}
@@ -0,0 +1,88 @@
+#version 330 core
+// Second of sjd::PostAntiAliasing's SMAA passes, drawn with
+// deferred_fullscreen.vert.glsl into a target cleared to 0: how much each
+// pixel on an edge should blend across it.
+//
+// From each edge pixel it searches along the edge both ways for its ends and
+// looks at which side the edge turns to there, which gives the edge's shape
+// (the L, Z and U patterns of MLAA). The blend is the area the line through
+// the shape leaves on the wrong side of the edge within this pixel. SMAA
+// proper looks the areas up in a precomputed texture and searches with
+// bilinear fetches, two texels at a time; this works them out directly.
+//
+// Out: x, how much this pixel takes from the one below, and y, how much that
+// one takes from this; z and w the same with the pixel to the left.
+layout(location = 0) out vec4 Weights;
+
+uniform sampler2D edges;
+uniform int maxSearch;
+
+vec2 edgesAt(ivec2 pixel)
+{
+    ivec2 size = textureSize(edges, 0);
+    if (any(lessThan(pixel, ivec2(0))) || any(greaterThanEqual(pixel, size))) return vec2(0.0);
+    return texelFetch(edges, pixel, 0).rg;
+}
+
+// -1 when the edge turns into this pixel's side at an end, 1 when into the
+// neighbour's, 0 when it doesn't turn (or turns both ways)
+float crossing(float ownSide, float otherSide)
+{
+    return step(0.5, otherSide) - step(0.5, ownSide);
+}
+
+// Where the line through the edge crosses this pixel's centre, from -0.5 (well
+// into this pixel's side) to 0.5 (into the neighbour's). `before` and `after`
+// are the pixels from here to each end of the edge.
+float area(float before, float after, float crossBefore, float crossAfter)
+{
+    float edgeLength = before + after + 1.0;
+    float toBefore = before + 0.5;
+    float toAfter = after + 0.5;
+    if (crossBefore != 0.0 && crossAfter != 0.0) {
+        // Z or U: each half is a line from its end to the middle
+        if (toBefore < toAfter) return crossBefore * 0.5 * (1.0 - toBefore / (0.5 * edgeLength));
+        if (toAfter < toBefore) return crossAfter * 0.5 * (1.0 - toAfter / (0.5 * edgeLength));
+        return 0.0;
+    }
+    // L: one line from the turning end to the other
+    if (crossBefore != 0.0) return crossBefore * 0.5 * (1.0 - toBefore / edgeLength);
+    if (crossAfter != 0.0) return crossAfter * 0.5 * (1.0 - toAfter / edgeLength);
+    return 0.0;
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec2 e = edgesAt(pixel);
+    if (e.x + e.y == 0.0) discard;
+    vec4 weights = vec4(0.0);
+
+    if (e.y > 0.5) {
+        // the edge with the pixel below, running left and right
+        int left = 0;
+        while (left < maxSearch && edgesAt(pixel - ivec2(left + 1, 0)).y > 0.5) left++;
+        int right = 0;
+        while (right < maxSearch && edgesAt(pixel + ivec2(right + 1, 0)).y > 0.5) right++;
+        ivec2 leftEnd = pixel - ivec2(left, 0);
+        ivec2 rightEnd = pixel + ivec2(right + 1, 0);
+        float crossLeft = (left < maxSearch) ? crossing(edgesAt(leftEnd).x, edgesAt(leftEnd - ivec2(0, 1)).x) : 0.0;
+        float crossRight = (right < maxSearch) ? crossing(edgesAt(rightEnd).x, edgesAt(rightEnd - ivec2(0, 1)).x) : 0.0;
+        float h = area(float(left), float(right), crossLeft, crossRight);
+        weights.xy = vec2(max(-h, 0.0), max(h, 0.0));
+    }
+    if (e.x > 0.5) {
+        // the edge with the pixel to the left, running down and up
+        int down = 0;
+        while (down < maxSearch && edgesAt(pixel - ivec2(0, down + 1)).x > 0.5) down++;
+        int up = 0;
+        while (up < maxSearch && edgesAt(pixel + ivec2(0, up + 1)).x > 0.5) up++;
+        ivec2 bottomEnd = pixel - ivec2(0, down);
+        ivec2 topEnd = pixel + ivec2(0, up + 1);
+        float crossBottom = (down < maxSearch) ? crossing(edgesAt(bottomEnd).y, edgesAt(bottomEnd - ivec2(1, 0)).y) : 0.0;
+        float crossTop = (up < maxSearch) ? crossing(edgesAt(topEnd).y, edgesAt(topEnd - ivec2(1, 0)).y) : 0.0;
+        float h = area(float(down), float(up), crossBottom, crossTop);
+        weights.zw = vec2(max(-h, 0.0), max(h, 0.0));
+    }
+    Weights = weights;
+}
@@ -0,0 +1,83 @@
+#version 330 core
+// sjd::TemporalAA's resolve, drawn with deferred_fullscreen.vert.glsl into the
+// next history target: this frame's jittered image blended into the history,
+// which is fetched from where each pixel was last frame.
+//
+// Motion comes from the motion pass where a mesh moved and from the depth
+// otherwise, since the camera's own motion is the same for everything: the
+// point behind the pixel is projected with this frame's and last frame's
+// (unjittered) matrices. It's taken from the nearest pixel in the 3x3
+// neighbourhood, so the edges of moving things carry their motion with them.
+//
+// The history is clamped to the range of the neighbourhood's colours, which is
+// what stops ghosting where the history no longer matches (disocclusion,
+// lighting changes), and the blend weights bright pixels down so single
+// fireflies don't flicker.
+out vec4 FragColor;
+
+uniform sampler2D current;
+uniform sampler2D motion;
+uniform sampler2D depth;
+uniform sampler2D history;
+uniform vec2 outputSize;
+uniform mat4 inverseViewProjection;     // with the jitter the frame was drawn with
+uniform mat4 viewProjection;            // without it, this frame
+uniform mat4 previousViewProjection;    // without it, last frame
+uniform float blend;                    // weight of the new frame
+uniform bool historyValid;
+
+// cleared where the motion pass didn't draw
+const float noMotion = -1000.0;
+
+vec2 cameraMotion(vec2 uv, float z)
+{
+    vec4 world = inverseViewProjection * vec4(vec3(uv, z) * 2.0 - 1.0, 1.0);
+    world /= world.w;
+    vec4 now = viewProjection * world;
+    vec4 before = previousViewProjection * world;
+    return (now.xy / now.w - before.xy / before.w) * 0.5;
+}
+
+float weight(vec3 colour)
+{
+    return 1.0 / (1.0 + max(colour.r, max(colour.g, colour.b)));
+}
+
+void main()
+{
+    vec2 texel = 1.0 / outputSize;
+    vec2 uv = gl_FragCoord.xy * texel;
+
+    vec3 colour = texture(current, uv).rgb;
+    vec3 lowest = colour;
+    vec3 highest = colour;
+    float closest = texture(depth, uv).r;
+    vec2 closestUv = uv;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            if (x == 0 && y == 0) continue;
+            vec2 neighbour = uv + vec2(x, y) * texel;
+            vec3 neighbourColour = texture(current, neighbour).rgb;
+            lowest = min(lowest, neighbourColour);
+            highest = max(highest, neighbourColour);
+            float z = texture(depth, neighbour).r;
+            if (z < closest) {
+                closest = z;
+                closestUv = neighbour;
+            }
+        }
+    }
+
+    vec2 velocity = texture(motion, closestUv).rg;
+    if (velocity.x <= noMotion) velocity = cameraMotion(closestUv, closest);
+    vec2 previousUv = uv - velocity;
+    if (!historyValid || any(lessThan(previousUv, vec2(0.0))) || any(greaterThan(previousUv, vec2(1.0)))) {
+        FragColor = vec4(colour, 1.0);
+        return;
+    }
+
+    vec3 previous = clamp(texture(history, previousUv).rgb, lowest, highest);
+    float currentWeight = weight(colour) * blend;
+    float previousWeight = weight(previous) * (1.0 - blend);
+    FragColor = vec4((colour * currentWeight + previous * previousWeight) / (currentWeight + previousWeight), 1.0);
+}
@@ -0,0 +1,36 @@
+#version 330 core
+// sjd::DynamicResolution's upscale and sjd::TemporalAA's copy to the output,
+// drawn with deferred_fullscreen.vert.glsl over it: a bilinear fetch from the
+// part of `source` that was drawn to, sharpened against its four neighbours.
+//
+// The sharpening is contrast adaptive: each channel's negative lobe is scaled
+// down where the neighbourhood already spans most of 0..1, so edges don't ring
+// and flat areas don't pick up noise. Above 1 (unmapped HDR) it does nothing.
+out vec4 FragColor;
+
+uniform sampler2D source;
+uniform vec2 outputSize;
+uniform vec2 uvScale;       // the drawn part of `source`, as a fraction of it
+uniform float sharpness;    // 0 to 1
+
+void main()
+{
+    vec2 texel = 1.0 / vec2(textureSize(source, 0));
+    // keep every tap inside the drawn part, away from the stale texels beyond it
+    vec2 uvMax = uvScale - 0.5 * texel;
+    vec2 uv = min(gl_FragCoord.xy / outputSize * uvScale, uvMax);
+
+    vec3 c = texture(source, uv).rgb;
+    vec3 n = texture(source, min(uv + vec2(0.0, texel.y), uvMax)).rgb;
+    vec3 s = texture(source, max(uv - vec2(0.0, texel.y), 0.5 * texel)).rgb;
+    vec3 e = texture(source, min(uv + vec2(texel.x, 0.0), uvMax)).rgb;
+    vec3 w = texture(source, max(uv - vec2(texel.x, 0.0), 0.5 * texel)).rgb;
+
+    vec3 lowest = min(c, min(min(n, s), min(e, w)));
+    vec3 highest = max(c, max(max(n, s), max(e, w)));
+    vec3 headroom = clamp(min(lowest, 1.0 - highest) / max(highest, vec3(1.0e-4)), 0.0, 1.0);
+    vec3 lobe = -sqrt(headroom) * mix(0.0, 0.2, sharpness);
+
+    vec3 colour = (c + (n + s + e + w) * lobe) / (1.0 + 4.0 * lobe);
+    FragColor = vec4(max(colour, 0.0), 1.0);
+}
@@ -16,6 +16,9 @@
 
 #include <sjd/shader.h>
 #include <sjd/camera.h>
+#include <sjd/render_target.h>
+#include <sjd/temporal_aa.h>
+#include <sjd/post_antialiasing.h>
 
 GLFWwindow* createCoreWindow(uint32_t windowWidth, uint32_t windowHeight, uint16_t msaa=1);
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
@@ -38,13 +41,24 @@ namespace globals {
     // CAMERA
     sjd::Camera myCamera {};
     // ---
+    // T cycles through 4x MSAA, TAA, FXAA and SMAA
+    enum AntiAliasingMode {
+        MSAA,
+        TAA,
+        FXAA,
+        SMAA
+    };
+    constexpr const char* antiAliasingNames[] {"4x MSAA", "TAA", "FXAA", "SMAA 1x"};
+    AntiAliasingMode antiAliasing {MSAA};
+    bool antiAliasingKeyDown {false};
 }
 
 
 int main(void) {
     
     // INIT WINDOW
-    GLFWwindow* window {createCoreWindow(globals::windowWidth, globals::windowHeight, 4)};
+    // single sampled; the multisampling happens in msaaTarget instead
+    GLFWwindow* window {createCoreWindow(globals::windowWidth, globals::windowHeight)};
     if (!window) {return -1;}
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     // ---
@@ -116,6 +130,20 @@ int main(void) {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
+    // RENDER TARGET
+    // 4x MSAA colour and depth, resolved into the window at the end of each frame
+    sjd::RenderTarget msaaTarget {globals::windowWidth, globals::windowHeight,
+                                  {{sjd::RenderTarget::RGBA8}, sjd::RenderTarget::DEPTH24, false, 4}};
+    // or one sample a pixel, jittered, and blended over frames; its shaders are
+    // loaded from ../code/shaders, so run from a directory next to code/
+    sjd::TemporalAA taa;
+    // or one sample a pixel, smoothed afterwards from the finished image alone
+    sjd::PostAntiAliasing fxaa {sjd::FXAA};
+    sjd::PostAntiAliasing smaa {sjd::SMAA};
+    globals::AntiAliasingMode lastAntiAliasing {globals::MSAA};
+    glfwSetWindowTitle(window, globals::antiAliasingNames[globals::MSAA]);
+    // ---
+
     // RENDER LOOP
     while(!glfwWindowShouldClose(window)) {
         float currentFrameTime {float(glfwGetTime())};
@@ -124,12 +152,33 @@ int main(void) {
         globals::lastFrameTime = currentFrameTime;
         processInput(window);
 
-
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        glEnable(GL_DEPTH_TEST);
+        glm::mat4 projection = glm::perspective(glm::radians(globals::myCamera.zoom), static_cast<float>(globals::windowWidth) / globals::windowHeight, 0.1f, 1000.0f);
+        if (globals::antiAliasing != lastAntiAliasing) {
+            glfwSetWindowTitle(window, globals::antiAliasingNames[globals::antiAliasing]);
+        }
+        if (globals::antiAliasing == globals::TAA) {
+            // the history is from whenever TAA was last on
+            if (lastAntiAliasing != globals::TAA) taa.reset();
+            projection = taa.begin(globals::myCamera, projection, framebufferWidth, framebufferHeight,
+                                   glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
+        }
+        else if (globals::antiAliasing == globals::FXAA) {
+            fxaa.begin(framebufferWidth, framebufferHeight, glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
+        }
+        else if (globals::antiAliasing == globals::SMAA) {
+            smaa.begin(framebufferWidth, framebufferHeight, glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
+        }
+        else {
+            msaaTarget.resize(framebufferWidth, framebufferHeight);
+            msaaTarget.bind();
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
 
         shader.use();
-        glm::mat4 projection = glm::perspective(glm::radians(globals::myCamera.zoom), static_cast<float>(globals::windowWidth) / globals::windowHeight, 0.1f, 1000.0f);
         glm::mat4 view = globals::myCamera.getViewMatrix();
         glm::mat4 model = glm::mat4(1.0f);
 
@@ -139,7 +188,20 @@ int main(void) {
 
         glBindVertexArray(VAO);
         glDrawArrays(GL_TRIANGLES, 0, 36);
-
+        if (globals::antiAliasing == globals::TAA) {
+            taa.end();
+        }
+        else if (globals::antiAliasing == globals::FXAA) {
+            fxaa.end();
+        }
+        else if (globals::antiAliasing == globals::SMAA) {
+            smaa.end();
+        }
+        else {
+            msaaTarget.release();
+            msaaTarget.blit(0, msaaTarget.width(), msaaTarget.height());
+        }
+        lastAntiAliasing = globals::antiAliasing;
 
         glfwSwapBuffers(window);
         glfwPollEvents();
@@ -158,7 +220,7 @@ GLFWwindow* createCoreWindow(uint32_t windowWidth, uint32_t windowHeight, uint16
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     if (msaa > 1) {
-        glfwWindowHint(GLFW_SAMPLES, 4);
+        glfwWindowHint(GLFW_SAMPLES, msaa);
     }
     GLFWwindow* window = glfwCreateWindow(windowWidth, 
                             windowHeight, 
@@ -234,4 +296,10 @@ void processInput(GLFWwindow *window)
     if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS)
         globals::myCamera.processKeyboard(sjd::Camera::DOWN,
                                           globals::deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS)
+        globals::antiAliasingKeyDown = true;
+    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_RELEASE && globals::antiAliasingKeyDown) {
+        globals::antiAliasingKeyDown = false;
+        globals::antiAliasing = static_cast<globals::AntiAliasingMode>((globals::antiAliasing + 1) % 4);
+    }
 }
@@ -9,6 +9,9 @@
 
 #include <sjd/shader.h>
 #include <sjd/camera.h>
+#include <sjd/render_target.h>
+#include <sjd/render_graph.h>
+#include <sjd/post_process.h>
 
 #include <iostream>
 
@@ -70,50 +73,26 @@ int main()
 
     // configure global opengl state
     // -----------------------------
-    unsigned int framebuffer;
-    glGenFramebuffers(1, &framebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-    // generate texture
-    unsigned int textureColorbuffer;
-    glGenTextures(1, &textureColorbuffer);
-    glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    // attach it to currently bound framebuffer object
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureColorbuffer, 0);
-    unsigned int rbo;
-    glGenRenderbuffers(1, &rbo);
-    glBindRenderbuffer(GL_RENDERBUFFER, rbo); 
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT);  
-    glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
-    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // the scene is drawn into this, then shown on a full screen quad; nothing
+    // uses stencil, so depth alone will do
+    sjd::RenderTarget sceneTarget {SCR_WIDTH, SCR_HEIGHT,
+                                   {{sjd::RenderTarget::RGBA8}, sjd::RenderTarget::DEPTH24}};
 
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS); // always pass the depth test (same effect as glDisable(GL_DEPTH_TEST))
 
+    // edge detection, then a vignette, fused into one full screen pass
+    sjd::PostProcessStack post;
+    post.addKernel(sjd::PostProcessStack::edgeDetect(), 12.0f);
+    post.addVignette(0.6f);
+    sjd::RenderGraph graph;
+
     // build and compile shaders
     // -------------------------
     sjd::Shader shader("1.1.depth_testing.vert.glsl", "1.1.depth_testing.frag.glsl");
-    sjd::Shader screenShader("4.5.framebuffer.vert.glsl", "4.5.framebuffer.frag.glsl");
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
-    float screenVertices[] = {
-        // positions          // texture Coords (note we set these higher than 1 (together with GL_REPEAT as texture wrapping mode). this will cause the floor texture to repeat)
-        -1.0f, -1.0f,  0.0f,  0.0f, 0.0f,
-         1.0f, -1.0f,  0.0f,  1.0f, 0.0f,
-         1.0f,  1.0f,  0.0f,  1.0f, 1.0f,
-
-         1.0f,  1.0f,  0.0f,  1.0f, 1.0f,
-        -1.0f,  1.0f,  0.0f,  0.0f, 1.0f,
-        -1.0f, -1.0f,  0.0f,  0.0f, 0.0f
-    };
     float cubeVertices[] = {
         // positions          // texture Coords
         -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
@@ -192,18 +171,6 @@ int main()
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
     glBindVertexArray(0);
-    // screen VAO
-    unsigned int quadVAO, quadVBO;
-    glGenVertexArrays(1, &quadVAO);
-    glGenBuffers(1, &quadVBO);
-    glBindVertexArray(quadVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(screenVertices), &screenVertices, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glBindVertexArray(0);
 
     // load textures
     // -------------
@@ -232,7 +199,10 @@ int main()
 
         // render
         // ------
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        sceneTarget.resize(framebufferWidth, framebufferHeight);
+        sceneTarget.bind();
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glEnable(GL_DEPTH_TEST);
@@ -262,16 +232,13 @@ int main()
         glDrawArrays(GL_TRIANGLES, 0, 6);
         glBindVertexArray(0);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        sceneTarget.release();
 
-        /*glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);*/
-        screenShader.use();
-        glBindVertexArray(quadVAO);
-        glDisable(GL_DEPTH_TEST);
-        glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        // the post-processing covers the whole window, so there's nothing to clear
+        graph.importTarget("scene", sceneTarget);
+        graph.importBackbuffer("window");
+        post.addPasses(graph, "scene", "window");
+        graph.execute();
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
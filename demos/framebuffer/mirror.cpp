@@ -9,6 +9,7 @@
 
 #include <sjd/shader.h>
 #include <sjd/camera.h>
+#include <sjd/render_target.h>
 
 #include <iostream>
 
@@ -70,29 +71,10 @@ int main()
 
     // configure global opengl state
     // -----------------------------
-    unsigned int framebuffer;
-    glGenFramebuffers(1, &framebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-    // generate texture
-    unsigned int textureColorbuffer;
-    glGenTextures(1, &textureColorbuffer);
-    glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, SCR_WIDTH/2, static_cast<GLsizei>(SCR_HEIGHT*0.25), 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    // attach it to currently bound framebuffer object
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureColorbuffer, 0);
-    unsigned int rbo;
-    glGenRenderbuffers(1, &rbo);
-    glBindRenderbuffer(GL_RENDERBUFFER, rbo); 
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT);  
-    glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
-    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // the mirror covers half the width and a quarter of the height of the
+    // screen, so it only needs that many pixels; no stencil, so depth alone
+    sjd::RenderTarget mirrorTarget {SCR_WIDTH / 2, SCR_HEIGHT / 4,
+                                    {{sjd::RenderTarget::RGBA8}, sjd::RenderTarget::DEPTH24}};
 
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS); // always pass the depth test (same effect as glDisable(GL_DEPTH_TEST))
@@ -265,7 +247,7 @@ int main()
 
         // render to mirror
         // ------
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        mirrorTarget.bind();
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glEnable(GL_DEPTH_TEST);
@@ -273,7 +255,10 @@ int main()
 
         model = glm::mat4(1.0f);
         view = glm::lookAt(camera.pos, camera.pos - camera.front, camera.up);
+        projection = glm::perspective(glm::radians(camera.zoom),
+                                      (float)mirrorTarget.width() / (float)mirrorTarget.height(), 0.1f, 100.0f);
         shader.setMat4("view", view);
+        shader.setMat4("projection", projection);
         // cubes
         glBindVertexArray(cubeVAO);
         glActiveTexture(GL_TEXTURE0);
@@ -292,14 +277,14 @@ int main()
         glDrawArrays(GL_TRIANGLES, 0, 6);
         glBindVertexArray(0);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        mirrorTarget.release();
         glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 
         /*glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);*/
         screenShader.use();
         glBindVertexArray(quadVAO);
         glDisable(GL_DEPTH_TEST);
-        glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
+        glBindTexture(GL_TEXTURE_2D, mirrorTarget.colourTexture());
         glDrawArrays(GL_TRIANGLES, 0, 6);
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
@@ -1,6 +1,8 @@
 #include "glm/ext/matrix_float4x4.hpp"
+#include <chrono>
 #include <cstdint>
 #include <iostream>
+#include <string>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -9,9 +11,13 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#include <memory>
+#include <vector>
 #include <sjd/shader.h>
 #include <sjd/camera.h>
+#include <sjd/simd_math.h>
+#include <sjd/asteroid_field.h>
+#include <sjd/stream_ring.h>
+#include <sjd/worker_pool.h>
 #include <logl/model.h>
 
 GLFWwindow* createCoreWindow(uint32_t windowWidth, uint32_t windowHeight);
@@ -40,7 +46,10 @@ namespace globals {
 }
 
 
-int main(void) {
+// usage: asteroid [rocks] [threads]   (threads 0 = every core)
+int main(int argc, char** argv) {
+    unsigned int amount {(argc > 1) ? static_cast<unsigned int>(std::stoul(argv[1])) : 100000u};
+    unsigned int threads {(argc > 2) ? static_cast<unsigned int>(std::stoul(argv[2])) : 0u};
     
     // INIT WINDOW
     GLFWwindow* window {createCoreWindow(globals::windowWidth, globals::windowHeight)};
@@ -69,62 +78,26 @@ int main(void) {
     Model planet("model_planet/planet.obj");
 
     // model matrices
-    unsigned int amount = 100000;
-    auto modelMatrices = std::make_unique<glm::mat4[]>(amount);
-    srand(static_cast<unsigned int>(glfwGetTime())); // initialize random seed	
-    float radius = 150.0f;
-    float offset = 25.0f;
-    for(unsigned int i = 0; i < amount; i++)
-    {
-        glm::mat4 model = glm::mat4(1.0f);
-        // 1. translation: displace along circle with 'radius' in range [-offset, offset]
-        float angle = (float)i / (float)amount * 360.0f;
-        float displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float x = sin(angle) * radius + displacement;
-        displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float y = displacement * 0.4f; // keep height of field smaller compared to width of x and z
-        displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float z = cos(angle) * radius + displacement;
-        model = glm::translate(model, glm::vec3(x, y, z));
-
-        // 2. scale: scale between 0.05 and 0.25f
-        float scale = (rand() % 20) / 100.0f + 0.05f;
-        model = glm::scale(model, glm::vec3(scale));
-
-        // 3. rotation: add random rotation around a (semi)randomly picked rotation axis vector
-        float rotAngle = static_cast<float>(rand() % 360);
-        model = glm::rotate(model, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
-
-        // 4. now add to list of matrices
-        modelMatrices[i] = model;
-    }
+    // the field orbits and spins, so its matrices are rebuilt every frame, split
+    // over the worker pool and written straight into a ring of instance buffers
+    sjd::AsteroidField field(amount, static_cast<uint64_t>(glfwGetTime() * 1000.0));
+    sjd::WorkerPool pool(threads);
+    sjd::StreamRing instanceRing(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4));
+    std::cout << amount << " asteroids on " << pool.threadCount() << " threads using "
+              << sjd::simd::isaName(sjd::simd::activeIsa()) << std::endl;
 
-    unsigned int buffer;
-    glGenBuffers(1, &buffer);
-    glBindBuffer(GL_ARRAY_BUFFER, buffer);
-    glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), &modelMatrices[0], GL_STATIC_DRAW);
-      
     for(unsigned int i = 0; i < rock.meshes.size(); i++)
     {
         glBindVertexArray(rock.meshes[i].VAO);
-        // vertex attributes
-        glEnableVertexAttribArray(3); 
-        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
-        glEnableVertexAttribArray(4); 
-        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4)));
-        glEnableVertexAttribArray(5); 
-        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(2 * sizeof(glm::vec4)));
-        glEnableVertexAttribArray(6); 
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(3 * sizeof(glm::vec4)));
-
-        glVertexAttribDivisor(3, 1);
-        glVertexAttribDivisor(4, 1);
-        glVertexAttribDivisor(5, 1);
-        glVertexAttribDivisor(6, 1);
-
+        // vertex attributes; the pointers are set each frame, to that frame's part of the ring
+        for (unsigned int column = 0; column < 4; column++) {
+            glEnableVertexAttribArray(3 + column);
+            glVertexAttribDivisor(3 + column, 1);
+        }
         glBindVertexArray(0);
-    }  
-    glBindBuffer(GL_ARRAY_BUFFER, 0);	
+    }
+    double updateMs {0.0};
+    unsigned int frame {0};
 
     // RENDER LOOP
     while(!glfwWindowShouldClose(window)) {
@@ -134,6 +107,34 @@ int main(void) {
         globals::lastFrameTime = currentFrameTime;
         processInput(window);
 
+        // move the rocks
+        auto updateStart {std::chrono::steady_clock::now()};
+        glm::mat4* modelMatrices {static_cast<glm::mat4*>(instanceRing.map())};
+        if (modelMatrices) {
+            pool.parallelFor(amount, 4096, [&](size_t first, size_t count) {
+                field.update(currentFrameTime, modelMatrices + first, first, count);
+            });
+        }
+        instanceRing.unmap();
+        auto updateEnd {std::chrono::steady_clock::now()};
+        updateMs += std::chrono::duration<double, std::milli>(updateEnd - updateStart).count();
+        for(unsigned int i = 0; i < rock.meshes.size(); i++)
+        {
+            glBindVertexArray(rock.meshes[i].VAO);
+            glBindBuffer(GL_ARRAY_BUFFER, instanceRing.id());
+            for (unsigned int column = 0; column < 4; column++) {
+                glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                                      (void*)(instanceRing.offset() + column * sizeof(glm::vec4)));
+            }
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        if (++frame % 60 == 0) {
+            std::string title {"LearnOpenGL: asteroids, update " + std::to_string(updateMs / 60.0) + " ms on "
+                               + std::to_string(pool.threadCount()) + " threads"};
+            glfwSetWindowTitle(window, title.c_str());
+            updateMs = 0.0;
+        }
 
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -158,6 +159,7 @@ int main(void) {
         // draw meteorites
         instanceShader.use();
         rock.DrawInstanced(instanceShader, amount);
+        instanceRing.fence();
 
         glfwSwapBuffers(window);
         glfwPollEvents();
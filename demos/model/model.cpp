@@ -86,6 +86,7 @@ int main(void) {
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));	// it's a bit too big for our scene, so scale it down
         modelShader.setMat4("model", model);
+        modelShader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(model))));
         glm::mat4 view = globals::myCamera.getViewMatrix();
         modelShader.setMat4("view", view);
         glm::mat4 projection = glm::perspective(glm::radians(globals::myCamera.zoom), 800.0f / 600.0f, 0.1f, 100.0f);
@@ -0,0 +1,155 @@
+#ifndef ASTEROID_FIELD_H
+#define ASTEROID_FIELD_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <glm/glm.hpp>
+#include <sjd/simd_math.h>
+
+namespace sjd {
+
+// The asteroid ring from the instancing demo, animated: every rock orbits the
+// planet (inner rocks faster, like real orbits) and spins about its own axis.
+// Positions and spins are a function of time only, so update() can be asked for
+// any time and any range of rocks independently. All per-rock data is kept one
+// array per component and pushed through the sjd::simd batch kernels.
+class AsteroidField {
+public:
+    AsteroidField(unsigned int amount, uint64_t seed=1, float radius=150.0f, float offset=25.0f)
+    :   m_amount {amount}
+    ,   m_orbitRadius(amount)
+    ,   m_orbitPhase(amount)
+    ,   m_orbitSpeed(amount)
+    ,   m_height(amount)
+    ,   m_scale(amount)
+    ,   m_inverseScale(amount)
+    ,   m_spinPhase(amount)
+    ,   m_spinSpeed(amount)
+    ,   m_angle(amount)
+    ,   m_sin(amount)
+    ,   m_cos(amount)
+    ,   m_px(amount)
+    ,   m_pz(amount)
+    ,   m_qx(amount)
+    ,   m_qy(amount)
+    ,   m_qz(amount)
+    ,   m_qw(amount)
+    {
+        // same layout as the original demo: rocks spread evenly round a circle,
+        // displaced by up to `offset`, in a flattened band
+        simd::Random random {seed};
+        std::vector<float> dx(amount), dz(amount);
+        random.uniform(dx.data(), amount, -offset, offset);
+        random.uniform(m_height.data(), amount, -offset * 0.4f, offset * 0.4f);
+        random.uniform(dz.data(), amount, -offset, offset);
+        random.uniform(m_scale.data(), amount, 0.05f, 0.25f);
+        random.uniform(m_spinPhase.data(), amount, 0.0f, 2.0f * pi);
+        random.uniform(m_spinSpeed.data(), amount, -1.0f, 1.0f);
+        for (unsigned int i = 0; i < amount; i++) {
+            float angle {static_cast<float>(i) / static_cast<float>(amount) * 2.0f * pi};
+            float x {std::sin(angle) * radius + dx[i]};
+            float z {std::cos(angle) * radius + dz[i]};
+            m_orbitRadius[i] = std::sqrt(x * x + z * z);
+            m_orbitPhase[i] = std::atan2(x, z);
+            // angular speed falls off with radius^1.5; a full orbit at `radius` takes five minutes
+            m_orbitSpeed[i] = (2.0f * pi / 300.0f) * std::pow(radius / m_orbitRadius[i], 1.5f);
+            m_inverseScale[i] = 1.0f / m_scale[i];
+        }
+    }
+
+    size_t size() const {
+        return m_amount;
+    }
+
+    // Model matrices of rocks [first, first + count) at `time` seconds, written to
+    // models[0, count). Different ranges may be updated from different threads.
+    // models may be mapped GL memory: it is only ever written, front to back.
+    void update(float time, glm::mat4* models, size_t first, size_t count) {
+        glm::mat4 staging[chunkSize];
+        // the batch sin/cos is only accurate to 8192 radians, so time wraps round;
+        // rocks jump once every couple of hours in exchange
+        float orbitTime {std::fmod(time, 300.0f * 64.0f)};
+        float spinTime {std::fmod(time, 2.0f * pi * 1024.0f)};
+        for (size_t chunk = first; chunk < first + count; chunk += chunkSize) {
+            size_t n {std::min(chunkSize, first + count - chunk)};
+            float* angle {&m_angle[chunk]};
+            float* s {&m_sin[chunk]};
+            float* c {&m_cos[chunk]};
+
+            for (size_t i = 0; i < n; i++) angle[i] = m_orbitPhase[chunk + i] + m_orbitSpeed[chunk + i] * orbitTime;
+            simd::sinCos(angle, s, c, n);
+            for (size_t i = 0; i < n; i++) {
+                m_px[chunk + i] = s[i] * m_orbitRadius[chunk + i];
+                m_pz[chunk + i] = c[i] * m_orbitRadius[chunk + i];
+            }
+
+            for (size_t i = 0; i < n; i++) angle[i] = 0.5f * (m_spinPhase[chunk + i] + m_spinSpeed[chunk + i] * spinTime);
+            simd::sinCos(angle, s, c, n);
+            for (size_t i = 0; i < n; i++) {
+                m_qx[chunk + i] = spinAxis.x * s[i];
+                m_qy[chunk + i] = spinAxis.y * s[i];
+                m_qz[chunk + i] = spinAxis.z * s[i];
+                m_qw[chunk + i] = c[i];
+            }
+
+            // composed in cache and copied out whole, since the kernel writes a
+            // column of four matrices at a time, which write-combined memory hates
+            simd::composeTRS(transforms(m_scale.data()).offset(chunk), staging, n);
+            std::memcpy(models + (chunk - first), staging, n * sizeof(glm::mat4));
+        }
+    }
+
+    void update(float time, glm::mat4* models) {
+        update(time, models, 0, size());
+    }
+
+    // Normal matrices matching the last update() of the same range. Scale is
+    // uniform, so inverse-transpose is just the rotation divided by the scale.
+    void normalMatrices(glm::mat3* out, size_t first, size_t count) const {
+        glm::mat4 rotations[chunkSize];
+        for (size_t chunk = first; chunk < first + count; chunk += chunkSize) {
+            size_t n {std::min(chunkSize, first + count - chunk)};
+            simd::composeTRS(transforms(m_inverseScale.data()).offset(chunk), rotations, n);
+            for (size_t i = 0; i < n; i++) out[chunk - first + i] = glm::mat3(rotations[i]);
+        }
+    }
+
+private:
+    static constexpr float pi {3.14159265358979f};
+    // rocks handled per kernel call, small enough that each chunk's scratch stays in L1
+    static constexpr size_t chunkSize {256};
+    static inline const glm::vec3 spinAxis {glm::normalize(glm::vec3(0.4f, 0.6f, 0.8f))};
+
+    simd::TRSArrays transforms(const float* scale) const {
+        return {m_px.data(), m_height.data(), m_pz.data(),
+                m_qx.data(), m_qy.data(), m_qz.data(), m_qw.data(),
+                scale, scale, scale};
+    }
+
+    unsigned int m_amount;
+    // per rock, fixed
+    std::vector<float> m_orbitRadius;
+    std::vector<float> m_orbitPhase;
+    std::vector<float> m_orbitSpeed;
+    std::vector<float> m_height;
+    std::vector<float> m_scale;
+    std::vector<float> m_inverseScale;
+    std::vector<float> m_spinPhase;
+    std::vector<float> m_spinSpeed;
+    // per rock, rewritten by update()
+    std::vector<float> m_angle;
+    std::vector<float> m_sin;
+    std::vector<float> m_cos;
+    std::vector<float> m_px;
+    std::vector<float> m_pz;
+    std::vector<float> m_qx;
+    std::vector<float> m_qy;
+    std::vector<float> m_qz;
+    std::vector<float> m_qw;
+};
+
+}
+#endif
@@ -0,0 +1,87 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <array>
+#include <cmath>
+#include <glm/glm.hpp>
+
+namespace sjd {
+
+// Axis aligned bounding box.
+struct AABB {
+    glm::vec3 min {0.0f};
+    glm::vec3 max {0.0f};
+
+    glm::vec3 center() const {
+        return (min + max) * 0.5f;
+    }
+
+    glm::vec3 extents() const {
+        return (max - min) * 0.5f;
+    }
+
+    // box around this box after transforming it, without transforming all 8 corners
+    AABB transformed(const glm::mat4& transform) const {
+        glm::vec3 center {transform * glm::vec4(this->center(), 1.0f)};
+        glm::vec3 halfSize {extents()};
+        glm::vec3 newHalfSize {0.0f};
+        for (int row = 0; row < 3; row++) {
+            for (int column = 0; column < 3; column++) {
+                newHalfSize[row] += std::abs(transform[column][row]) * halfSize[column];
+            }
+        }
+        return {center - newHalfSize, center + newHalfSize};
+    }
+};
+
+struct Sphere {
+    glm::vec3 center {0.0f};
+    float radius {0.0f};
+};
+
+// The six clip planes of a view-projection (or light-space) matrix, pointing inwards.
+class Frustum {
+public:
+    Frustum(const glm::mat4& viewProjection) {
+        for (int i = 0; i < 3; i++) {
+            for (int column = 0; column < 4; column++) {
+                m_planes[2 * i][column]     = viewProjection[column][3] + viewProjection[column][i];
+                m_planes[2 * i + 1][column] = viewProjection[column][3] - viewProjection[column][i];
+            }
+        }
+    }
+
+    // false only if the box is entirely outside one of the planes
+    bool intersects(const AABB& box) const {
+        glm::vec3 center {box.center()};
+        glm::vec3 halfSize {box.extents()};
+        for (const glm::vec4& plane : m_planes) {
+            float distance {plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w};
+            float radius {std::abs(plane.x) * halfSize.x + std::abs(plane.y) * halfSize.y
+                          + std::abs(plane.z) * halfSize.z};
+            if (distance + radius < 0.0f) return false;
+        }
+        return true;
+    }
+
+    // false only if the sphere is entirely outside one of the planes
+    bool intersects(const glm::vec3& center, float radius) const {
+        for (const glm::vec4& plane : m_planes) {
+            // the planes aren't normalized, so scale the radius by each normal's length instead
+            float distance {plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w};
+            if (distance < -radius * glm::length(glm::vec3(plane))) return false;
+        }
+        return true;
+    }
+
+    // left, right, bottom, top, near, far; unnormalized
+    const std::array<glm::vec4, 6>& planes() const {
+        return m_planes;
+    }
+
+private:
+    std::array<glm::vec4, 6> m_planes {};
+};
+
+}
+#endif
@@ -33,6 +33,10 @@ public:
     float mouseSensitivity {};
     float zoom {};
 
+    // sub-pixel offset of the image, in pixels, that jitterProjection() applies;
+    // TemporalAA moves it every frame
+    glm::vec2 jitter {};
+
 
     Camera(glm::vec3 initialPosition = glm::vec3(0.0f, 0.0f, 3.0f),
            glm::vec3 initialFocus = glm::vec3(0.0f));
@@ -41,6 +45,28 @@ public:
         return glm::lookAt(pos, pos + front, up);
     }
 
+    // `projection` moved by `jitter` pixels of a `viewportSize` viewport
+    glm::mat4 jitterProjection(const glm::mat4& projection, glm::vec2 viewportSize) const {
+        glm::vec2 offset {2.0f * jitter / glm::max(viewportSize, glm::vec2(1.0f))};
+        return glm::translate(glm::mat4(1.0f), glm::vec3(offset, 0.0f)) * projection;
+    }
+
+    // The `index`th point of the Halton (2, 3) sequence, centred on 0: offsets
+    // within a pixel that cover it evenly however many of them are used.
+    static glm::vec2 haltonJitter(unsigned int index) {
+        auto halton = [](unsigned int i, unsigned int base) {
+            float result {0.0f};
+            float fraction {1.0f};
+            for (; i > 0; i /= base) {
+                fraction /= static_cast<float>(base);
+                result += fraction * static_cast<float>(i % base);
+            }
+            return result;
+        };
+        // index 0 would be the pixel corner, so start at 1
+        return {halton(index + 1, 2) - 0.5f, halton(index + 1, 3) - 0.5f};
+    }
+
     void processKeyboard(Movement direction, float deltaTime);
 
     void turnTo(glm::vec3 point3d = glm::vec3(0.0f));
@@ -51,6 +77,9 @@ public:
 
     void processMouseScroll(float yoffset);
 
+    // look along `yaw` and `pitch` (degrees), as if turned there with the mouse
+    void setOrientation(float newYaw, float newPitch);
+
 private:
     // calculates the front vector from the Camera's (updated) Euler Angles
     void updateCameraVectors();
@@ -145,6 +174,12 @@ inline void Camera::processMouseScroll(float yoffset) {
         zoom = 45.0f;
 }
 
+inline void Camera::setOrientation(float newYaw, float newPitch) {
+    yaw = newYaw;
+    pitch = newPitch;
+    updateCameraVectors();
+}
+
 inline void Camera::updateCameraVectors() {
     // calculate the new Front vector
     glm::vec3 newFront {};
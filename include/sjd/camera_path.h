@@ -0,0 +1,74 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <cmath>
+#include <vector>
+#include <glm/glm.hpp>
+#include <sjd/camera.h>
+
+namespace sjd {
+
+// A scripted flythrough: a looping list of timed keyframes, each a camera position
+// and the point it looks at. Positions are Catmull-Rom interpolated so the path is
+// smooth through every keyframe; the focus point is interpolated linearly.
+// Evaluating the path only depends on the time passed in, so the same time always
+// produces the same camera.
+class CameraPath {
+public:
+    struct Keyframe {
+        float time;
+        glm::vec3 position;
+        glm::vec3 focus;
+    };
+
+    CameraPath(std::vector<Keyframe> keyframes={})
+    : m_keyframes {keyframes}
+    {
+    }
+
+    void addKeyframe(float time, glm::vec3 position, glm::vec3 focus) {
+        m_keyframes.push_back({time, position, focus});
+    }
+
+    float duration() const {
+        if (m_keyframes.empty()) return 0.0f;
+        return m_keyframes.back().time;
+    }
+
+    // place the camera on the path at `time` (seconds), wrapping past the end
+    void apply(sjd::Camera& camera, float time) const {
+        if (m_keyframes.empty()) return;
+        if (m_keyframes.size() == 1 || duration() <= 0.0f) {
+            camera.pos = m_keyframes.front().position;
+            camera.turnTo(m_keyframes.front().focus);
+            return;
+        }
+        time = std::fmod(time, duration());
+        size_t i {0};
+        while (i + 2 < m_keyframes.size() && m_keyframes[i + 1].time <= time) i++;
+        const Keyframe& k1 {m_keyframes[i]};
+        const Keyframe& k2 {m_keyframes[i + 1]};
+        const Keyframe& k0 {m_keyframes[(i == 0) ? i : i - 1]};
+        const Keyframe& k3 {m_keyframes[(i + 2 < m_keyframes.size()) ? i + 2 : i + 1]};
+        float span {k2.time - k1.time};
+        float t {(span > 0.0f) ? (time - k1.time) / span : 0.0f};
+
+        camera.pos = catmullRom(k0.position, k1.position, k2.position, k3.position, t);
+        camera.turnTo(glm::mix(k1.focus, k2.focus, t));
+    }
+
+private:
+    static glm::vec3 catmullRom(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, glm::vec3 p3, float t) {
+        float t2 {t * t};
+        float t3 {t2 * t};
+        return 0.5f * ((2.0f * p1)
+                       + (p2 - p0) * t
+                       + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2
+                       + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+    }
+
+    std::vector<Keyframe> m_keyframes;
+};
+
+}
+#endif
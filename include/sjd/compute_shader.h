@@ -0,0 +1,92 @@
+#ifndef COMPUTE_SHADER_H
+#define COMPUTE_SHADER_H
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <sjd/profiling.h>
+
+namespace sjd {
+
+// A compute program built from one file, the compute counterpart of sjd::Shader.
+// Needs a 4.3 context (see createCoreWindow's modernGL and hasComputeShaders()).
+class ComputeShader {
+public:
+    // the program ID
+    GLuint m_id;
+
+    ComputeShader(const std::string& computePath) {
+        std::string computeCode;
+        std::ifstream file {computePath};
+        if (!file) {
+            std::cout << "ERROR::COMPUTE_SHADER::FILE_NOT_SUCCESFULLY_READ " << computePath << std::endl;
+        }
+        else {
+            std::stringstream stream;
+            stream << file.rdbuf();
+            computeCode = stream.str();
+        }
+        const char* code {computeCode.c_str()};
+
+        int success {};
+        char infoLog[512];
+        GLuint compute {glCreateShader(GL_COMPUTE_SHADER)};
+        glShaderSource(compute, 1, &code, NULL);
+        glCompileShader(compute);
+        glGetShaderiv(compute, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(compute, 512, NULL, infoLog);
+            std::cout << "ERROR::COMPUTE_SHADER::COMPILATION_FAILED\n" << infoLog << std::endl;
+        }
+
+        m_id = glCreateProgram();
+        glAttachShader(m_id, compute);
+        glLinkProgram(m_id);
+        glGetProgramiv(m_id, GL_LINK_STATUS, &success);
+        if (!success) {
+            glGetProgramInfoLog(m_id, 512, NULL, infoLog);
+            std::cout << "ERROR::COMPUTE_SHADER::LINKING_FAILED\n" << infoLog << std::endl;
+        }
+        glDeleteShader(compute);
+    }
+
+    ~ComputeShader() {
+        glDeleteProgram(m_id);
+    }
+
+    ComputeShader(const ComputeShader&) = delete;
+    ComputeShader& operator=(const ComputeShader&) = delete;
+
+    void use() {glUseProgram(m_id); stats::stateChange();}
+
+    // enough groups of `groupSize` to cover `invocations`
+    void dispatch(unsigned int invocations, unsigned int groupSize) {
+        glDispatchCompute((invocations + groupSize - 1) / groupSize, 1, 1);
+    }
+
+    void setInt(const std::string& name, int value) const {
+        glUniform1i(glGetUniformLocation(m_id, name.c_str()), value);
+    }
+
+    void setUint(const std::string& name, unsigned int value) const {
+        glUniform1ui(glGetUniformLocation(m_id, name.c_str()), value);
+    }
+
+    void setFloat(const std::string& name, float value) const {
+        glUniform1f(glGetUniformLocation(m_id, name.c_str()), value);
+    }
+
+    void setVec4(const std::string& name, const glm::vec4& vec) const {
+        glUniform4fv(glGetUniformLocation(m_id, name.c_str()), 1, &vec[0]);
+    }
+
+    void setMat4(const std::string& name, const glm::mat4& mat) const {
+        glUniformMatrix4fv(glGetUniformLocation(m_id, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    }
+};
+
+}
+#endif
@@ -0,0 +1,303 @@
+#ifndef DEFERRED_SHADING_H
+#define DEFERRED_SHADING_H
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <sjd/light.h>
+#include <sjd/light_buffer.h>
+#include <sjd/profiling.h>
+#include <sjd/shader.h>
+
+namespace sjd {
+
+// Lighting done once per visible pixel instead of once per rasterised fragment
+// per light, for scenes with more point lights than a forward shader can loop
+// over. sjd::Scene drives it when given one with setDeferred().
+//
+// The geometry pass writes the G-buffer at the size of the viewport:
+//   albedo and specular intensity   GL_SRGB8_ALPHA8
+//   octahedral normal and shininess GL_RGB10_A2
+//   depth                           GL_DEPTH_COMPONENT24
+// Positions are rebuilt from depth, so 12 bytes a pixel in all.
+//
+// The light pass then draws into whatever framebuffer was bound before:
+//   - a full screen pass adds the directional light and copies the G-buffer's
+//     depth across, so forward drawing afterwards (light cubes, skybox) still
+//     depth tests against the scene
+//   - every point light is a sphere of its PointLight::range(), all in one
+//     instanced draw from a PointLightBuffer. Only back faces are drawn, with
+//     GL_GEQUAL, so a light only shades pixels whose surface is in front of the
+//     back of its sphere, and still works with the camera inside it. Light adds
+//     up with additive blending.
+//
+// The G-buffer isn't multisampled and shadows aren't read, so this is for
+// comparing against the forward path rather than replacing it yet.
+class DeferredShading {
+public:
+    // albedo, normal and depth take this unit and the two after it
+    static constexpr unsigned int firstTextureUnit {10};
+
+    DeferredShading()
+    :   m_geometryShader {"../code/shaders/lighting.vert.glsl", "../code/shaders/gbuffer.frag.glsl"}
+    ,   m_directionalShader {"../code/shaders/deferred_fullscreen.vert.glsl",
+                             "../code/shaders/deferred_directional.frag.glsl"}
+    ,   m_volumeShader {"../code/shaders/light_volume.vert.glsl", "../code/shaders/light_volume.frag.glsl"}
+    ,   m_width {0}
+    ,   m_height {0}
+    ,   m_fbo {0}
+    ,   m_albedo {0}
+    ,   m_normal {0}
+    ,   m_depth {0}
+    ,   m_previousFramebuffer {0}
+    ,   m_srgbWasEnabled {GL_FALSE}
+    {
+        glGenVertexArrays(1, &m_emptyVao);
+        createSphere();
+    }
+
+    ~DeferredShading() {
+        release();
+        glDeleteVertexArrays(1, &m_emptyVao);
+        glDeleteVertexArrays(1, &m_sphereVao);
+        glDeleteBuffers(1, &m_sphereVbo);
+        glDeleteBuffers(1, &m_sphereEbo);
+    }
+
+    DeferredShading(const DeferredShading&) = delete;
+    DeferredShading& operator=(const DeferredShading&) = delete;
+
+    // meshes draw into the G-buffer with this between beginGeometry() and endGeometry()
+    sjd::Shader& geometryShader() {
+        return m_geometryShader;
+    }
+
+    // bind and clear the G-buffer, resized to the current viewport if that changed
+    void beginGeometry() {
+        m_geometryTimer.begin();
+        GLint viewport[4] {};
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        if (viewport[2] != m_width || viewport[3] != m_height) resize(viewport[2], viewport[3]);
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_previousFramebuffer);
+        // the albedo target is sRGB, so writes need encoding to match reads
+        m_srgbWasEnabled = glIsEnabled(GL_FRAMEBUFFER_SRGB);
+        glEnable(GL_FRAMEBUFFER_SRGB);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+        glViewport(0, 0, m_width, m_height);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        stats::stateChange();
+    }
+
+    void endGeometry() {
+        glBindFramebuffer(GL_FRAMEBUFFER, m_previousFramebuffer);
+        if (!m_srgbWasEnabled) glDisable(GL_FRAMEBUFFER_SRGB);
+        stats::stateChange();
+        m_geometryTimer.end();
+    }
+
+    // light the G-buffer into the framebuffer bound before beginGeometry(),
+    // which should have been cleared to the background
+    void light(const glm::mat4& projection, const glm::mat4& view, const glm::vec3& viewPos,
+               const sjd::DirLight* dirLight, const sjd::PointLightBuffer& pointLights) {
+        m_lightTimer.begin();
+        GLboolean blend {glIsEnabled(GL_BLEND)};
+        GLboolean depthTest {glIsEnabled(GL_DEPTH_TEST)};
+        GLboolean cullFace {glIsEnabled(GL_CULL_FACE)};
+        GLint depthFunc {GL_LESS};
+        glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+        GLint cullFaceMode {GL_BACK};
+        glGetIntegerv(GL_CULL_FACE_MODE, &cullFaceMode);
+        glm::mat4 inverseViewProjection {glm::inverse(projection * view)};
+
+        glActiveTexture(GL_TEXTURE0 + firstTextureUnit);
+        glBindTexture(GL_TEXTURE_2D, m_albedo);
+        glActiveTexture(GL_TEXTURE0 + firstTextureUnit + 1);
+        glBindTexture(GL_TEXTURE_2D, m_normal);
+        glActiveTexture(GL_TEXTURE0 + firstTextureUnit + 2);
+        glBindTexture(GL_TEXTURE_2D, m_depth);
+        glActiveTexture(GL_TEXTURE0);
+        stats::stateChange(3);
+
+        // directional light and depth; every pixel with a surface is written once
+        glDisable(GL_BLEND);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_ALWAYS);
+        glDisable(GL_CULL_FACE);
+        m_directionalShader.use();
+        setGBuffer(m_directionalShader, inverseViewProjection, viewPos);
+        m_directionalShader.setBool("hasDirLight", dirLight != nullptr);
+        if (dirLight) dirLight->computeLight(m_directionalShader);
+        glBindVertexArray(m_emptyVao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        stats::stateChange();
+        stats::drawCall(1);
+
+        // point lights, added on top
+        if (pointLights.count() > 0) {
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_ONE, GL_ONE);
+            glDepthMask(GL_FALSE);
+            glDepthFunc(GL_GEQUAL);
+            glEnable(GL_CULL_FACE);
+            glCullFace(GL_FRONT);
+            // spheres poking through the far plane still need their back faces
+            glEnable(GL_DEPTH_CLAMP);
+            m_volumeShader.use();
+            setGBuffer(m_volumeShader, inverseViewProjection, viewPos);
+            m_volumeShader.setMat4("viewProjection", projection * view);
+            pointLights.bind(m_volumeShader);
+            glBindVertexArray(m_sphereVao);
+            glDrawElementsInstanced(GL_TRIANGLES, m_sphereIndexCount, GL_UNSIGNED_INT, 0,
+                                    static_cast<GLsizei>(pointLights.count()));
+            stats::stateChange();
+            stats::drawCall(m_sphereIndexCount / 3, pointLights.count());
+            glDisable(GL_DEPTH_CLAMP);
+            glDepthMask(GL_TRUE);
+        }
+        glBindVertexArray(0);
+
+        if (!blend) glDisable(GL_BLEND);
+        else glEnable(GL_BLEND);
+        if (!depthTest) glDisable(GL_DEPTH_TEST);
+        glDepthFunc(depthFunc);
+        if (cullFace) glEnable(GL_CULL_FACE);
+        else glDisable(GL_CULL_FACE);
+        glCullFace(cullFaceMode);
+        m_lightTimer.end();
+    }
+
+    // GPU times of the last measured passes, a few frames behind
+    double geometryPassMs() const {
+        return m_geometryTimer.lastMs();
+    }
+
+    double lightPassMs() const {
+        return m_lightTimer.lastMs();
+    }
+
+private:
+    void setGBuffer(sjd::Shader& shader, const glm::mat4& inverseViewProjection, const glm::vec3& viewPos) {
+        shader.setInt("gAlbedoSpec", firstTextureUnit);
+        shader.setInt("gNormalShininess", firstTextureUnit + 1);
+        shader.setInt("gDepth", firstTextureUnit + 2);
+        shader.setMat4("inverseViewProjection", inverseViewProjection);
+        shader.setVec2("screenSize", glm::vec2(m_width, m_height));
+        shader.setVec3("viewPos", viewPos);
+    }
+
+    static unsigned int gBufferTexture(GLint internalFormat, GLenum format, GLenum type, GLsizei width, GLsizei height) {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+        // read with texelFetch, but a complete texture still needs a non-mipmap filter
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return texture;
+    }
+
+    void resize(GLsizei width, GLsizei height) {
+        release();
+        m_width = width;
+        m_height = height;
+        m_albedo = gBufferTexture(GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+        m_normal = gBufferTexture(GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, width, height);
+        m_depth = gBufferTexture(GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, width, height);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        GLint previousFramebuffer {0};
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        glGenFramebuffers(1, &m_fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_albedo, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_normal, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depth, 0);
+        const GLenum attachments[] {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+        glDrawBuffers(2, attachments);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "ERROR::DEFERRED_SHADING::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    }
+
+    void release() {
+        if (m_fbo == 0) return;
+        glDeleteFramebuffers(1, &m_fbo);
+        glDeleteTextures(1, &m_albedo);
+        glDeleteTextures(1, &m_normal);
+        glDeleteTextures(1, &m_depth);
+        m_fbo = 0;
+    }
+
+    // A unit sphere pushed out so its flat faces, not just its corners, reach
+    // radius 1 and the volume covers the whole range.
+    void createSphere() {
+        const unsigned int rings {8};
+        const unsigned int segments {16};
+        const float pi {glm::pi<float>()};
+        const float scale {1.0f / std::cos(pi / rings)};
+        std::vector<float> vertices;
+        for (unsigned int ring = 0; ring <= rings; ring++) {
+            float theta {pi * ring / rings};
+            for (unsigned int segment = 0; segment <= segments; segment++) {
+                float phi {2.0f * pi * segment / segments};
+                vertices.push_back(scale * std::sin(theta) * std::cos(phi));
+                vertices.push_back(scale * std::cos(theta));
+                vertices.push_back(scale * std::sin(theta) * std::sin(phi));
+            }
+        }
+        // wound counter-clockwise seen from outside
+        std::vector<unsigned int> indices;
+        for (unsigned int ring = 0; ring < rings; ring++) {
+            for (unsigned int segment = 0; segment < segments; segment++) {
+                unsigned int a {ring * (segments + 1) + segment};
+                unsigned int b {a + segments + 1};
+                indices.insert(indices.end(), {a, a + 1, b, a + 1, b + 1, b});
+            }
+        }
+        m_sphereIndexCount = static_cast<unsigned int>(indices.size());
+
+        glGenVertexArrays(1, &m_sphereVao);
+        glGenBuffers(1, &m_sphereVbo);
+        glGenBuffers(1, &m_sphereEbo);
+        glBindVertexArray(m_sphereVao);
+        glBindBuffer(GL_ARRAY_BUFFER, m_sphereVbo);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertices.size() * sizeof(float)),
+                     vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_sphereEbo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices.size() * sizeof(unsigned int)),
+                     indices.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    sjd::Shader m_geometryShader;
+    sjd::Shader m_directionalShader;
+    sjd::Shader m_volumeShader;
+    GLsizei m_width;
+    GLsizei m_height;
+    unsigned int m_fbo;
+    unsigned int m_albedo;
+    unsigned int m_normal;
+    unsigned int m_depth;
+    GLint m_previousFramebuffer;
+    GLboolean m_srgbWasEnabled;
+    unsigned int m_emptyVao;
+    unsigned int m_sphereVao;
+    unsigned int m_sphereVbo;
+    unsigned int m_sphereEbo;
+    unsigned int m_sphereIndexCount;
+    sjd::GpuTimer m_geometryTimer;
+    sjd::GpuTimer m_lightTimer;
+};
+
+}
+#endif
@@ -0,0 +1,185 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <algorithm>
+#include <cmath>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <sjd/profiling.h>
+#include <sjd/render_target.h>
+#include <sjd/shader.h>
+
+namespace sjd {
+
+struct DynamicResolutionSettings {
+    float minScale {0.5f};              // of the output's width and height
+    float maxScale {1.0f};
+    float targetFrameMs {16.6f};        // GPU budget for everything from begin() to end()
+    // The scale moves in steps this big, so whatever is sized from the viewport
+    // (G-buffer, Hi-Z pyramid, HDR target) is only reallocated now and then.
+    float scaleStep {0.05f};
+    // after a change, frames to wait before judging the new scale, since the
+    // timings come back a few frames late
+    unsigned int settleFrames {8};
+    float sharpness {0.5f};             // of the upscale, 0 (plain bilinear) to 1
+    RenderTarget::ColourFormat format {RenderTarget::R11G11B10F};
+};
+
+// Draw the scene at less than the output's resolution when it's too slow to
+// hold the frame time, then upscale it with a sharpening filter.
+//
+// The scene goes into the corner of a target allocated at maxScale, with the
+// viewport set to the part being drawn, so changing the scale costs nothing.
+// Before each frame the scale is set from the GPU time of an earlier one: the
+// work that grows with the pixel count goes as the scale squared, so the scale
+// that would just fit is the current one times sqrt(target / measured). It drops
+// straight there, but only comes back up with some headroom to spare, so it
+// doesn't flip between two steps either side of the budget.
+//
+//     resolution.begin(width, height, clearColour);
+//     scene.draw(shader);  // anything that follows the viewport works as is
+//     resolution.end();    // upscale into what was bound before begin()
+//
+// The scene has to be drawn with the output's aspect ratio, which the scaled
+// viewport keeps.
+class DynamicResolution {
+public:
+    DynamicResolution(DynamicResolutionSettings settings={})
+    :   m_settings {settings}
+    ,   m_target {1, 1, {{settings.format}, RenderTarget::DEPTH24}}
+    ,   m_upscaleShader {"../code/shaders/deferred_fullscreen.vert.glsl", "../code/shaders/upscale_sharpen.frag.glsl"}
+    ,   m_scale {0.0f}
+    ,   m_framesSinceChange {0}
+    ,   m_width {1}
+    ,   m_height {1}
+    {
+        m_settings.minScale = std::max(m_settings.minScale, 0.05f);
+        m_settings.maxScale = std::max(m_settings.maxScale, m_settings.minScale);
+        m_settings.scaleStep = std::max(m_settings.scaleStep, 0.01f);
+        m_scale = m_settings.maxScale;
+        glGenVertexArrays(1, &m_emptyVao);
+    }
+
+    ~DynamicResolution() {
+        glDeleteVertexArrays(1, &m_emptyVao);
+    }
+
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+    // Draw into the scaled target from here on, for an output `width` by
+    // `height`, cleared to `clearColour`.
+    void begin(unsigned int width, unsigned int height, glm::vec4 clearColour=glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)) {
+        _update_scale();
+        m_frameTimer.begin();
+        m_target.resize(static_cast<unsigned int>(std::ceil(width * m_settings.maxScale)),
+                        static_cast<unsigned int>(std::ceil(height * m_settings.maxScale)));
+        m_width = std::clamp(static_cast<unsigned int>(std::lround(width * m_scale)), 1u, m_target.width());
+        m_height = std::clamp(static_cast<unsigned int>(std::lround(height * m_scale)), 1u, m_target.height());
+        m_target.bind();
+        glViewport(0, 0, static_cast<GLsizei>(m_width), static_cast<GLsizei>(m_height));
+        // the rest of the target is never sampled, so only clear what's drawn
+        GLboolean scissorTest {glIsEnabled(GL_SCISSOR_TEST)};
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(0, 0, static_cast<GLsizei>(m_width), static_cast<GLsizei>(m_height));
+        glClearColor(clearColour.x, clearColour.y, clearColour.z, clearColour.w);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (!scissorTest) glDisable(GL_SCISSOR_TEST);
+    }
+
+    // upscale what was drawn since begin() into the framebuffer and viewport bound then
+    void end() {
+        m_target.release();
+        m_upscaleTimer.begin();
+        GLint viewport[4] {};
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        GLboolean depthTest {glIsEnabled(GL_DEPTH_TEST)};
+        GLboolean blend {glIsEnabled(GL_BLEND)};
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+        m_target.bindTexture(0);
+        m_upscaleShader.use();
+        m_upscaleShader.setInt("source", 0);
+        m_upscaleShader.setVec2("outputSize", glm::vec2(static_cast<float>(viewport[2]), static_cast<float>(viewport[3])));
+        m_upscaleShader.setVec2("uvScale", glm::vec2(static_cast<float>(m_width) / m_target.width(),
+                                                     static_cast<float>(m_height) / m_target.height()));
+        m_upscaleShader.setFloat("sharpness", std::clamp(m_settings.sharpness, 0.0f, 1.0f));
+        glBindVertexArray(m_emptyVao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+        if (depthTest) glEnable(GL_DEPTH_TEST);
+        if (blend) glEnable(GL_BLEND);
+        stats::drawCall(1);
+        m_upscaleTimer.end();
+        m_frameTimer.end();
+    }
+
+    // Set the scale (clamped to the settings' range) as if the controller had
+    // just picked it. It carries on from there; a `targetFrameMs` of 0 holds it.
+    void setScale(float scale) {
+        m_scale = std::clamp(scale, m_settings.minScale, m_settings.maxScale);
+        m_framesSinceChange = 0;
+    }
+
+    float scale() const {
+        return m_scale;
+    }
+
+    // size drawn at this frame
+    unsigned int width() const {
+        return m_width;
+    }
+
+    unsigned int height() const {
+        return m_height;
+    }
+
+    DynamicResolutionSettings& settings() {
+        return m_settings;
+    }
+
+    // GPU times, a few frames behind: begin() to end(), which is what's held to
+    // the target, and the upscale alone
+    double frameMs() const {
+        return m_frameTimer.lastMs();
+    }
+
+    double upscaleMs() const {
+        return m_upscaleTimer.lastMs();
+    }
+
+private:
+    // the scale only grows when the bigger step is predicted to fit in this
+    // much of the budget
+    static constexpr float growHeadroom {0.9f};
+
+    void _update_scale() {
+        m_framesSinceChange++;
+        double ms {m_frameTimer.lastMs()};
+        if (m_settings.targetFrameMs <= 0.0f || ms <= 0.0 || m_framesSinceChange <= m_settings.settleFrames) return;
+        float budget {m_settings.targetFrameMs};
+        if (ms < budget) budget *= growHeadroom;
+        float fit {m_scale * static_cast<float>(std::sqrt(budget / ms))};
+        // round down to a step, so a step is only taken when it's predicted to fit
+        float steps {std::floor(fit / m_settings.scaleStep + 1.0e-3f)};
+        float scale {std::clamp(steps * m_settings.scaleStep, m_settings.minScale, m_settings.maxScale)};
+        // under budget it only ever grows and over it only ever shrinks
+        if ((ms < m_settings.targetFrameMs) ? scale <= m_scale : scale >= m_scale) return;
+        m_scale = scale;
+        m_framesSinceChange = 0;
+    }
+
+    DynamicResolutionSettings m_settings;
+    RenderTarget m_target;
+    Shader m_upscaleShader;
+    float m_scale;
+    unsigned int m_framesSinceChange;
+    unsigned int m_width;
+    unsigned int m_height;
+    unsigned int m_emptyVao;
+    GpuTimer m_frameTimer;
+    GpuTimer m_upscaleTimer;
+};
+
+}
+#endif
@@ -0,0 +1,206 @@
+#ifndef GAUSSIAN_BLUR_H
+#define GAUSSIAN_BLUR_H
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <sjd/compute_shader.h>
+#include <sjd/glfw_setup.h>
+#include <sjd/profiling.h>
+#include <sjd/render_target.h>
+#include <sjd/render_target_pool.h>
+#include <sjd/shader.h>
+
+namespace sjd {
+
+// Gaussian blur of a render target's first colour attachment, as a horizontal
+// then a vertical pass through a scratch target of the same shape. Separating
+// it makes a radius r blur 2 (2r + 1) taps a pixel instead of (2r + 1)^2, which
+// is what makes wide blurs (bloom, soft shadows, depth of field) affordable.
+//
+// FRAGMENT merges pairs of neighbouring taps into one bilinear fetch, about
+// r + 1 fetches a pixel per pass. COMPUTE (4.3) has each work group load a run
+// of texels and its apron into shared memory once and take every tap from
+// there; it writes with image stores, so the target has to be RGBA8,
+// R11G11B10F or RGBA16F.
+//
+// The radius is in texels, up to maxRadius, with sigma a third of it so the
+// weights have fallen to about 1% at the edge.
+class GaussianBlur {
+public:
+    enum Method {
+        FRAGMENT,
+        COMPUTE
+    };
+
+    static constexpr unsigned int maxRadius {64};
+
+    // COMPUTE falls back to FRAGMENT when the context has no compute shaders
+    GaussianBlur(Method method=FRAGMENT)
+    :   m_method {method}
+    ,   m_shader {"../code/shaders/deferred_fullscreen.vert.glsl", "../code/shaders/blur_separable.frag.glsl"}
+    ,   m_radius {0}
+    {
+        if (m_method == COMPUTE && !hasComputeShaders()) {
+            std::cout << "ERROR::GAUSSIAN_BLUR::NO_COMPUTE_SHADERS blurring with fragment shaders instead" << std::endl;
+            m_method = FRAGMENT;
+        }
+        if (m_method == COMPUTE) m_computeShader = std::make_unique<ComputeShader>("../code/shaders/blur.comp.glsl");
+        glGenVertexArrays(1, &m_emptyVao);
+    }
+
+    ~GaussianBlur() {
+        glDeleteVertexArrays(1, &m_emptyVao);
+    }
+
+    GaussianBlur(const GaussianBlur&) = delete;
+    GaussianBlur& operator=(const GaussianBlur&) = delete;
+
+    // blur `target` in place, going through `scratch`, which must match it in
+    // size and description
+    void blur(RenderTarget& target, RenderTarget& scratch, unsigned int radius) {
+        if (scratch.width() != target.width() || scratch.height() != target.height()
+            || !(scratch.description() == target.description())) {
+            std::cout << "ERROR::GAUSSIAN_BLUR::SCRATCH_MISMATCH" << std::endl;
+            return;
+        }
+        radius = std::min(radius, maxRadius);
+        if (radius == 0) return;
+        _set_radius(radius);
+        m_timer.begin();
+        if (m_method == COMPUTE) {
+            _compute_pass(target, scratch, glm::ivec2(1, 0));
+            _compute_pass(scratch, target, glm::ivec2(0, 1));
+        }
+        else {
+            _fragment_pass(target, scratch, glm::vec2(1.0f / target.width(), 0.0f));
+            _fragment_pass(scratch, target, glm::vec2(0.0f, 1.0f / target.height()));
+        }
+        m_timer.end();
+    }
+
+    // the same with a scratch target borrowed from `pool`
+    void blur(RenderTarget& target, RenderTargetPool& pool, unsigned int radius) {
+        RenderTarget& scratch {pool.acquire(target.width(), target.height(), target.description())};
+        blur(target, scratch, radius);
+        pool.release(scratch);
+    }
+
+    // One side of the normalised kernel, weights[0] being the centre: `radius`
+    // + 1 weights, and the two sides together sum to 1.
+    static std::vector<float> weights(unsigned int radius) {
+        radius = std::min(radius, maxRadius);
+        float sigma {std::max(static_cast<float>(radius) / 3.0f, 0.5f)};
+        std::vector<float> result(radius + 1);
+        float total {0.0f};
+        for (unsigned int i = 0; i <= radius; i++) {
+            result[i] = std::exp(-0.5f * static_cast<float>(i * i) / (sigma * sigma));
+            total += (i == 0) ? result[i] : 2.0f * result[i];
+        }
+        for (float& weight : result) weight /= total;
+        return result;
+    }
+
+    // The kernel for linear filtering: the centre tap alone, then each pair of
+    // texels i, i + 1 as one fetch at their weighted mean offset with their summed
+    // weight. Each entry is (offset in texels, weight).
+    static std::vector<glm::vec2> bilinearTaps(unsigned int radius) {
+        std::vector<float> discrete {weights(radius)};
+        std::vector<glm::vec2> taps {{0.0f, discrete[0]}};
+        for (size_t i = 1; i < discrete.size(); i += 2) {
+            if (i + 1 == discrete.size()) {
+                taps.push_back({static_cast<float>(i), discrete[i]});
+                break;
+            }
+            float weight {discrete[i] + discrete[i + 1]};
+            float offset {(i * discrete[i] + (i + 1) * discrete[i + 1]) / weight};
+            taps.push_back({offset, weight});
+        }
+        return taps;
+    }
+
+    Method method() const {
+        return m_method;
+    }
+
+    // GPU time of the last measured blur, both passes, a few frames behind
+    double lastMs() const {
+        return m_timer.lastMs();
+    }
+
+private:
+    // upload the kernel for `radius` if it isn't the one already there
+    void _set_radius(unsigned int radius) {
+        if (radius == m_radius) return;
+        m_radius = radius;
+        if (m_method == COMPUTE) {
+            std::vector<float> discrete {weights(radius)};
+            m_computeShader->use();
+            m_computeShader->setInt("radius", static_cast<int>(radius));
+            glUniform1fv(glGetUniformLocation(m_computeShader->m_id, "weights"),
+                         static_cast<GLsizei>(discrete.size()), discrete.data());
+            return;
+        }
+        std::vector<glm::vec2> taps {bilinearTaps(radius)};
+        std::vector<float> offsets;
+        std::vector<float> tapWeights;
+        for (const glm::vec2& tap : taps) {
+            offsets.push_back(tap.x);
+            tapWeights.push_back(tap.y);
+        }
+        m_shader.use();
+        m_shader.setInt("image", 0);
+        m_shader.setInt("tapCount", static_cast<int>(taps.size()));
+        glUniform1fv(glGetUniformLocation(m_shader.m_id, "offsets"), static_cast<GLsizei>(offsets.size()),
+                     offsets.data());
+        glUniform1fv(glGetUniformLocation(m_shader.m_id, "weights"), static_cast<GLsizei>(tapWeights.size()),
+                     tapWeights.data());
+    }
+
+    void _fragment_pass(RenderTarget& source, RenderTarget& destination, glm::vec2 direction) {
+        GLboolean depthTest {glIsEnabled(GL_DEPTH_TEST)};
+        GLboolean blend {glIsEnabled(GL_BLEND)};
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+        destination.bind();
+        source.bindTexture(0);
+        m_shader.use();
+        m_shader.setVec2("direction", direction);
+        glBindVertexArray(m_emptyVao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+        destination.release();
+        if (depthTest) glEnable(GL_DEPTH_TEST);
+        if (blend) glEnable(GL_BLEND);
+        stats::drawCall(1);
+    }
+
+    void _compute_pass(RenderTarget& source, RenderTarget& destination, glm::ivec2 direction) {
+        m_computeShader->use();
+        source.bindTexture(0);
+        m_computeShader->setInt("image", 0);
+        glUniform2i(glGetUniformLocation(m_computeShader->m_id, "direction"), direction.x, direction.y);
+        glBindImageTexture(0, destination.colourTexture(), 0, GL_FALSE, 0, GL_WRITE_ONLY,
+                           RenderTarget::internalFormat(destination.description().colour[0]));
+        unsigned int extent {direction.x ? source.width() : source.height()};
+        unsigned int lines {direction.x ? source.height() : source.width()};
+        glDispatchCompute((extent + 127) / 128, lines, 1);
+        // the next pass, or whoever samples the result, reads what was just stored
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        stats::stateChange(2);
+    }
+
+    Method m_method;
+    Shader m_shader;
+    std::unique_ptr<ComputeShader> m_computeShader;
+    unsigned int m_emptyVao;
+    unsigned int m_radius;
+    GpuTimer m_timer;
+};
+
+}
+#endif
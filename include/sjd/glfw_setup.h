@@ -3,18 +3,40 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <map>
 
 namespace sjd {
-GLFWwindow* createCoreWindow(uint32_t windowWidth, uint32_t windowHeight, uint16_t msaa=1);
+// How a window's edges are anti-aliased: by the window's own samples, or by a
+// post pass (sjd::PostAntiAliasing) over a single sampled window.
+enum AntiAliasing {
+    MSAA,
+    FXAA,
+    SMAA
+};
+
+// modernGL asks for a 4.3 context (compute shaders, indirect draws) and settles
+// for 3.3 where there isn't one; check hasComputeShaders() before relying on it
+GLFWwindow* createCoreWindow(uint32_t windowWidth, uint32_t windowHeight, uint16_t msaa=1, bool modernGL=false);
+// the same, with `msaa` samples only when antiAliasing is MSAA
+GLFWwindow* createCoreWindow(uint32_t windowWidth, uint32_t windowHeight, AntiAliasing antiAliasing,
+                             uint16_t msaa=4, bool modernGL=false);
+// what a window was created with, MSAA for one created without saying
+AntiAliasing windowAntiAliasing(GLFWwindow* window);
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
+bool hasComputeShaders();
+
+inline std::map<GLFWwindow*, AntiAliasing>& _window_anti_aliasing() {
+    static std::map<GLFWwindow*, AntiAliasing> modes;
+    return modes;
+}
 
-inline GLFWwindow* createCoreWindow(uint32_t windowWidth, uint32_t windowHeight, uint16_t msaa){
+inline GLFWwindow* createCoreWindow(uint32_t windowWidth, uint32_t windowHeight, uint16_t msaa, bool modernGL){
     glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, modernGL ? 4 : 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     if (msaa > 1) {
-        glfwWindowHint(GLFW_SAMPLES, 4);
+        glfwWindowHint(GLFW_SAMPLES, msaa);
     }
     GLFWwindow* window = glfwCreateWindow(windowWidth, 
                             windowHeight, 
@@ -22,6 +44,11 @@ inline GLFWwindow* createCoreWindow(uint32_t windowWidth, uint32_t windowHeight,
                             NULL, 
                             NULL
     );
+    if (!window && modernGL) {
+        std::cout << "no OpenGL 4.3 context, falling back to 3.3" << std::endl;
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        window = glfwCreateWindow(windowWidth, windowHeight, "LearnOpenGL: transformations", NULL, NULL);
+    }
     if (!window) {
         std::cout << "Failed to create GLFW window." << std::endl;
         glfwTerminate();
@@ -40,6 +67,22 @@ inline GLFWwindow* createCoreWindow(uint32_t windowWidth, uint32_t windowHeight,
     return window;
 }
 
+inline GLFWwindow* createCoreWindow(uint32_t windowWidth, uint32_t windowHeight, AntiAliasing antiAliasing,
+                                    uint16_t msaa, bool modernGL) {
+    GLFWwindow* window {createCoreWindow(windowWidth, windowHeight, (antiAliasing == MSAA) ? msaa : 1, modernGL)};
+    if (window) _window_anti_aliasing()[window] = antiAliasing;
+    return window;
+}
+
+inline AntiAliasing windowAntiAliasing(GLFWwindow* window) {
+    auto mode {_window_anti_aliasing().find(window)};
+    return (mode == _window_anti_aliasing().end()) ? MSAA : mode->second;
+}
+
+inline bool hasComputeShaders() {
+    return GLAD_GL_VERSION_4_3 != 0;
+}
+
 // callback function for when the window is resized by a user 
 inline void framebufferSizeCallback([[maybe_unused]] GLFWwindow* window, int width, int height)
 {
@@ -0,0 +1,196 @@
+#ifndef HDR_PIPELINE_H
+#define HDR_PIPELINE_H
+
+#include <algorithm>
+#include <string>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <sjd/profiling.h>
+#include <sjd/render_graph.h>
+#include <sjd/render_target.h>
+#include <sjd/shader.h>
+
+namespace sjd {
+
+struct HdrSettings {
+    float exposure {1.0f};
+    float bloomStrength {0.04f};        // how much of the bloom is mixed in
+    unsigned int bloomLevels {6};       // half, quarter, ... size steps in the chain
+    float filterRadius {1.0f};          // of the upsampling tent, in texels of the smaller level
+};
+
+// Render the scene in linear HDR to an R11G11B10F target instead of straight to
+// the (sRGB) window, then add bloom and tonemap it down to the window.
+//
+// The bloom is a chain of ever smaller targets rather than a full resolution
+// blur: each level is a 13 tap downsample of the one above, then the levels are
+// added back up the chain with a 3x3 tent filter. Every step is a small
+// fixed-size filter on a quarter as many pixels as the last, so the whole chain
+// costs about one and a half full resolution passes however wide the glow gets.
+//
+//     hdr.begin(width, height);
+//     scene.draw(shader);
+//     hdr.end();          // bloom and tonemap into what was bound before begin()
+//
+// Each stage is its own RenderGraph pass, timed, so downsampleMs(), upsampleMs()
+// and compositeMs() say what it costs; addPasses() puts the same passes on
+// another graph instead.
+class HdrPipeline {
+public:
+    HdrPipeline(HdrSettings settings={})
+    :   m_settings {settings}
+    ,   m_target {1, 1, {{RenderTarget::R11G11B10F}, RenderTarget::DEPTH24}}
+    ,   m_downsampleShader {"../code/shaders/deferred_fullscreen.vert.glsl", "../code/shaders/bloom_downsample.frag.glsl"}
+    ,   m_upsampleShader {"../code/shaders/deferred_fullscreen.vert.glsl", "../code/shaders/bloom_upsample.frag.glsl"}
+    ,   m_compositeShader {"../code/shaders/deferred_fullscreen.vert.glsl", "../code/shaders/hdr_composite.frag.glsl"}
+    {
+        m_settings.bloomLevels = std::max(m_settings.bloomLevels, 1u);
+        glGenVertexArrays(1, &m_emptyVao);
+        m_graph.setTiming(true);
+    }
+
+    ~HdrPipeline() {
+        glDeleteVertexArrays(1, &m_emptyVao);
+    }
+
+    HdrPipeline(const HdrPipeline&) = delete;
+    HdrPipeline& operator=(const HdrPipeline&) = delete;
+
+    // Draw into the HDR target from here on, cleared to `clearColour` (which
+    // is linear, not sRGB), at the size of what's being drawn to the window.
+    void begin(unsigned int width, unsigned int height, glm::vec4 clearColour=glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)) {
+        m_target.resize(width, height);
+        m_target.bind();
+        glClearColor(clearColour.x, clearColour.y, clearColour.z, clearColour.w);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        m_sceneTimer.begin();
+    }
+
+    // bloom and tonemap the HDR target into the framebuffer bound at begin()
+    void end() {
+        m_sceneTimer.end();
+        m_target.release();
+        m_graph.importTarget("hdr", m_target);
+        m_graph.importBackbuffer("output");
+        addPasses(m_graph, "hdr", "output");
+        m_graph.execute();
+    }
+
+    // The bloom chain and tonemap as passes on `graph`, from the target `hdr` to
+    // `output`. The chain's targets are transients sized from the graph's backbuffer.
+    void addPasses(RenderGraph& graph, const std::string& hdr, const std::string& output) {
+        unsigned int levels {m_settings.bloomLevels};
+        for (unsigned int level = 0; level < levels; level++) {
+            graph.createTarget(_level(level), {{RenderTarget::R11G11B10F}, RenderTarget::NO_DEPTH},
+                               1.0f / static_cast<float>(2u << level));
+        }
+        for (unsigned int level = 0; level < levels; level++) {
+            std::string source {(level == 0) ? hdr : _level(level - 1)};
+            graph.addPass("bloom_down_" + std::to_string(level), [this, source, level](RenderGraph::Context& context) {
+                context.bindTexture(source, 0);
+                m_downsampleShader.use();
+                m_downsampleShader.setInt("source", 0);
+                m_downsampleShader.setBool("karisAverage", level == 0);
+                _draw(m_downsampleShader, context, false);
+            }).read(source).write(_level(level));
+        }
+        for (unsigned int level = levels - 1; level > 0; level--) {
+            std::string source {_level(level)};
+            graph.addPass("bloom_up_" + std::to_string(level), [this, source](RenderGraph::Context& context) {
+                context.bindTexture(source, 0);
+                m_upsampleShader.use();
+                m_upsampleShader.setInt("source", 0);
+                m_upsampleShader.setFloat("filterRadius", m_settings.filterRadius);
+                _draw(m_upsampleShader, context, true);
+            }).read(source).write(_level(level - 1));
+        }
+        graph.addPass("hdr_composite", [this, hdr](RenderGraph::Context& context) {
+            context.bindTexture(hdr, 0);
+            context.bindTexture(_level(0), 1);
+            m_compositeShader.use();
+            m_compositeShader.setInt("hdr", 0);
+            m_compositeShader.setInt("bloom", 1);
+            m_compositeShader.setFloat("exposure", m_settings.exposure);
+            m_compositeShader.setFloat("bloomStrength", m_settings.bloomStrength);
+            m_compositeShader.setBool("encodeGamma", !glIsEnabled(GL_FRAMEBUFFER_SRGB));
+            _draw(m_compositeShader, context, false);
+        }).read(hdr).read(_level(0)).write(output);
+    }
+
+    HdrSettings& settings() {
+        return m_settings;
+    }
+
+    RenderTarget& target() {
+        return m_target;
+    }
+
+    // GPU times of the last measured frame's stages, a few frames behind:
+    // the scene between begin() and end(), then the passes end() runs
+    double sceneMs() const {
+        return m_sceneTimer.lastMs();
+    }
+
+    double downsampleMs() const {
+        double total {0.0};
+        for (unsigned int level = 0; level < m_settings.bloomLevels; level++) {
+            total += m_graph.passMs("bloom_down_" + std::to_string(level));
+        }
+        return total;
+    }
+
+    double upsampleMs() const {
+        double total {0.0};
+        for (unsigned int level = 1; level < m_settings.bloomLevels; level++) {
+            total += m_graph.passMs("bloom_up_" + std::to_string(level));
+        }
+        return total;
+    }
+
+    double compositeMs() const {
+        return m_graph.passMs("hdr_composite");
+    }
+
+private:
+    static std::string _level(unsigned int level) {
+        return "bloom_" + std::to_string(level);
+    }
+
+    // one full-screen triangle, added on top when `additive`
+    void _draw(Shader& shader, const RenderGraph::Context& context, bool additive) {
+        shader.setVec2("outputSize", glm::vec2(static_cast<float>(context.width()),
+                                               static_cast<float>(context.height())));
+        GLboolean depthTest {glIsEnabled(GL_DEPTH_TEST)};
+        GLboolean blend {glIsEnabled(GL_BLEND)};
+        GLint blendSource {GL_ONE};
+        GLint blendDestination {GL_ZERO};
+        glGetIntegerv(GL_BLEND_SRC_RGB, &blendSource);
+        glGetIntegerv(GL_BLEND_DST_RGB, &blendDestination);
+        glDisable(GL_DEPTH_TEST);
+        if (additive) {
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_ONE, GL_ONE);
+        }
+        else glDisable(GL_BLEND);
+        glBindVertexArray(m_emptyVao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+        if (depthTest) glEnable(GL_DEPTH_TEST);
+        if (blend) glEnable(GL_BLEND);
+        else glDisable(GL_BLEND);
+        if (additive) glBlendFunc(static_cast<GLenum>(blendSource), static_cast<GLenum>(blendDestination));
+        stats::drawCall(1);
+    }
+
+    HdrSettings m_settings;
+    RenderTarget m_target;
+    Shader m_downsampleShader;
+    Shader m_upsampleShader;
+    Shader m_compositeShader;
+    unsigned int m_emptyVao;
+    RenderGraph m_graph;
+    GpuTimer m_sceneTimer;
+};
+
+}
+#endif
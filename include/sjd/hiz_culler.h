@@ -0,0 +1,405 @@
+#ifndef HIZ_CULLER_H
+#define HIZ_CULLER_H
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <sjd/bounds.h>
+#include <sjd/compute_shader.h>
+#include <sjd/glfw_setup.h>
+#include <sjd/profiling.h>
+#include <sjd/shader.h>
+
+namespace sjd {
+
+// Occlusion culling against the previous frame's depth. After a frame is drawn,
+// update() copies the depth of the bound framebuffer into a pyramid of mip
+// levels, each texel the farthest depth of the four below it, and tests a list
+// of world space boxes against it: a box is hidden if its nearest depth is
+// behind the farthest depth over the (at most 2x2) texels of the level where
+// it covers about one texel. The results come back a frame or so later and
+// visible() answers for the next draws; sjd::Scene uses it through
+// setOcclusionCuller() to skip hidden meshes.
+//
+// On a 4.3 context (GPU) a compute shader tests every box and only the
+// visibility flags are read back. On 3.3 (CPU) one coarse level of the pyramid
+// is read back through a pixel buffer and the boxes are tested against that on
+// the CPU. Either way nothing waits on the GPU: a new test only starts once the
+// last one's fence has passed.
+//
+// Being a frame late, something that comes out from behind an occluder may
+// show up a frame late too. Boxes that reach behind the camera or off screen
+// are always visible, so frustum culling stays a separate job.
+//
+// The depth is copied with glBlitFramebuffer, so the framebuffer's depth format
+// has to be 24 bit depth with 8 bits of stencil (GLFW's default window).
+class HiZCuller {
+public:
+    enum Mode {
+        CPU,
+        GPU
+    };
+
+    // GPU falls back to CPU when the context has no compute shaders
+    HiZCuller(Mode mode=GPU)
+    :   m_mode {mode}
+    ,   m_reduceShader {"../code/shaders/deferred_fullscreen.vert.glsl", "../code/shaders/hiz_reduce.frag.glsl"}
+    ,   m_width {0}
+    ,   m_height {0}
+    ,   m_levels {0}
+    ,   m_readbackLevel {0}
+    ,   m_depth {0}
+    ,   m_pyramid {0}
+    ,   m_depthFbo {0}
+    ,   m_pyramidFbo {0}
+    ,   m_fence {nullptr}
+    ,   m_pendingCount {0}
+    ,   m_occludedCount {0}
+    {
+        if (m_mode == GPU && !hasComputeShaders()) {
+            std::cout << "ERROR::HIZ_CULLER::NO_COMPUTE_SHADERS culling on the CPU instead" << std::endl;
+            m_mode = CPU;
+        }
+        glGenVertexArrays(1, &m_emptyVao);
+        if (m_mode == GPU) {
+            m_cullShader = std::make_unique<ComputeShader>("../code/shaders/hiz_cull.comp.glsl");
+            glGenBuffers(1, &m_boxes);
+            glGenBuffers(1, &m_flags);
+        }
+        else {
+            glGenBuffers(1, &m_readback);
+        }
+    }
+
+    ~HiZCuller() {
+        release();
+        glDeleteVertexArrays(1, &m_emptyVao);
+        if (m_mode == GPU) {
+            glDeleteBuffers(1, &m_boxes);
+            glDeleteBuffers(1, &m_flags);
+        }
+        else {
+            glDeleteBuffers(1, &m_readback);
+        }
+        if (m_fence) glDeleteSync(m_fence);
+    }
+
+    HiZCuller(const HiZCuller&) = delete;
+    HiZCuller& operator=(const HiZCuller&) = delete;
+
+    Mode mode() const {
+        return m_mode;
+    }
+
+    // false only if the last finished test found box `index` hidden
+    bool visible(size_t index) const {
+        return index >= m_visibility.size() || m_visibility[index] != 0;
+    }
+
+    // boxes the last finished test found hidden
+    unsigned int occludedCount() const {
+        return m_occludedCount;
+    }
+
+    // GPU time of the last measured pyramid build and test, a few frames behind
+    double cullMs() const {
+        return m_timer.lastMs();
+    }
+
+    // Collect the previous test if it's done, and if so start another on the
+    // bound framebuffer's depth, with the boxes as they were drawn this frame.
+    void update(const glm::mat4& viewProjection, const std::vector<AABB>& boxes) {
+        collect();
+        if (m_fence) return;
+
+        m_timer.begin();
+        buildPyramid();
+        m_pendingCount = static_cast<unsigned int>(boxes.size());
+        if (m_mode == GPU) startGpuTest(viewProjection, boxes);
+        else               startReadback(viewProjection, boxes);
+        m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_timer.end();
+    }
+
+    // The test itself, shared with hiz_cull.comp.glsl: `farthest(level, x, y)`
+    // gives the pyramid depth at a texel of a level that's `baseSize >> level`
+    // in size (at least 1), and levels from `firstLevel` up are available.
+    template <typename Fetch>
+    static bool occluded(const AABB& box, const glm::mat4& viewProjection, glm::ivec2 baseSize,
+                         unsigned int levels, unsigned int firstLevel, Fetch farthest) {
+        glm::vec3 ndcMin {FLT_MAX};
+        glm::vec3 ndcMax {-FLT_MAX};
+        for (unsigned int corner = 0; corner < 8; corner++) {
+            glm::vec3 point {(corner & 1) ? box.max.x : box.min.x,
+                             (corner & 2) ? box.max.y : box.min.y,
+                             (corner & 4) ? box.max.z : box.min.z};
+            glm::vec4 clip {viewProjection * glm::vec4(point, 1.0f)};
+            // reaching behind the camera, nothing to go on
+            if (clip.w <= 1e-5f) return false;
+            glm::vec3 ndc {glm::vec3(clip) / clip.w};
+            ndcMin = glm::min(ndcMin, ndc);
+            ndcMax = glm::max(ndcMax, ndc);
+        }
+        if (ndcMax.x < -1.0f || ndcMax.y < -1.0f || ndcMin.x > 1.0f || ndcMin.y > 1.0f) return false;
+        float nearest {ndcMin.z * 0.5f + 0.5f};
+        if (nearest <= 0.0f) return false;
+
+        float pixelMinX {std::clamp(ndcMin.x * 0.5f + 0.5f, 0.0f, 1.0f) * static_cast<float>(baseSize.x)};
+        float pixelMinY {std::clamp(ndcMin.y * 0.5f + 0.5f, 0.0f, 1.0f) * static_cast<float>(baseSize.y)};
+        float pixelMaxX {std::clamp(ndcMax.x * 0.5f + 0.5f, 0.0f, 1.0f) * static_cast<float>(baseSize.x)};
+        float pixelMaxY {std::clamp(ndcMax.y * 0.5f + 0.5f, 0.0f, 1.0f) * static_cast<float>(baseSize.y)};
+        float extent {std::max(std::max(pixelMaxX - pixelMinX, pixelMaxY - pixelMinY), 1.0f)};
+        unsigned int level {static_cast<unsigned int>(std::ceil(std::log2(extent)))};
+        level = std::min(std::max(level, firstLevel), levels - 1);
+
+        // level texels cover 2^level pixels, the last in a row or column whatever's left
+        int lastX {std::max(1, baseSize.x >> level) - 1};
+        int lastY {std::max(1, baseSize.y >> level) - 1};
+        float scale {1.0f / static_cast<float>(1u << level)};
+        int texelMinX {std::min(static_cast<int>(pixelMinX * scale), lastX)};
+        int texelMinY {std::min(static_cast<int>(pixelMinY * scale), lastY)};
+        int texelMaxX {std::min(static_cast<int>(pixelMaxX * scale), lastX)};
+        int texelMaxY {std::min(static_cast<int>(pixelMaxY * scale), lastY)};
+        float farthestDepth {0.0f};
+        for (int y = texelMinY; y <= texelMaxY; y++) {
+            for (int x = texelMinX; x <= texelMaxX; x++) {
+                farthestDepth = std::max(farthestDepth, farthest(level, x, y));
+            }
+        }
+        return nearest > farthestDepth;
+    }
+
+private:
+    // every level from the viewport's size down to 1x1, and the coarse one the CPU reads
+    void resize(GLsizei width, GLsizei height) {
+        release();
+        m_width = width;
+        m_height = height;
+        m_levels = static_cast<unsigned int>(std::floor(std::log2(static_cast<float>(std::max(width, height))))) + 1;
+        m_readbackLevel = 0;
+        while (m_readbackLevel + 1 < m_levels && std::max(width >> m_readbackLevel, height >> m_readbackLevel) > 256) {
+            m_readbackLevel++;
+        }
+
+        glGenTextures(1, &m_depth);
+        glBindTexture(GL_TEXTURE_2D, m_depth);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0,
+                     GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glGenTextures(1, &m_pyramid);
+        glBindTexture(GL_TEXTURE_2D, m_pyramid);
+        for (unsigned int level = 0; level < m_levels; level++) {
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), GL_R32F,
+                         std::max(1, width >> level), std::max(1, height >> level), 0, GL_RED, GL_FLOAT, NULL);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(m_levels - 1));
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        GLint previousFramebuffer {0};
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        glGenFramebuffers(1, &m_depthFbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_depthFbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_depth, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "ERROR::HIZ_CULLER::DEPTH_FRAMEBUFFER_INCOMPLETE" << std::endl;
+        }
+        glGenFramebuffers(1, &m_pyramidFbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    }
+
+    void release() {
+        if (m_depth == 0) return;
+        glDeleteFramebuffers(1, &m_depthFbo);
+        glDeleteFramebuffers(1, &m_pyramidFbo);
+        glDeleteTextures(1, &m_depth);
+        glDeleteTextures(1, &m_pyramid);
+        m_depth = 0;
+    }
+
+    // copy the depth, then halve it level by level keeping the farthest
+    void buildPyramid() {
+        GLint viewport[4] {};
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        if (viewport[2] != m_width || viewport[3] != m_height) resize(viewport[2], viewport[3]);
+        GLint previousFramebuffer {0};
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        GLboolean depthTest {glIsEnabled(GL_DEPTH_TEST)};
+        GLboolean cullFace {glIsEnabled(GL_CULL_FACE)};
+        GLboolean blend {glIsEnabled(GL_BLEND)};
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, previousFramebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_depthFbo);
+        glBlitFramebuffer(viewport[0], viewport[1], viewport[0] + m_width, viewport[1] + m_height,
+                          0, 0, m_width, m_height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_CULL_FACE);
+        glDisable(GL_BLEND);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_pyramidFbo);
+        m_reduceShader.use();
+        m_reduceShader.setInt("source", 0);
+        glBindVertexArray(m_emptyVao);
+        glActiveTexture(GL_TEXTURE0);
+        for (unsigned int level = 0; level < m_levels; level++) {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_pyramid,
+                                   static_cast<GLint>(level));
+            glViewport(0, 0, std::max(1, m_width >> level), std::max(1, m_height >> level));
+            if (level == 0) {
+                glBindTexture(GL_TEXTURE_2D, m_depth);
+            }
+            else {
+                // only the level below is visible to sampling, so reading it
+                // while writing this one isn't a feedback loop
+                glBindTexture(GL_TEXTURE_2D, m_pyramid);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(level - 1));
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(level - 1));
+            }
+            m_reduceShader.setBool("copy", level == 0);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            stats::drawCall(1);
+        }
+        glBindTexture(GL_TEXTURE_2D, m_pyramid);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(m_levels - 1));
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindVertexArray(0);
+        stats::stateChange(2 * m_levels + 2);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        if (depthTest) glEnable(GL_DEPTH_TEST);
+        if (cullFace) glEnable(GL_CULL_FACE);
+        if (blend) glEnable(GL_BLEND);
+    }
+
+    void startGpuTest(const glm::mat4& viewProjection, const std::vector<AABB>& boxes) {
+        if (boxes.empty()) return;
+        std::vector<glm::vec4> packed;
+        packed.reserve(boxes.size() * 2);
+        for (const AABB& box : boxes) {
+            packed.push_back(glm::vec4(box.min, 0.0f));
+            packed.push_back(glm::vec4(box.max, 0.0f));
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_boxes);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(packed.size() * sizeof(glm::vec4)),
+                     packed.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_flags);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(boxes.size() * sizeof(uint32_t)),
+                     NULL, GL_STREAM_READ);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_boxes);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_flags);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, m_pyramid);
+        m_cullShader->use();
+        m_cullShader->setInt("pyramid", 0);
+        m_cullShader->setMat4("viewProjection", viewProjection);
+        m_cullShader->setUint("boxCount", static_cast<unsigned int>(boxes.size()));
+        m_cullShader->setInt("levels", static_cast<int>(m_levels));
+        m_cullShader->dispatch(static_cast<unsigned int>(boxes.size()), 64);
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    void startReadback(const glm::mat4& viewProjection, const std::vector<AABB>& boxes) {
+        m_pendingViewProjection = viewProjection;
+        m_pendingBoxes = boxes;
+        GLsizei width {std::max(1, m_width >> m_readbackLevel)};
+        GLsizei height {std::max(1, m_height >> m_readbackLevel)};
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readback);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(width * height * sizeof(float)),
+                     NULL, GL_STREAM_READ);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_2D, m_pyramid);
+        glGetTexImage(GL_TEXTURE_2D, static_cast<GLint>(m_readbackLevel), GL_RED, GL_FLOAT, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    // take the pending results if the GPU has finished with them
+    void collect() {
+        if (!m_fence || glClientWaitSync(m_fence, 0, 0) == GL_TIMEOUT_EXPIRED) return;
+        glDeleteSync(m_fence);
+        m_fence = nullptr;
+
+        m_visibility.assign(m_pendingCount, 1);
+        if (m_pendingCount == 0) {
+            m_occludedCount = 0;
+            return;
+        }
+        if (m_mode == GPU) {
+            std::vector<uint32_t> flags(m_pendingCount);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_flags);
+            glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(flags.size() * sizeof(uint32_t)),
+                               flags.data());
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            for (size_t i = 0; i < flags.size(); i++) m_visibility[i] = static_cast<uint8_t>(flags[i] != 0);
+        }
+        else {
+            GLsizei width {std::max(1, m_width >> m_readbackLevel)};
+            GLsizei height {std::max(1, m_height >> m_readbackLevel)};
+            m_cpuDepth.resize(static_cast<size_t>(width) * height);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readback);
+            const void* mapped {glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                                                 static_cast<GLsizeiptr>(m_cpuDepth.size() * sizeof(float)),
+                                                 GL_MAP_READ_BIT)};
+            if (mapped) {
+                std::memcpy(m_cpuDepth.data(), mapped, m_cpuDepth.size() * sizeof(float));
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            if (mapped) {
+                auto fetch {[&](unsigned int, int x, int y) { return m_cpuDepth[static_cast<size_t>(y) * width + x]; }};
+                for (size_t i = 0; i < m_pendingBoxes.size(); i++) {
+                    m_visibility[i] = !occluded(m_pendingBoxes[i], m_pendingViewProjection,
+                                                glm::ivec2(m_width, m_height), m_readbackLevel + 1,
+                                                m_readbackLevel, fetch);
+                }
+            }
+        }
+        m_occludedCount = static_cast<unsigned int>(std::count(m_visibility.begin(), m_visibility.end(), 0));
+    }
+
+    Mode m_mode;
+    sjd::Shader m_reduceShader;
+    std::unique_ptr<ComputeShader> m_cullShader;
+    GLsizei m_width;
+    GLsizei m_height;
+    unsigned int m_levels;
+    unsigned int m_readbackLevel;
+    unsigned int m_depth;
+    unsigned int m_pyramid;
+    unsigned int m_depthFbo;
+    unsigned int m_pyramidFbo;
+    unsigned int m_emptyVao;
+    // GPU: boxes in, a flag per box out
+    unsigned int m_boxes {0};
+    unsigned int m_flags {0};
+    // CPU: the coarse level, and what to test against it once it arrives
+    unsigned int m_readback {0};
+    glm::mat4 m_pendingViewProjection {1.0f};
+    std::vector<AABB> m_pendingBoxes;
+    std::vector<float> m_cpuDepth;
+    GLsync m_fence;
+    unsigned int m_pendingCount;
+    std::vector<uint8_t> m_visibility;
+    unsigned int m_occludedCount;
+    GpuTimer m_timer;
+};
+
+}
+#endif
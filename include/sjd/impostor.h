@@ -0,0 +1,254 @@
+#ifndef IMPOSTOR_H
+#define IMPOSTOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <sjd/bounds.h>
+#include <sjd/model.h>
+#include <sjd/profiling.h>
+#include <sjd/shader.h>
+
+namespace sjd {
+
+// A stand-in for a model too far away for its triangles to matter: a single
+// quad textured with a picture of the model taken from the nearest of a set of
+// directions around it.
+//
+// The pictures are rendered once, when the impostor is made, into an atlas of
+// frames x frames views laid out by octahedral mapping (each cell is the view
+// from the direction that maps to its centre, so the whole sphere of directions
+// is covered evenly). Each cell holds the colour, and in a second texture the
+// model space normal plus the depth through the bounding sphere, so the quads
+// can be lit and can write proper depth against the real meshes.
+//
+// Far impostors sample the atlas's small mips, so each cell has a gutter around
+// its view (the same picture, taken a little wider) and the mip chain stops
+// while the gutter is still a texel wide: a cell never takes in its neighbours.
+// Where nothing was drawn both textures stay 0, so a mip texel's colour, normal
+// and depth are weighted by how much of it was covered, and the shader divides
+// that coverage (the albedo's alpha) back out rather than averaging in the
+// background.
+//
+// Instances are mat4s at attributes 3-6 as for instanced meshes; point them at
+// the instance data (sjd::InstanceCuller does this for its impostor range) and
+// draw with code/shaders/impostor.vert.glsl / impostor.frag.glsl.
+class Impostor {
+public:
+    static constexpr unsigned int indexCount {6};
+
+    Impostor(Model& model, unsigned int frames=12, unsigned int frameSize=128)
+    :   m_bounds {model.bounds()}
+    ,   m_frames {frames}
+    ,   m_frameSize {frameSize}
+    ,   m_gutter {std::max(frameSize / 16u, 1u)}
+    {
+        createQuad();
+        bake(model);
+    }
+
+    ~Impostor() {
+        glDeleteTextures(1, &m_albedo);
+        glDeleteTextures(1, &m_normalDepth);
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &m_vbo);
+        glDeleteBuffers(1, &m_ebo);
+    }
+
+    Impostor(const Impostor&) = delete;
+    Impostor& operator=(const Impostor&) = delete;
+
+    const Sphere& bounds() const {
+        return m_bounds;
+    }
+
+    // bind the atlas and set what the impostor shaders need to know about it
+    void bind(Shader& shader) const {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, m_albedo);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, m_normalDepth);
+        glActiveTexture(GL_TEXTURE0);
+        shader.setInt("impostor.albedo", 0);
+        shader.setInt("impostor.normalDepth", 1);
+        shader.setInt("impostor.frames", static_cast<int>(m_frames));
+        shader.setFloat("impostor.border", static_cast<float>(m_gutter) / static_cast<float>(cellSize()));
+        shader.setVec4("impostor.bounds", glm::vec4(m_bounds.center, m_bounds.radius));
+        stats::stateChange(2);
+    }
+
+    void drawInstanced(Shader& shader, unsigned int amount) const {
+        if (amount == 0) return;
+        bind(shader);
+        glBindVertexArray(VAO);
+        glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, amount);
+        glBindVertexArray(0);
+        stats::stateChange();
+        stats::drawCall(indexCount / 3, amount);
+    }
+
+    // one command from the bound GL_DRAW_INDIRECT_BUFFER (4.3 contexts only)
+    void drawIndirect(Shader& shader, GLintptr commandOffset) const {
+        bind(shader);
+        glBindVertexArray(VAO);
+        glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)commandOffset);
+        glBindVertexArray(0);
+        stats::stateChange();
+        stats::drawCall(0);
+    }
+
+    // the quad, with instance attributes 3-6 enabled
+    unsigned int VAO;
+
+private:
+    // the same mapping as impostor.vert.glsl: directions on the unit sphere to
+    // [-1, 1]^2, upper hemisphere in the middle diamond, lower folded into the corners
+    static glm::vec3 octahedralDirection(glm::vec2 uv) {
+        glm::vec3 n {uv.x, 1.0f - std::abs(uv.x) - std::abs(uv.y), uv.y};
+        if (n.y < 0.0f) {
+            float x {n.x};
+            n.x = (1.0f - std::abs(n.z)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+            n.z = (1.0f - std::abs(x)) * ((n.z >= 0.0f) ? 1.0f : -1.0f);
+        }
+        return glm::normalize(n);
+    }
+
+    // also as in the shader, so a cell's picture lines up with the quad drawn for it
+    static glm::vec3 referenceUp(const glm::vec3& direction) {
+        return (std::abs(direction.y) > 0.99f) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+
+    void createQuad() {
+        const float corners[] {-1.0f, -1.0f,  1.0f, -1.0f,  1.0f, 1.0f,  -1.0f, 1.0f};
+        const unsigned int indices[] {0, 1, 2, 0, 2, 3};
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &m_vbo);
+        glGenBuffers(1, &m_ebo);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        for (unsigned int column = 0; column < 4; column++) {
+            glEnableVertexAttribArray(3 + column);
+            glVertexAttribDivisor(3 + column, 1);
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    unsigned int cellSize() const {
+        return m_frameSize + 2 * m_gutter;
+    }
+
+    // The last mip whose texels still don't reach across the gutter, with cells
+    // starting on a texel of it; a cell's view is still 16 texels or more there.
+    int maxLevel() const {
+        int level {0};
+        while ((2u << level) <= m_gutter && cellSize() % (2u << level) == 0) level++;
+        return level;
+    }
+
+    unsigned int atlasTexture(GLsizei size) const {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxLevel());
+        return texture;
+    }
+
+    // Render the model orthographically from the direction of every cell.
+    void bake(Model& model) {
+        GLsizei size {static_cast<GLsizei>(m_frames * cellSize())};
+        m_albedo = atlasTexture(size);
+        m_normalDepth = atlasTexture(size);
+
+        // the caller's state, put back afterwards
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        GLint previousFramebuffer {0};
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        GLfloat clearColour[4];
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColour);
+        GLboolean depthTest {glIsEnabled(GL_DEPTH_TEST)};
+        GLboolean cullFace {glIsEnabled(GL_CULL_FACE)};
+
+        unsigned int fbo, depth;
+        glGenFramebuffers(1, &fbo);
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_albedo, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_normalDepth, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+        const GLenum attachments[] {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+        glDrawBuffers(2, attachments);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "ERROR::IMPOSTOR::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        }
+
+        glEnable(GL_DEPTH_TEST);
+        glDisable(GL_CULL_FACE);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);   // no coverage, and nothing to add to a mip
+        glViewport(0, 0, size, size);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        Shader shader {"../code/shaders/impostor_bake.vert.glsl", "../code/shaders/impostor_bake.frag.glsl"};
+        shader.use();
+        shader.setMat4("model", glm::mat4(1.0f));
+        const float radius {m_bounds.radius};
+        // the bounding sphere fills the inside of the cell and the gutter sees a bit
+        // more; depth 0 on the near side of the sphere, 1 on the far side
+        const float extent {radius * static_cast<float>(cellSize()) / static_cast<float>(m_frameSize)};
+        glm::mat4 projection {glm::ortho(-extent, extent, -extent, extent, 0.0f, 2.0f * radius)};
+        for (unsigned int y = 0; y < m_frames; y++) {
+            for (unsigned int x = 0; x < m_frames; x++) {
+                glm::vec2 uv {(glm::vec2(x, y) + 0.5f) / static_cast<float>(m_frames) * 2.0f - 1.0f};
+                glm::vec3 direction {octahedralDirection(uv)};
+                glm::mat4 view {glm::lookAt(m_bounds.center + direction * radius, m_bounds.center,
+                                            referenceUp(direction))};
+                shader.setMat4("viewProjection", projection * view);
+                glViewport(static_cast<GLint>(x * cellSize()), static_cast<GLint>(y * cellSize()),
+                           static_cast<GLsizei>(cellSize()), static_cast<GLsizei>(cellSize()));
+                model.Draw(shader);
+            }
+        }
+
+        glBindTexture(GL_TEXTURE_2D, m_albedo);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, m_normalDepth);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &depth);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        glClearColor(clearColour[0], clearColour[1], clearColour[2], clearColour[3]);
+        if (!depthTest) glDisable(GL_DEPTH_TEST);
+        if (cullFace) glEnable(GL_CULL_FACE);
+    }
+
+    Sphere m_bounds;
+    unsigned int m_frames;
+    unsigned int m_frameSize;
+    unsigned int m_gutter;      // texels around each cell's view
+    unsigned int m_albedo;
+    unsigned int m_normalDepth;
+    unsigned int m_vbo;
+    unsigned int m_ebo;
+};
+
+}
+#endif
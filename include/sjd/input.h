@@ -0,0 +1,311 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <sjd/camera.h>
+#include <sjd/mouse_input.h>
+
+namespace sjd {
+
+// Everything the player reacts to in one frame. Sources fill these in from live
+// GLFW state or from a recording, so Player doesn't care where input comes from.
+struct InputFrame {
+    enum Key : uint8_t {
+        FORWARD  = 1 << 0,
+        BACKWARD = 1 << 1,
+        LEFT     = 1 << 2,
+        RIGHT    = 1 << 3,
+        UP       = 1 << 4,
+        DOWN     = 1 << 5,
+        QUIT     = 1 << 6,
+    };
+
+    float deltaTime {0.0f};
+    glm::vec2 mouseOffset {0.0f, 0.0f};
+    float scroll {0.0f};
+    uint8_t keys {0};
+
+    bool pressed(Key key) const {
+        return (keys & key) != 0;
+    }
+};
+
+// Where the camera was when a recording started. Input is relative (mouse
+// offsets, held keys), so a replay only retraces the recorded path from here.
+struct CameraPose {
+    glm::vec3 pos {0.0f, 0.0f, 3.0f};
+    float yaw {-90.0f};
+    float pitch {0.0f};
+    float zoom {45.0f};
+
+    static CameraPose of(const Camera& camera) {
+        return {camera.pos, camera.yaw, camera.pitch, camera.zoom};
+    }
+
+    void apply(Camera& camera) const {
+        camera.pos = pos;
+        camera.zoom = zoom;
+        camera.setOrientation(yaw, pitch);
+    }
+};
+
+class InputSource {
+public:
+    virtual ~InputSource() = default;
+
+    // fill in the next frame of input; returns false once the source is exhausted
+    virtual bool poll(InputFrame& frame, float deltaTime) = 0;
+
+    // the pose the camera has to start from for this input, if the source has
+    // one (a recording does)
+    virtual bool startPose([[maybe_unused]] CameraPose& pose) const {
+        return false;
+    }
+};
+
+// Live keyboard and mouse input from a GLFW window.
+class GlfwInput: public InputSource {
+public:
+    GlfwInput(GLFWwindow* window)
+    :   m_window {window}
+    ,   m_mouse {window}
+    {
+    }
+
+    bool poll(InputFrame& frame, float deltaTime) {
+        frame.deltaTime = deltaTime;
+        frame.mouseOffset = m_mouse.getoffsets();
+        frame.scroll = m_mouse.getScroll();
+        frame.keys = 0;
+        if (glfwGetKey(m_window, GLFW_KEY_W) == GLFW_PRESS) frame.keys |= InputFrame::FORWARD;
+        if (glfwGetKey(m_window, GLFW_KEY_S) == GLFW_PRESS) frame.keys |= InputFrame::BACKWARD;
+        if (glfwGetKey(m_window, GLFW_KEY_A) == GLFW_PRESS) frame.keys |= InputFrame::LEFT;
+        if (glfwGetKey(m_window, GLFW_KEY_D) == GLFW_PRESS) frame.keys |= InputFrame::RIGHT;
+        if (glfwGetKey(m_window, GLFW_KEY_SPACE) == GLFW_PRESS) frame.keys |= InputFrame::UP;
+        if (glfwGetKey(m_window, GLFW_KEY_C) == GLFW_PRESS) frame.keys |= InputFrame::DOWN;
+        if (glfwGetKey(m_window, GLFW_KEY_ESCAPE) == GLFW_PRESS) frame.keys |= InputFrame::QUIT;
+        return true;
+    }
+
+private:
+    GLFWwindow* m_window;
+    Mouse m_mouse;
+};
+
+// Recordings are a stream of small events rather than a snapshot per frame:
+//
+//   header:  "SJDI" u16 version u16 reserved
+//            f32 x, f32 y, f32 z, f32 yaw, f32 pitch, f32 zoom   (the camera's start pose)
+//   event:   u8 type, then
+//            FRAME  f32 deltaTime    (closes the frame; timestamps are the running sum)
+//            KEYS   u8 keys          (only when the held keys change)
+//            MOUSE  f32 dx, f32 dy   (only when the mouse moved)
+//            SCROLL f32 y            (only when the wheel moved)
+//
+// An idle frame costs 5 bytes. Values are stored unquantised so a replay feeds
+// Camera exactly the numbers it saw when recording.
+namespace input_file {
+    constexpr char magic[4] {'S', 'J', 'D', 'I'};
+    constexpr uint16_t version {2};
+
+    enum Event : uint8_t {
+        FRAME  = 0,
+        KEYS   = 1,
+        MOUSE  = 2,
+        SCROLL = 3,
+    };
+}
+
+class InputRecorder {
+public:
+    // `camera` is where the recording starts from
+    InputRecorder(const std::string& path, const Camera& camera)
+    : m_file {path, std::ios::binary}
+    , m_keys {0}
+    {
+        if (!m_file) {
+            std::cout << "ERROR::INPUT::RECORDER::CANNOT_OPEN " << path << std::endl;
+            return;
+        }
+        uint16_t version {input_file::version};
+        uint16_t reserved {0};
+        m_file.write(input_file::magic, sizeof(input_file::magic));
+        write(version);
+        write(reserved);
+        CameraPose pose {CameraPose::of(camera)};
+        write(pose.pos.x);
+        write(pose.pos.y);
+        write(pose.pos.z);
+        write(pose.yaw);
+        write(pose.pitch);
+        write(pose.zoom);
+    }
+
+    void record(const InputFrame& frame) {
+        if (!m_file) return;
+        if (frame.keys != m_keys) {
+            write(input_file::KEYS);
+            write(frame.keys);
+            m_keys = frame.keys;
+        }
+        if (frame.mouseOffset.x != 0.0f || frame.mouseOffset.y != 0.0f) {
+            write(input_file::MOUSE);
+            write(frame.mouseOffset.x);
+            write(frame.mouseOffset.y);
+        }
+        if (frame.scroll != 0.0f) {
+            write(input_file::SCROLL);
+            write(frame.scroll);
+        }
+        write(input_file::FRAME);
+        write(frame.deltaTime);
+    }
+
+private:
+    template <typename T>
+    void write(T value) {
+        m_file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    std::ofstream m_file;
+    uint8_t m_keys;
+};
+
+// Plays a recording back. FRAME_LOCKED hands out recorded frames one per poll,
+// including their recorded deltaTime, so the camera follows the exact same path
+// regardless of how fast frames are rendered. REALTIME instead advances by the
+// caller's deltaTime and merges every recorded frame whose timestamp has passed.
+class InputReplay: public InputSource {
+public:
+    enum Mode {
+        FRAME_LOCKED,
+        REALTIME
+    };
+
+    InputReplay(const std::string& path, Mode mode=FRAME_LOCKED)
+    : m_mode {mode}
+    , m_next {0}
+    , m_clock {0.0}
+    , m_hasStartPose {false}
+    {
+        load(path);
+    }
+
+    bool poll(InputFrame& frame, float deltaTime) {
+        if (finished()) return false;
+        if (m_mode == FRAME_LOCKED) {
+            frame = m_frames[m_next++];
+            return true;
+        }
+        m_clock += deltaTime;
+        frame = InputFrame {};
+        frame.deltaTime = deltaTime;
+        if (m_next > 0) frame.keys = m_frames[m_next - 1].keys;
+        while (m_next < m_frames.size() && m_timestamps[m_next] <= m_clock) {
+            frame.mouseOffset += m_frames[m_next].mouseOffset;
+            frame.scroll += m_frames[m_next].scroll;
+            frame.keys = m_frames[m_next].keys;
+            m_next++;
+        }
+        return true;
+    }
+
+    bool startPose(CameraPose& pose) const {
+        if (m_hasStartPose) pose = m_startPose;
+        return m_hasStartPose;
+    }
+
+    bool finished() const {
+        return m_next >= m_frames.size();
+    }
+
+    size_t frameCount() const {
+        return m_frames.size();
+    }
+
+    double duration() const {
+        return m_timestamps.empty() ? 0.0 : m_timestamps.back();
+    }
+
+    void rewind() {
+        m_next = 0;
+        m_clock = 0.0;
+    }
+
+private:
+    void load(const std::string& path) {
+        std::ifstream file {path, std::ios::binary};
+        char magic[4] {};
+        uint16_t version {};
+        uint16_t reserved {};
+        file.read(magic, sizeof(magic));
+        read(file, version);
+        read(file, reserved);
+        read(file, m_startPose.pos.x);
+        read(file, m_startPose.pos.y);
+        read(file, m_startPose.pos.z);
+        read(file, m_startPose.yaw);
+        read(file, m_startPose.pitch);
+        read(file, m_startPose.zoom);
+        if (!file || std::memcmp(magic, input_file::magic, sizeof(magic)) != 0
+                  || version != input_file::version) {
+            std::cout << "ERROR::INPUT::REPLAY::BAD_FILE " << path << std::endl;
+            return;
+        }
+        m_hasStartPose = true;
+
+        InputFrame current {};
+        double timestamp {0.0};
+        uint8_t type {};
+        while (read(file, type)) {
+            switch (type) {
+                case input_file::KEYS:
+                    read(file, current.keys);
+                    break;
+                case input_file::MOUSE:
+                    read(file, current.mouseOffset.x);
+                    read(file, current.mouseOffset.y);
+                    break;
+                case input_file::SCROLL:
+                    read(file, current.scroll);
+                    break;
+                case input_file::FRAME:
+                    read(file, current.deltaTime);
+                    timestamp += current.deltaTime;
+                    m_frames.push_back(current);
+                    m_timestamps.push_back(timestamp);
+                    // held keys carry over, one-shot deltas don't
+                    current.mouseOffset = {0.0f, 0.0f};
+                    current.scroll = 0.0f;
+                    break;
+                default:
+                    std::cout << "ERROR::INPUT::REPLAY::BAD_EVENT " << int(type) << std::endl;
+                    return;
+            }
+        }
+    }
+
+    template <typename T>
+    static bool read(std::ifstream& file, T& value) {
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    Mode m_mode;
+    std::vector<InputFrame> m_frames;
+    std::vector<double> m_timestamps;
+    size_t m_next;
+    double m_clock;
+    CameraPose m_startPose;
+    bool m_hasStartPose;
+};
+
+}
+#endif
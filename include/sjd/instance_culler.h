@@ -0,0 +1,486 @@
+#ifndef INSTANCE_CULLER_H
+#define INSTANCE_CULLER_H
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <sjd/bounds.h>
+#include <sjd/compute_shader.h>
+#include <sjd/glfw_setup.h>
+#include <sjd/impostor.h>
+#include <sjd/model.h>
+#include <sjd/profiling.h>
+#include <sjd/shader.h>
+
+namespace sjd {
+
+// Frustum culling and level of detail selection for an instanced model. Each
+// frame cull() takes every instance's model matrix, drops the instances whose
+// bounding sphere is outside the view or smaller than minScreenSize pixels, picks
+// a level of detail for the rest by their size on screen, and packs the
+// survivors into one buffer grouped by level; draw() then draws each level of
+// each mesh once.
+//
+// On a 4.3 context (GPU) this all happens in a compute shader reading the
+// instances straight from their buffer, and draw() issues indirect draws whose
+// instance counts never leave the GPU. On 3.3 (CPU) the same steps run on the
+// CPU from a copy of the matrices and the packed buffer is uploaded, one
+// instanced draw per mesh and level. Either way instances are mat4s at
+// attributes 3-6, as in the instancing demo's shader.
+//
+// With a crossfade band, instances near a switch are drawn at both levels and
+// the fragment shader dithers between them. The fade rides along in the unused
+// bottom row of the packed matrix (element [0][3]), so the instance shader must
+// read and clear it; see code/shaders/instancing_fade.vert.glsl.
+//
+// Given an sjd::Impostor, instances further away than impostorDistance are
+// packed into one more range after the levels and drawn as impostors by
+// drawImpostors() instead.
+class InstanceCuller {
+public:
+    enum Mode {
+        CPU,
+        GPU
+    };
+
+    struct Settings {
+        // projected bounding sphere diameter, in pixels, an instance must reach to
+        // keep level i; below all of them it gets the last level. Levels past
+        // what the meshes have are ignored. Left empty, the sizes come from the
+        // model's simplification errors and maxScreenError
+        std::vector<float> lodScreenSizes {};
+        // instances smaller than this on screen aren't drawn at all
+        float minScreenSize {1.0f};
+        // pixels of simplification error allowed on screen before a finer level is used
+        float maxScreenError {1.0f};
+        // how far above each switching size (as a fraction of it) both levels are
+        // drawn and dithered together; 0 switches outright
+        float crossfadeBand {0.0f};
+        // view depth beyond which instances are drawn as the impostor, if there is one
+        float impostorDistance {0.0f};
+    };
+
+    static constexpr unsigned int maxLods {5};
+
+    // GPU falls back to CPU when the context has no compute shaders. The
+    // impostor, if any, must outlive the culler.
+    InstanceCuller(Model& model, unsigned int maxInstances, Mode mode, const Settings& settings,
+                   const Impostor* impostor=nullptr)
+    :   m_model {model}
+    ,   m_impostor {impostor}
+    ,   m_maxInstances {maxInstances}
+    ,   m_mode {mode}
+    ,   m_settings {settings}
+    ,   m_visibleCount {0}
+    ,   m_frame {0}
+    {
+        if (m_mode == GPU && !hasComputeShaders()) {
+            std::cout << "ERROR::INSTANCE_CULLER::NO_COMPUTE_SHADERS culling on the CPU instead" << std::endl;
+            m_mode = CPU;
+        }
+        Sphere bounds {m_model.bounds()};
+        m_center = bounds.center;
+        m_radius = bounds.radius;
+        computeLevels();
+        // a crossfading instance takes a slot in two levels
+        m_capacity = m_maxInstances * ((m_settings.crossfadeBand > 0.0f) ? 2 : 1);
+
+        glGenBuffers(1, &m_visible);
+        glBindBuffer(GL_ARRAY_BUFFER, m_visible);
+        glBufferData(GL_ARRAY_BUFFER, m_capacity * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        for (ModelMesh& mesh : m_model.m_meshes) {
+            glBindVertexArray(mesh.VAO);
+            for (unsigned int column = 0; column < 4; column++) {
+                glEnableVertexAttribArray(3 + column);
+                glVertexAttribDivisor(3 + column, 1);
+            }
+        }
+        glBindVertexArray(0);
+
+        if (m_mode == GPU) createGpuResources();
+        else               m_choices.resize(m_maxInstances);
+    }
+
+    ~InstanceCuller() {
+        glDeleteBuffers(1, &m_visible);
+        if (m_mode == GPU) {
+            glDeleteBuffers(1, &m_slots);
+            glDeleteBuffers(1, &m_counters);
+            glDeleteBuffers(1, &m_commands);
+            glDeleteBuffers(1, &m_ranges);
+            glDeleteBuffers(1, &m_readback);
+            for (GLsync& fence : m_readbackFences) {
+                if (fence) glDeleteSync(fence);
+            }
+        }
+    }
+
+    InstanceCuller(const InstanceCuller&) = delete;
+    InstanceCuller& operator=(const InstanceCuller&) = delete;
+
+    Mode mode() const {
+        return m_mode;
+    }
+
+    unsigned int levels() const {
+        return m_levels;
+    }
+
+    // instances drawn as the impostor by the last drawImpostors(), on the same
+    // terms as visibleCount()
+    unsigned int impostorCount() const {
+        return m_impostor ? m_lodCounts[m_levels] : 0;
+    }
+
+    // Instances drawn by the last draw(), counting crossfading ones twice. Exact
+    // for CPU; for GPU it's read back a few frames late so that asking never stalls.
+    unsigned int visibleCount() const {
+        return m_visibleCount;
+    }
+
+    // triangles drawn by the last draw(), on the same terms as visibleCount()
+    uint64_t trianglesDrawn() const {
+        uint64_t triangles {0};
+        for (unsigned int level = 0; level < m_levels; level++) {
+            triangles += static_cast<uint64_t>(m_lodCounts[level]) * m_levelTriangles[level];
+        }
+        return triangles + impostorCount() * (Impostor::indexCount / 3);
+    }
+
+    // GPU: `count` matrices at `offset` in `buffer`, which must be aligned to
+    // GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT (sjd::StreamRing regions are)
+    void cull(GLuint buffer, GLintptr offset, unsigned int count,
+              const glm::mat4& view, const glm::mat4& projection, float viewportHeight) {
+        if (m_mode != GPU) {
+            std::cout << "ERROR::INSTANCE_CULLER::NOT_GPU use the matrix overload" << std::endl;
+            return;
+        }
+        count = std::min(count, m_maxInstances);
+        readCounters();
+        const std::array<GLuint, counterCount> zeros {};
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_counters);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zeros), zeros.data());
+        if (count > 0) {
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, buffer, offset,
+                              static_cast<GLsizeiptr>(count * sizeof(glm::mat4)));
+        }
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_visible);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_slots);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_counters);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_commands);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, m_ranges);
+        stats::stateChange(7);
+
+        m_compute->use();
+        m_compute->setUint("count", count);
+        m_compute->setUint("levels", m_levels);
+        m_compute->setUint("meshCount", static_cast<unsigned int>(m_model.m_meshes.size()));
+        m_compute->setVec4("bounds", glm::vec4(m_center, m_radius));
+        m_compute->setMat4("view", view);
+        m_compute->setFloat("pixelsPerUnit", pixelsPerUnit(projection, viewportHeight));
+        m_compute->setFloat("minScreenSize", m_settings.minScreenSize);
+        m_compute->setFloat("crossfadeBand", m_settings.crossfadeBand);
+        m_compute->setUint("impostorBucket", m_impostor ? m_levels : culled);
+        m_compute->setFloat("impostorDistance", m_settings.impostorDistance);
+        const Frustum frustum {projection * view};
+        for (unsigned int i = 0; i < 6; i++) {
+            m_compute->setVec4("planes[" + std::to_string(i) + "]", frustum.planes()[i]);
+        }
+        for (unsigned int i = 0; i + 1 < m_levels; i++) {
+            m_compute->setFloat("lodScreenSizes[" + std::to_string(i) + "]", m_screenSizes[i]);
+        }
+
+        // classify and count, then one invocation turns the counts into offsets
+        // and draw commands, then everything visible is copied into place
+        m_compute->setUint("stage", 0);
+        m_compute->dispatch(count, groupSize);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        m_compute->setUint("stage", 1);
+        m_compute->dispatch(1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        m_compute->setUint("stage", 2);
+        m_compute->dispatch(count, groupSize);
+        glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+        unsigned int slot {static_cast<unsigned int>(m_frame % m_readbackFences.size())};
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_readback);
+        glBindBuffer(GL_COPY_READ_BUFFER, m_counters);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                            0, slot * sizeof(zeros), sizeof(zeros));
+        if (m_readbackFences[slot]) glDeleteSync(m_readbackFences[slot]);
+        m_readbackFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_frame++;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    // CPU: `count` matrices in ordinary memory
+    void cull(const glm::mat4* instances, unsigned int count,
+              const glm::mat4& view, const glm::mat4& projection, float viewportHeight) {
+        if (m_mode != CPU) {
+            std::cout << "ERROR::INSTANCE_CULLER::NOT_CPU use the buffer overload" << std::endl;
+            return;
+        }
+        count = std::min(count, m_maxInstances);
+        const Frustum frustum {projection * view};
+        const float scale {pixelsPerUnit(projection, viewportHeight)};
+        m_lodCounts.fill(0);
+        for (unsigned int i = 0; i < count; i++) {
+            const Choice& choice {m_choices[i] = classify(instances[i], frustum, view, scale)};
+            if (choice.level == culled) continue;
+            m_lodCounts[choice.level]++;
+            if (choice.fade > 0.0f) m_lodCounts[choice.level + 1]++;
+        }
+        m_visibleCount = 0;
+        for (unsigned int bucket = 0; bucket < buckets(); bucket++) {
+            m_lodOffsets[bucket] = m_visibleCount;
+            m_visibleCount += m_lodCounts[bucket];
+        }
+
+        m_packed.resize(m_visibleCount);
+        std::array<unsigned int, maxBuckets> cursors {m_lodOffsets};
+        for (unsigned int i = 0; i < count; i++) {
+            const Choice& choice {m_choices[i]};
+            if (choice.level == culled) continue;
+            glm::mat4& packed {m_packed[cursors[choice.level]++] = instances[i]};
+            if (choice.fade > 0.0f) {
+                packed[0][3] = choice.fade;
+                glm::mat4& coarser {m_packed[cursors[choice.level + 1]++] = instances[i]};
+                coarser[0][3] = -choice.fade;
+            }
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, m_visible);
+        // orphan first, so the upload doesn't wait for last frame's draws
+        glBufferData(GL_ARRAY_BUFFER, m_capacity * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, m_visibleCount * sizeof(glm::mat4), m_packed.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        stats::stateChange();
+    }
+
+    // Draw what the last cull() kept. The instance attributes are pointed at the
+    // packed buffer here, so draw() has to come after anything else that sets them.
+    void draw(Shader& shader) {
+        if (m_mode == GPU) {
+            pointInstances(0);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commands);
+            for (unsigned int mesh = 0; mesh < m_model.m_meshes.size(); mesh++) {
+                m_model.m_meshes[mesh].DrawIndirect(shader, mesh * m_levels * sizeof(DrawCommand), m_levels);
+            }
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+            return;
+        }
+        // no baseInstance before 4.2, so each level moves the attributes instead
+        for (unsigned int level = 0; level < m_levels; level++) {
+            if (m_lodCounts[level] == 0) continue;
+            pointInstances(m_lodOffsets[level]);
+            for (ModelMesh& mesh : m_model.m_meshes) mesh.DrawInstancedLod(shader, level, m_lodCounts[level]);
+        }
+    }
+
+    // Draw the instances the last cull() left to the impostor, with an impostor shader.
+    void drawImpostors(Shader& shader) {
+        if (!m_impostor) return;
+        if (m_mode == GPU) {
+            pointInstances(0);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commands);
+            m_impostor->drawIndirect(shader, m_model.m_meshes.size() * m_levels * sizeof(DrawCommand));
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+            return;
+        }
+        if (m_lodCounts[m_levels] == 0) return;
+        pointInstances(m_lodOffsets[m_levels]);
+        m_impostor->drawInstanced(shader, m_lodCounts[m_levels]);
+    }
+
+private:
+    // matches the shader; DrawElementsIndirectCommand as laid out by GL
+    struct DrawCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint  baseVertex;
+        GLuint baseInstance;
+    };
+
+    // an instance's level, and if it's crossfading, how much of it is still that
+    // level (the rest is level + 1)
+    struct Choice {
+        unsigned int level;
+        float fade;
+    };
+
+    // the levels, then the impostor
+    static constexpr unsigned int maxBuckets {maxLods + 1};
+    // counters buffer: per bucket counts, per bucket offsets, total visible
+    static constexpr unsigned int counterCount {2 * maxBuckets + 1};
+    static constexpr unsigned int visibleCounter {2 * maxBuckets};
+    static constexpr unsigned int groupSize {256};
+    static constexpr unsigned int culled {~0u};
+
+    unsigned int buckets() const {
+        return m_levels + (m_impostor ? 1 : 0);
+    }
+
+    // how many levels to use, the size at which each one gives way to the next,
+    // and what each costs
+    void computeLevels() {
+        size_t levels {m_model.lodCount()};
+        if (!m_settings.lodScreenSizes.empty()) levels = std::min(levels, m_settings.lodScreenSizes.size() + 1);
+        m_levels = static_cast<unsigned int>(std::min<size_t>(levels, maxLods));
+
+        // error in pixels is error / diameter * size, so level + 1 is good enough
+        // as long as the size is below maxScreenError * diameter / its error
+        for (unsigned int level = 0; level + 1 < m_levels; level++) {
+            if (!m_settings.lodScreenSizes.empty()) {
+                m_screenSizes[level] = m_settings.lodScreenSizes[level];
+                continue;
+            }
+            float error {m_model.lodError(level + 1)};
+            m_screenSizes[level] = (error > 0.0f) ? m_settings.maxScreenError * 2.0f * m_radius / error : FLT_MAX;
+        }
+        for (unsigned int level = 0; level < m_levels; level++) {
+            for (const ModelMesh& mesh : m_model.m_meshes) {
+                m_levelTriangles[level] += mesh.m_lods[std::min<size_t>(level, mesh.m_lods.size() - 1)].indexCount / 3;
+            }
+        }
+    }
+
+    // pixels across the viewport per world unit at a distance of one unit
+    static float pixelsPerUnit(const glm::mat4& projection, float viewportHeight) {
+        return projection[1][1] * viewportHeight * 0.5f;
+    }
+
+    // the CPU copy of the compute shader's stage 0
+    Choice classify(const glm::mat4& model, const Frustum& frustum, const glm::mat4& view,
+                    float pixelsPerUnit) const {
+        glm::vec3 center {model * glm::vec4(m_center, 1.0f)};
+        float scale {std::max({glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])),
+                               glm::length(glm::vec3(model[2]))})};
+        float radius {m_radius * scale};
+        if (!frustum.intersects(center, radius)) return {culled, 0.0f};
+
+        float distance {-(view * glm::vec4(center, 1.0f)).z};
+        // inside the sphere counts as infinitely big
+        float size {(distance > radius) ? 2.0f * radius * pixelsPerUnit / distance : FLT_MAX};
+        if (size < m_settings.minScreenSize) return {culled, 0.0f};
+        if (m_impostor && distance > m_settings.impostorDistance) return {m_levels, 0.0f};
+        unsigned int level {0};
+        while (level + 1 < m_levels && size < m_screenSizes[level]) level++;
+
+        float fade {0.0f};
+        if (level + 1 < m_levels && m_settings.crossfadeBand > 0.0f && m_screenSizes[level] < FLT_MAX) {
+            float band {m_screenSizes[level] * m_settings.crossfadeBand};
+            // kept away from 0 and 1 so both copies always know which half they are
+            if (size < m_screenSizes[level] + band) {
+                fade = std::clamp((size - m_screenSizes[level]) / band, 1.0f / 64.0f, 63.0f / 64.0f);
+            }
+        }
+        return {level, fade};
+    }
+
+    void pointInstances(unsigned int firstInstance) {
+        GLintptr offset {static_cast<GLintptr>(firstInstance * sizeof(glm::mat4))};
+        auto point = [&](unsigned int vao) {
+            glBindVertexArray(vao);
+            glBindBuffer(GL_ARRAY_BUFFER, m_visible);
+            for (unsigned int column = 0; column < 4; column++) {
+                glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                                      (void*)(offset + column * sizeof(glm::vec4)));
+            }
+            stats::stateChange();
+        };
+        for (const ModelMesh& mesh : m_model.m_meshes) point(mesh.VAO);
+        if (m_impostor) point(m_impostor->VAO);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void createGpuResources() {
+        m_compute = std::make_unique<ComputeShader>("../code/shaders/instance_cull.comp.glsl");
+
+        // each mesh's index range for each level, clamped to the levels it has
+        std::vector<GLuint> ranges;
+        for (const ModelMesh& mesh : m_model.m_meshes) {
+            for (unsigned int level = 0; level < m_levels; level++) {
+                const ModelMesh::Lod& lod {mesh.m_lods[std::min<size_t>(level, mesh.m_lods.size() - 1)]};
+                ranges.push_back(lod.firstIndex);
+                ranges.push_back(lod.indexCount);
+            }
+        }
+        // and the impostor's quad, drawn by the command after all of them
+        ranges.push_back(0);
+        ranges.push_back(Impostor::indexCount);
+        glGenBuffers(1, &m_slots);
+        glGenBuffers(1, &m_counters);
+        glGenBuffers(1, &m_commands);
+        glGenBuffers(1, &m_ranges);
+        glGenBuffers(1, &m_readback);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_slots);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, m_maxInstances * 4 * sizeof(GLuint), NULL, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_counters);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, counterCount * sizeof(GLuint), NULL, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_commands);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, ranges.size() / 2 * sizeof(DrawCommand), NULL, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_ranges);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, ranges.size() * sizeof(GLuint), ranges.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_readback);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, m_readbackFences.size() * counterCount * sizeof(GLuint), NULL,
+                     GL_STREAM_READ);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    // pick up the oldest counts that have finished, without waiting
+    void readCounters() {
+        unsigned int slot {static_cast<unsigned int>(m_frame % m_readbackFences.size())};
+        GLsync& fence {m_readbackFences[slot]};
+        if (!fence || glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) return;
+        std::array<GLuint, counterCount> counters {};
+        glBindBuffer(GL_COPY_READ_BUFFER, m_readback);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, slot * sizeof(counters), sizeof(counters), counters.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        std::copy(counters.begin(), counters.begin() + maxBuckets, m_lodCounts.begin());
+        m_visibleCount = counters[visibleCounter];
+    }
+
+    Model& m_model;
+    const Impostor* m_impostor;
+    unsigned int m_maxInstances;
+    unsigned int m_capacity;
+    Mode m_mode;
+    Settings m_settings;
+    unsigned int m_levels;
+    std::array<float, maxLods - 1> m_screenSizes {};
+    std::array<uint64_t, maxLods> m_levelTriangles {};
+    glm::vec3 m_center {0.0f};
+    float m_radius {0.0f};
+    unsigned int m_visible;
+    unsigned int m_visibleCount;
+    // per bucket; for GPU, as of the last readback
+    std::array<unsigned int, maxBuckets> m_lodCounts {};
+
+    // CPU
+    std::vector<Choice> m_choices;
+    std::vector<glm::mat4> m_packed;
+    std::array<unsigned int, maxBuckets> m_lodOffsets {};
+
+    // GPU
+    std::unique_ptr<ComputeShader> m_compute;
+    unsigned int m_slots {0};
+    unsigned int m_counters {0};
+    unsigned int m_commands {0};
+    unsigned int m_ranges {0};
+    unsigned int m_readback {0};
+    std::array<GLsync, 4> m_readbackFences {};
+    size_t m_frame;
+};
+
+}
+#endif
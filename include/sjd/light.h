@@ -1,8 +1,9 @@
 #ifndef LIGHT_H
 #define LIGHT_H
 #include "glm/geometric.hpp"
-#include "sjd/framebuffer.h"
+#include "sjd/shadow_cascades.h"
 #include <array>
+#include <cmath>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -103,7 +104,7 @@ public:
         shader.setVec3("dirLight.specular", m_specular*m_colour);
     }
 
-    void enableShadowMap(sjd::Shader* depthShader, sjd::FBTexture* shadowMap) {
+    void enableShadowMap(sjd::Shader* depthShader, sjd::ShadowCascades* shadowMap) {
         m_shadowMapShader = depthShader;
         m_shadowMap = shadowMap;
     }
@@ -118,41 +119,51 @@ public:
         else return true;
     }
 
-    glm::mat4 generateLightSpaceMat() {
-        if (!m_shadowMapShader) {
+    glm::vec3 getDirection() const {
+        return m_direction;
+    }
+
+    // fit the shadow cascades around the camera for this frame
+    void updateShadowCascades(const glm::mat4& view, const glm::mat4& projection) {
+        if (!m_shadowMap) {
             std::cout << "ERROR::DIRLIGHT::SHADOW_MAP" << std::endl;
-            return glm::mat4(1.0f);
+            return;
         }
-        float near_plane = 1.0f, far_plane = 15.0f;
-        glm::mat4 lightProjection = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, near_plane, far_plane);
-        glm::mat4 lightView = glm::lookAt(getPosition(),
-                                  glm::vec3( 0.0f, 0.0f,  0.0f),
-                                  glm::vec3( 0.0f, 1.0f,  0.0f));
-        glm::mat4 lightSpaceMatrix = lightProjection * lightView;
+        m_shadowMap->update(view, projection, m_direction);
+    }
 
+    // returns false if the cascade's cached static casters are still valid
+    bool bindStaticDepthMap(unsigned int cascade) {
+        if (!m_shadowMap || !m_shadowMapShader) {
+            std::cout << "ERROR::DIRLIGHT::SHADOW_MAP" << std::endl;
+            return false;
+        }
+        if (!m_shadowMap->bindStatic(cascade)) return false;
         m_shadowMapShader->use();
-        m_shadowMapShader->setMat4("lightSpaceMatrix", lightSpaceMatrix);
-        return lightSpaceMatrix;
+        m_shadowMapShader->setMat4("lightSpaceMatrix", m_shadowMap->lightSpaceMatrix(cascade));
+        glCullFace(GL_FRONT);
+        return true;
     }
 
-    void bindDepthMap() {
-        if (!m_shadowMap) {
+    void bindDepthMap(unsigned int cascade) {
+        if (!m_shadowMap || !m_shadowMapShader) {
             std::cout << "ERROR::DIRLIGHT::SHADOW_MAP" << std::endl;
             return;
         }
-        m_shadowMap->bind();    // render offscreen to depthmap
-        glClear(GL_DEPTH_BUFFER_BIT);
+        m_shadowMapShader->use();
+        m_shadowMapShader->setMat4("lightSpaceMatrix", m_shadowMap->lightSpaceMatrix(cascade));
+        m_shadowMap->bind(cascade);    // render offscreen to this cascade's layer
         glCullFace(GL_FRONT);
     }
 
     void unbindDepthMap() {
         glCullFace(GL_BACK); // don't forget to reset original culling face
-        m_shadowMap->release(); // switch back to default framebuffer
+        m_shadowMap->release(); // switch back to the caller's framebuffer and viewport
     }
 
 
     sjd::Shader* m_shadowMapShader {nullptr};
-    sjd::FBTexture* m_shadowMap {nullptr};
+    sjd::ShadowCascades* m_shadowMap {nullptr};
 private:
     glm::vec3 m_direction;
 };
@@ -163,7 +174,7 @@ public:
                glm::vec3 colour={1.0f, 1.0f, 1.0f},
                bool gamma=false)
     :   Light {position, colour, gamma}
-    ,   m_lightCubeShader {"../code/shaders/3.3.simple.vert.glsl", "../code/shaders/light_cube.frag.glsl"}
+    ,   m_castsShadows {false}
     {
         if (!gamma) {
             m_constant = 1.0f;
@@ -176,24 +187,6 @@ public:
             m_linear = 0.14f;
             m_quadratic = 0.07f;
         }
-
-        glGenBuffers(1, &m_lightCubeVbo);
-        glGenVertexArrays(1, &m_lightCubeVao);
-        glBindVertexArray(m_lightCubeVao);
-        glBindBuffer(GL_ARRAY_BUFFER, m_lightCubeVbo);
-        glVertexAttribPointer(0,
-                              3,
-                              GL_FLOAT,
-                              GL_FALSE,
-                              3 * sizeof(float),
-                              (void*)0);
-
-        glBufferData(GL_ARRAY_BUFFER,
-                     sizeof(lightCubeVertices),
-                     lightCubeVertices.data(),
-                     GL_STATIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glEnableVertexAttribArray(0);
     }
 
     void computeLight(sjd::Shader& shader, unsigned int id=0) const {
@@ -208,13 +201,16 @@ public:
     }
 
     void drawLightCube(glm::mat4 projection, glm::mat4 view) {
-        m_lightCubeShader.use();
-        m_lightCubeShader.setMat4("projection", projection);
-        m_lightCubeShader.setMat4("view", view);
-        m_lightCubeShader.setMat4("model", glm::scale(glm::translate(glm::mat4(1.0f), m_position), glm::vec3(0.25f)));
-        m_lightCubeShader.setVec3("lightColour", m_colour);
-        glBindVertexArray(m_lightCubeVao);
+        sjd::Shader& shader {lightCubeShader()};
+        shader.use();
+        shader.setMat4("projection", projection);
+        shader.setMat4("view", view);
+        shader.setMat4("model", glm::scale(glm::translate(glm::mat4(1.0f), m_position), glm::vec3(0.25f)));
+        shader.setVec3("lightColour", m_colour);
+        glBindVertexArray(lightCubeVao());
         glDrawArrays(GL_TRIANGLES, 0, 36);
+        stats::stateChange();
+        stats::drawCall(12);
         glBindVertexArray(0);
     }
 
@@ -222,13 +218,77 @@ public:
         m_position = position;
     }
 
+    // distance at which the attenuation drops below `cutoff` of full brightness
+    float range(float cutoff=5.0f / 256.0f) const {
+        float c {m_constant - 1.0f / cutoff};
+        return (-m_linear + std::sqrt(m_linear * m_linear - 4.0f * m_quadratic * c))
+               / (2.0f * m_quadratic);
+    }
+
+    // replaces the defaults the constructor picks; range() follows
+    void setAttenuation(float constant, float linear, float quadratic) {
+        m_constant = constant;
+        m_linear = linear;
+        m_quadratic = quadratic;
+    }
+
+    // the four texels per light of sjd::PointLightBuffer: position and range,
+    // then ambient, diffuse and specular each with one attenuation term
+    std::array<glm::vec4, 4> packed() const {
+        return {
+            glm::vec4(m_position, range()),
+            glm::vec4(m_ambient * m_colour, m_constant),
+            glm::vec4(m_diffuse * m_colour, m_linear),
+            glm::vec4(m_specular * m_colour, m_quadratic),
+        };
+    }
+
+    // omnidirectional shadows, rendered by Scene into its ShadowAtlas
+    void enableShadows(bool castsShadows=true) {
+        m_castsShadows = castsShadows;
+    }
+
+    bool castsShadows() const {
+        return m_castsShadows;
+    }
+
 private:
+    // one cube and shader shared by every light, made on first use; scenes with
+    // thousands of lights would otherwise compile the shader thousands of times
+    static sjd::Shader& lightCubeShader() {
+        static sjd::Shader shader {"../code/shaders/3.3.simple.vert.glsl", "../code/shaders/light_cube.frag.glsl"};
+        return shader;
+    }
+
+    static unsigned int lightCubeVao() {
+        static unsigned int vao {0};
+        if (vao == 0) {
+            unsigned int vbo;
+            glGenBuffers(1, &vbo);
+            glGenVertexArrays(1, &vao);
+            glBindVertexArray(vao);
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+            glBufferData(GL_ARRAY_BUFFER,
+                         sizeof(lightCubeVertices),
+                         lightCubeVertices.data(),
+                         GL_STATIC_DRAW);
+            glVertexAttribPointer(0,
+                                  3,
+                                  GL_FLOAT,
+                                  GL_FALSE,
+                                  3 * sizeof(float),
+                                  (void*)0);
+            glEnableVertexAttribArray(0);
+            glBindVertexArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        return vao;
+    }
+
     float m_constant;
     float m_linear;
     float m_quadratic;
-    unsigned int m_lightCubeVao;
-    unsigned int m_lightCubeVbo;
-    sjd::Shader m_lightCubeShader;
+    bool m_castsShadows;
 };
 
 }
@@ -0,0 +1,86 @@
+#ifndef LIGHT_BUFFER_H
+#define LIGHT_BUFFER_H
+
+#include <array>
+#include <functional>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <sjd/light.h>
+#include <sjd/profiling.h>
+#include <sjd/shader.h>
+
+namespace sjd {
+
+// Point lights packed into a texture buffer, for shaders that take any number of
+// them instead of a fixed pointLights[] uniform array. Each light is four RGBA32F
+// texels as laid out by PointLight::packed(); shaders fetch light i from
+// pointLightData at 4 * i.
+class PointLightBuffer {
+public:
+    // kept clear of the units meshes use and of ShadowAtlas and ShadowCascades
+    static constexpr unsigned int textureUnit {13};
+
+    PointLightBuffer()
+    :   m_count {0}
+    {
+        glGenBuffers(1, &m_buffer);
+        glGenTextures(1, &m_texture);
+        glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+        glBufferData(GL_TEXTURE_BUFFER, sizeof(glm::vec4) * 4, NULL, GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    ~PointLightBuffer() {
+        glDeleteTextures(1, &m_texture);
+        glDeleteBuffers(1, &m_buffer);
+    }
+
+    PointLightBuffer(const PointLightBuffer&) = delete;
+    PointLightBuffer& operator=(const PointLightBuffer&) = delete;
+
+    // repack every light; the old contents are orphaned rather than waited on
+    void update(const std::vector<std::reference_wrapper<sjd::PointLight>>& lights) {
+        m_data.clear();
+        m_data.reserve(lights.size() * 4);
+        for (const std::reference_wrapper<sjd::PointLight>& light : lights) {
+            std::array<glm::vec4, 4> texels {light.get().packed()};
+            m_data.insert(m_data.end(), texels.begin(), texels.end());
+        }
+        m_count = static_cast<unsigned int>(lights.size());
+        if (m_data.empty()) return;
+        glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(m_data.size() * sizeof(glm::vec4)),
+                     NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, static_cast<GLsizeiptr>(m_data.size() * sizeof(glm::vec4)),
+                        m_data.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    // sets pointLightData and numPointLights
+    void bind(sjd::Shader& shader) const {
+        glActiveTexture(GL_TEXTURE0 + textureUnit);
+        glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+        glActiveTexture(GL_TEXTURE0);
+        shader.use();
+        shader.setInt("pointLightData", textureUnit);
+        shader.setInt("numPointLights", static_cast<int>(m_count));
+        stats::stateChange();
+    }
+
+    unsigned int count() const {
+        return m_count;
+    }
+
+private:
+    unsigned int m_buffer;
+    unsigned int m_texture;
+    unsigned int m_count;
+    std::vector<glm::vec4> m_data;
+};
+
+}
+#endif
@@ -0,0 +1,376 @@
+#ifndef MESH_SIMPLIFY_H
+#define MESH_SIMPLIFY_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace sjd {
+
+// Mesh simplification by edge collapse with quadric error metrics (Garland and
+// Heckbert, "Surface Simplification Using Quadric Error Metrics", 1997). Every
+// vertex keeps the sum of the planes of the triangles around it, and the edge
+// whose collapse moves the surface least against those planes goes first.
+//
+// Vertices only ever collapse onto existing vertices, so every simplified index
+// list still indexes the original vertex buffer and levels of detail can share
+// it. Vertices are welded by position first, so texture seams don't split the
+// surface; a seam vertex may only slide along its seam, and open borders stay put.
+//
+// simplify() carries on from where the last call stopped, so calling it with
+// smaller and smaller targets builds a whole chain in one pass:
+//
+//     MeshSimplifier simplifier {positions, texCoords, indices};
+//     std::vector<unsigned int> half {simplifier.simplify(indices.size() / 2)};
+//     std::vector<unsigned int> quarter {simplifier.simplify(indices.size() / 4)};
+class MeshSimplifier {
+public:
+    MeshSimplifier(const std::vector<glm::vec3>& positions, const std::vector<glm::vec2>& texCoords,
+                   const std::vector<unsigned int>& indices)
+    :   m_texCoords {texCoords}
+    ,   m_group(positions.size())
+    ,   m_liveTriangles {indices.size() / 3}
+    ,   m_error {0.0f}
+    {
+        weld(positions);
+        m_triangles.resize(m_liveTriangles);
+        for (size_t t = 0; t < m_liveTriangles; t++) {
+            for (int corner = 0; corner < 3; corner++) m_triangles[t].corners[corner] = indices[3 * t + corner];
+        }
+        m_quadrics.resize(m_positions.size());
+        m_triangleLists.resize(m_positions.size());
+        for (uint32_t t = 0; t < m_triangles.size(); t++) {
+            Triangle& triangle {m_triangles[t]};
+            if (isDegenerate(triangle)) {
+                triangle.removed = true;
+                m_liveTriangles--;
+                continue;
+            }
+            Quadric plane {planeQuadric(triangle)};
+            for (int corner = 0; corner < 3; corner++) {
+                uint32_t group {groupOf(triangle, corner)};
+                m_quadrics[group] += plane;
+                m_triangleLists[group].push_back(t);
+            }
+        }
+        lockBorders();
+        for (uint32_t t = 0; t < m_triangles.size(); t++) {
+            if (m_triangles[t].removed) continue;
+            for (int corner = 0; corner < 3; corner++) {
+                uint32_t a {groupOf(m_triangles[t], corner)};
+                uint32_t b {groupOf(m_triangles[t], (corner + 1) % 3)};
+                pushCollapse(a, b);
+                pushCollapse(b, a);
+            }
+        }
+    }
+
+    // Collapse edges, cheapest first, until at most targetIndexCount indices are
+    // left or the next collapse would move the surface by more than maxError.
+    std::vector<unsigned int> simplify(size_t targetIndexCount, float maxError=INFINITY) {
+        while (m_liveTriangles * 3 > targetIndexCount && !m_collapses.empty()) {
+            Collapse collapse {m_collapses.top()};
+            if (collapse.error > maxError) break;
+            m_collapses.pop();
+            if (isStale(collapse) || !canCollapse(collapse.from, collapse.to)) continue;
+            apply(collapse.from, collapse.to);
+            m_error = std::max(m_error, collapse.error);
+        }
+
+        std::vector<unsigned int> indices;
+        indices.reserve(m_liveTriangles * 3);
+        for (const Triangle& triangle : m_triangles) {
+            if (triangle.removed) continue;
+            indices.insert(indices.end(), triangle.corners, triangle.corners + 3);
+        }
+        return indices;
+    }
+
+    // largest error of any collapse so far: roughly how far, in model units, the
+    // simplified surface may be from the original
+    float error() const {
+        return m_error;
+    }
+
+private:
+    // symmetric 4x4 matrix summing squared distances to planes, weighted by area
+    struct Quadric {
+        double a2 {0}, ab {0}, ac {0}, ad {0}, b2 {0}, bc {0}, bd {0}, c2 {0}, cd {0}, d2 {0};
+        double weight {0};
+
+        Quadric& operator+=(const Quadric& q) {
+            a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2;
+            bc += q.bc; bd += q.bd; c2 += q.c2; cd += q.cd; d2 += q.d2;
+            weight += q.weight;
+            return *this;
+        }
+
+        double evaluate(const glm::vec3& p) const {
+            double x {p.x}, y {p.y}, z {p.z};
+            return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+                 + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+                 + c2 * z * z + 2 * cd * z
+                 + d2;
+        }
+    };
+
+    struct Triangle {
+        uint32_t corners[3];
+        bool removed {false};
+    };
+
+    struct Collapse {
+        float error;
+        uint32_t from;
+        uint32_t to;
+        uint32_t fromVersion;
+        uint32_t toVersion;
+
+        bool operator>(const Collapse& other) const {
+            return error > other.error;
+        }
+    };
+
+    // one group per distinct position; a group with more than one vertex sits on a seam
+    void weld(const std::vector<glm::vec3>& positions) {
+        std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+        for (uint32_t v = 0; v < positions.size(); v++) {
+            uint32_t bits[3];
+            std::memcpy(bits, &positions[v], sizeof(bits));
+            uint64_t hash {(bits[0] * 73856093ull) ^ (bits[1] * 19349663ull) ^ (bits[2] * 83492791ull)};
+            std::vector<uint32_t>& bucket {buckets[hash]};
+            uint32_t group {UINT32_MAX};
+            for (uint32_t candidate : bucket) {
+                if (m_positions[candidate] == positions[v]) group = candidate;
+            }
+            if (group == UINT32_MAX) {
+                group = static_cast<uint32_t>(m_positions.size());
+                m_positions.push_back(positions[v]);
+                m_vertices.emplace_back();
+                bucket.push_back(group);
+            }
+            m_group[v] = group;
+            m_vertices[group].push_back(v);
+        }
+        m_versions.assign(m_positions.size(), 0);
+        m_alive.assign(m_positions.size(), true);
+        m_locked.assign(m_positions.size(), false);
+    }
+
+    // an edge used by only one triangle is on an open border; its ends don't move
+    void lockBorders() {
+        std::unordered_map<uint64_t, int> edgeUses;
+        for (const Triangle& triangle : m_triangles) {
+            if (triangle.removed) continue;
+            for (int corner = 0; corner < 3; corner++) edgeUses[edgeKey(triangle, corner)]++;
+        }
+        for (const Triangle& triangle : m_triangles) {
+            if (triangle.removed) continue;
+            for (int corner = 0; corner < 3; corner++) {
+                if (edgeUses[edgeKey(triangle, corner)] == 1) {
+                    m_locked[groupOf(triangle, corner)] = true;
+                    m_locked[groupOf(triangle, (corner + 1) % 3)] = true;
+                }
+            }
+        }
+    }
+
+    uint64_t edgeKey(const Triangle& triangle, int corner) const {
+        uint64_t a {groupOf(triangle, corner)};
+        uint64_t b {groupOf(triangle, (corner + 1) % 3)};
+        return (std::min(a, b) << 32) | std::max(a, b);
+    }
+
+    uint32_t groupOf(const Triangle& triangle, int corner) const {
+        return m_group[triangle.corners[corner]];
+    }
+
+    bool isDegenerate(const Triangle& triangle) const {
+        uint32_t a {groupOf(triangle, 0)}, b {groupOf(triangle, 1)}, c {groupOf(triangle, 2)};
+        return a == b || b == c || a == c;
+    }
+
+    bool contains(const Triangle& triangle, uint32_t group) const {
+        return groupOf(triangle, 0) == group || groupOf(triangle, 1) == group || groupOf(triangle, 2) == group;
+    }
+
+    glm::vec3 normal(const Triangle& triangle, uint32_t moved, const glm::vec3& to) const {
+        glm::vec3 p[3];
+        for (int corner = 0; corner < 3; corner++) {
+            uint32_t group {groupOf(triangle, corner)};
+            p[corner] = (group == moved) ? to : m_positions[group];
+        }
+        return glm::cross(p[1] - p[0], p[2] - p[0]);
+    }
+
+    Quadric planeQuadric(const Triangle& triangle) const {
+        // in double, since the quadrics of large flat areas nearly cancel
+        const glm::vec3& p0 {m_positions[groupOf(triangle, 0)]};
+        glm::vec3 e1 {m_positions[groupOf(triangle, 1)] - p0};
+        glm::vec3 e2 {m_positions[groupOf(triangle, 2)] - p0};
+        double nx {double(e1.y) * e2.z - double(e1.z) * e2.y};
+        double ny {double(e1.z) * e2.x - double(e1.x) * e2.z};
+        double nz {double(e1.x) * e2.y - double(e1.y) * e2.x};
+        double length {std::sqrt(nx * nx + ny * ny + nz * nz)};
+        Quadric q;
+        if (length <= 0.0) return q;
+        double area {length * 0.5};
+        nx /= length;
+        ny /= length;
+        nz /= length;
+        double d {-(nx * p0.x + ny * p0.y + nz * p0.z)};
+        q.a2 = area * nx * nx; q.ab = area * nx * ny; q.ac = area * nx * nz; q.ad = area * nx * d;
+        q.b2 = area * ny * ny; q.bc = area * ny * nz; q.bd = area * ny * d;
+        q.c2 = area * nz * nz; q.cd = area * nz * d;
+        q.d2 = area * d * d;
+        q.weight = area;
+        return q;
+    }
+
+    // the quadric's mean squared distance, as a distance
+    float collapseError(uint32_t from, uint32_t to) const {
+        Quadric q {m_quadrics[from]};
+        q += m_quadrics[to];
+        if (q.weight <= 0.0) return 0.0f;
+        return static_cast<float>(std::sqrt(std::max(0.0, q.evaluate(m_positions[to]) / q.weight)));
+    }
+
+    void pushCollapse(uint32_t from, uint32_t to) {
+        if (m_locked[from]) return;
+        m_collapses.push({collapseError(from, to), from, to, m_versions[from], m_versions[to]});
+    }
+
+    bool isStale(const Collapse& collapse) const {
+        return !m_alive[collapse.from] || !m_alive[collapse.to]
+            || m_versions[collapse.from] != collapse.fromVersion
+            || m_versions[collapse.to] != collapse.toVersion;
+    }
+
+    bool isSeam(uint32_t group) const {
+        return m_vertices[group].size() > 1;
+    }
+
+    bool canCollapse(uint32_t from, uint32_t to) const {
+        std::vector<uint32_t> fromNeighbours;
+        std::vector<uint32_t> toNeighbours;
+        std::vector<uint32_t> seamVertices;
+        for (uint32_t t : m_triangleLists[from]) {
+            const Triangle& triangle {m_triangles[t]};
+            if (triangle.removed) continue;
+            for (int corner = 0; corner < 3; corner++) {
+                uint32_t group {groupOf(triangle, corner)};
+                if (group != from) fromNeighbours.push_back(group);
+                else if (contains(triangle, to)) seamVertices.push_back(triangle.corners[corner]);
+            }
+            if (contains(triangle, to)) continue;
+            // refuse to flip any triangle over
+            glm::vec3 before {normal(triangle, from, m_positions[from])};
+            glm::vec3 after {normal(triangle, from, m_positions[to])};
+            if (glm::dot(before, after) <= 0.0f) return false;
+        }
+        // a seam vertex may only move along its seam, onto another seam vertex, or
+        // the texture on one side would be dragged across the other
+        if (isSeam(from)) {
+            std::sort(seamVertices.begin(), seamVertices.end());
+            bool seamEdge {std::unique(seamVertices.begin(), seamVertices.end()) - seamVertices.begin() > 1};
+            if (!seamEdge || !isSeam(to)) return false;
+        }
+        // more than two shared neighbours would pinch the surface into a non-manifold fold
+        for (uint32_t t : m_triangleLists[to]) {
+            const Triangle& triangle {m_triangles[t]};
+            if (triangle.removed) continue;
+            for (int corner = 0; corner < 3; corner++) toNeighbours.push_back(groupOf(triangle, corner));
+        }
+        std::sort(fromNeighbours.begin(), fromNeighbours.end());
+        fromNeighbours.erase(std::unique(fromNeighbours.begin(), fromNeighbours.end()), fromNeighbours.end());
+        std::sort(toNeighbours.begin(), toNeighbours.end());
+        toNeighbours.erase(std::unique(toNeighbours.begin(), toNeighbours.end()), toNeighbours.end());
+        size_t shared {0};
+        for (uint32_t group : fromNeighbours) {
+            if (group != to && std::binary_search(toNeighbours.begin(), toNeighbours.end(), group)) shared++;
+        }
+        return shared <= 2;
+    }
+
+    // the vertex of `group` whose texture coordinates are nearest `vertex`'s
+    uint32_t matchingVertex(uint32_t group, uint32_t vertex) const {
+        const std::vector<uint32_t>& candidates {m_vertices[group]};
+        if (candidates.size() == 1 || m_texCoords.size() <= vertex) return candidates.front();
+        uint32_t best {candidates.front()};
+        float bestDistance {INFINITY};
+        for (uint32_t candidate : candidates) {
+            glm::vec2 delta {m_texCoords[candidate] - m_texCoords[vertex]};
+            float distance {glm::dot(delta, delta)};
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = candidate;
+            }
+        }
+        return best;
+    }
+
+    void apply(uint32_t from, uint32_t to) {
+        for (uint32_t t : m_triangleLists[from]) {
+            Triangle& triangle {m_triangles[t]};
+            if (triangle.removed) continue;
+            if (contains(triangle, to)) {
+                triangle.removed = true;
+                m_liveTriangles--;
+                continue;
+            }
+            for (int corner = 0; corner < 3; corner++) {
+                if (groupOf(triangle, corner) == from) triangle.corners[corner] = matchingVertex(to, triangle.corners[corner]);
+            }
+            m_triangleLists[to].push_back(t);
+        }
+        m_triangleLists[from].clear();
+        m_triangleLists[from].shrink_to_fit();
+        m_alive[from] = false;
+        m_quadrics[to] += m_quadrics[from];
+        m_versions[to]++;
+
+        // drop the dead triangles from `to`'s list and requeue every edge around it
+        std::vector<uint32_t>& triangles {m_triangleLists[to]};
+        triangles.erase(std::remove_if(triangles.begin(), triangles.end(),
+                                       [this](uint32_t t) { return m_triangles[t].removed; }),
+                        triangles.end());
+        std::vector<uint32_t> neighbours;
+        for (uint32_t t : triangles) {
+            for (int corner = 0; corner < 3; corner++) {
+                uint32_t group {groupOf(m_triangles[t], corner)};
+                if (group != to) neighbours.push_back(group);
+            }
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        for (uint32_t neighbour : neighbours) {
+            pushCollapse(to, neighbour);
+            pushCollapse(neighbour, to);
+        }
+    }
+
+    std::vector<glm::vec2> m_texCoords;
+    // per original vertex
+    std::vector<uint32_t> m_group;
+    // per group
+    std::vector<glm::vec3> m_positions;
+    std::vector<std::vector<uint32_t>> m_vertices;
+    std::vector<std::vector<uint32_t>> m_triangleLists;
+    std::vector<Quadric> m_quadrics;
+    std::vector<uint32_t> m_versions;
+    std::vector<bool> m_alive;
+    std::vector<bool> m_locked;
+
+    std::vector<Triangle> m_triangles;
+    size_t m_liveTriangles;
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> m_collapses;
+    float m_error;
+};
+
+}
+#endif
@@ -113,6 +113,10 @@ public:
         return cubeVertices;
     }
 
+    virtual sjd::AABB localBounds() const {
+        return {glm::vec3(-1.0f), glm::vec3(1.0f)};
+    }
+
     virtual void draw(glm::mat4 projection, glm::mat4 view, sjd::Shader& shader) {
         shader.use();
         shader.setFloat("material.shininess", m_shininess);
@@ -120,6 +124,7 @@ public:
             shader.setInt("material.diffuse", m_diffuseMap.textureUnit);
             glActiveTexture(GL_TEXTURE0 + m_diffuseMap.textureUnit);
             glBindTexture(GL_TEXTURE_2D, m_diffuseMap.texture->m_id);
+            stats::stateChange();
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_diffuseMap.texture->m_textureWrapS);	
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_diffuseMap.texture->m_textureWrapT);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_diffuseMap.texture->m_textureMinFilter);
@@ -129,6 +134,7 @@ public:
             shader.setInt("material.specular", m_specularMap.textureUnit);
             glActiveTexture(GL_TEXTURE0 + m_specularMap.textureUnit);
             glBindTexture(GL_TEXTURE_2D, m_specularMap.texture->m_id);
+            stats::stateChange();
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_specularMap.texture->m_textureWrapS);	
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_specularMap.texture->m_textureWrapT);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_specularMap.texture->m_textureMinFilter);
@@ -137,20 +143,17 @@ public:
         if (m_shadowMap.texture) {
             shader.setInt("shadowMap", m_shadowMap.textureUnit);
             glActiveTexture(GL_TEXTURE0 + m_shadowMap.textureUnit);
-            glBindTexture(GL_TEXTURE_2D, m_shadowMap.texture->m_id);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_shadowMap.texture->m_textureWrapS);	
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_shadowMap.texture->m_textureWrapT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_shadowMap.texture->m_textureMinFilter);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_shadowMap.texture->m_textureMagFilter);
-            float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-            glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-
+            glBindTexture(GL_TEXTURE_2D, m_shadowMap.texture->depthTexture());
+            stats::stateChange();
         }
         glBindVertexArray(m_vao);
         shader.setMat4("projection", projection);
         shader.setMat4("view", view);
         shader.setMat4("model", m_model);
+        shader.setMat3("normalMatrix", normalMatrix());
         glDrawArrays(GL_TRIANGLES, 0, 36);
+        stats::stateChange();
+        stats::drawCall(36 / 3);
         glBindVertexArray(0);
     }
 
@@ -1,12 +1,14 @@
 #ifndef MESH_H
 #define MESH_H
 
-#include "sjd/framebuffer.h"
+#include <sjd/render_target.h>
 #include <sjd/texture.h>
+#include <sjd/bounds.h>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <array>
+#include <cstdint>
 
 #include <sjd/shader.h>
 #include <sjd/light.h>
@@ -14,9 +16,16 @@
 
 
 namespace sjd {
-static unsigned int texNr {0};
 
 class Mesh {
+public:
+    // Every draw rebinds its maps and points the samplers at them, so meshes can
+    // share units rather than each taking new ones (which ran into the units
+    // ShadowCascades, ShadowAtlas and friends keep for themselves once a scene
+    // had a few dozen textured meshes).
+    static constexpr unsigned int diffuseUnit {0};
+    static constexpr unsigned int specularUnit {1};
+    static constexpr unsigned int shadowUnit {2};
 
 protected:
     struct TexPair {
@@ -24,14 +33,19 @@ protected:
         unsigned int textureUnit {};
     };
 
-    struct FBTexPair {
-        sjd::FBTexture* texture {nullptr};
+    struct ShadowMapPair {
+        sjd::RenderTarget* texture {nullptr};
         unsigned int textureUnit {};
     };
 
     Mesh()
     :   m_model {1.0f}
+    ,   m_previousModel {1.0f}
     ,   m_shininess {32.0f}
+    ,   m_static {false}
+    ,   m_transformVersion {0}
+    ,   m_normalMatrix {1.0f}
+    ,   m_normalMatrixVersion {UINT64_MAX}
     {
     }
 
@@ -43,38 +57,98 @@ public:
 
     void reset() {
         m_model = glm::mat4(1.0f);
+        m_transformVersion++;
     }
 
     void move(glm::vec3 location) {
         m_model = glm::translate(m_model, location);
+        m_transformVersion++;
     }
 
     void scale(glm::vec3 scaling) {
         m_model = glm::scale(m_model, scaling);
+        m_transformVersion++;
     }
 
     void rotateX(float radians) {
         m_model = glm::rotate(m_model, radians, glm::vec3(1.0f, 0.0f, 0.0f));
+        m_transformVersion++;
     }
 
     void rotateY(float radians) {
         m_model = glm::rotate(m_model, radians, glm::vec3(0.0f, 1.0f, 0.0f));
+        m_transformVersion++;
     }
 
     void rotateZ(float radians) {
         m_model = glm::rotate(m_model, radians, glm::vec3(0.0f, 0.0f, 1.0f));
+        m_transformVersion++;
+    }
+
+    // replace the model matrix outright, e.g. with a world matrix from a TransformHierarchy
+    void setModel(const glm::mat4& model) {
+        m_model = model;
+        m_transformVersion++;
+    }
+
+    const glm::mat4& model() const {
+        return m_model;
+    }
+
+    // the model matrix as of the last endFrame(), for motion vectors
+    const glm::mat4& previousModel() const {
+        return m_previousModel;
+    }
+
+    // keep the model matrix as previousModel(); Scene::draw() does this once a frame
+    void endFrame() {
+        m_previousModel = m_model;
+    }
+
+    // bounds of the untransformed vertices
+    virtual sjd::AABB localBounds() const = 0;
+
+    // world space bounds under the current model matrix
+    sjd::AABB bounds() const {
+        return localBounds().transformed(m_model);
+    }
+
+    // static meshes are expected to stay put, so their shadows can be cached;
+    // moving one anyway just costs a cache refresh
+    void setStatic(bool isStatic) {
+        m_static = isStatic;
+    }
+
+    bool isStatic() const {
+        return m_static;
+    }
+
+    // bumped by every transform call, for caches that depend on m_model
+    uint64_t transformVersion() const {
+        return m_transformVersion;
+    }
+
+    // transpose(inverse(mat3(m_model))), recomputed only after the model matrix
+    // changed so shaders don't have to invert it for every vertex
+    const glm::mat3& normalMatrix() {
+        if (m_normalMatrixVersion != m_transformVersion) {
+            m_normalMatrix = glm::transpose(glm::inverse(glm::mat3(m_model)));
+            m_normalMatrixVersion = m_transformVersion;
+        }
+        return m_normalMatrix;
     }
 
     void setDiffuseMap(sjd::Texture* diffuseMap) {
-        m_diffuseMap = {diffuseMap, texNr++};
+        m_diffuseMap = {diffuseMap, diffuseUnit};
     }
 
     void setSpecularMap(sjd::Texture* specularMap) {
-        m_specularMap = {specularMap, texNr++};
+        m_specularMap = {specularMap, specularUnit};
     }
 
-    void setShadowMap(sjd::FBTexture* shadowMap) {
-        m_shadowMap = {shadowMap, texNr++};
+    // a target with a depth texture
+    void setShadowMap(sjd::RenderTarget* shadowMap) {
+        m_shadowMap = {shadowMap, shadowUnit};
     }
 
     void setShininess(float shininess) {
@@ -87,10 +161,15 @@ protected:
     unsigned int m_vao;
     unsigned int m_vbo;
     glm::mat4 m_model;
+    glm::mat4 m_previousModel;
     float m_shininess;
     TexPair m_diffuseMap;
     TexPair m_specularMap;
-    FBTexPair m_shadowMap;
+    ShadowMapPair m_shadowMap;
+    bool m_static;
+    uint64_t m_transformVersion;
+    glm::mat3 m_normalMatrix;
+    uint64_t m_normalMatrixVersion;
 };
 
 }
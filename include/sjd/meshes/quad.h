@@ -83,6 +83,17 @@ public:
         return m_quadVertices;
     }
 
+    virtual sjd::AABB localBounds() const {
+        sjd::AABB box {glm::vec3(m_quadVertices[0], m_quadVertices[1], m_quadVertices[2]),
+                       glm::vec3(m_quadVertices[0], m_quadVertices[1], m_quadVertices[2])};
+        for (size_t i = 8; i < m_quadVertices.size(); i += 8) {
+            glm::vec3 position {m_quadVertices[i], m_quadVertices[i + 1], m_quadVertices[i + 2]};
+            box.min = glm::min(box.min, position);
+            box.max = glm::max(box.max, position);
+        }
+        return box;
+    }
+
     virtual void draw(glm::mat4 projection, glm::mat4 view, sjd::Shader& shader) {
         shader.use();
         shader.setFloat("material.shininess", m_shininess);
@@ -90,6 +101,7 @@ public:
             shader.setInt("material.diffuse", m_diffuseMap.textureUnit);
             glActiveTexture(GL_TEXTURE0 + m_diffuseMap.textureUnit);
             glBindTexture(GL_TEXTURE_2D, m_diffuseMap.texture->m_id);
+            stats::stateChange();
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_diffuseMap.texture->m_textureWrapS);	
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_diffuseMap.texture->m_textureWrapT);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_diffuseMap.texture->m_textureMinFilter);
@@ -99,6 +111,7 @@ public:
             shader.setInt("material.specular", m_specularMap.textureUnit);
             glActiveTexture(GL_TEXTURE0 + m_specularMap.textureUnit);
             glBindTexture(GL_TEXTURE_2D, m_specularMap.texture->m_id);
+            stats::stateChange();
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_specularMap.texture->m_textureWrapS);	
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_specularMap.texture->m_textureWrapT);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_specularMap.texture->m_textureMinFilter);
@@ -107,19 +120,17 @@ public:
         if (m_shadowMap.texture) {
             shader.setInt("shadowMap", m_shadowMap.textureUnit);
             glActiveTexture(GL_TEXTURE0 + m_shadowMap.textureUnit);
-            glBindTexture(GL_TEXTURE_2D, m_shadowMap.texture->m_id);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_shadowMap.texture->m_textureWrapS);	
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_shadowMap.texture->m_textureWrapT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_shadowMap.texture->m_textureMinFilter);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_shadowMap.texture->m_textureMagFilter);
-            float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-            glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+            glBindTexture(GL_TEXTURE_2D, m_shadowMap.texture->depthTexture());
+            stats::stateChange();
         }
         glBindVertexArray(m_vao);
         shader.setMat4("projection", projection);
         shader.setMat4("view", view);
         shader.setMat4("model", m_model);
+        shader.setMat3("normalMatrix", normalMatrix());
         glDrawArrays(GL_TRIANGLES, 0, 6);
+        stats::stateChange();
+        stats::drawCall(6 / 3);
         glBindVertexArray(0);
     }
 
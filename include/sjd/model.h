@@ -1,10 +1,11 @@
 #ifndef MODEL_H
 #define MODEL_H
 
-#define STB_IMAGE_IMPLEMENTATION    // configure stb headers before include
 // Model class created following the instructions at learnopengl.com here:
 // https://learnopengl.com/Model-Loading/Model
 
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <vector>
 #include <glad/glad.h>
@@ -12,8 +13,16 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <sjd/shader.h>
+#include <sjd/bounds.h>
 #include <sjd/model_mesh.h>
+#include <sjd/mesh_simplify.h>
+// only emit the stb implementation once per translation unit (see texture.h)
+#ifndef SJD_STB_IMAGE_IMPLEMENTATION
+#define SJD_STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION    // configure stb headers before include
 #include <stb/stb_image.h>
+#undef STB_IMAGE_IMPLEMENTATION
+#endif
 
 namespace sjd {
 using VertsVec = std::vector<ModelMesh::Vertex>;
@@ -23,18 +32,43 @@ unsigned int TextureFromFile(const char *path, const std::string &directory);
 
 class Model {
 public:
-    Model(std::string path) {
+    static constexpr unsigned int maxLodLevels {5};
+
+    // lodLevels > 1 simplifies every mesh at load into that many levels of detail
+    // (fewer if a mesh stops simplifying), each about half the triangles of the last
+    Model(std::string path, unsigned int lodLevels=1)
+    :   m_lodLevels {std::clamp(lodLevels, 1u, maxLodLevels)}
+    {
         loadModel(path);
     }
 
     void Draw(Shader &shader);	
 
+    void DrawLod(Shader &shader, unsigned int lod);
+
+    void DrawInstanced(Shader &shader, unsigned int amount);
+
+    // sphere around every mesh, in model space
+    Sphere bounds() const;
+
+    // most levels any mesh has
+    unsigned int lodCount() const;
+
+    // largest error of any mesh at that level, in model units
+    float lodError(unsigned int lod) const;
+
+    // The coarsest level whose error projects to no more than maxScreenError
+    // pixels, for the model drawn with `model` (taking its origin as its position).
+    unsigned int selectLod(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection,
+                           float viewportHeight, float maxScreenError=1.0f) const;
+
     std::vector<ModelMesh> m_meshes;
     TexVec m_texturesLoaded;
 
 private:
     // model data
     std::string m_directory;
+    unsigned int m_lodLevels;
 
     void loadModel(std::string path);
 
@@ -42,6 +76,9 @@ private:
 
     ModelMesh processMesh(aiMesh* mesh, const aiScene* scene);
 
+    // append the simplified levels to indices
+    std::vector<ModelMesh::Lod> buildLods(const VertsVec& vertices, std::vector<unsigned int>& indices);
+
     TexVec loadMaterialTextures(aiMaterial* mat, aiTextureType type, 
                                          std::string typeName);
 };
@@ -51,6 +88,61 @@ inline void Model::Draw(Shader &shader) {
         m_meshes[i].Draw(shader);
 }
 
+inline void Model::DrawLod(Shader &shader, unsigned int lod) {
+    for(unsigned int i = 0; i < m_meshes.size(); i++)
+        m_meshes[i].DrawLod(shader, lod);
+}
+
+inline void Model::DrawInstanced(Shader &shader, unsigned int amount) {
+    for(unsigned int i = 0; i < m_meshes.size(); i++)
+        m_meshes[i].DrawInstanced(shader, amount);
+}
+
+inline Sphere Model::bounds() const {
+    AABB box {glm::vec3(INFINITY), glm::vec3(-INFINITY)};
+    for (const ModelMesh& mesh : m_meshes) {
+        for (const ModelMesh::Vertex& vertex : mesh.m_vertices) {
+            box.min = glm::min(box.min, vertex.position);
+            box.max = glm::max(box.max, vertex.position);
+        }
+    }
+    if (box.min.x > box.max.x) return {};
+    Sphere sphere {box.center(), 0.0f};
+    for (const ModelMesh& mesh : m_meshes) {
+        for (const ModelMesh::Vertex& vertex : mesh.m_vertices) {
+            sphere.radius = std::max(sphere.radius, glm::length(vertex.position - sphere.center));
+        }
+    }
+    return sphere;
+}
+
+inline unsigned int Model::lodCount() const {
+    size_t count {1};
+    for (const ModelMesh& mesh : m_meshes) count = std::max(count, mesh.m_lods.size());
+    return static_cast<unsigned int>(count);
+}
+
+inline float Model::lodError(unsigned int lod) const {
+    float error {0.0f};
+    for (const ModelMesh& mesh : m_meshes) {
+        error = std::max(error, mesh.m_lods[std::min<size_t>(lod, mesh.m_lods.size() - 1)].error);
+    }
+    return error;
+}
+
+inline unsigned int Model::selectLod(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection,
+                                     float viewportHeight, float maxScreenError) const {
+    float depth {-(view * model[3]).z};
+    if (depth <= 0.0f) return 0;
+    float scale {std::max({glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])),
+                           glm::length(glm::vec3(model[2]))})};
+    // pixels covered by one model unit at that depth
+    float pixels {scale * projection[1][1] * viewportHeight * 0.5f / depth};
+    unsigned int lod {0};
+    while (lod + 1 < lodCount() && lodError(lod + 1) * pixels <= maxScreenError) lod++;
+    return lod;
+}
+
 inline void Model::loadModel(std::string path) {
     Assimp::Importer importer;
     const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
@@ -136,7 +228,31 @@ inline ModelMesh Model::processMesh(aiMesh *mesh, const aiScene *scene)
                         specularMaps.end());
     }
 
-    return ModelMesh(vertices, indices, textures);
+    std::vector<ModelMesh::Lod> lods {buildLods(vertices, indices)};
+    return ModelMesh(vertices, indices, textures, lods);
+}
+
+inline std::vector<ModelMesh::Lod> Model::buildLods(const VertsVec& vertices, std::vector<unsigned int>& indices) {
+    std::vector<ModelMesh::Lod> lods {{0, static_cast<unsigned int>(indices.size())}};
+    if (m_lodLevels < 2) return lods;
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;
+    for (const ModelMesh::Vertex& vertex : vertices) {
+        positions.push_back(vertex.position);
+        texCoords.push_back(vertex.texCoords);
+    }
+    MeshSimplifier simplifier {positions, texCoords, indices};
+    size_t fullCount {indices.size()};
+    for (unsigned int level = 1; level < m_lodLevels; level++) {
+        std::vector<unsigned int> simplified {simplifier.simplify(fullCount >> level)};
+        // stop once the mesh won't simplify much further; another level wouldn't be cheaper
+        if (simplified.empty() || simplified.size() * 10 > lods.back().indexCount * 9) break;
+        lods.push_back({static_cast<unsigned int>(indices.size()), static_cast<unsigned int>(simplified.size()),
+                        simplifier.error()});
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+    }
+    return lods;
 }
 
 inline TexVec Model::loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName) {
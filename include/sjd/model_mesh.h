@@ -4,11 +4,13 @@
 // mesh class written following learnopengl guide here:
 // https://learnopengl.com/Model-Loading/Mesh
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <sjd/shader.h>
+#include <sjd/profiling.h>
 
 namespace sjd {
 class ModelMesh {
@@ -24,32 +26,62 @@ public:
         std::string path;
     };
 
+    // a level of detail: a range of m_indices drawing the mesh with fewer triangles
+    struct Lod {
+        unsigned int firstIndex;
+        unsigned int indexCount;
+        // how far, in model units, this level's surface may stray from the full mesh
+        float error {0.0f};
+    };
+
     // mesh data
     std::vector<Vertex>       m_vertices;
     std::vector<unsigned int> m_indices;
     std::vector<Texture>      m_textures;
+    // most detailed first; level 0 is always the full mesh
+    std::vector<Lod>          m_lods;
 
+    // indices may hold several levels one after the other, described by lods;
+    // with no lods all of them are one level
     ModelMesh(std::vector<Vertex> vertices,
          std::vector<unsigned int> indices,
-         std::vector<Texture> textures);
+         std::vector<Texture> textures,
+         std::vector<Lod> lods={});
 
     void Draw(sjd::Shader &shader);
 
+    void DrawLod(sjd::Shader &shader, unsigned int lod);
+
+    // draw `amount` instances; per-instance attributes must already be set up on VAO
+    void DrawInstanced(sjd::Shader &shader, unsigned int amount);
+
+    // the same for one level of detail
+    void DrawInstancedLod(sjd::Shader &shader, unsigned int lod, unsigned int amount);
+
+    // drawCount draws from the commands at commandOffset in the bound
+    // GL_DRAW_INDIRECT_BUFFER (4.3 contexts only)
+    void DrawIndirect(sjd::Shader &shader, GLintptr commandOffset, unsigned int drawCount);
+
     //  render data
     unsigned int VAO, VBO, EBO;
 
 private:
 
     void setupMesh();
+
+    void bindTextures(sjd::Shader &shader);
 };
 
 inline ModelMesh::ModelMesh(std::vector<Vertex> vertices,
                   std::vector<unsigned int> indices,
-                  std::vector<Texture> textures) 
+                  std::vector<Texture> textures,
+                  std::vector<Lod> lods) 
     : m_vertices {vertices}
     , m_indices {indices}
     , m_textures {textures}
+    , m_lods {lods}
     {
+        if (m_lods.empty()) m_lods.push_back({0, static_cast<unsigned int>(m_indices.size())});
         setupMesh();
     }
 
@@ -82,6 +114,51 @@ inline void ModelMesh::setupMesh()
 }
 
 inline void ModelMesh::Draw(sjd::Shader &shader) {
+    DrawLod(shader, 0);
+}
+
+inline void ModelMesh::DrawLod(sjd::Shader &shader, unsigned int lod) {
+    const Lod& level {m_lods[std::min<size_t>(lod, m_lods.size() - 1)]};
+    bindTextures(shader);
+
+    // draw mesh
+    glBindVertexArray(VAO);
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(level.indexCount), GL_UNSIGNED_INT,
+                   (void*)(level.firstIndex * sizeof(unsigned int)));
+    glBindVertexArray(0);
+    stats::stateChange();
+    stats::drawCall(level.indexCount / 3);
+}
+
+inline void ModelMesh::DrawInstanced(sjd::Shader &shader, unsigned int amount) {
+    DrawInstancedLod(shader, 0, amount);
+}
+
+inline void ModelMesh::DrawInstancedLod(sjd::Shader &shader, unsigned int lod, unsigned int amount) {
+    if (amount == 0) return;
+    const Lod& level {m_lods[std::min<size_t>(lod, m_lods.size() - 1)]};
+    bindTextures(shader);
+
+    glBindVertexArray(VAO);
+    glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(level.indexCount), GL_UNSIGNED_INT,
+                            (void*)(level.firstIndex * sizeof(unsigned int)), amount);
+    glBindVertexArray(0);
+    stats::stateChange();
+    stats::drawCall(level.indexCount / 3, amount);
+}
+
+inline void ModelMesh::DrawIndirect(sjd::Shader &shader, GLintptr commandOffset, unsigned int drawCount) {
+    bindTextures(shader);
+
+    glBindVertexArray(VAO);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)commandOffset, drawCount, 0);
+    glBindVertexArray(0);
+    stats::stateChange();
+    // the instance counts live on the GPU, so only the call is counted
+    stats::drawCall(0);
+}
+
+inline void ModelMesh::bindTextures(sjd::Shader &shader) {
     unsigned int diffuseNr {0};
     unsigned int specularNr {0};
     for(unsigned int i = 0; i < m_textures.size(); i++)
@@ -97,13 +174,9 @@ inline void ModelMesh::Draw(sjd::Shader &shader) {
 
         shader.setInt(("material." + name + number).c_str(), i);
         glBindTexture(GL_TEXTURE_2D, m_textures[i].id);
+        stats::stateChange();
     }
     glActiveTexture(GL_TEXTURE0);
-
-    // draw mesh
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_indices.size()), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
 }
 }
 #endif
@@ -0,0 +1,458 @@
+#ifndef OCCLUSION_RASTER_H
+#define OCCLUSION_RASTER_H
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <sjd/bounds.h>
+#include <sjd/model_mesh.h>
+#include <sjd/simd_math.h>
+#include <sjd/worker_pool.h>
+
+namespace sjd {
+
+// Occlusion culling on the CPU, for contexts where sjd::HiZCuller would have to
+// read depth back from the GPU. A handful of big occluders are drawn as boxes
+// (12 triangles each, near plane clipped, back faces dropped) into a small
+// depth buffer, and then world space boxes are tested against it: a box is
+// hidden if its nearest depth is behind every texel under it. Everything
+// happens before the frame's draws, so unlike HiZCuller there's no frame of lag.
+//
+// The depth buffer is split into tiles; triangles are binned by the tiles
+// their bounds touch, and the tiles are rasterized in parallel on a
+// sjd::WorkerPool, so no two threads ever write the same texel. Within a tile
+// the edge functions and depth are evaluated for 4 (SSE2) or 8 (AVX2) texels
+// at once, picked at runtime like the sjd::simd kernels.
+//
+// Occluders have to be inside what they stand for or they'll hide things that
+// are visible. Box meshes (sjd::Cube, sjd::Quad) are their own bounds; for
+// anything else pass a scale that shrinks the box to fit inside the mesh.
+// Coverage is sampled at texel centres, so an occluder can cover up to half a
+// texel more than it should at its edges; the test looks one texel past a
+// box's outline to make up for that.
+class SoftwareOcclusion {
+public:
+    static constexpr unsigned int tileWidth {32};
+    static constexpr unsigned int tileHeight {16};
+
+    // the size is rounded up to whole tiles
+    SoftwareOcclusion(sjd::WorkerPool& pool, unsigned int width=256, unsigned int height=128)
+    :   m_pool {pool}
+    ,   m_width {(std::max(width, 1u) + tileWidth - 1) / tileWidth * tileWidth}
+    ,   m_height {(std::max(height, 1u) + tileHeight - 1) / tileHeight * tileHeight}
+    ,   m_tilesX {m_width / tileWidth}
+    ,   m_tilesY {m_height / tileHeight}
+    ,   m_depth(static_cast<size_t>(m_width) * m_height, 1.0f)
+    ,   m_bins(static_cast<size_t>(m_tilesX) * m_tilesY)
+    ,   m_occludedCount {0}
+    ,   m_rasterMs {0.0}
+    ,   m_testMs {0.0}
+    {
+    }
+
+    SoftwareOcclusion(const SoftwareOcclusion&) = delete;
+    SoftwareOcclusion& operator=(const SoftwareOcclusion&) = delete;
+
+    unsigned int width() const {
+        return m_width;
+    }
+
+    unsigned int height() const {
+        return m_height;
+    }
+
+    void clearOccluders() {
+        m_occluders.clear();
+    }
+
+    // A box occluder: `localBounds` shrunk about its centre by `scale`, then
+    // put in the world by `model`.
+    void addOccluder(const AABB& localBounds, const glm::mat4& model, float scale=1.0f) {
+        glm::vec3 center {localBounds.center()};
+        glm::vec3 extents {localBounds.extents() * scale};
+        Occluder occluder {};
+        for (unsigned int corner = 0; corner < 8; corner++) {
+            glm::vec3 point {center.x + ((corner & 1) ? extents.x : -extents.x),
+                             center.y + ((corner & 2) ? extents.y : -extents.y),
+                             center.z + ((corner & 4) ? extents.z : -extents.z)};
+            occluder.corners[corner] = glm::vec3(model * glm::vec4(point, 1.0f));
+        }
+        // a mirroring model matrix turns the faces inside out
+        occluder.mirrored = glm::determinant(glm::mat3(model)) < 0.0f;
+        m_occluders.push_back(occluder);
+    }
+
+    // bounds of a model mesh's vertices, for addOccluder()
+    static AABB vertexBounds(const ModelMesh& mesh) {
+        AABB box {glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX)};
+        for (const ModelMesh::Vertex& vertex : mesh.m_vertices) {
+            box.min = glm::min(box.min, vertex.position);
+            box.max = glm::max(box.max, vertex.position);
+        }
+        if (box.min.x > box.max.x) return {};
+        return box;
+    }
+
+    size_t occluderCount() const {
+        return m_occluders.size();
+    }
+
+    // Clear the depth buffer and draw every occluder into it.
+    void render(const glm::mat4& viewProjection) {
+        auto start {std::chrono::steady_clock::now()};
+
+        // set up each occluder's triangles in its own slots, then bin them in order
+        m_setup.resize(m_occluders.size() * maxTrianglesPerOccluder);
+        m_setupCount.assign(m_occluders.size(), 0);
+        m_pool.parallelFor(m_occluders.size(), 16, [&](size_t first, size_t count) {
+            for (size_t i = first; i < first + count; i++) setUpOccluder(i, viewProjection);
+        });
+        m_triangles.clear();
+        for (std::vector<uint32_t>& bin : m_bins) bin.clear();
+        for (size_t i = 0; i < m_occluders.size(); i++) {
+            for (unsigned int j = 0; j < m_setupCount[i]; j++) {
+                const Triangle& triangle {m_setup[i * maxTrianglesPerOccluder + j]};
+                uint32_t index {static_cast<uint32_t>(m_triangles.size())};
+                m_triangles.push_back(triangle);
+                for (int tileY = triangle.minY / static_cast<int>(tileHeight);
+                     tileY <= (triangle.maxY - 1) / static_cast<int>(tileHeight); tileY++) {
+                    for (int tileX = triangle.minX / static_cast<int>(tileWidth);
+                         tileX <= (triangle.maxX - 1) / static_cast<int>(tileWidth); tileX++) {
+                        m_bins[static_cast<size_t>(tileY) * m_tilesX + tileX].push_back(index);
+                    }
+                }
+            }
+        }
+
+        m_pool.parallelFor(m_bins.size(), 1, [&](size_t first, size_t count) {
+            for (size_t tile = first; tile < first + count; tile++) rasterizeTile(tile);
+        });
+
+        auto end {std::chrono::steady_clock::now()};
+        m_rasterMs = std::chrono::duration<double, std::milli>(end - start).count();
+        m_viewProjection = viewProjection;
+    }
+
+    // whether `box` is behind the occluders drawn by the last render()
+    bool occluded(const AABB& box) const {
+        glm::vec3 ndcMin {FLT_MAX};
+        glm::vec3 ndcMax {-FLT_MAX};
+        for (unsigned int corner = 0; corner < 8; corner++) {
+            glm::vec3 point {(corner & 1) ? box.max.x : box.min.x,
+                             (corner & 2) ? box.max.y : box.min.y,
+                             (corner & 4) ? box.max.z : box.min.z};
+            glm::vec4 clip {m_viewProjection * glm::vec4(point, 1.0f)};
+            // reaching behind the camera, nothing to go on
+            if (clip.w <= 1e-5f) return false;
+            glm::vec3 ndc {glm::vec3(clip) / clip.w};
+            ndcMin = glm::min(ndcMin, ndc);
+            ndcMax = glm::max(ndcMax, ndc);
+        }
+        if (ndcMax.x < -1.0f || ndcMax.y < -1.0f || ndcMin.x > 1.0f || ndcMin.y > 1.0f) return false;
+        float nearest {ndcMin.z * 0.5f + 0.5f};
+        if (nearest <= 0.0f) return false;
+
+        // every texel the box touches and one more all round
+        int lastX {static_cast<int>(m_width) - 1};
+        int lastY {static_cast<int>(m_height) - 1};
+        int minX {std::clamp(static_cast<int>(std::floor((ndcMin.x * 0.5f + 0.5f) * m_width)) - 1, 0, lastX)};
+        int minY {std::clamp(static_cast<int>(std::floor((ndcMin.y * 0.5f + 0.5f) * m_height)) - 1, 0, lastY)};
+        int maxX {std::clamp(static_cast<int>(std::ceil((ndcMax.x * 0.5f + 0.5f) * m_width)), 0, lastX)};
+        int maxY {std::clamp(static_cast<int>(std::ceil((ndcMax.y * 0.5f + 0.5f) * m_height)), 0, lastY)};
+        for (int y = minY; y <= maxY; y++) {
+            const float* row {m_depth.data() + static_cast<size_t>(y) * m_width};
+            for (int x = minX; x <= maxX; x++) {
+                if (row[x] >= nearest) return false;
+            }
+        }
+        return true;
+    }
+
+    // Test every box against the last render(), across the pool; visible()
+    // answers for them afterwards.
+    void test(const std::vector<AABB>& boxes) {
+        auto start {std::chrono::steady_clock::now()};
+        m_visibility.assign(boxes.size(), 1);
+        m_pool.parallelFor(boxes.size(), 64, [&](size_t first, size_t count) {
+            for (size_t i = first; i < first + count; i++) {
+                if (occluded(boxes[i])) m_visibility[i] = 0;
+            }
+        });
+        m_occludedCount = static_cast<unsigned int>(std::count(m_visibility.begin(), m_visibility.end(), 0));
+        auto end {std::chrono::steady_clock::now()};
+        m_testMs = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // false only if the last test() found box `index` hidden
+    bool visible(size_t index) const {
+        return index >= m_visibility.size() || m_visibility[index] != 0;
+    }
+
+    unsigned int occludedCount() const {
+        return m_occludedCount;
+    }
+
+    // triangles the last render() rasterized, after clipping and back faces
+    size_t trianglesRasterized() const {
+        return m_triangles.size();
+    }
+
+    // CPU time of the last render() and test()
+    double rasterMs() const {
+        return m_rasterMs;
+    }
+
+    double testMs() const {
+        return m_testMs;
+    }
+
+    double trianglesPerMs() const {
+        return (m_rasterMs > 0.0) ? static_cast<double>(m_triangles.size()) / m_rasterMs : 0.0;
+    }
+
+    // window space depth, bottom row first, 1 where no occluder was drawn
+    const std::vector<float>& depth() const {
+        return m_depth;
+    }
+
+private:
+    // 12 faces' worth, each of which near plane clipping can split in two
+    static constexpr unsigned int maxTrianglesPerOccluder {24};
+
+    struct Occluder {
+        std::array<glm::vec3, 8> corners;
+        bool mirrored;
+    };
+
+    // Ready to rasterize, in texel units with texel centres at whole numbers:
+    // a texel is inside when all three a * x + b * y + c >= 0, and its depth is
+    // zx * x + zy * y + z0.
+    struct Triangle {
+        float a[3];
+        float b[3];
+        float c[3];
+        float zx, zy, z0;
+        // texels that can be covered, max exclusive
+        int minX, minY, maxX, maxY;
+    };
+
+    void setUpOccluder(size_t index, const glm::mat4& viewProjection) {
+        // counter-clockwise seen from outside, corner bits are x, y, z
+        static const unsigned int faces[6][4] {
+            {0, 4, 6, 2}, {1, 3, 7, 5},
+            {0, 1, 5, 4}, {2, 6, 7, 3},
+            {0, 2, 3, 1}, {4, 5, 7, 6}
+        };
+        const Occluder& occluder {m_occluders[index]};
+        std::array<glm::vec4, 8> clip;
+        for (unsigned int corner = 0; corner < 8; corner++) {
+            clip[corner] = viewProjection * glm::vec4(occluder.corners[corner], 1.0f);
+        }
+        Triangle* out {&m_setup[index * maxTrianglesPerOccluder]};
+        unsigned int& count {m_setupCount[index]};
+        for (const unsigned int* face : faces) {
+            for (unsigned int half = 0; half < 2; half++) {
+                std::array<glm::vec4, 3> triangle {clip[face[0]], clip[face[half + 1]], clip[face[half + 2]]};
+                if (occluder.mirrored) std::swap(triangle[1], triangle[2]);
+                count += clipAndSetUp(triangle, out + count);
+            }
+        }
+    }
+
+    // Clip against the near plane (z >= -w), which leaves a triangle or a quad,
+    // and set up what's left if it faces the camera and touches the buffer.
+    unsigned int clipAndSetUp(const std::array<glm::vec4, 3>& triangle, Triangle* out) const {
+        glm::vec4 polygon[4];
+        unsigned int vertices {0};
+        for (unsigned int i = 0; i < 3; i++) {
+            const glm::vec4& from {triangle[i]};
+            const glm::vec4& to {triangle[(i + 1) % 3]};
+            float fromDistance {from.z + from.w};
+            float toDistance {to.z + to.w};
+            if (fromDistance >= 0.0f) polygon[vertices++] = from;
+            if ((fromDistance >= 0.0f) != (toDistance >= 0.0f)) {
+                float t {fromDistance / (fromDistance - toDistance)};
+                polygon[vertices++] = from + (to - from) * t;
+            }
+        }
+        if (vertices < 3) return 0;
+
+        glm::vec3 window[4];
+        for (unsigned int i = 0; i < vertices; i++) {
+            float w {std::max(polygon[i].w, 1e-6f)};
+            window[i] = {(polygon[i].x / w * 0.5f + 0.5f) * m_width,
+                         (polygon[i].y / w * 0.5f + 0.5f) * m_height,
+                         polygon[i].z / w * 0.5f + 0.5f};
+        }
+        unsigned int written {0};
+        for (unsigned int i = 2; i < vertices; i++) {
+            if (setUp(window[0], window[i - 1], window[i], out[written])) written++;
+        }
+        return written;
+    }
+
+    bool setUp(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, Triangle& triangle) const {
+        float area {(v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y)};
+        // back facing, or too thin to cover anything
+        if (area <= 1e-6f) return false;
+        if (std::min({v0.z, v1.z, v2.z}) >= 1.0f) return false;
+
+        float minX {std::min({v0.x, v1.x, v2.x})};
+        float minY {std::min({v0.y, v1.y, v2.y})};
+        float maxX {std::max({v0.x, v1.x, v2.x})};
+        float maxY {std::max({v0.y, v1.y, v2.y})};
+        triangle.minX = static_cast<int>(std::clamp(std::floor(minX), 0.0f, static_cast<float>(m_width)));
+        triangle.minY = static_cast<int>(std::clamp(std::floor(minY), 0.0f, static_cast<float>(m_height)));
+        triangle.maxX = static_cast<int>(std::clamp(std::ceil(maxX), 0.0f, static_cast<float>(m_width)));
+        triangle.maxY = static_cast<int>(std::clamp(std::ceil(maxY), 0.0f, static_cast<float>(m_height)));
+        if (triangle.minX >= triangle.maxX || triangle.minY >= triangle.maxY) return false;
+
+        // edges left of v0 -> v1 -> v2 -> v0, moved so whole numbers are texel centres
+        const glm::vec3* corners[3] {&v0, &v1, &v2};
+        for (unsigned int edge = 0; edge < 3; edge++) {
+            const glm::vec3& from {*corners[edge]};
+            const glm::vec3& to {*corners[(edge + 1) % 3]};
+            triangle.a[edge] = from.y - to.y;
+            triangle.b[edge] = to.x - from.x;
+            triangle.c[edge] = -(triangle.a[edge] * from.x + triangle.b[edge] * from.y)
+                               + 0.5f * (triangle.a[edge] + triangle.b[edge]);
+        }
+        triangle.zx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+        triangle.zy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+        triangle.z0 = v0.z - triangle.zx * v0.x - triangle.zy * v0.y + 0.5f * (triangle.zx + triangle.zy);
+        return true;
+    }
+
+    void rasterizeTile(size_t tile) {
+        int tileX {static_cast<int>((tile % m_tilesX) * tileWidth)};
+        int tileY {static_cast<int>((tile / m_tilesX) * tileHeight)};
+        for (int y = tileY; y < tileY + static_cast<int>(tileHeight); y++) {
+            std::fill_n(m_depth.data() + static_cast<size_t>(y) * m_width + tileX, tileWidth, 1.0f);
+        }
+        for (uint32_t index : m_bins[tile]) {
+            const Triangle& triangle {m_triangles[index]};
+            int minX {std::max(triangle.minX, tileX)};
+            int minY {std::max(triangle.minY, tileY)};
+            int maxX {std::min(triangle.maxX, tileX + static_cast<int>(tileWidth))};
+            int maxY {std::min(triangle.maxY, tileY + static_cast<int>(tileHeight))};
+#ifdef SJD_SIMD_X86
+            switch (simd::activeIsa()) {
+                case simd::Isa::AVX2:
+                    rasterizeAvx2(triangle, minX, minY, maxX, maxY, m_depth.data(), m_width);
+                    continue;
+                case simd::Isa::SSE2:
+                    rasterizeSse2(triangle, minX, minY, maxX, maxY, m_depth.data(), m_width);
+                    continue;
+                default:
+                    break;
+            }
+#endif
+            rasterizeScalar(triangle, minX, minY, maxX, maxY, m_depth.data(), m_width);
+        }
+    }
+
+    // Keep the nearer depth at every covered texel of [minX, maxX) x [minY, maxY).
+    // The SIMD versions round minX down to a whole group of texels; tiles are
+    // whole groups wide, so that never leaves the tile.
+    static void rasterizeScalar(const Triangle& t, int minX, int minY, int maxX, int maxY,
+                                float* depth, unsigned int stride) {
+        for (int y = minY; y < maxY; y++) {
+            float fy {static_cast<float>(y)};
+            float row0 {t.b[0] * fy + t.c[0]};
+            float row1 {t.b[1] * fy + t.c[1]};
+            float row2 {t.b[2] * fy + t.c[2]};
+            float rowZ {t.zy * fy + t.z0};
+            float* texels {depth + static_cast<size_t>(y) * stride};
+            for (int x = minX; x < maxX; x++) {
+                float fx {static_cast<float>(x)};
+                if (t.a[0] * fx + row0 < 0.0f || t.a[1] * fx + row1 < 0.0f || t.a[2] * fx + row2 < 0.0f) continue;
+                texels[x] = std::min(texels[x], t.zx * fx + rowZ);
+            }
+        }
+    }
+
+#ifdef SJD_SIMD_X86
+    static void rasterizeSse2(const Triangle& t, int minX, int minY, int maxX, int maxY,
+                              float* depth, unsigned int stride) {
+        const __m128 zero {_mm_setzero_ps()};
+        const __m128 lanes {_mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f)};
+        const __m128 a0 {_mm_set1_ps(t.a[0])}, a1 {_mm_set1_ps(t.a[1])}, a2 {_mm_set1_ps(t.a[2])};
+        const __m128 zx {_mm_set1_ps(t.zx)};
+        for (int y = minY; y < maxY; y++) {
+            float fy {static_cast<float>(y)};
+            __m128 row0 {_mm_set1_ps(t.b[0] * fy + t.c[0])};
+            __m128 row1 {_mm_set1_ps(t.b[1] * fy + t.c[1])};
+            __m128 row2 {_mm_set1_ps(t.b[2] * fy + t.c[2])};
+            __m128 rowZ {_mm_set1_ps(t.zy * fy + t.z0)};
+            float* texels {depth + static_cast<size_t>(y) * stride};
+            for (int x = minX & ~3; x < maxX; x += 4) {
+                __m128 fx {_mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lanes)};
+                __m128 inside {_mm_and_ps(_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, fx), row0), zero),
+                                          _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, fx), row1), zero))};
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, fx), row2), zero));
+                if (_mm_movemask_ps(inside) == 0) continue;
+                __m128 old {_mm_loadu_ps(texels + x)};
+                __m128 nearer {_mm_min_ps(old, _mm_add_ps(_mm_mul_ps(zx, fx), rowZ))};
+                _mm_storeu_ps(texels + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+            }
+        }
+    }
+
+    SJD_TARGET_AVX2
+    static void rasterizeAvx2(const Triangle& t, int minX, int minY, int maxX, int maxY,
+                              float* depth, unsigned int stride) {
+        const __m256 zero {_mm256_setzero_ps()};
+        const __m256 lanes {_mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f)};
+        const __m256 a0 {_mm256_set1_ps(t.a[0])}, a1 {_mm256_set1_ps(t.a[1])}, a2 {_mm256_set1_ps(t.a[2])};
+        const __m256 zx {_mm256_set1_ps(t.zx)};
+        for (int y = minY; y < maxY; y++) {
+            float fy {static_cast<float>(y)};
+            __m256 row0 {_mm256_set1_ps(t.b[0] * fy + t.c[0])};
+            __m256 row1 {_mm256_set1_ps(t.b[1] * fy + t.c[1])};
+            __m256 row2 {_mm256_set1_ps(t.b[2] * fy + t.c[2])};
+            __m256 rowZ {_mm256_set1_ps(t.zy * fy + t.z0)};
+            float* texels {depth + static_cast<size_t>(y) * stride};
+            for (int x = minX & ~7; x < maxX; x += 8) {
+                __m256 fx {_mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), lanes)};
+                __m256 inside {_mm256_and_ps(
+                    _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(a0, fx), row0), zero, _CMP_GE_OQ),
+                    _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(a1, fx), row1), zero, _CMP_GE_OQ))};
+                inside = _mm256_and_ps(inside,
+                    _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(a2, fx), row2), zero, _CMP_GE_OQ));
+                if (_mm256_movemask_ps(inside) == 0) continue;
+                __m256 old {_mm256_loadu_ps(texels + x)};
+                __m256 nearer {_mm256_min_ps(old, _mm256_add_ps(_mm256_mul_ps(zx, fx), rowZ))};
+                _mm256_storeu_ps(texels + x, _mm256_blendv_ps(old, nearer, inside));
+            }
+        }
+    }
+#endif
+
+    sjd::WorkerPool& m_pool;
+    unsigned int m_width;
+    unsigned int m_height;
+    unsigned int m_tilesX;
+    unsigned int m_tilesY;
+    std::vector<float> m_depth;
+    std::vector<Occluder> m_occluders;
+    // maxTrianglesPerOccluder slots per occluder, m_setupCount of them used
+    std::vector<Triangle> m_setup;
+    std::vector<unsigned int> m_setupCount;
+    std::vector<Triangle> m_triangles;
+    // indices into m_triangles, per tile
+    std::vector<std::vector<uint32_t>> m_bins;
+    glm::mat4 m_viewProjection {1.0f};
+    std::vector<uint8_t> m_visibility;
+    unsigned int m_occludedCount;
+    double m_rasterMs;
+    double m_testMs;
+};
+
+}
+#endif
@@ -1,54 +1,102 @@
 #ifndef PLAYER_H
 #define PLAYER_H
+#include <memory>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <sjd/camera.h>
-#include <sjd/mouse_input.h>
+#include <sjd/input.h>
 
 namespace sjd {
 class Player {
 public:
 
+    // live keyboard and mouse input from the window
     Player(GLFWwindow* window, sjd::Camera& playerCamera)
     :   m_window {window}
     ,   m_playerCamera {playerCamera}
-    ,   m_playerMouse {window}
+    ,   m_liveInput {std::make_unique<GlfwInput>(window)}
+    ,   m_input {m_liveInput.get()}
+    ,   m_recorder {nullptr}
+    ,   m_inputFinished {false}
     {
     }
 
+    // input from any source, e.g. an InputReplay; no window needed
+    Player(sjd::Camera& playerCamera, InputSource& input)
+    :   m_window {nullptr}
+    ,   m_playerCamera {playerCamera}
+    ,   m_liveInput {nullptr}
+    ,   m_input {&input}
+    ,   m_recorder {nullptr}
+    ,   m_inputFinished {false}
+    {
+        _restore_start_pose();
+    }
+
+    // a recording also moves the camera back to where it started
+    void setInput(InputSource* input) {
+        m_input = input;
+        m_inputFinished = false;
+        _restore_start_pose();
+    }
+
+    // every processed frame is also written to the recorder (nullptr to stop)
+    void setRecorder(InputRecorder* recorder) {
+        m_recorder = recorder;
+    }
+
+    // true once a finite source (a replay) has run out of frames
+    bool inputFinished() const {
+        return m_inputFinished;
+    }
+
     // take input from user
     void processInput(float deltaTime)
     {
-        glm::vec2 mouse_movement {m_playerMouse.getoffsets()};
-        m_playerCamera.processMouseMovement(mouse_movement.x,
-                                            mouse_movement.y);
-        m_playerCamera.processMouseScroll(m_playerMouse.getScroll());
-        if (glfwGetKey(m_window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        InputFrame frame {};
+        if (!m_input || !m_input->poll(frame, deltaTime)) {
+            m_inputFinished = true;
+            return;
+        }
+        if (m_recorder) m_recorder->record(frame);
+
+        m_playerCamera.processMouseMovement(frame.mouseOffset.x,
+                                            frame.mouseOffset.y);
+        m_playerCamera.processMouseScroll(frame.scroll);
+        if (frame.pressed(InputFrame::QUIT) && m_window)
             glfwSetWindowShouldClose(m_window, true);
-        if (glfwGetKey(m_window, GLFW_KEY_W) == GLFW_PRESS)
+        if (frame.pressed(InputFrame::FORWARD))
             m_playerCamera.processKeyboard(sjd::Camera::FORWARD,
-                                              deltaTime);
-        if (glfwGetKey(m_window, GLFW_KEY_S) == GLFW_PRESS)
+                                              frame.deltaTime);
+        if (frame.pressed(InputFrame::BACKWARD))
             m_playerCamera.processKeyboard(sjd::Camera::BACKWARD,
-                                              deltaTime);
-        if (glfwGetKey(m_window, GLFW_KEY_A) == GLFW_PRESS)
+                                              frame.deltaTime);
+        if (frame.pressed(InputFrame::LEFT))
             m_playerCamera.processKeyboard(sjd::Camera::LEFT,
-                                              deltaTime);
-        if (glfwGetKey(m_window, GLFW_KEY_D) == GLFW_PRESS)
+                                              frame.deltaTime);
+        if (frame.pressed(InputFrame::RIGHT))
             m_playerCamera.processKeyboard(sjd::Camera::RIGHT,
-                                              deltaTime);
-        if (glfwGetKey(m_window, GLFW_KEY_SPACE) == GLFW_PRESS)
+                                              frame.deltaTime);
+        if (frame.pressed(InputFrame::UP))
             m_playerCamera.processKeyboard(sjd::Camera::UP,
-                                              deltaTime);
-        if (glfwGetKey(m_window, GLFW_KEY_C) == GLFW_PRESS)
+                                              frame.deltaTime);
+        if (frame.pressed(InputFrame::DOWN))
             m_playerCamera.processKeyboard(sjd::Camera::DOWN,
-                                              deltaTime);
+                                              frame.deltaTime);
     }
 
 private:
+    void _restore_start_pose() {
+        CameraPose pose {};
+        if (m_input && m_input->startPose(pose)) pose.apply(m_playerCamera);
+    }
+
     GLFWwindow* m_window;
     Camera& m_playerCamera;
-    Mouse m_playerMouse;
+    std::unique_ptr<GlfwInput> m_liveInput;
+    InputSource* m_input;
+    InputRecorder* m_recorder;
+    bool m_inputFinished;
 };
 }
 #endif
@@ -0,0 +1,206 @@
+#ifndef POST_ANTIALIASING_H
+#define POST_ANTIALIASING_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <sjd/glfw_setup.h>
+#include <sjd/profiling.h>
+#include <sjd/render_graph.h>
+#include <sjd/render_target.h>
+#include <sjd/shader.h>
+
+namespace sjd {
+
+struct PostAntiAliasingSettings {
+    float edgeThreshold {0.1f};         // SMAA: luma step (gamma space) that counts as an edge
+    int maxSearch {16};                 // SMAA: pixels searched along an edge each way
+};
+
+// Anti-aliasing as a pass over the finished image, for a window created single
+// sampled with createCoreWindow(width, height, FXAA or SMAA). Nothing is kept
+// from frame to frame, so unlike TemporalAA there's no ghosting or motion to
+// track, but also nothing finer than a pixel to go on: it smooths the stairs
+// along geometric edges, not detail that falls between pixels.
+//
+// FXAA is one pass that finds edges from the luma around each pixel and blurs
+// across them. SMAA 1x takes three: edges into an RGBA8 target, then how much
+// each edge pixel should blend from the shape of the edge it's on, then the
+// blend, which keeps sharp corners and text that FXAA softens.
+//
+// Against 4x MSAA at the same size: the scene's colour and depth are written
+// once per pixel rather than four times and nothing has to be resolved; the
+// extras are an 8 byte a pixel target to draw into and, for SMAA, two transient
+// 4 byte a pixel targets that only live for the passes.
+//
+//     PostAntiAliasing antiAliasing {windowAntiAliasing(window)};
+//     antiAliasing.begin(width, height, clearColour);
+//     scene.draw(shader);
+//     antiAliasing.end();     // into what was bound before begin()
+//
+// For MSAA it draws straight to what's bound and end() does nothing, so the
+// same code serves every window.
+class PostAntiAliasing {
+public:
+    PostAntiAliasing(AntiAliasing mode, PostAntiAliasingSettings settings={})
+    :   m_mode {mode}
+    ,   m_settings {settings}
+    ,   m_linear {false}
+    {
+        if (m_mode == FXAA) {
+            m_fxaaShader = std::make_unique<Shader>("../code/shaders/deferred_fullscreen.vert.glsl",
+                                                    "../code/shaders/fxaa.frag.glsl");
+        }
+        else if (m_mode == SMAA) {
+            m_edgesShader = std::make_unique<Shader>("../code/shaders/deferred_fullscreen.vert.glsl",
+                                                     "../code/shaders/smaa_edges.frag.glsl");
+            m_weightsShader = std::make_unique<Shader>("../code/shaders/deferred_fullscreen.vert.glsl",
+                                                       "../code/shaders/smaa_weights.frag.glsl");
+            m_blendShader = std::make_unique<Shader>("../code/shaders/deferred_fullscreen.vert.glsl",
+                                                     "../code/shaders/smaa_blend.frag.glsl");
+        }
+        glGenVertexArrays(1, &m_emptyVao);
+        m_graph.setTiming(true);
+    }
+
+    ~PostAntiAliasing() {
+        glDeleteVertexArrays(1, &m_emptyVao);
+    }
+
+    PostAntiAliasing(const PostAntiAliasing&) = delete;
+    PostAntiAliasing& operator=(const PostAntiAliasing&) = delete;
+
+    // Draw into the target to be anti-aliased from here on, `width` by
+    // `height` and cleared to `clearColour`. The target is sRGB when
+    // GL_FRAMEBUFFER_SRGB is on, so the scene is written the way it would be to
+    // the window.
+    void begin(unsigned int width, unsigned int height, glm::vec4 clearColour=glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)) {
+        glClearColor(clearColour.x, clearColour.y, clearColour.z, clearColour.w);
+        if (m_mode == MSAA) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            return;
+        }
+        m_linear = glIsEnabled(GL_FRAMEBUFFER_SRGB);
+        RenderTarget::ColourFormat format {m_linear ? RenderTarget::SRGB8_ALPHA8 : RenderTarget::RGBA8};
+        if (!m_target || m_target->description().colour[0] != format) {
+            m_target = std::make_unique<RenderTarget>(width, height, RenderTarget::Description {{format},
+                                                                                                RenderTarget::DEPTH24});
+        }
+        m_target->resize(width, height);
+        m_target->bind();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+
+    // anti-alias what was drawn since begin() into the framebuffer bound then
+    void end() {
+        if (m_mode == MSAA) return;
+        m_target->release();
+        m_graph.importTarget("scene", *m_target);
+        m_graph.importBackbuffer("output");
+        addPasses(m_graph, "scene", "output");
+        m_graph.execute();
+    }
+
+    // The passes on `graph`, from the target `input` to `output`. SMAA's edge
+    // and weight targets are transients sized from the graph's backbuffer.
+    void addPasses(RenderGraph& graph, const std::string& input, const std::string& output) {
+        if (m_mode == FXAA) {
+            graph.addPass("fxaa", [this, input](RenderGraph::Context& context) {
+                context.bindTexture(input, 0);
+                m_fxaaShader->use();
+                m_fxaaShader->setInt("source", 0);
+                m_fxaaShader->setBool("linearInput", m_linear);
+                _draw(*m_fxaaShader, context);
+            }).read(input).write(output);
+        }
+        else if (m_mode == SMAA) {
+            graph.createTarget("smaa_edges", {{RenderTarget::RGBA8}, RenderTarget::NO_DEPTH});
+            graph.createTarget("smaa_weights", {{RenderTarget::RGBA8}, RenderTarget::NO_DEPTH});
+            // both are mostly empty: the passes discard everywhere there's no edge
+            graph.addPass("smaa_edges", [this, input](RenderGraph::Context& context) {
+                context.bindTexture(input, 0);
+                m_edgesShader->use();
+                m_edgesShader->setInt("source", 0);
+                m_edgesShader->setBool("linearInput", m_linear);
+                m_edgesShader->setFloat("threshold", m_settings.edgeThreshold);
+                _draw(*m_edgesShader, context);
+            }).read(input).write("smaa_edges", GL_COLOR_BUFFER_BIT);
+            graph.addPass("smaa_weights", [this](RenderGraph::Context& context) {
+                context.bindTexture("smaa_edges", 0);
+                m_weightsShader->use();
+                m_weightsShader->setInt("edges", 0);
+                m_weightsShader->setInt("maxSearch", m_settings.maxSearch);
+                _draw(*m_weightsShader, context);
+            }).read("smaa_edges").write("smaa_weights", GL_COLOR_BUFFER_BIT);
+            graph.addPass("smaa_blend", [this, input](RenderGraph::Context& context) {
+                context.bindTexture(input, 0);
+                context.bindTexture("smaa_weights", 1);
+                m_blendShader->use();
+                m_blendShader->setInt("source", 0);
+                m_blendShader->setInt("weights", 1);
+                _draw(*m_blendShader, context);
+            }).read(input).read("smaa_weights").write(output);
+        }
+    }
+
+    AntiAliasing mode() const {
+        return m_mode;
+    }
+
+    PostAntiAliasingSettings& settings() {
+        return m_settings;
+    }
+
+    // video memory of the target and, for SMAA, the edge and weight targets
+    // while they're alive
+    size_t bytes() const {
+        if (!m_target) return 0;
+        size_t total {m_target->bytes()};
+        if (m_mode == SMAA) {
+            total += 2 * RenderTarget::bytes({{RenderTarget::RGBA8}, RenderTarget::NO_DEPTH},
+                                             m_target->width(), m_target->height());
+        }
+        return total;
+    }
+
+    // GPU time of the last measured frame's passes, a few frames behind
+    double lastMs() const {
+        if (m_mode == FXAA) return m_graph.passMs("fxaa");
+        if (m_mode == SMAA) {
+            return m_graph.passMs("smaa_edges") + m_graph.passMs("smaa_weights") + m_graph.passMs("smaa_blend");
+        }
+        return 0.0;
+    }
+
+private:
+    void _draw(Shader& shader, const RenderGraph::Context& context) {
+        shader.setVec2("outputSize", glm::vec2(static_cast<float>(context.width()),
+                                               static_cast<float>(context.height())));
+        GLboolean depthTest {glIsEnabled(GL_DEPTH_TEST)};
+        GLboolean blend {glIsEnabled(GL_BLEND)};
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+        glBindVertexArray(m_emptyVao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+        if (depthTest) glEnable(GL_DEPTH_TEST);
+        if (blend) glEnable(GL_BLEND);
+        stats::drawCall(1);
+    }
+
+    AntiAliasing m_mode;
+    PostAntiAliasingSettings m_settings;
+    bool m_linear;
+    std::unique_ptr<RenderTarget> m_target;
+    std::unique_ptr<Shader> m_fxaaShader;
+    std::unique_ptr<Shader> m_edgesShader;
+    std::unique_ptr<Shader> m_weightsShader;
+    std::unique_ptr<Shader> m_blendShader;
+    unsigned int m_emptyVao;
+    RenderGraph m_graph;
+};
+
+}
+#endif
@@ -0,0 +1,453 @@
+#ifndef POST_PROCESS_H
+#define POST_PROCESS_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <sjd/profiling.h>
+#include <sjd/render_graph.h>
+#include <sjd/render_target.h>
+#include <sjd/shader.h>
+#include <sjd/worker_pool.h>
+
+namespace sjd {
+
+struct PostProcessSettings {
+    bool fuse {true};                   // false gives one pass per effect
+    // between passes, when there's more than one
+    RenderTarget::ColourFormat intermediateFormat {RenderTarget::RGBA16F};
+};
+
+// Full-screen effects applied in order to a finished frame: tonemap, colour
+// grade, vignette, 3x3 kernel filters and gamma.
+//
+// Rather than one full-screen pass per effect, neighbouring effects are fused
+// into one generated shader, so a stack of N costs one read and one write of
+// the frame instead of N. Per-pixel effects always fuse. A kernel needs its
+// input's neighbours, so the per-pixel effects before it are run on each of its
+// nine taps instead (ALU is cheaper than another trip through memory), and only
+// a second kernel starts a new pass. PostProcessSettings::fuse=false gives one
+// pass per effect, for comparing.
+//
+// process() runs the same passes on the CPU over float pixels, so the fusion
+// can be measured and checked without a GPU.
+class PostProcessStack {
+public:
+    enum Type {
+        TONEMAP,
+        COLOUR_GRADE,
+        VIGNETTE,
+        KERNEL,
+        GAMMA
+    };
+
+    // Only the fields of an effect's type are used. They can be changed between
+    // frames through effect(); changing the list of effects means building a new stack.
+    struct Effect {
+        Type type;
+        float exposure {1.0f};                  // TONEMAP: 1 - exp(-colour * exposure)
+        glm::vec3 tint {1.0f};                  // COLOUR_GRADE: multiplied in first,
+        float saturation {1.0f};                // then mixed with the luminance,
+        float contrast {1.0f};                  // then scaled about 0.5
+        float strength {0.5f};                  // VIGNETTE: darkening in the corners,
+        float radius {0.5f};                    // from this far out (0 centre, 1 corner)
+        std::array<float, 9> kernel {};         // KERNEL: weights, rows top to bottom,
+        float step {1.0f};                      // taps this many texels apart
+        float gamma {2.2f};                     // GAMMA: colour^(1 / gamma)
+    };
+
+    PostProcessStack(PostProcessSettings settings={})
+    :   m_settings {settings}
+    ,   m_planned {false}
+    ,   m_built {false}
+    ,   m_emptyVao {0}
+    {
+    }
+
+    ~PostProcessStack() {
+        _delete_shaders();
+        if (m_emptyVao) glDeleteVertexArrays(1, &m_emptyVao);
+    }
+
+    PostProcessStack(const PostProcessStack&) = delete;
+    PostProcessStack& operator=(const PostProcessStack&) = delete;
+
+    void addTonemap(float exposure=1.0f) {
+        Effect effect {TONEMAP};
+        effect.exposure = exposure;
+        _add(effect);
+    }
+
+    void addColourGrade(glm::vec3 tint, float saturation=1.0f, float contrast=1.0f) {
+        Effect effect {COLOUR_GRADE};
+        effect.tint = tint;
+        effect.saturation = saturation;
+        effect.contrast = contrast;
+        _add(effect);
+    }
+
+    void addVignette(float strength=0.5f, float radius=0.5f) {
+        Effect effect {VIGNETTE};
+        effect.strength = strength;
+        effect.radius = radius;
+        _add(effect);
+    }
+
+    void addKernel(const std::array<float, 9>& kernel, float step=1.0f) {
+        Effect effect {KERNEL};
+        effect.kernel = kernel;
+        effect.step = step;
+        _add(effect);
+    }
+
+    void addGamma(float gamma=2.2f) {
+        Effect effect {GAMMA};
+        effect.gamma = gamma;
+        _add(effect);
+    }
+
+    static std::array<float, 9> edgeDetect() {
+        return {1.0f, 1.0f, 1.0f,
+                1.0f, -8.0f, 1.0f,
+                1.0f, 1.0f, 1.0f};
+    }
+
+    static std::array<float, 9> sharpen() {
+        return {-1.0f, -1.0f, -1.0f,
+                -1.0f, 9.0f, -1.0f,
+                -1.0f, -1.0f, -1.0f};
+    }
+
+    static std::array<float, 9> boxBlur() {
+        std::array<float, 9> kernel {};
+        kernel.fill(1.0f / 9.0f);
+        return kernel;
+    }
+
+    Effect& effect(size_t index) {
+        return m_effects[index];
+    }
+
+    size_t effectCount() const {
+        return m_effects.size();
+    }
+
+    // full-screen passes the effects take
+    size_t passCount() {
+        _plan();
+        return m_passes.size();
+    }
+
+    // Add a pass to `graph` per fused pass, from target `input` to `output`
+    // (a target or the backbuffer), with transient targets in between. `input`
+    // must be single sampled and is sampled with clamp to edge.
+    void addPasses(RenderGraph& graph, const std::string& input, const std::string& output) {
+        _plan();
+        if (m_passes.empty()) {
+            std::cout << "ERROR::POST_PROCESS::EMPTY_STACK" << std::endl;
+            return;
+        }
+        _build();
+        std::string source {input};
+        for (size_t i = 0; i < m_passes.size(); i++) {
+            std::string destination {output};
+            if (i + 1 < m_passes.size()) {
+                destination = output + "_post_" + std::to_string(i);
+                graph.createTarget(destination, {{m_settings.intermediateFormat}, RenderTarget::NO_DEPTH});
+            }
+            graph.addPass("post_" + std::to_string(i), [this, i, source](RenderGraph::Context& context) {
+                RenderTarget* target {context.target(source)};
+                if (!target) {
+                    std::cout << "ERROR::POST_PROCESS::INPUT_NOT_A_TARGET " << source << std::endl;
+                    return;
+                }
+                target->bindTexture(0);
+                _draw(i, target->width(), target->height());
+            }).read(source).write(destination);
+            source = destination;
+        }
+    }
+
+    // The same passes on the CPU: `source` is `width` x `height` pixels, bottom
+    // row first like a GL texture, and `destination` is resized to match.
+    // Rows are shared out over `pool` when there is one.
+    void process(const std::vector<glm::vec4>& source, std::vector<glm::vec4>& destination,
+                 unsigned int width, unsigned int height, WorkerPool* pool=nullptr) {
+        _plan();
+        destination.resize(source.size());
+        if (m_passes.empty()) {
+            destination = source;
+            return;
+        }
+        // ping-pong so each pass reads the last one's output; the final pass lands in destination
+        m_scratch.resize(source.size());
+        const std::vector<glm::vec4>* input {&source};
+        for (size_t i = 0; i < m_passes.size(); i++) {
+            bool last {i + 1 == m_passes.size()};
+            bool toScratch {((m_passes.size() - 1 - i) % 2) == 1};
+            std::vector<glm::vec4>* output {(last || !toScratch) ? &destination : &m_scratch};
+            auto rows {[&](size_t first, size_t count) {
+                for (size_t y = first; y < first + count; y++) {
+                    _process_row(m_passes[i], *input, *output, width, height, static_cast<unsigned int>(y));
+                }
+            }};
+            if (pool) pool->parallelFor(height, 16, rows);
+            else rows(0, height);
+            input = output;
+        }
+    }
+
+    // the generated fragment shader of pass `pass`, for reading
+    std::string fragmentSource(size_t pass) {
+        _plan();
+        return _fragment_source(m_passes[pass]);
+    }
+
+private:
+    struct Pass {
+        std::vector<size_t> perTap;         // before the kernel, or everything if there's none
+        size_t kernel {npos};
+        std::vector<size_t> after;
+    };
+
+    static constexpr size_t npos {static_cast<size_t>(-1)};
+
+    void _add(const Effect& effect) {
+        m_effects.push_back(effect);
+        m_planned = false;
+        m_built = false;
+    }
+
+    void _plan() {
+        if (m_planned) return;
+        m_passes.clear();
+        for (size_t i = 0; i < m_effects.size(); i++) {
+            bool kernel {m_effects[i].type == KERNEL};
+            bool newPass {m_passes.empty() || !m_settings.fuse || (kernel && m_passes.back().kernel != npos)};
+            if (newPass) m_passes.push_back({});
+            Pass& pass {m_passes.back()};
+            if (kernel) pass.kernel = i;
+            else if (pass.kernel == npos) pass.perTap.push_back(i);
+            else pass.after.push_back(i);
+        }
+        m_planned = true;
+    }
+
+    void _build() {
+        if (m_built) return;
+        _delete_shaders();
+        const std::string vertexSource {
+            "#version 330 core\n"
+            "out vec2 TexCoords;\n"
+            "void main()\n"
+            "{\n"
+            "    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+            "    TexCoords = corner;\n"
+            "    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);\n"
+            "}\n"};
+        for (const Pass& pass : m_passes) {
+            m_shaders.push_back(Shader::fromSource(vertexSource, _fragment_source(pass)));
+        }
+        if (!m_emptyVao) glGenVertexArrays(1, &m_emptyVao);
+        m_built = true;
+    }
+
+    void _delete_shaders() {
+        for (const Shader& shader : m_shaders) glDeleteProgram(shader.m_id);
+        m_shaders.clear();
+    }
+
+    std::string _fragment_source(const Pass& pass) const {
+        std::string uniforms;
+        auto declare {[&](size_t index) {
+            std::string n {std::to_string(index)};
+            switch (m_effects[index].type) {
+            case TONEMAP: uniforms += "uniform float exposure" + n + ";\n"; break;
+            case COLOUR_GRADE:
+                uniforms += "uniform vec3 tint" + n + ";\nuniform float saturation" + n
+                            + ";\nuniform float contrast" + n + ";\n";
+                break;
+            case VIGNETTE:
+                uniforms += "uniform float strength" + n + ";\nuniform float radius" + n + ";\n";
+                break;
+            case KERNEL:
+                uniforms += "uniform float kernel" + n + "[9];\nuniform vec2 kernelStep" + n + ";\n";
+                break;
+            case GAMMA: uniforms += "uniform float gamma" + n + ";\n"; break;
+            }
+        }};
+        for (size_t index : pass.perTap) declare(index);
+        if (pass.kernel != npos) declare(pass.kernel);
+        for (size_t index : pass.after) declare(index);
+
+        std::string source {"#version 330 core\nout vec4 FragColor;\nin vec2 TexCoords;\n"
+                            "uniform sampler2D screenTexture;\n"};
+        source += uniforms;
+        source += "\nvec3 tap(vec2 uv)\n{\n    vec3 colour = texture(screenTexture, uv).rgb;\n";
+        for (size_t index : pass.perTap) source += _glsl(index, "uv");
+        source += "    return colour;\n}\n\nvoid main()\n{\n";
+        if (pass.kernel != npos) {
+            std::string n {std::to_string(pass.kernel)};
+            source += "    vec3 colour = vec3(0.0);\n"
+                      "    for (int i = 0; i < 9; i++)\n"
+                      "    {\n"
+                      "        vec2 offset = vec2(i % 3 - 1, 1 - i / 3) * kernelStep" + n + ";\n"
+                      "        colour += tap(TexCoords + offset) * kernel" + n + "[i];\n"
+                      "    }\n";
+        }
+        else {
+            source += "    vec3 colour = tap(TexCoords);\n";
+        }
+        for (size_t index : pass.after) source += _glsl(index, "TexCoords");
+        source += "    FragColor = vec4(colour, 1.0);\n}\n";
+        return source;
+    }
+
+    // effect `index` on `colour`, at texture coordinate `uv`
+    std::string _glsl(size_t index, const std::string& uv) const {
+        std::string n {std::to_string(index)};
+        switch (m_effects[index].type) {
+        case TONEMAP:
+            return "    colour = vec3(1.0) - exp(-colour * exposure" + n + ");\n";
+        case COLOUR_GRADE:
+            return "    colour *= tint" + n + ";\n"
+                   "    colour = mix(vec3(dot(colour, vec3(0.2126, 0.7152, 0.0722))), colour, saturation" + n + ");\n"
+                   "    colour = (colour - 0.5) * contrast" + n + " + 0.5;\n";
+        case VIGNETTE:
+            return "    colour *= 1.0 - strength" + n + " * smoothstep(radius" + n + ", 1.0, length(" + uv
+                   + " - 0.5) * 1.41421356);\n";
+        case GAMMA:
+            return "    colour = pow(max(colour, vec3(0.0)), vec3(1.0 / gamma" + n + "));\n";
+        case KERNEL:
+            break;
+        }
+        return "";
+    }
+
+    void _set_uniforms(Shader& shader, size_t index, unsigned int width, unsigned int height) const {
+        const Effect& effect {m_effects[index]};
+        std::string n {std::to_string(index)};
+        switch (effect.type) {
+        case TONEMAP: shader.setFloat("exposure" + n, effect.exposure); break;
+        case COLOUR_GRADE:
+            shader.setVec3("tint" + n, effect.tint);
+            shader.setFloat("saturation" + n, effect.saturation);
+            shader.setFloat("contrast" + n, effect.contrast);
+            break;
+        case VIGNETTE:
+            shader.setFloat("strength" + n, effect.strength);
+            shader.setFloat("radius" + n, effect.radius);
+            break;
+        case KERNEL:
+            for (size_t k = 0; k < 9; k++) {
+                shader.setFloat("kernel" + n + "[" + std::to_string(k) + "]", effect.kernel[k]);
+            }
+            shader.setVec2("kernelStep" + n, glm::vec2(effect.step / static_cast<float>(width),
+                                                      effect.step / static_cast<float>(height)));
+            break;
+        case GAMMA: shader.setFloat("gamma" + n, effect.gamma); break;
+        }
+    }
+
+    // one full-screen triangle into whatever is bound, reading texture unit 0
+    void _draw(size_t index, unsigned int width, unsigned int height) {
+        const Pass& pass {m_passes[index]};
+        Shader& shader {m_shaders[index]};
+        shader.use();
+        shader.setInt("screenTexture", 0);
+        for (size_t effect : pass.perTap) _set_uniforms(shader, effect, width, height);
+        if (pass.kernel != npos) _set_uniforms(shader, pass.kernel, width, height);
+        for (size_t effect : pass.after) _set_uniforms(shader, effect, width, height);
+
+        GLboolean depthTest {glIsEnabled(GL_DEPTH_TEST)};
+        GLboolean blend {glIsEnabled(GL_BLEND)};
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+        glBindVertexArray(m_emptyVao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+        if (depthTest) glEnable(GL_DEPTH_TEST);
+        if (blend) glEnable(GL_BLEND);
+        stats::stateChange();
+        stats::drawCall(1);
+    }
+
+    // the CPU twin of _glsl()
+    glm::vec3 _apply(size_t index, glm::vec3 colour, glm::vec2 uv) const {
+        const Effect& effect {m_effects[index]};
+        switch (effect.type) {
+        case TONEMAP:
+            return {1.0f - std::exp(-colour.x * effect.exposure), 1.0f - std::exp(-colour.y * effect.exposure),
+                    1.0f - std::exp(-colour.z * effect.exposure)};
+        case COLOUR_GRADE: {
+            colour *= effect.tint;
+            float luminance {glm::dot(colour, glm::vec3(0.2126f, 0.7152f, 0.0722f))};
+            colour = glm::vec3(luminance) + (colour - glm::vec3(luminance)) * effect.saturation;
+            return (colour - glm::vec3(0.5f)) * effect.contrast + glm::vec3(0.5f);
+        }
+        case VIGNETTE: {
+            float distance {glm::length(uv - glm::vec2(0.5f)) * 1.41421356f};
+            float t {std::clamp((distance - effect.radius) / std::max(1.0f - effect.radius, 1e-5f), 0.0f, 1.0f)};
+            return colour * (1.0f - effect.strength * t * t * (3.0f - 2.0f * t));
+        }
+        case GAMMA:
+            return {std::pow(std::max(colour.x, 0.0f), 1.0f / effect.gamma),
+                    std::pow(std::max(colour.y, 0.0f), 1.0f / effect.gamma),
+                    std::pow(std::max(colour.z, 0.0f), 1.0f / effect.gamma)};
+        case KERNEL:
+            break;
+        }
+        return colour;
+    }
+
+    glm::vec3 _tap(const Pass& pass, const std::vector<glm::vec4>& input, unsigned int width, unsigned int height,
+                   int x, int y) const {
+        x = std::clamp(x, 0, static_cast<int>(width) - 1);
+        y = std::clamp(y, 0, static_cast<int>(height) - 1);
+        const glm::vec4& texel {input[static_cast<size_t>(y) * width + static_cast<size_t>(x)]};
+        glm::vec3 colour {texel.x, texel.y, texel.z};
+        glm::vec2 uv {(x + 0.5f) / width, (y + 0.5f) / height};
+        for (size_t index : pass.perTap) colour = _apply(index, colour, uv);
+        return colour;
+    }
+
+    void _process_row(const Pass& pass, const std::vector<glm::vec4>& input, std::vector<glm::vec4>& output,
+                      unsigned int width, unsigned int height, unsigned int y) const {
+        int step {0};
+        if (pass.kernel != npos) step = static_cast<int>(std::lround(m_effects[pass.kernel].step));
+        for (unsigned int x = 0; x < width; x++) {
+            int ix {static_cast<int>(x)};
+            int iy {static_cast<int>(y)};
+            glm::vec3 colour {0.0f};
+            if (pass.kernel != npos) {
+                const std::array<float, 9>& kernel {m_effects[pass.kernel].kernel};
+                for (int i = 0; i < 9; i++) {
+                    colour += _tap(pass, input, width, height, ix + (i % 3 - 1) * step, iy + (1 - i / 3) * step)
+                              * kernel[i];
+                }
+            }
+            else colour = _tap(pass, input, width, height, ix, iy);
+            glm::vec2 uv {(x + 0.5f) / width, (y + 0.5f) / height};
+            for (size_t index : pass.after) colour = _apply(index, colour, uv);
+            output[static_cast<size_t>(y) * width + x] = glm::vec4(colour, 1.0f);
+        }
+    }
+
+    PostProcessSettings m_settings;
+    std::vector<Effect> m_effects;
+    std::vector<Pass> m_passes;
+    bool m_planned;
+    bool m_built;
+    std::vector<Shader> m_shaders;
+    unsigned int m_emptyVao;
+    std::vector<glm::vec4> m_scratch;
+};
+
+}
+#endif
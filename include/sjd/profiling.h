@@ -0,0 +1,181 @@
+#ifndef PROFILING_H
+#define PROFILING_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+
+namespace sjd {
+
+// Counters bumped by the sjd draw code. They are reset by whoever is measuring
+// (e.g. the benchmark runner once per frame) and are cheap enough to leave on.
+namespace stats {
+    inline uint64_t drawCalls {0};
+    inline uint64_t stateChanges {0};
+    inline uint64_t triangles {0};
+
+    inline void reset() {
+        drawCalls = 0;
+        stateChanges = 0;
+        triangles = 0;
+    }
+
+    inline void drawCall(uint64_t triangleCount, uint64_t instances=1) {
+        drawCalls++;
+        triangles += triangleCount * instances;
+    }
+
+    inline void stateChange(uint64_t count=1) {
+        stateChanges += count;
+    }
+}
+
+// GPU timer built on GL_TIMESTAMP queries (core since 3.3). Results are read
+// back a few frames late from a small ring of queries so timing never stalls the
+// pipeline. Unlike GL_TIME_ELAPSED, timestamps let timers nest (e.g. a shadow pass
+// timer inside the benchmark's whole-frame timer).
+class GpuTimer {
+public:
+    GpuTimer()
+    : m_frame {0}
+    , m_lastMs {0.0}
+    {
+        glGenQueries(static_cast<GLsizei>(m_begin.size()), m_begin.data());
+        glGenQueries(static_cast<GLsizei>(m_end.size()), m_end.data());
+    }
+
+    ~GpuTimer() {
+        glDeleteQueries(static_cast<GLsizei>(m_begin.size()), m_begin.data());
+        glDeleteQueries(static_cast<GLsizei>(m_end.size()), m_end.data());
+    }
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    void begin() {
+        glQueryCounter(m_begin[m_frame % m_begin.size()], GL_TIMESTAMP);
+    }
+
+    void end() {
+        glQueryCounter(m_end[m_frame % m_end.size()], GL_TIMESTAMP);
+        m_frame++;
+        // the oldest pair in the ring is the next one to be overwritten
+        if (m_frame >= m_end.size()) {
+            size_t oldest {m_frame % m_end.size()};
+            GLint available {0};
+            glGetQueryObjectiv(m_end[oldest], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint64 start {0};
+                GLuint64 stop {0};
+                glGetQueryObjectui64v(m_begin[oldest], GL_QUERY_RESULT, &start);
+                glGetQueryObjectui64v(m_end[oldest], GL_QUERY_RESULT, &stop);
+                m_lastMs = static_cast<double>(stop - start) / 1.0e6;
+            }
+        }
+    }
+
+    // most recent resolved measurement, in milliseconds
+    double lastMs() const {
+        return m_lastMs;
+    }
+
+private:
+    std::array<unsigned int, 4> m_begin {};
+    std::array<unsigned int, 4> m_end {};
+    size_t m_frame;
+    double m_lastMs;
+};
+
+// Counts the samples that pass the depth test between begin() and end() with
+// GL_SAMPLES_PASSED occlusion queries, read back late from a ring like GpuTimer.
+// Around a colour pass that's how many fragments (samples, with MSAA) got shaded.
+class SampleCounter {
+public:
+    SampleCounter()
+    : m_frame {0}
+    , m_lastCount {0}
+    {
+        glGenQueries(static_cast<GLsizei>(m_queries.size()), m_queries.data());
+    }
+
+    ~SampleCounter() {
+        glDeleteQueries(static_cast<GLsizei>(m_queries.size()), m_queries.data());
+    }
+
+    SampleCounter(const SampleCounter&) = delete;
+    SampleCounter& operator=(const SampleCounter&) = delete;
+
+    void begin() {
+        glBeginQuery(GL_SAMPLES_PASSED, m_queries[m_frame % m_queries.size()]);
+    }
+
+    void end() {
+        glEndQuery(GL_SAMPLES_PASSED);
+        m_frame++;
+        if (m_frame >= m_queries.size()) {
+            size_t oldest {m_frame % m_queries.size()};
+            GLint available {0};
+            glGetQueryObjectiv(m_queries[oldest], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint64 count {0};
+                glGetQueryObjectui64v(m_queries[oldest], GL_QUERY_RESULT, &count);
+                m_lastCount = count;
+            }
+        }
+    }
+
+    // most recent resolved count
+    uint64_t lastCount() const {
+        return m_lastCount;
+    }
+
+private:
+    std::array<unsigned int, 4> m_queries {};
+    size_t m_frame;
+    uint64_t m_lastCount;
+};
+
+// Collects per-frame samples and summarises them.
+class FrameStats {
+public:
+    void add(double sample) {
+        m_samples.push_back(sample);
+    }
+
+    void clear() {
+        m_samples.clear();
+    }
+
+    size_t count() const {
+        return m_samples.size();
+    }
+
+    double mean() const {
+        if (m_samples.empty()) return 0.0;
+        double sum {0.0};
+        for (double sample : m_samples) sum += sample;
+        return sum / static_cast<double>(m_samples.size());
+    }
+
+    // nearest-rank percentile, p in [0, 100]
+    double percentile(double p) const {
+        if (m_samples.empty()) return 0.0;
+        std::vector<double> sorted {m_samples};
+        std::sort(sorted.begin(), sorted.end());
+        size_t rank {static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5)};
+        return sorted[std::min(rank, sorted.size() - 1)];
+    }
+
+    double max() const {
+        if (m_samples.empty()) return 0.0;
+        return *std::max_element(m_samples.begin(), m_samples.end());
+    }
+
+private:
+    std::vector<double> m_samples;
+};
+
+}
+#endif
@@ -0,0 +1,480 @@
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <sjd/profiling.h>
+#include <sjd/render_target.h>
+#include <sjd/render_target_pool.h>
+
+namespace sjd {
+
+// One frame's passes, declared up front with the resources each one reads and
+// writes, then run by execute(). Rebuilt every frame: declare the resources,
+// addPass() each pass in the order it should run, execute().
+//
+// Resources are named. They're either
+//   - the backbuffer, whatever framebuffer and viewport are current at execute(),
+//   - a RenderTarget the caller owns (importTarget()),
+//   - a transient target (createTarget()), taken from a RenderTargetPool just
+//     before its first pass and handed back after its last, or
+//   - anything else a pass names without declaring it, which the graph only
+//     tracks for dependencies (shadow maps, a G-buffer, the Hi-Z pyramid...).
+//
+// execute() drops passes whose results nobody uses: it keeps passes with a side
+// effect, the last writer of every backbuffer and imported target, and then
+// whatever those read from. A write that doesn't clear depends on the writes
+// before it. Kept passes run in the order they were added.
+//
+// The graph doesn't reorder anything: a read depends on the writes added before
+// it, so a writer added after a reader would be culled, or run too late,
+// without anyone noticing. Compiling reports it (WRITTEN_AFTER_READ), and for
+// transients a read with no write before it at all (READ_BEFORE_WRITE). To read
+// what a resource held before this frame's writes, e.g. a history, import it
+// under a name of its own.
+//
+// A pass writes at most one target. The graph binds it and its viewport before
+// the pass runs, only when they aren't bound already, and does the clears the
+// write asked for, so passes never bind or clear it themselves. Passes that only
+// write undeclared resources may bind whatever they like. Afterwards the caller's
+// framebuffer, viewport and clear colour are put back.
+class RenderGraph {
+public:
+    class Context;
+    using Execute = std::function<void(Context&)>;
+
+    class Pass {
+    public:
+        Pass& read(const std::string& resource) {
+            m_reads.push_back(m_graph->_resource(resource));
+            return *this;
+        }
+
+        // `clear` is the glClear() bits to clear the target with first (colour
+        // with `clearColour`); 0 keeps what's there
+        Pass& write(const std::string& resource, GLbitfield clear=0, glm::vec4 clearColour=glm::vec4(0.0f)) {
+            m_writes.push_back({m_graph->_resource(resource), clear, clearColour});
+            return *this;
+        }
+
+        // never culled, for passes whose results leave the graph some other way
+        Pass& sideEffect() {
+            m_sideEffect = true;
+            return *this;
+        }
+
+    private:
+        friend class RenderGraph;
+
+        struct Write {
+            size_t resource;
+            GLbitfield clear;
+            glm::vec4 clearColour;
+        };
+
+        Pass(RenderGraph* graph, const std::string& name, Execute execute)
+        :   m_graph {graph}
+        ,   m_name {name}
+        ,   m_execute {std::move(execute)}
+        ,   m_sideEffect {false}
+        ,   m_kept {false}
+        ,   m_target {npos}
+        {
+        }
+
+        RenderGraph* m_graph;
+        std::string m_name;
+        Execute m_execute;
+        std::vector<size_t> m_reads;
+        std::vector<Write> m_writes;
+        bool m_sideEffect;
+        bool m_kept;
+        size_t m_target;
+        std::vector<size_t> m_dependencies;
+    };
+
+    // what a pass gets while it runs
+    class Context {
+    public:
+        // the target behind `resource`, nullptr for the backbuffer and undeclared resources
+        RenderTarget* target(const std::string& resource) const {
+            return m_graph->_target(m_graph->_find(resource));
+        }
+
+        // bind colour attachment `attachment` of target `resource` for sampling
+        void bindTexture(const std::string& resource, unsigned int unit, unsigned int attachment=0) const {
+            RenderTarget* found {target(resource)};
+            if (!found) {
+                std::cout << "ERROR::RENDER_GRAPH::NOT_A_TARGET " << resource << std::endl;
+                return;
+            }
+            found->bindTexture(unit, attachment);
+        }
+
+        // size of the target the pass writes, or of the backbuffer
+        unsigned int width() const {
+            return m_width;
+        }
+
+        unsigned int height() const {
+            return m_height;
+        }
+
+    private:
+        friend class RenderGraph;
+
+        Context(RenderGraph* graph, unsigned int width, unsigned int height)
+        :   m_graph {graph}
+        ,   m_width {width}
+        ,   m_height {height}
+        {
+        }
+
+        RenderGraph* m_graph;
+        unsigned int m_width;
+        unsigned int m_height;
+    };
+
+    // Transient targets come out of `pool`, or out of the graph's own pool when
+    // it's nullptr. A shared pool is left for its owner to endFrame().
+    RenderGraph(RenderTargetPool* pool=nullptr)
+    :   m_pool {pool}
+    ,   m_timing {false}
+    ,   m_passesRun {0}
+    ,   m_passesCulled {0}
+    ,   m_outputWidth {0}
+    ,   m_outputHeight {0}
+    ,   m_boundFramebuffer {-1}
+    {
+        if (!m_pool) {
+            m_ownPool = std::make_unique<RenderTargetPool>();
+            m_pool = m_ownPool.get();
+        }
+    }
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    // the framebuffer and viewport current when execute() is called
+    void importBackbuffer(const std::string& name) {
+        m_resources[_resource(name)].kind = BACKBUFFER;
+    }
+
+    void importTarget(const std::string& name, RenderTarget& target) {
+        Resource& resource {m_resources[_resource(name)]};
+        resource.kind = IMPORTED;
+        resource.target = &target;
+    }
+
+    // a target that only lives between its first and last pass, `scale` times
+    // the backbuffer's size
+    void createTarget(const std::string& name, const RenderTarget::Description& description, float scale=1.0f) {
+        Resource& resource {m_resources[_resource(name)]};
+        resource.kind = TRANSIENT;
+        resource.description = description;
+        resource.scale = scale;
+    }
+
+    // The returned pass is only good for chaining read() and write() onto
+    // before the next addPass().
+    Pass& addPass(const std::string& name, Execute execute) {
+        m_passes.push_back(Pass(this, name, std::move(execute)));
+        return m_passes.back();
+    }
+
+    // run every pass still needed, then forget the passes and resources
+    void execute() {
+        GLint previousFramebuffer {0};
+        std::array<GLint, 4> viewport {};
+        std::array<GLfloat, 4> clearColour {};
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        glGetIntegerv(GL_VIEWPORT, viewport.data());
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColour.data());
+        m_backbuffer = previousFramebuffer;
+        m_backbufferViewport = viewport;
+        m_outputWidth = static_cast<unsigned int>(std::max(viewport[2], 1));
+        m_outputHeight = static_cast<unsigned int>(std::max(viewport[3], 1));
+        m_boundFramebuffer = previousFramebuffer;
+        m_boundViewport = viewport;
+
+        _compile();
+        m_passesRun = 0;
+        for (size_t i = 0; i < m_passes.size(); i++) {
+            Pass& pass {m_passes[i]};
+            if (!pass.m_kept) continue;
+            for (Resource& resource : m_resources) {
+                if (resource.kind == TRANSIENT && resource.firstUse == i) {
+                    resource.target = &m_pool->acquire(_scaled(m_outputWidth, resource.scale),
+                                                       _scaled(m_outputHeight, resource.scale),
+                                                       resource.description);
+                }
+            }
+
+            Context context {this, m_outputWidth, m_outputHeight};
+            if (pass.m_target != npos) {
+                _bind(pass.m_target, context);
+                _clear(pass);
+            }
+            if (m_timing) _timer(pass.m_name).begin();
+            pass.m_execute(context);
+            if (m_timing) _timer(pass.m_name).end();
+            // whatever an untargeted pass bound is unknown now
+            if (pass.m_target == npos) {
+                m_boundFramebuffer = -1;
+                m_boundViewport = {-1, -1, -1, -1};
+            }
+            m_passesRun++;
+
+            for (Resource& resource : m_resources) {
+                if (resource.kind == TRANSIENT && resource.lastUse == i && resource.target) {
+                    m_pool->release(*resource.target);
+                    resource.target = nullptr;
+                }
+            }
+        }
+
+        if (m_boundFramebuffer != previousFramebuffer) {
+            glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+            stats::stateChange();
+        }
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        glClearColor(clearColour[0], clearColour[1], clearColour[2], clearColour[3]);
+        if (m_ownPool) m_pool->endFrame();
+        m_passes.clear();
+        m_resources.clear();
+        m_names.clear();
+    }
+
+    // time every pass with a GpuTimer, read with passMs()
+    void setTiming(bool timing) {
+        m_timing = timing;
+    }
+
+    // GPU time of the last timed run of pass `name`, a few frames behind
+    double passMs(const std::string& name) const {
+        auto found {m_timers.find(name)};
+        return found == m_timers.end() ? 0.0 : found->second->lastMs();
+    }
+
+    // passes run and passes dropped by the last execute()
+    size_t passesRun() const {
+        return m_passesRun;
+    }
+
+    size_t passesCulled() const {
+        return m_passesCulled;
+    }
+
+    RenderTargetPool& pool() {
+        return *m_pool;
+    }
+
+private:
+    static constexpr size_t npos {static_cast<size_t>(-1)};
+
+    enum Kind {
+        UNDECLARED,
+        BACKBUFFER,
+        IMPORTED,
+        TRANSIENT
+    };
+
+    struct Resource {
+        std::string name;
+        Kind kind {UNDECLARED};
+        RenderTarget::Description description {};
+        float scale {1.0f};
+        RenderTarget* target {nullptr};
+        size_t lastWriter {npos};
+        size_t firstReader {npos};      // a pass that read it before anything wrote it
+        size_t firstUse {npos};
+        size_t lastUse {npos};
+    };
+
+    size_t _find(const std::string& name) const {
+        auto found {m_names.find(name)};
+        return found == m_names.end() ? npos : found->second;
+    }
+
+    size_t _resource(const std::string& name) {
+        size_t index {_find(name)};
+        if (index != npos) return index;
+        m_names[name] = m_resources.size();
+        m_resources.push_back({});
+        m_resources.back().name = name;
+        return m_resources.size() - 1;
+    }
+
+    RenderTarget* _target(size_t index) const {
+        if (index == npos) return nullptr;
+        return m_resources[index].target;
+    }
+
+    bool _isTarget(size_t index) const {
+        return m_resources[index].kind != UNDECLARED;
+    }
+
+    // Work out dependencies, cull, and find each transient's lifetime. Passes
+    // are taken to be in a valid order, so dependencies only ever point back;
+    // a write after a read of what it writes says they weren't.
+    void _compile() {
+        for (size_t i = 0; i < m_passes.size(); i++) {
+            Pass& pass {m_passes[i]};
+            for (size_t read : pass.m_reads) {
+                Resource& resource {m_resources[read]};
+                if (resource.lastWriter != npos) pass.m_dependencies.push_back(resource.lastWriter);
+                else {
+                    if (resource.firstReader == npos) resource.firstReader = i;
+                    if (resource.kind == TRANSIENT) {
+                        std::cout << "ERROR::RENDER_GRAPH::READ_BEFORE_WRITE " << resource.name
+                                  << " in " << pass.m_name << std::endl;
+                    }
+                }
+            }
+            for (const Pass::Write& write : pass.m_writes) {
+                Resource& resource {m_resources[write.resource]};
+                // a pass reading what it then writes over is fine; transients already said so
+                if (resource.lastWriter == npos && resource.firstReader != npos && resource.firstReader != i
+                    && resource.kind != TRANSIENT) {
+                    std::cout << "ERROR::RENDER_GRAPH::WRITTEN_AFTER_READ " << resource.name << " by "
+                              << pass.m_name << ", read before by " << m_passes[resource.firstReader].m_name
+                              << std::endl;
+                }
+                if (resource.lastWriter != npos && !_overwrites(write)) {
+                    pass.m_dependencies.push_back(resource.lastWriter);
+                }
+                if (_isTarget(write.resource)) {
+                    if (pass.m_target == npos) pass.m_target = write.resource;
+                    else if (pass.m_target != write.resource) {
+                        std::cout << "ERROR::RENDER_GRAPH::MULTIPLE_TARGETS " << pass.m_name << std::endl;
+                    }
+                }
+            }
+            // a second write to the same resource in one pass mustn't depend on itself
+            for (const Pass::Write& write : pass.m_writes) m_resources[write.resource].lastWriter = i;
+        }
+
+        std::vector<size_t> stack;
+        for (size_t i = 0; i < m_passes.size(); i++) {
+            if (m_passes[i].m_sideEffect) stack.push_back(i);
+        }
+        for (const Resource& resource : m_resources) {
+            if ((resource.kind == BACKBUFFER || resource.kind == IMPORTED) && resource.lastWriter != npos) {
+                stack.push_back(resource.lastWriter);
+            }
+        }
+        while (!stack.empty()) {
+            Pass& pass {m_passes[stack.back()]};
+            stack.pop_back();
+            if (pass.m_kept) continue;
+            pass.m_kept = true;
+            stack.insert(stack.end(), pass.m_dependencies.begin(), pass.m_dependencies.end());
+        }
+
+        m_passesCulled = 0;
+        for (size_t i = 0; i < m_passes.size(); i++) {
+            Pass& pass {m_passes[i]};
+            if (!pass.m_kept) {
+                m_passesCulled++;
+                continue;
+            }
+            auto use {[&](size_t index) {
+                Resource& resource {m_resources[index]};
+                if (resource.firstUse == npos) resource.firstUse = i;
+                resource.lastUse = i;
+            }};
+            for (size_t read : pass.m_reads) use(read);
+            for (const Pass::Write& write : pass.m_writes) use(write.resource);
+        }
+    }
+
+    // whether a write clears everything the previous contents could show through
+    bool _overwrites(const Pass::Write& write) const {
+        const Resource& resource {m_resources[write.resource]};
+        GLbitfield needed {0};
+        if (resource.kind == BACKBUFFER) needed = GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT;
+        else if (resource.kind == IMPORTED || resource.kind == TRANSIENT) {
+            const RenderTarget::Description& description {resource.kind == IMPORTED
+                                                          ? resource.target->description()
+                                                          : resource.description};
+            if (!description.colour.empty()) needed |= GL_COLOR_BUFFER_BIT;
+            if (description.depth != RenderTarget::NO_DEPTH) needed |= GL_DEPTH_BUFFER_BIT;
+            if (description.depth == RenderTarget::DEPTH24_STENCIL8) needed |= GL_STENCIL_BUFFER_BIT;
+        }
+        else return false;
+        return (write.clear & needed) == needed;
+    }
+
+    // bind target `index` and its viewport unless they already are
+    void _bind(size_t index, Context& context) {
+        const Resource& resource {m_resources[index]};
+        GLint framebuffer {m_backbuffer};
+        std::array<GLint, 4> viewport {m_backbufferViewport};
+        if (resource.kind != BACKBUFFER) {
+            framebuffer = static_cast<GLint>(resource.target->fbo());
+            viewport = {0, 0, static_cast<GLint>(resource.target->width()),
+                        static_cast<GLint>(resource.target->height())};
+        }
+        if (framebuffer != m_boundFramebuffer) {
+            glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(framebuffer));
+            stats::stateChange();
+            m_boundFramebuffer = framebuffer;
+        }
+        if (viewport != m_boundViewport) {
+            glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+            m_boundViewport = viewport;
+        }
+        context.m_width = static_cast<unsigned int>(viewport[2]);
+        context.m_height = static_cast<unsigned int>(viewport[3]);
+    }
+
+    void _clear(const Pass& pass) {
+        for (const Pass::Write& write : pass.m_writes) {
+            if (write.resource != pass.m_target || write.clear == 0) continue;
+            if (write.clear & GL_COLOR_BUFFER_BIT) {
+                glClearColor(write.clearColour.x, write.clearColour.y, write.clearColour.z, write.clearColour.w);
+            }
+            glClear(write.clear);
+        }
+    }
+
+    static unsigned int _scaled(unsigned int size, float scale) {
+        return std::max(1u, static_cast<unsigned int>(static_cast<float>(size) * scale + 0.5f));
+    }
+
+    GpuTimer& _timer(const std::string& name) {
+        std::unique_ptr<GpuTimer>& timer {m_timers[name]};
+        if (!timer) timer = std::make_unique<GpuTimer>();
+        return *timer;
+    }
+
+    RenderTargetPool* m_pool;
+    std::unique_ptr<RenderTargetPool> m_ownPool;
+    std::deque<Pass> m_passes;
+    std::vector<Resource> m_resources;
+    std::map<std::string, size_t> m_names;
+    std::map<std::string, std::unique_ptr<GpuTimer>> m_timers;
+    bool m_timing;
+    size_t m_passesRun;
+    size_t m_passesCulled;
+    unsigned int m_outputWidth;
+    unsigned int m_outputHeight;
+    GLint m_backbuffer {0};
+    std::array<GLint, 4> m_backbufferViewport {};
+    GLint m_boundFramebuffer;
+    std::array<GLint, 4> m_boundViewport {};
+};
+
+}
+#endif
@@ -0,0 +1,340 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+#include <glad/glad.h>
+#include <sjd/profiling.h>
+
+namespace sjd {
+
+// An offscreen framebuffer: any number of colour attachments, an optional depth
+// (or depth and stencil) attachment, optionally multisampled.
+//
+// Formats are spelled out rather than left to the driver, since every byte per
+// texel is paid for on every write, blend and read of the target:
+//   RGBA8        4 bytes, plain LDR colour
+//   SRGB8_ALPHA8 4 bytes, LDR colour stored gamma encoded, for linear blending
+//   R11G11B10F   4 bytes, HDR colour without alpha; prefer it to RGBA16F
+//   RGBA16F      8 bytes, HDR colour that needs alpha or more precision
+//   RG16F        4 bytes, two signed values such as motion vectors
+//   DEPTH16      2 bytes, enough for short depth ranges and small shadow maps
+//   DEPTH24      4 bytes (padded), the usual choice
+//   DEPTH32F     4 bytes, for reversed Z or very long depth ranges
+//   DEPTH24_STENCIL8 4 bytes, only when the stencil is used
+//
+// Depth is a renderbuffer unless it's going to be sampled afterwards (shadow
+// maps), since renderbuffers leave the driver free to keep it compressed or on
+// chip. Multisampled targets are all renderbuffers; blit() them to a
+// single sampled target or the window to resolve them.
+class RenderTarget {
+public:
+    enum ColourFormat {
+        RGBA8,
+        SRGB8_ALPHA8,
+        R11G11B10F,
+        RGBA16F,
+        RG16F
+    };
+
+    enum DepthFormat {
+        NO_DEPTH,
+        DEPTH16,
+        DEPTH24,
+        DEPTH32F,
+        DEPTH24_STENCIL8
+    };
+
+    struct Description {
+        std::vector<ColourFormat> colour {RGBA8};
+        DepthFormat depth {DEPTH24};
+        // sample the depth afterwards; single sampled targets only
+        bool depthTexture {false};
+        unsigned int samples {1};
+
+        bool operator==(const Description& other) const {
+            return colour == other.colour && depth == other.depth
+                && depthTexture == other.depthTexture && samples == other.samples;
+        }
+    };
+
+    RenderTarget(unsigned int width, unsigned int height)
+    :   RenderTarget(width, height, Description {})
+    {
+    }
+
+    RenderTarget(unsigned int width, unsigned int height, const Description& description)
+    :   m_description {description}
+    ,   m_width {0}
+    ,   m_height {0}
+    ,   m_depth {0}
+    ,   m_previousFramebuffer {0}
+    ,   m_previousViewport {0, 0, 0, 0}
+    {
+        if (m_description.samples == 0) m_description.samples = 1;
+        if (m_description.depthTexture && (m_description.samples > 1 || m_description.depth == NO_DEPTH)) {
+            std::cout << "ERROR::RENDER_TARGET::NO_DEPTH_TEXTURE" << std::endl;
+            m_description.depthTexture = false;
+        }
+        GLsizei colourCount {static_cast<GLsizei>(m_description.colour.size())};
+        m_colour.resize(m_description.colour.size());
+        if (colourCount > 0) {
+            if (multisampled()) glGenRenderbuffers(colourCount, m_colour.data());
+            else                glGenTextures(colourCount, m_colour.data());
+        }
+        if (m_description.depth != NO_DEPTH) {
+            if (m_description.depthTexture) glGenTextures(1, &m_depth);
+            else                            glGenRenderbuffers(1, &m_depth);
+        }
+        allocate(width, height);
+
+        glGenFramebuffers(1, &m_fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+        std::vector<GLenum> drawBuffers;
+        for (GLsizei i = 0; i < colourCount; i++) {
+            GLenum attachment {static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + i)};
+            if (multisampled()) glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, m_colour[i]);
+            else                glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, m_colour[i], 0);
+            drawBuffers.push_back(attachment);
+        }
+        if (m_description.depth != NO_DEPTH) {
+            GLenum attachment {GL_DEPTH_ATTACHMENT};
+            if (m_description.depth == DEPTH24_STENCIL8) attachment = GL_DEPTH_STENCIL_ATTACHMENT;
+            if (m_description.depthTexture) glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, m_depth, 0);
+            else                            glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, m_depth);
+        }
+        if (drawBuffers.empty()) {
+            glDrawBuffer(GL_NONE);
+            glReadBuffer(GL_NONE);
+        }
+        else {
+            glDrawBuffers(colourCount, drawBuffers.data());
+        }
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "ERROR::RENDER_TARGET::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    ~RenderTarget() {
+        glDeleteFramebuffers(1, &m_fbo);
+        if (!m_colour.empty()) {
+            if (multisampled()) glDeleteRenderbuffers(static_cast<GLsizei>(m_colour.size()), m_colour.data());
+            else                glDeleteTextures(static_cast<GLsizei>(m_colour.size()), m_colour.data());
+        }
+        if (m_depth) {
+            if (m_description.depthTexture) glDeleteTextures(1, &m_depth);
+            else                            glDeleteRenderbuffers(1, &m_depth);
+        }
+    }
+
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+
+    // Reallocate every attachment at the new size; the contents are lost.
+    // Does nothing if the size hasn't changed, so it's fine to call every frame.
+    void resize(unsigned int width, unsigned int height) {
+        if (width == m_width && height == m_height) return;
+        allocate(width, height);
+    }
+
+    // Draw into the target from here on, over all of it. release() puts back
+    // the framebuffer and viewport that were current here.
+    void bind() {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_previousFramebuffer);
+        glGetIntegerv(GL_VIEWPORT, m_previousViewport);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+        glViewport(0, 0, static_cast<GLsizei>(m_width), static_cast<GLsizei>(m_height));
+        stats::stateChange();
+    }
+
+    void release() {
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(m_previousFramebuffer));
+        glViewport(m_previousViewport[0], m_previousViewport[1], m_previousViewport[2], m_previousViewport[3]);
+        stats::stateChange();
+    }
+
+    // Copy into another target, resolving multisampling on the way. Multisampled
+    // sources need a destination of the same size. `mask` may include depth and
+    // stencil when both targets have them in the same format.
+    void blit(RenderTarget& destination, GLbitfield mask=GL_COLOR_BUFFER_BIT, unsigned int attachment=0) const {
+        blit(destination.m_fbo, destination.m_width, destination.m_height, mask, attachment);
+    }
+
+    // the same into framebuffer `framebuffer` (0 for the window) of the given size
+    void blit(unsigned int framebuffer, unsigned int width, unsigned int height,
+              GLbitfield mask=GL_COLOR_BUFFER_BIT, unsigned int attachment=0) const {
+        GLint previousRead {0};
+        GLint previousDraw {0};
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousDraw);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+        if (mask & GL_COLOR_BUFFER_BIT) glReadBuffer(GL_COLOR_ATTACHMENT0 + attachment);
+        // only colour can be filtered
+        GLenum filter {GL_NEAREST};
+        if ((width != m_width || height != m_height) && mask == GL_COLOR_BUFFER_BIT) filter = GL_LINEAR;
+        glBlitFramebuffer(0, 0, static_cast<GLint>(m_width), static_cast<GLint>(m_height),
+                          0, 0, static_cast<GLint>(width), static_cast<GLint>(height), mask, filter);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previousRead));
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(previousDraw));
+        stats::stateChange(2);
+    }
+
+    // bind colour attachment `attachment` for sampling; single sampled targets only
+    void bindTexture(unsigned int unit, unsigned int attachment=0) const {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, colourTexture(attachment));
+        glActiveTexture(GL_TEXTURE0);
+        stats::stateChange();
+    }
+
+    // texture names, 0 where the attachment is a renderbuffer
+    unsigned int colourTexture(unsigned int attachment=0) const {
+        if (multisampled() || attachment >= m_colour.size()) return 0;
+        return m_colour[attachment];
+    }
+
+    // Clamped to a border of 1 and nearest filtered, as shadow maps want.
+    unsigned int depthTexture() const {
+        return m_description.depthTexture ? m_depth : 0;
+    }
+
+    unsigned int fbo() const {
+        return m_fbo;
+    }
+
+    unsigned int width() const {
+        return m_width;
+    }
+
+    unsigned int height() const {
+        return m_height;
+    }
+
+    unsigned int samples() const {
+        return m_description.samples;
+    }
+
+    const Description& description() const {
+        return m_description;
+    }
+
+    // roughly what the attachments take up in video memory
+    size_t bytes() const {
+        return bytes(m_description, m_width, m_height);
+    }
+
+    static size_t bytes(const Description& description, unsigned int width, unsigned int height) {
+        size_t perTexel {bytesPerTexel(description.depth)};
+        for (ColourFormat format : description.colour) perTexel += bytesPerTexel(format);
+        return perTexel * width * height * std::max(description.samples, 1u);
+    }
+
+    static size_t bytesPerTexel(ColourFormat format) {
+        return (format == RGBA16F) ? 8 : 4;
+    }
+
+    static size_t bytesPerTexel(DepthFormat format) {
+        switch (format) {
+            case NO_DEPTH: return 0;
+            case DEPTH16:  return 2;
+            default:       return 4;
+        }
+    }
+
+    // the sized internal format, e.g. for glBindImageTexture
+    static GLenum internalFormat(ColourFormat format) {
+        return glFormat(format).internalFormat;
+    }
+
+private:
+    bool multisampled() const {
+        return m_description.samples > 1;
+    }
+
+    // internal format, then the format and type glTexImage2D wants with it
+    struct GlFormat {
+        GLenum internalFormat;
+        GLenum format;
+        GLenum type;
+    };
+
+    static GlFormat glFormat(ColourFormat format) {
+        switch (format) {
+            case SRGB8_ALPHA8: return {GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE};
+            case R11G11B10F:   return {GL_R11F_G11F_B10F, GL_RGB, GL_UNSIGNED_INT_10F_11F_11F_REV};
+            case RGBA16F:      return {GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT};
+            case RG16F:        return {GL_RG16F, GL_RG, GL_HALF_FLOAT};
+            default:           return {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE};
+        }
+    }
+
+    static GlFormat glFormat(DepthFormat format) {
+        switch (format) {
+            case DEPTH16:          return {GL_DEPTH_COMPONENT16, GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT};
+            case DEPTH32F:         return {GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT};
+            case DEPTH24_STENCIL8: return {GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8};
+            default:               return {GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT};
+        }
+    }
+
+    // (re)specify every attachment's storage; the names, and so the framebuffer, stay the same
+    void allocate(unsigned int width, unsigned int height) {
+        m_width = std::max(width, 1u);
+        m_height = std::max(height, 1u);
+        GLsizei w {static_cast<GLsizei>(m_width)};
+        GLsizei h {static_cast<GLsizei>(m_height)};
+        GLsizei samples {static_cast<GLsizei>(m_description.samples)};
+        for (size_t i = 0; i < m_colour.size(); i++) {
+            GlFormat format {glFormat(m_description.colour[i])};
+            if (multisampled()) {
+                glBindRenderbuffer(GL_RENDERBUFFER, m_colour[i]);
+                glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, format.internalFormat, w, h);
+                continue;
+            }
+            glBindTexture(GL_TEXTURE_2D, m_colour[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format.internalFormat), w, h, 0,
+                         format.format, format.type, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+        if (m_description.depth != NO_DEPTH) {
+            GlFormat format {glFormat(m_description.depth)};
+            if (m_description.depthTexture) {
+                glBindTexture(GL_TEXTURE_2D, m_depth);
+                glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format.internalFormat), w, h, 0,
+                             format.format, format.type, NULL);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+                const float border[] {1.0f, 1.0f, 1.0f, 1.0f};
+                glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+            }
+            else {
+                glBindRenderbuffer(GL_RENDERBUFFER, m_depth);
+                if (multisampled()) glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, format.internalFormat, w, h);
+                else                glRenderbufferStorage(GL_RENDERBUFFER, format.internalFormat, w, h);
+            }
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    }
+
+    Description m_description;
+    unsigned int m_width;
+    unsigned int m_height;
+    unsigned int m_fbo;
+    std::vector<unsigned int> m_colour;
+    unsigned int m_depth;
+    GLint m_previousFramebuffer;
+    GLint m_previousViewport[4];
+};
+
+}
+#endif
@@ -0,0 +1,129 @@
+#ifndef RENDER_TARGET_POOL_H
+#define RENDER_TARGET_POOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <sjd/render_target.h>
+
+namespace sjd {
+
+// Render targets that only live for part of a frame (post-processing steps,
+// blur ping-pongs, per-frame shadow maps), shared out of one pool instead of
+// each pass keeping its own for good.
+//
+// acquire() hands out a free target with the same size and description, or
+// makes one; release() gives it back as soon as the last pass reading it has
+// run, so a later pass in the same frame can reuse the same memory for
+// something else of that shape. endFrame() takes back anything still out and
+// deletes targets nobody asked for in the last few frames, so a window resize
+// doesn't leave the old sizes behind.
+//
+// GL can't alias one allocation as different formats, so reuse is per
+// (size, formats, samples); describing passes alike gets the most out of it.
+class RenderTargetPool {
+public:
+    // targets left unused this many frames are deleted
+    RenderTargetPool(unsigned int framesToKeep=2)
+    :   m_framesToKeep {framesToKeep}
+    ,   m_frame {0}
+    ,   m_bytesInUse {0}
+    ,   m_peakBytes {0}
+    ,   m_lastPeakBytes {0}
+    ,   m_created {0}
+    {
+    }
+
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+    RenderTarget& acquire(unsigned int width, unsigned int height, const RenderTarget::Description& description) {
+        width = std::max(width, 1u);
+        height = std::max(height, 1u);
+        Entry* entry {nullptr};
+        for (Entry& candidate : m_entries) {
+            if (candidate.inUse || candidate.target->width() != width || candidate.target->height() != height) continue;
+            if (!(candidate.target->description() == description)) continue;
+            entry = &candidate;
+            break;
+        }
+        if (!entry) {
+            m_entries.push_back({std::make_unique<RenderTarget>(width, height, description), false, m_frame});
+            entry = &m_entries.back();
+            m_created++;
+        }
+        entry->inUse = true;
+        entry->lastUsed = m_frame;
+        m_bytesInUse += entry->target->bytes();
+        m_peakBytes = std::max(m_peakBytes, m_bytesInUse);
+        return *entry->target;
+    }
+
+    // Hand `target` back for the rest of the frame; it must not be read again
+    // until it's acquired again.
+    void release(RenderTarget& target) {
+        for (Entry& entry : m_entries) {
+            if (entry.target.get() != &target) continue;
+            if (!entry.inUse) break;
+            entry.inUse = false;
+            m_bytesInUse -= target.bytes();
+            return;
+        }
+        std::cout << "ERROR::RENDER_TARGET_POOL::NOT_ACQUIRED" << std::endl;
+    }
+
+    // take back everything still out and drop targets that have gone unused
+    void endFrame() {
+        for (Entry& entry : m_entries) entry.inUse = false;
+        m_bytesInUse = 0;
+        m_lastPeakBytes = m_peakBytes;
+        m_peakBytes = 0;
+        m_frame++;
+        m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [this](const Entry& entry) {
+                            return m_frame - entry.lastUsed > m_framesToKeep;
+                        }),
+                        m_entries.end());
+    }
+
+    // most bytes of targets out at once during the last finished frame
+    size_t peakBytes() const {
+        return m_lastPeakBytes;
+    }
+
+    // everything the pool holds, in use or not
+    size_t allocatedBytes() const {
+        size_t total {0};
+        for (const Entry& entry : m_entries) total += entry.target->bytes();
+        return total;
+    }
+
+    size_t targetCount() const {
+        return m_entries.size();
+    }
+
+    // targets made since the pool was, to spot descriptions that never get reused
+    uint64_t targetsCreated() const {
+        return m_created;
+    }
+
+private:
+    struct Entry {
+        std::unique_ptr<RenderTarget> target;
+        bool inUse;
+        uint64_t lastUsed;
+    };
+
+    unsigned int m_framesToKeep;
+    uint64_t m_frame;
+    std::vector<Entry> m_entries;
+    size_t m_bytesInUse;
+    size_t m_peakBytes;
+    size_t m_lastPeakBytes;
+    uint64_t m_created;
+};
+
+}
+#endif
@@ -1,14 +1,27 @@
 #ifndef SCENE_H
 #define SCENE_H
 
-#include "sjd/framebuffer.h"
 #include "sjd/skybox.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <memory>
+#include <utility>
 #include <sjd/meshes/mesh.h>
 #include <glm/glm.hpp>
 #include <vector>
 #include <sjd/light.h>
+#include <sjd/light_buffer.h>
+#include <sjd/deferred_shading.h>
+#include <sjd/hiz_culler.h>
+#include <sjd/occlusion_raster.h>
+#include <sjd/bounds.h>
+#include <sjd/render_graph.h>
+#include <sjd/shadow_atlas.h>
 #include <sjd/shader.h>
+#include <sjd/temporal_aa.h>
+#include <sjd/profiling.h>
 
 namespace sjd {
 
@@ -18,7 +31,18 @@ public:
     Scene(std::vector<std::reference_wrapper<sjd::Mesh>> meshes)
     : m_meshes {meshes}
     , m_dirLight {nullptr}
-    , m_shadowMap {nullptr}
+    , m_skybox {nullptr}
+    , m_staticCastersVersion {0}
+    , m_shadowAtlas {nullptr}
+    , m_pointShadowShader {nullptr}
+    , m_pointShadowFaces {0}
+    , m_deferred {nullptr}
+    , m_bufferedPointLights {false}
+    , m_lightCubes {true}
+    , m_depthPrepassShader {nullptr}
+    , m_occlusionCuller {nullptr}
+    , m_softwareOcclusion {nullptr}
+    , m_temporalAA {nullptr}
     {
     }
 
@@ -28,63 +52,468 @@ public:
 
     void setDirLight(sjd::DirLight* dirLight) {
         m_dirLight = dirLight;
-        if (m_dirLight->isShadowMapEnabled()) {
-            setShadowMap(m_dirLight->m_shadowMap);
-        }
     }
 
     void setPointLights(std::vector<std::reference_wrapper<sjd::PointLight>> lights) {
         m_pointLights = lights;
     }
 
-    void setShadowMap(sjd::FBTexture* shadowMap) {
-        m_shadowMap = shadowMap;
-        for (std::reference_wrapper<sjd::Mesh> meshref : m_meshes) {
-            meshref.get().setShadowMap(shadowMap);
-        }
-    }
-
     void setSkyBox(sjd::Skybox* skybox) {
         m_skybox = skybox;
     }
 
+    // point lights with enableShadows() get omnidirectional shadows in `atlas`,
+    // rendered with `depthShader` (the same simple depth shader DirLight uses)
+    void setPointShadows(sjd::ShadowAtlas* atlas, sjd::Shader* depthShader) {
+        m_shadowAtlas = atlas;
+        m_pointShadowShader = depthShader;
+    }
+
+    // Light the meshes with `deferred` instead of the shader draw() is given, or
+    // nullptr to go back to forward shading. Shadows are forward only for now.
+    void setDeferred(sjd::DeferredShading* deferred) {
+        m_deferred = deferred;
+    }
+
+    // hand forward shaders the point lights in a PointLightBuffer instead of the
+    // pointLights[] array, for shaders like blinn_phong_buffered.frag.glsl that
+    // take any number of them (but no point shadows)
+    void setBufferedPointLights(bool buffered) {
+        m_bufferedPointLights = buffered;
+    }
+
+    // the little cube drawn at every point light
+    void setLightCubes(bool drawLightCubes) {
+        m_lightCubes = drawLightCubes;
+    }
+
+    // Lay down depth for the meshes with `prepassShader` first (depth_prepass.vert.glsl
+    // with simple_depth_shader.frag.glsl), then shade with GL_EQUAL and depth
+    // writes off, so each pixel runs the forward shader once however much
+    // overdraw there is. nullptr turns it off. Vertex shaders used with it need
+    // `invariant gl_Position` and the same position maths as depth_prepass.vert.glsl.
+    void setDepthPrepass(sjd::Shader* prepassShader) {
+        m_depthPrepassShader = prepassShader;
+    }
+
+    // skip meshes the culler found hidden behind others last time, and hand it
+    // this frame's depth afterwards; nullptr draws everything
+    void setOcclusionCuller(sjd::HiZCuller* culler) {
+        m_occlusionCuller = culler;
+    }
+
+    // Rasterize the occluders added with addOccluder() on the CPU before each
+    // draw and skip meshes found behind them, in the same frame; nullptr draws
+    // everything. Can be used together with setOcclusionCuller().
+    void setSoftwareOcclusion(sjd::SoftwareOcclusion* occlusion) {
+        m_softwareOcclusion = occlusion;
+    }
+
+    // Draw the motion of meshes that moved since the last frame into `taa`'s
+    // target after the colour pass, for drawing between its begin() and end();
+    // nullptr turns it off. Everything else moves with the camera, which TAA
+    // works out for itself.
+    void setTemporalAA(sjd::TemporalAA* taa) {
+        m_temporalAA = taa;
+    }
+
+    // Draw `mesh`'s bounds as an occluder, shrunk by `scale` for meshes that
+    // don't fill their box. Only box shaped meshes should go in at full size.
+    void addOccluder(sjd::Mesh& mesh, float scale=1.0f) {
+        m_occluders.push_back({&mesh, scale});
+    }
+
+    // Draw into whatever framebuffer and viewport are current, as a RenderGraph
+    // of the passes this scene's settings call for.
     void draw(sjd::Shader shader) {
+        _sort_front_to_back();
+        m_graph.importBackbuffer("scene");
+        if (m_deferred) _add_deferred_passes();
+        else _add_forward_passes(shader);
+
+        if (m_temporalAA) {
+            m_graph.addPass("motion_vectors", [this](sjd::RenderGraph::Context&) {
+                _draw_motion_vectors();
+            }).write("scene");
+        }
+
+        if (m_occlusionCuller) {
+            m_graph.addPass("occlusion_update", [this](sjd::RenderGraph::Context&) {
+                m_occlusionCuller->update(m_projection * m_view, m_meshBounds);
+            }).read("scene").sideEffect();
+        }
+
+        if (m_lightCubes && !m_pointLights.empty()) {
+            m_graph.addPass("light_cubes", [this](sjd::RenderGraph::Context&) {
+                for (std::reference_wrapper<sjd::PointLight> pointLight : m_pointLights) {
+                    pointLight.get().drawLightCube(m_projection, m_view);
+                }
+            }).write("scene");
+        }
+
+        if (m_skybox) {
+            m_graph.addPass("skybox", [this](sjd::RenderGraph::Context&) {
+                m_skybox->draw(m_projection, m_view);
+            }).write("scene");
+        }
+        m_graph.execute();
+        for (std::reference_wrapper<sjd::Mesh> mesh : m_meshes) mesh.get().endFrame();
+    }
+
+    // The graph draw() builds its passes on. Add passes that write "scene" to
+    // draw on top of it, or turn on its per-pass timing.
+    sjd::RenderGraph& renderGraph() {
+        return m_graph;
+    }
+
+    // GPU time of the last measured shadow pass, a few frames behind
+    double shadowPassMs() const {
+        return m_shadowTimer.lastMs();
+    }
+
+    double pointShadowPassMs() const {
+        return m_pointShadowTimer.lastMs();
+    }
+
+    // cube faces re-rendered into the shadow atlas last frame
+    unsigned int pointShadowFacesRendered() const {
+        return m_pointShadowFaces;
+    }
+
+    // GPU times of the forward colour pass over the meshes and of the depth
+    // pre-pass before it, a few frames behind
+    double colourPassMs() const {
+        return m_colourTimer.lastMs();
+    }
+
+    double depthPrepassMs() const {
+        return m_depthPrepassTimer.lastMs();
+    }
+
+    // samples that passed the depth test in the forward colour pass, i.e. were shaded
+    uint64_t samplesShaded() const {
+        return m_samplesShaded.lastCount();
+    }
+
+    // meshes drawn last frame after occlusion culling
+    size_t meshesDrawn() const {
+        return m_drawOrder.size();
+    }
+private:
+    // shadow maps, then the optional depth pre-pass, then the lit meshes
+    void _add_forward_passes(sjd::Shader shader) {
+        bool cascades {m_dirLight && m_dirLight->isShadowMapEnabled()};
+        if (cascades) {
+            m_graph.addPass("shadow_cascades", [this](sjd::RenderGraph::Context&) {
+                m_shadowTimer.begin();
+                _draw_shadow_casters();
+                m_shadowTimer.end();
+            }).write("shadow_cascades");
+        }
+
+        m_shadowSlots.assign(m_pointLights.size(), -1);
+        bool pointShadows {m_shadowAtlas && m_pointShadowShader};
+        if (pointShadows) {
+            m_graph.addPass("point_shadows", [this](sjd::RenderGraph::Context& context) {
+                m_pointShadowTimer.begin();
+                _draw_point_shadows(context.height());
+                m_pointShadowTimer.end();
+            }).write("point_shadow_atlas");
+        }
+
+        if (m_depthPrepassShader) {
+            m_graph.addPass("depth_prepass", [this](sjd::RenderGraph::Context&) {
+                _draw_depth_prepass();
+            }).write("scene");
+        }
+
+        sjd::RenderGraph::Pass& colour {m_graph.addPass("forward_colour",
+                                                        [this, shader, pointShadows](sjd::RenderGraph::Context&) {
+            _draw_forward(shader, pointShadows);
+        })};
+        if (cascades) colour.read("shadow_cascades");
+        if (pointShadows) colour.read("point_shadow_atlas");
+        colour.write("scene");
+    }
+
+    void _draw_forward(sjd::Shader shader, bool pointShadows) {
         shader.use();
         shader.setVec3("viewPos", m_viewPos);
         if (m_dirLight) {
             if (m_dirLight->isShadowMapEnabled()) {
-                glm::mat4 lightSpaceMatrix = m_dirLight->generateLightSpaceMat();
-                m_dirLight->bindDepthMap();
-                _draw_objects(*m_dirLight->m_shadowMapShader);
-                m_dirLight->unbindDepthMap();
-                shader.use();
-                shader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
+                m_dirLight->m_shadowMap->bindTexture(shader);
             }
             else {
                 shader.use();
-                shader.setMat4("lightSpaceMatrix", glm::mat4(1.0f));
+                // the sampler still needs its own unit so it can't clash with a sampler2D
+                shader.setInt("shadowMap", sjd::ShadowCascades::textureUnit);
+                shader.setInt("cascadeCount", 0);
             }
             m_dirLight->computeLight(shader);
         }
 
-        shader.setInt("numPointLights", static_cast<int>(m_pointLights.size()));
-        int i {0};
-        for (std::reference_wrapper<sjd::PointLight> pointLight : m_pointLights) {
-            pointLight.get().computeLight(shader, i++);
-            pointLight.get().drawLightCube(m_projection, m_view);
+        if (pointShadows) {
+            m_shadowAtlas->bindTexture(shader, m_pointShadowPlanes);
+        }
+        else {
+            shader.use();
+            shader.setInt("pointShadowAtlas", sjd::ShadowAtlas::textureUnit);
+        }
+
+        if (m_bufferedPointLights) {
+            _point_light_buffer().update(m_pointLights);
+            _point_light_buffer().bind(shader);
+        }
+        else {
+            shader.setInt("numPointLights", static_cast<int>(m_pointLights.size()));
+            int i {0};
+            for (std::reference_wrapper<sjd::PointLight> pointLight : m_pointLights) {
+                shader.setInt(("pointLights[" + std::to_string(i) + "].shadow").c_str(), m_shadowSlots[i]);
+                pointLight.get().computeLight(shader, i++);
+            }
         }
 
+        m_colourTimer.begin();
+        m_samplesShaded.begin();
         _draw_objects(shader);
+        m_samplesShaded.end();
+        m_colourTimer.end();
+        if (m_depthPrepassShader) {
+            glDepthFunc(GL_LESS);
+            glDepthMask(GL_TRUE);
+        }
+    }
 
-        if (m_skybox) {
-            m_skybox->draw(m_projection, m_view);
+    // depth only, then leave the depth test at GL_EQUAL with writes off for the colour pass
+    void _draw_depth_prepass() {
+        m_depthPrepassTimer.begin();
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        for (sjd::Mesh* mesh : m_drawOrder) {
+            mesh->draw(m_projection, m_view, *m_depthPrepassShader);
         }
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+        stats::stateChange(2);
+        m_depthPrepassTimer.end();
     }
-private:
+
+    // nearest first by the closest point of each mesh's bounds, so early depth
+    // testing throws away what's behind; big meshes like floors count as close.
+    // Meshes either occlusion culler says are hidden are left out.
+    void _sort_front_to_back() {
+        m_meshBounds.clear();
+        for (std::reference_wrapper<sjd::Mesh> mesh : m_meshes) m_meshBounds.push_back(mesh.get().bounds());
+        if (m_softwareOcclusion) _test_software_occlusion();
+
+        std::vector<std::pair<float, sjd::Mesh*>> keyed;
+        keyed.reserve(m_meshes.size());
+        for (size_t i = 0; i < m_meshes.size(); i++) {
+            const sjd::AABB& box {m_meshBounds[i]};
+            if (m_occlusionCuller && !m_occlusionCuller->visible(i)) continue;
+            if (m_softwareOcclusion && !m_softwareOcclusion->visible(i)) continue;
+            glm::vec3 closest {glm::clamp(m_viewPos, box.min, box.max)};
+            glm::vec3 offset {closest - m_viewPos};
+            keyed.push_back({glm::dot(offset, offset), &m_meshes[i].get()});
+        }
+        std::stable_sort(keyed.begin(), keyed.end(),
+                         [](const std::pair<float, sjd::Mesh*>& a, const std::pair<float, sjd::Mesh*>& b) {
+                             return a.first < b.first;
+                         });
+        m_drawOrder.clear();
+        for (const std::pair<float, sjd::Mesh*>& entry : keyed) m_drawOrder.push_back(entry.second);
+    }
+
+    void _test_software_occlusion() {
+        m_softwareOcclusion->clearOccluders();
+        for (const std::pair<sjd::Mesh*, float>& occluder : m_occluders) {
+            m_softwareOcclusion->addOccluder(occluder.first->localBounds(), occluder.first->model(), occluder.second);
+        }
+        m_softwareOcclusion->render(m_projection * m_view);
+        m_softwareOcclusion->test(m_meshBounds);
+    }
+
+    // the G-buffer is DeferredShading's own, so the geometry pass binds it itself
+    void _add_deferred_passes() {
+        m_graph.addPass("deferred_geometry", [this](sjd::RenderGraph::Context&) {
+            m_deferred->beginGeometry();
+            _draw_objects(m_deferred->geometryShader());
+            m_deferred->endGeometry();
+        }).write("gbuffer");
+        m_graph.addPass("deferred_lighting", [this](sjd::RenderGraph::Context&) {
+            _point_light_buffer().update(m_pointLights);
+            m_deferred->light(m_projection, m_view, m_viewPos, m_dirLight, _point_light_buffer());
+        }).read("gbuffer").write("scene");
+    }
+
+    // only meshes whose model matrix changed; the rest get the camera's motion
+    void _draw_motion_vectors() {
+        sjd::Shader& shader {m_temporalAA->beginMotion()};
+        for (sjd::Mesh* mesh : m_drawOrder) {
+            if (mesh->model() == mesh->previousModel()) continue;
+            shader.use();
+            shader.setMat4("previousModel", mesh->previousModel());
+            mesh->draw(m_projection, m_view, shader);
+        }
+        m_temporalAA->endMotion();
+    }
+
+    // made on first use, so scenes that never need it don't hold the GL objects
+    sjd::PointLightBuffer& _point_light_buffer() {
+        if (!m_pointLightBuffer) m_pointLightBuffer = std::make_unique<sjd::PointLightBuffer>();
+        return *m_pointLightBuffer;
+    }
+
     void _draw_objects(sjd::Shader shader) {
+        for (sjd::Mesh* mesh : m_drawOrder) {
+            mesh->draw(m_projection, m_view, shader);
+        }
+    }
+
+    // Render every cascade. Casters outside a cascade's light frustum are skipped,
+    // and when the cascades cache static casters those are only redrawn after the
+    // cascade was refit or a static mesh moved; dynamic casters go on top each frame.
+    void _draw_shadow_casters() {
+        sjd::ShadowCascades& cascades {*m_dirLight->m_shadowMap};
+        m_dirLight->updateShadowCascades(m_view, m_projection);
+
+        uint64_t staticVersion {m_meshes.size()};
         for (std::reference_wrapper<sjd::Mesh> meshref : m_meshes) {
-            meshref.get().draw(m_projection, m_view, shader);
+            if (meshref.get().isStatic()) {
+                staticVersion = staticVersion * 31 + meshref.get().transformVersion() + 1;
+            }
+        }
+        if (staticVersion != m_staticCastersVersion) {
+            cascades.invalidateStatic();
+            m_staticCastersVersion = staticVersion;
         }
+
+        sjd::Shader& depthShader {*m_dirLight->m_shadowMapShader};
+        bool splitStatic {cascades.cachingStatic()};
+        for (unsigned int cascade = 0; cascade < cascades.count(); cascade++) {
+            sjd::Frustum lightFrustum {cascades.lightSpaceMatrix(cascade)};
+            if (splitStatic && m_dirLight->bindStaticDepthMap(cascade)) {
+                for (std::reference_wrapper<sjd::Mesh> meshref : m_meshes) {
+                    sjd::Mesh& mesh {meshref.get()};
+                    if (mesh.isStatic() && lightFrustum.intersects(mesh.bounds()))
+                        mesh.draw(m_projection, m_view, depthShader);
+                }
+            }
+            m_dirLight->bindDepthMap(cascade);
+            for (std::reference_wrapper<sjd::Mesh> meshref : m_meshes) {
+                sjd::Mesh& mesh {meshref.get()};
+                if (splitStatic && mesh.isStatic()) continue;
+                if (lightFrustum.intersects(mesh.bounds()))
+                    mesh.draw(m_projection, m_view, depthShader);
+            }
+        }
+        m_dirLight->unbindDepthMap();
+    }
+
+    // Give the first ShadowAtlas::maxLights shadowed point lights a slot and face
+    // size from their on-screen size, then re-render the faces whose contents
+    // changed, most important first, up to the atlas' per-frame budget.
+    // `screenHeight` is the height in pixels of what the scene is drawn into.
+    void _draw_point_shadows(unsigned int screenHeight) {
+        sjd::ShadowAtlas& atlas {*m_shadowAtlas};
+        float pixelsPerUnit {m_projection[1][1] * static_cast<float>(screenHeight) * 0.5f};  // at distance 1
+        sjd::Frustum viewFrustum {m_projection * m_view};
+
+        std::vector<sjd::PointLight*> lights;
+        std::vector<unsigned int> sizes;
+        std::vector<float> priorities;
+        m_pointShadowPlanes.clear();
+        for (size_t i = 0; i < m_pointLights.size() && lights.size() < sjd::ShadowAtlas::maxLights; i++) {
+            sjd::PointLight& light {m_pointLights[i].get()};
+            if (!light.castsShadows()) continue;
+            float range {light.range()};
+            float distance {glm::length(light.getPosition() - m_viewPos)};
+            float screenRadius {(distance > range) ? range / distance * pixelsPerUnit
+                                                   : static_cast<float>(screenHeight)};
+            // a light whose whole reach is off screen only needs the smallest tiles
+            if (!viewFrustum.intersects({light.getPosition() - glm::vec3(range),
+                                         light.getPosition() + glm::vec3(range)})) {
+                screenRadius = 0.0f;
+            }
+            unsigned int slot {static_cast<unsigned int>(lights.size())};
+            m_shadowSlots[i] = static_cast<int>(slot);
+            lights.push_back(&light);
+            sizes.push_back(atlas.faceSizeFor(screenRadius, atlas.tile(slot, 0).size));
+            priorities.push_back(screenRadius);
+            m_pointShadowPlanes.push_back({0.05f, range});
+        }
+        atlas.assign(sizes);
+
+        struct PendingFace {
+            unsigned int slot;
+            unsigned int face;
+            uint64_t version;
+            glm::mat4 lightSpace;
+        };
+        std::vector<PendingFace> pending;
+        for (unsigned int slot = 0; slot < lights.size(); slot++) {
+            glm::vec3 position {lights[slot]->getPosition()};
+            glm::mat4 projection {sjd::ShadowAtlas::faceProjection(m_pointShadowPlanes[slot].x,
+                                                                   m_pointShadowPlanes[slot].y)};
+            for (unsigned int face = 0; face < sjd::ShadowAtlas::faces; face++) {
+                const sjd::ShadowAtlas::Tile& tile {atlas.tile(slot, face)};
+                if (tile.size == 0) continue;
+                glm::mat4 lightSpace {projection * sjd::ShadowAtlas::faceView(position, face)};
+
+                // everything the face's depth depends on: the light, its tile and
+                // the transforms of the meshes it sees
+                uint64_t version {_hash(0, position.x)};
+                version = _hash(version, position.y);
+                version = _hash(version, position.z);
+                version = _hash(version, m_pointShadowPlanes[slot].y);
+                version = _hash(version, static_cast<uint64_t>(tile.x) << 32 | tile.y);
+                sjd::Frustum faceFrustum {lightSpace};
+                for (size_t k = 0; k < m_meshes.size(); k++) {
+                    if (faceFrustum.intersects(m_meshes[k].get().bounds())) {
+                        version = _hash(version, static_cast<uint64_t>(k));
+                        version = _hash(version, m_meshes[k].get().transformVersion());
+                    }
+                }
+                if (!atlas.faceValid(slot, face, version)) {
+                    pending.push_back({slot, face, version, lightSpace});
+                }
+            }
+        }
+        // faces with nothing in them yet first, then by how big their light is on screen
+        std::stable_sort(pending.begin(), pending.end(), [&](const PendingFace& a, const PendingFace& b) {
+            bool aRendered {atlas.faceRendered(a.slot, a.face)};
+            bool bRendered {atlas.faceRendered(b.slot, b.face)};
+            if (aRendered != bRendered) return !aRendered;
+            return priorities[a.slot] > priorities[b.slot];
+        });
+
+        m_pointShadowFaces = std::min<unsigned int>(static_cast<unsigned int>(pending.size()),
+                                                    atlas.settings().faceBudget);
+        if (m_pointShadowFaces == 0) return;
+        glCullFace(GL_FRONT);
+        for (unsigned int i = 0; i < m_pointShadowFaces; i++) {
+            const PendingFace& face {pending[i]};
+            atlas.bindFace(face.slot, face.face, face.version);
+            m_pointShadowShader->use();
+            m_pointShadowShader->setMat4("lightSpaceMatrix", face.lightSpace);
+            sjd::Frustum faceFrustum {face.lightSpace};
+            for (std::reference_wrapper<sjd::Mesh> meshref : m_meshes) {
+                if (faceFrustum.intersects(meshref.get().bounds()))
+                    meshref.get().draw(m_projection, m_view, *m_pointShadowShader);
+            }
+        }
+        glCullFace(GL_BACK);
+        atlas.release();
+    }
+
+    static uint64_t _hash(uint64_t seed, uint64_t value) {
+        return (seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2))) * 1099511628211ull;
+    }
+
+    static uint64_t _hash(uint64_t seed, float value) {
+        uint32_t bits {0};
+        std::memcpy(&bits, &value, sizeof(bits));
+        return _hash(seed, static_cast<uint64_t>(bits));
     }
 
 public:
@@ -95,8 +524,30 @@ private:
     std::vector<std::reference_wrapper<sjd::Mesh>> m_meshes;
     std::vector<std::reference_wrapper<sjd::PointLight>> m_pointLights;
     sjd::DirLight* m_dirLight;
-    sjd::FBTexture* m_shadowMap;
     sjd::Skybox* m_skybox;
+    sjd::GpuTimer m_shadowTimer;
+    uint64_t m_staticCastersVersion;
+    sjd::ShadowAtlas* m_shadowAtlas;
+    sjd::Shader* m_pointShadowShader;
+    std::vector<glm::vec2> m_pointShadowPlanes;
+    std::vector<int> m_shadowSlots;
+    sjd::GpuTimer m_pointShadowTimer;
+    unsigned int m_pointShadowFaces;
+    sjd::DeferredShading* m_deferred;
+    bool m_bufferedPointLights;
+    bool m_lightCubes;
+    std::unique_ptr<sjd::PointLightBuffer> m_pointLightBuffer;
+    sjd::Shader* m_depthPrepassShader;
+    std::vector<sjd::Mesh*> m_drawOrder;
+    std::vector<sjd::AABB> m_meshBounds;
+    sjd::HiZCuller* m_occlusionCuller;
+    sjd::SoftwareOcclusion* m_softwareOcclusion;
+    std::vector<std::pair<sjd::Mesh*, float>> m_occluders;
+    sjd::TemporalAA* m_temporalAA;
+    sjd::GpuTimer m_depthPrepassTimer;
+    sjd::GpuTimer m_colourTimer;
+    sjd::SampleCounter m_samplesShaded;
+    sjd::RenderGraph m_graph;
 
 };
 
@@ -9,6 +9,7 @@
 #include <glad/glad.h>
 #include <string_view>
 #include <glm/glm.hpp>
+#include <sjd/profiling.h>
 
 namespace sjd {
 
@@ -20,8 +21,11 @@ public:
     // constructor that builds the shader
     Shader(const std::string& vertexPath, const std::string& fragmentPath, const std::string& geometryPath="");
 
+    // build from source held in memory instead of files, e.g. generated shaders
+    static Shader fromSource(const std::string& vertexCode, const std::string& fragmentCode);
+
     // use/activate the shader
-    void use() {glUseProgram(m_id);}
+    void use() {glUseProgram(m_id); stats::stateChange();}
 
     // utility uniform instructions
     void setBool(const std::string& name, bool value) const;
@@ -30,11 +34,26 @@ public:
 
     void setFloat(const std::string& name, float value) const;
 
+    void setVec2(const std::string &name, const glm::vec2 &vec) const;
+
     void setVec3(const std::string &name, const glm::vec3 &vec) const;
 
     void setVec3(const std::string &name, float x, float y, float z) const;
 
+    void setVec4(const std::string &name, const glm::vec4 &vec) const;
+
+    void setMat3(const std::string &name, const glm::mat3 &mat) const;
+
     void setMat4(const std::string &name, const glm::mat4 &mat) const;
+
+private:
+    Shader()
+    : m_id {0}
+    {
+    }
+
+    // compile and link; gShaderCode may be nullptr
+    void compile(const char* vShaderCode, const char* fShaderCode, const char* gShaderCode);
 };
 
 inline Shader::Shader(const std::string& vertexPath, const std::string& fragmentPath, const std::string& geometryPath)
@@ -97,6 +116,18 @@ inline Shader::Shader(const std::string& vertexPath, const std::string& fragment
     const char* gShaderCode = geometryCode.c_str();
 
     // 2. compile shaders
+    compile(vShaderCode, fShaderCode, (geometryPath != "") ? gShaderCode : nullptr);
+}
+
+inline Shader Shader::fromSource(const std::string& vertexCode, const std::string& fragmentCode)
+{
+    Shader shader;
+    shader.compile(vertexCode.c_str(), fragmentCode.c_str(), nullptr);
+    return shader;
+}
+
+inline void Shader::compile(const char* vShaderCode, const char* fShaderCode, const char* gShaderCode)
+{
     GLuint vertex {};
     GLuint fragment {};
     GLuint geometry {};
@@ -128,7 +159,7 @@ inline Shader::Shader(const std::string& vertexPath, const std::string& fragment
     };
 
     // Optional Geometry Shader
-    if (geometryPath != "") {
+    if (gShaderCode) {
         geometry = glCreateShader(GL_GEOMETRY_SHADER);
         glShaderSource(geometry, 1, &gShaderCode, NULL);
         glCompileShader(geometry);
@@ -145,7 +176,7 @@ inline Shader::Shader(const std::string& vertexPath, const std::string& fragment
     // shader Program
     m_id = glCreateProgram();
     glAttachShader(m_id, vertex);
-    if (geometryPath != "") glAttachShader(m_id, geometry);
+    if (gShaderCode) glAttachShader(m_id, geometry);
     glAttachShader(m_id, fragment);
     glLinkProgram(m_id);
     // print linking errors if any
@@ -173,6 +204,13 @@ inline void Shader::setFloat(const std::string& name, float value) const {
     glUniform1f(glGetUniformLocation(m_id, name.c_str()), value); 
 }
 
+inline void Shader::setVec2(const std::string &name, const glm::vec2 &vec) const {
+    glUniform2fv(glGetUniformLocation(m_id, name.c_str()), 
+                       1, 
+                       &vec[0]
+                       );
+}
+
 inline void Shader::setVec3(const std::string &name, const glm::vec3 &vec) const {
     glUniform3fv(glGetUniformLocation(m_id, name.c_str()), 
                        1, 
@@ -187,6 +225,21 @@ inline void Shader::setVec3(const std::string &name, float x, float y, float z)
                 z); 
 }
 
+inline void Shader::setVec4(const std::string &name, const glm::vec4 &vec) const {
+    glUniform4fv(glGetUniformLocation(m_id, name.c_str()), 
+                       1, 
+                       &vec[0]
+                       );
+}
+
+inline void Shader::setMat3(const std::string &name, const glm::mat3 &mat) const {
+    glUniformMatrix3fv(glGetUniformLocation(m_id, name.c_str()), 
+                       1, 
+                       GL_FALSE, 
+                       &mat[0][0]
+                       );
+}
+
 inline void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const {
     glUniformMatrix4fv(glGetUniformLocation(m_id, name.c_str()), 
                        1, 
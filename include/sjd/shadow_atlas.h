@@ -0,0 +1,264 @@
+#ifndef SHADOW_ATLAS_H
+#define SHADOW_ATLAS_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <sjd/shader.h>
+#include <sjd/profiling.h>
+
+namespace sjd {
+
+struct ShadowAtlasSettings {
+    unsigned int size {4096};           // width and height of the atlas
+    unsigned int minFaceSize {64};      // all face sizes are powers of two in this range
+    unsigned int maxFaceSize {1024};
+    unsigned int faceBudget {6};        // most cube faces re-rendered in one frame
+    float texelsPerPixel {1.0f};        // face size per pixel of the light's on-screen radius
+};
+
+// One depth texture shared by the omnidirectional shadows of several point
+// lights. Every shadowed light gets six square tiles, one per cube face, whose
+// size follows how large the light's area of influence is on screen. Faces are
+// rendered with a 90 degree perspective projection and sampled by picking the
+// major axis of the light-to-fragment vector, like a cube map, but living in one
+// 2D texture lets lights of different resolutions share the memory.
+//
+// A face only needs re-rendering when something it sees changed. The caller
+// hashes whatever the face depends on into a version; faces whose version is
+// unchanged keep their depth, and no more than faceBudget faces are redrawn per
+// frame. Faces that haven't been rendered into their current tile yet are
+// reported as unshadowed to the shader rather than showing stale depth.
+class ShadowAtlas {
+public:
+    static constexpr unsigned int maxLights {8};
+    static constexpr unsigned int faces {6};
+    // kept clear of both the units meshes hand out and ShadowCascades::textureUnit
+    static constexpr unsigned int textureUnit {14};
+
+    struct Tile {
+        unsigned int x {0};
+        unsigned int y {0};
+        unsigned int size {0};      // 0 when the light didn't fit
+
+        bool operator==(const Tile& other) const {
+            return x == other.x && y == other.y && size == other.size;
+        }
+    };
+
+    ShadowAtlas(ShadowAtlasSettings settings={})
+    :   m_settings {settings}
+    ,   m_bound {false}
+    {
+        glGenFramebuffers(1, &m_fbo);
+        glGenTextures(1, &m_id);
+        glBindTexture(GL_TEXTURE_2D, m_id);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, m_settings.size, m_settings.size,
+                     0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_id, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::SHADOW_ATLAS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    ~ShadowAtlas() {
+        glDeleteTextures(1, &m_id);
+        glDeleteFramebuffers(1, &m_fbo);
+    }
+
+    ShadowAtlas(const ShadowAtlas&) = delete;
+    ShadowAtlas& operator=(const ShadowAtlas&) = delete;
+
+    const ShadowAtlasSettings& settings() const {
+        return m_settings;
+    }
+
+    // Face size for a light covering `screenRadius` pixels. Growing happens at once,
+    // shrinking only once the light needs less than half its current size, so a
+    // light hovering around a boundary doesn't keep getting repacked.
+    unsigned int faceSizeFor(float screenRadius, unsigned int currentSize) const {
+        unsigned int wanted {m_settings.minFaceSize};
+        while (wanted < m_settings.maxFaceSize && wanted < screenRadius * m_settings.texelsPerPixel) {
+            wanted *= 2;
+        }
+        if (currentSize > 0 && wanted < currentSize && wanted * 2 >= currentSize) return currentSize;
+        return wanted;
+    }
+
+    // Give light slot i six tiles of faceSizes[i]. Tiles are only repacked when the
+    // requested sizes change; faces whose tile moved have to be rendered again.
+    void assign(const std::vector<unsigned int>& faceSizes) {
+        size_t lights {std::min<size_t>(faceSizes.size(), maxLights)};
+        std::vector<unsigned int> sizes {faceSizes.begin(), faceSizes.begin() + lights};
+        if (sizes == m_sizes) return;
+        m_sizes = sizes;
+
+        // biggest first, each at the first free spot aligned to its own size; with
+        // power of two squares this packs without gaps until the atlas is full
+        std::vector<unsigned int> order(lights);
+        for (unsigned int i = 0; i < lights; i++) order[i] = i;
+        std::stable_sort(order.begin(), order.end(),
+                         [&](unsigned int a, unsigned int b) { return sizes[a] > sizes[b]; });
+        unsigned int cells {m_settings.size / m_settings.minFaceSize};
+        std::vector<bool> used(cells * cells, false);
+
+        std::array<std::array<Tile, faces>, maxLights> tiles {};
+        for (unsigned int slot : order) {
+            for (unsigned int size = sizes[slot]; size >= m_settings.minFaceSize; size /= 2) {
+                std::array<Tile, faces> placed {};
+                std::vector<bool> trial {used};
+                bool fits {true};
+                for (unsigned int face = 0; face < faces && fits; face++) {
+                    fits = place(trial, cells, size, placed[face]);
+                }
+                if (fits) {
+                    tiles[slot] = placed;
+                    used = trial;
+                    break;
+                }
+            }
+            if (tiles[slot][0].size == 0) {
+                std::cout << "ERROR::SHADOW_ATLAS::FULL light " << slot << std::endl;
+            }
+        }
+
+        for (unsigned int slot = 0; slot < maxLights; slot++) {
+            for (unsigned int face = 0; face < faces; face++) {
+                if (!(tiles[slot][face] == m_tiles[slot][face])) {
+                    m_tiles[slot][face] = tiles[slot][face];
+                    m_rendered[slot][face] = false;
+                }
+            }
+        }
+    }
+
+    const Tile& tile(unsigned int slot, unsigned int face) const {
+        return m_tiles[slot][face];
+    }
+
+    // true if the face holds depth rendered from exactly this version of its contents
+    bool faceValid(unsigned int slot, unsigned int face, uint64_t version) const {
+        return m_rendered[slot][face] && m_versions[slot][face] == version;
+    }
+
+    bool faceRendered(unsigned int slot, unsigned int face) const {
+        return m_rendered[slot][face];
+    }
+
+    // render one face; the caller's framebuffer and viewport are put back by release()
+    void bindFace(unsigned int slot, unsigned int face, uint64_t version) {
+        const Tile& target {m_tiles[slot][face]};
+        if (!m_bound) {
+            glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_savedFramebuffer);
+            glGetIntegerv(GL_VIEWPORT, m_savedViewport.data());
+            glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+            glEnable(GL_SCISSOR_TEST);
+            stats::stateChange();
+            m_bound = true;
+        }
+        glViewport(target.x, target.y, target.size, target.size);
+        glScissor(target.x, target.y, target.size, target.size);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        m_rendered[slot][face] = true;
+        m_versions[slot][face] = version;
+    }
+
+    void release() {
+        if (!m_bound) return;
+        glDisable(GL_SCISSOR_TEST);
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(m_savedFramebuffer));
+        glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+        stats::stateChange();
+        m_bound = false;
+    }
+
+    // bind the atlas and upload tiles and clip planes for `planes.size()` light slots
+    void bindTexture(sjd::Shader& shader, const std::vector<glm::vec2>& planes) const {
+        shader.use();
+        glActiveTexture(GL_TEXTURE0 + textureUnit);
+        glBindTexture(GL_TEXTURE_2D, m_id);
+        stats::stateChange();
+        shader.setInt("pointShadowAtlas", textureUnit);
+        float texel {1.0f / m_settings.size};
+        for (unsigned int slot = 0; slot < planes.size() && slot < maxLights; slot++) {
+            shader.setVec2(("pointShadowPlanes[" + std::to_string(slot) + "]").c_str(), planes[slot]);
+            for (unsigned int face = 0; face < faces; face++) {
+                const Tile& t {m_tiles[slot][face]};
+                // unrendered faces go up with size 0, which the shader treats as unshadowed
+                float size {m_rendered[slot][face] ? static_cast<float>(t.size) : 0.0f};
+                shader.setVec4(("pointShadowTiles[" + std::to_string(slot * faces + face) + "]").c_str(),
+                               glm::vec4(t.x * texel, t.y * texel, size * texel, size));
+            }
+        }
+    }
+
+    // Cube map face orientations (+X, -X, +Y, -Y, +Z, -Z). The lighting shader
+    // mirrors these in its POINT_SHADOW_* tables, so keep the two in step.
+    static glm::mat4 faceView(glm::vec3 position, unsigned int face) {
+        static const std::array<glm::vec3, faces> forward {
+            glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(-1.0f,  0.0f,  0.0f),
+            glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3( 0.0f, -1.0f,  0.0f),
+            glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3( 0.0f,  0.0f, -1.0f),
+        };
+        static const std::array<glm::vec3, faces> up {
+            glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3( 0.0f, -1.0f,  0.0f),
+            glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3( 0.0f,  0.0f, -1.0f),
+            glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3( 0.0f, -1.0f,  0.0f),
+        };
+        return glm::lookAt(position, position + forward[face], up[face]);
+    }
+
+    static glm::mat4 faceProjection(float nearPlane, float farPlane) {
+        return glm::perspective(glm::radians(90.0f), 1.0f, nearPlane, farPlane);
+    }
+
+private:
+    // first free size x size square aligned to its size, scanning rows
+    bool place(std::vector<bool>& used, unsigned int cells, unsigned int size, Tile& tile) const {
+        unsigned int span {size / m_settings.minFaceSize};
+        for (unsigned int y = 0; y + span <= cells; y += span) {
+            for (unsigned int x = 0; x + span <= cells; x += span) {
+                bool free {true};
+                for (unsigned int j = 0; j < span && free; j++)
+                    for (unsigned int i = 0; i < span && free; i++)
+                        free = !used[(y + j) * cells + x + i];
+                if (!free) continue;
+                for (unsigned int j = 0; j < span; j++)
+                    for (unsigned int i = 0; i < span; i++)
+                        used[(y + j) * cells + x + i] = true;
+                tile = {x * m_settings.minFaceSize, y * m_settings.minFaceSize, size};
+                return true;
+            }
+        }
+        return false;
+    }
+
+    ShadowAtlasSettings m_settings;
+    unsigned int m_fbo;
+    unsigned int m_id;
+    bool m_bound;
+    std::vector<unsigned int> m_sizes;
+    std::array<std::array<Tile, faces>, maxLights> m_tiles {};
+    std::array<std::array<bool, faces>, maxLights> m_rendered {};
+    std::array<std::array<uint64_t, faces>, maxLights> m_versions {};
+    std::array<int, 4> m_savedViewport {};
+    GLint m_savedFramebuffer {0};
+};
+
+}
+#endif
@@ -0,0 +1,321 @@
+#ifndef SHADOW_CASCADES_H
+#define SHADOW_CASCADES_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <sjd/shader.h>
+#include <sjd/profiling.h>
+
+namespace sjd {
+
+struct ShadowCascadeSettings {
+    unsigned int count {4};             // 1 to ShadowCascades::maxCascades
+    unsigned int resolution {2048};     // width and height of every cascade
+    float splitLambda {0.75f};          // 0 = uniform splits, 1 = logarithmic splits
+    float maxDistance {50.0f};          // shadows end here even if the camera sees further
+    float casterMargin {20.0f};         // how far towards the light casters are still caught
+    float refitPadding {0.15f};         // cascades are fitted this much larger and only refit
+                                        // once the camera's slice leaves them
+    bool cacheStatic {true};            // keep static casters in a second array (see bindStatic)
+};
+
+// Cascaded shadow maps for a directional light. The camera frustum (up to
+// maxDistance) is cut into `count` slices with the practical split scheme, and
+// each slice gets its own orthographic light projection and its own layer of a
+// depth texture array, so texel density follows the camera instead of being
+// spread evenly over the whole scene.
+//
+// Each cascade is fitted to the bounding sphere of its slice rather than the
+// slice itself, which keeps the projection the same size as the camera turns,
+// and the projection is snapped to whole shadow map texels so moving the camera
+// doesn't make shadow edges shimmer. Cascades are fitted with some padding and
+// kept until the slice they cover no longer fits, so most frames reuse last
+// frame's projections.
+//
+// With cacheStatic, static casters are drawn into a second depth array that is
+// only redrawn when its cascade is refit or invalidateStatic() is called. Each
+// frame the live layer starts as a copy of the cached one and only dynamic
+// casters are drawn on top.
+class ShadowCascades {
+public:
+    static constexpr unsigned int maxCascades {4};
+    // texture unit the cascade array is bound to while lighting; kept out of the
+    // way of the units meshes hand out for their own maps
+    static constexpr unsigned int textureUnit {15};
+
+    ShadowCascades(ShadowCascadeSettings settings={})
+    :   m_settings {settings}
+    ,   m_fbo {0}
+    ,   m_id {0}
+    ,   m_staticFbo {0}
+    ,   m_staticId {0}
+    ,   m_bound {false}
+    {
+        m_settings.count = std::clamp(m_settings.count, 1u, maxCascades);
+        glGenFramebuffers(1, &m_fbo);
+        glGenFramebuffers(1, &m_staticFbo);
+        allocate();
+    }
+
+    ~ShadowCascades() {
+        glDeleteTextures(1, &m_id);
+        glDeleteTextures(1, &m_staticId);
+        glDeleteFramebuffers(1, &m_fbo);
+        glDeleteFramebuffers(1, &m_staticFbo);
+    }
+
+    ShadowCascades(const ShadowCascades&) = delete;
+    ShadowCascades& operator=(const ShadowCascades&) = delete;
+
+    const ShadowCascadeSettings& settings() const {
+        return m_settings;
+    }
+
+    // reallocates the depth array if the count or resolution changed
+    void setSettings(ShadowCascadeSettings settings) {
+        settings.count = std::clamp(settings.count, 1u, maxCascades);
+        bool reallocate {settings.count != m_settings.count
+                         || settings.resolution != m_settings.resolution
+                         || settings.cacheStatic != m_settings.cacheStatic};
+        m_settings = settings;
+        if (reallocate) allocate();
+        invalidateFit();
+    }
+
+    // static casters moved or were added; redraw every cached layer
+    void invalidateStatic() {
+        m_staticValid.fill(false);
+    }
+
+    unsigned int count() const {
+        return m_settings.count;
+    }
+
+    const glm::mat4& lightSpaceMatrix(unsigned int cascade) const {
+        return m_lightSpaceMatrices[cascade];
+    }
+
+    // view space distance at which `cascade` ends
+    float splitDepth(unsigned int cascade) const {
+        return m_splitDepths[cascade];
+    }
+
+    // fit every cascade to the camera; `lightDirection` points from the light into the scene
+    void update(const glm::mat4& view, const glm::mat4& projection, glm::vec3 lightDirection) {
+        // near and far planes back out of the perspective matrix
+        float cameraNear {projection[3][2] / (projection[2][2] - 1.0f)};
+        float cameraFar {projection[3][2] / (projection[2][2] + 1.0f)};
+        float shadowFar {std::min(cameraFar, m_settings.maxDistance)};
+
+        // world space corners of the whole frustum; a slice's corners lie on the
+        // edges between them, and view depth grows linearly along each edge
+        glm::mat4 inverseViewProjection {glm::inverse(projection * view)};
+        std::array<glm::vec3, 4> nearCorners;
+        std::array<glm::vec3, 4> farCorners;
+        for (unsigned int i = 0; i < 4; i++) {
+            glm::vec2 ndc {(i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f};
+            glm::vec4 nearCorner {inverseViewProjection * glm::vec4(ndc, -1.0f, 1.0f)};
+            glm::vec4 farCorner {inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f)};
+            nearCorners[i] = glm::vec3(nearCorner) / nearCorner.w;
+            farCorners[i] = glm::vec3(farCorner) / farCorner.w;
+        }
+
+        glm::vec3 up {std::abs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f)
+                                                         : glm::vec3(0.0f, 1.0f, 0.0f)};
+        float sliceStart {cameraNear};
+        for (unsigned int cascade = 0; cascade < m_settings.count; cascade++) {
+            // practical split scheme: blend of logarithmic and uniform splits
+            float fraction {static_cast<float>(cascade + 1) / m_settings.count};
+            float logSplit {cameraNear * std::pow(shadowFar / cameraNear, fraction)};
+            float uniformSplit {cameraNear + (shadowFar - cameraNear) * fraction};
+            float sliceEnd {m_settings.splitLambda * logSplit
+                            + (1.0f - m_settings.splitLambda) * uniformSplit};
+
+            m_splitDepths[cascade] = sliceEnd;
+            std::array<glm::vec3, 8> corners;
+            glm::vec3 center {0.0f};
+            for (unsigned int i = 0; i < 4; i++) {
+                glm::vec3 edge {farCorners[i] - nearCorners[i]};
+                corners[i] = nearCorners[i] + edge * ((sliceStart - cameraNear) / (cameraFar - cameraNear));
+                corners[i + 4] = nearCorners[i] + edge * ((sliceEnd - cameraNear) / (cameraFar - cameraNear));
+                center += corners[i] + corners[i + 4];
+            }
+            center /= 8.0f;
+            float radius {0.0f};
+            for (const glm::vec3& corner : corners) {
+                radius = std::max(radius, glm::length(corner - center));
+            }
+            sliceStart = sliceEnd;
+
+            // keep the current fit while it still contains the whole slice
+            if (lightDirection == m_lightDirection
+                    && glm::length(center - m_centers[cascade]) + radius <= m_radii[cascade]) {
+                continue;
+            }
+            // round up so float noise in the fit doesn't rescale the projection every frame
+            radius = std::ceil(radius * (1.0f + m_settings.refitPadding) * 16.0f) / 16.0f;
+            m_centers[cascade] = center;
+            m_radii[cascade] = radius;
+            m_staticValid[cascade] = false;
+
+            glm::mat4 lightView {glm::lookAt(center - lightDirection * radius, center, up)};
+            glm::mat4 lightProjection {glm::ortho(-radius, radius, -radius, radius,
+                                                  -m_settings.casterMargin, 2.0f * radius)};
+
+            // snap the projection so the world origin lands on a texel corner
+            float halfResolution {m_settings.resolution * 0.5f};
+            glm::vec4 origin {lightProjection * lightView * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)};
+            glm::vec2 texelOrigin {glm::vec2(origin) * halfResolution};
+            glm::vec2 offset {(glm::round(texelOrigin) - texelOrigin) / halfResolution};
+            lightProjection[3][0] += offset.x;
+            lightProjection[3][1] += offset.y;
+
+            m_lightSpaceMatrices[cascade] = lightProjection * lightView;
+            // one texel's worth of world space, in light depth units, as the base
+            // depth bias; wider cascades need proportionally more
+            float texelWorldSize {2.0f * radius / m_settings.resolution};
+            m_depthBias[cascade] = texelWorldSize / (2.0f * radius + m_settings.casterMargin);
+        }
+        m_lightDirection = lightDirection;
+    }
+
+    bool cachingStatic() const {
+        return m_settings.cacheStatic;
+    }
+
+    // Render static casters into one cascade's cached layer. Returns false, binding
+    // nothing, when the cached layer is still valid and there's nothing to draw.
+    bool bindStatic(unsigned int cascade) {
+        if (!m_settings.cacheStatic || cascade >= m_settings.count || m_staticValid[cascade]) {
+            return false;
+        }
+        saveViewport();
+        glBindFramebuffer(GL_FRAMEBUFFER, m_staticFbo);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_staticId, 0, cascade);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        stats::stateChange();
+        m_staticValid[cascade] = true;
+        return true;
+    }
+
+    // Render into one cascade's live layer. With static caching the layer starts as
+    // a copy of the cached static casters, otherwise it starts cleared.
+    // The caller's framebuffer and viewport are put back by release().
+    void bind(unsigned int cascade) {
+        if (cascade >= m_settings.count) {
+            std::cout << "ERROR::SHADOW_CASCADES::BAD_CASCADE " << cascade << std::endl;
+            return;
+        }
+        saveViewport();
+        glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_id, 0, cascade);
+        stats::stateChange();
+        if (m_settings.cacheStatic) {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, m_staticFbo);
+            glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_staticId, 0, cascade);
+            GLint size {static_cast<GLint>(m_settings.resolution)};
+            glBlitFramebuffer(0, 0, size, size, 0, 0, size, size, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+        }
+        else {
+            glClear(GL_DEPTH_BUFFER_BIT);
+        }
+    }
+
+    // put back the framebuffer and viewport that were current at the first bind
+    void release() {
+        if (!m_bound) return;
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(m_savedFramebuffer));
+        glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+        m_bound = false;
+        stats::stateChange();
+    }
+
+    // bind the depth array and upload everything the lighting shader needs to pick a cascade
+    void bindTexture(sjd::Shader& shader) const {
+        shader.use();
+        glActiveTexture(GL_TEXTURE0 + textureUnit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+        stats::stateChange();
+        shader.setInt("shadowMap", textureUnit);
+        shader.setInt("cascadeCount", static_cast<int>(m_settings.count));
+        for (unsigned int i = 0; i < m_settings.count; i++) {
+            std::string index {"[" + std::to_string(i) + "]"};
+            shader.setMat4(("lightSpaceMatrices" + index).c_str(), m_lightSpaceMatrices[i]);
+            shader.setFloat(("cascadeSplits" + index).c_str(), m_splitDepths[i]);
+            shader.setFloat(("cascadeDepthBias" + index).c_str(), m_depthBias[i]);
+        }
+    }
+
+private:
+    void saveViewport() {
+        if (m_bound) return;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_savedFramebuffer);
+        glGetIntegerv(GL_VIEWPORT, m_savedViewport.data());
+        glViewport(0, 0, m_settings.resolution, m_settings.resolution);
+        m_bound = true;
+    }
+
+    // force every cascade to refit (and so redraw its static layer) next update
+    void invalidateFit() {
+        m_radii.fill(0.0f);
+        invalidateStatic();
+    }
+
+    void allocate() {
+        allocateArray(m_fbo, m_id);
+        if (m_staticId) glDeleteTextures(1, &m_staticId);
+        m_staticId = 0;
+        if (m_settings.cacheStatic) allocateArray(m_staticFbo, m_staticId);
+        invalidateFit();
+    }
+
+    void allocateArray(unsigned int fbo, unsigned int& id) {
+        if (id) glDeleteTextures(1, &id);
+        glGenTextures(1, &id);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24,
+                     m_settings.resolution, m_settings.resolution, m_settings.count,
+                     0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, id, 0, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::SHADOW_CASCADES::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    ShadowCascadeSettings m_settings;
+    unsigned int m_fbo;
+    unsigned int m_id;
+    unsigned int m_staticFbo;
+    unsigned int m_staticId;
+    bool m_bound;
+    glm::vec3 m_lightDirection {0.0f};
+    std::array<glm::vec3, maxCascades> m_centers {};
+    std::array<float, maxCascades> m_radii {};
+    std::array<bool, maxCascades> m_staticValid {};
+    std::array<glm::mat4, maxCascades> m_lightSpaceMatrices {};
+    std::array<float, maxCascades> m_splitDepths {};
+    std::array<float, maxCascades> m_depthBias {};
+    std::array<int, 4> m_savedViewport {};
+    GLint m_savedFramebuffer {0};
+};
+
+}
+#endif
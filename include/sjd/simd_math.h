@@ -0,0 +1,583 @@
+#ifndef SIMD_MATH_H
+#define SIMD_MATH_H
+
+#include <cstdint>
+#include <cstring>
+#include <glm/glm.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SJD_SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC accepts AVX intrinsics in any function
+#define SJD_TARGET_AVX2
+#else
+#define SJD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace sjd {
+
+// Batch math over arrays, for when there are thousands of the same small
+// operation to do (instance matrices and the like). Every kernel has a scalar
+// version plus SSE2 and AVX2 versions on x86; the best one the CPU supports is
+// picked at runtime, so the build doesn't need /arch flags. Kernels avoid FMA,
+// so every ISA level gives the same results up to the odd rounding difference.
+namespace simd {
+
+enum class Isa {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+inline const char* isaName(Isa isa) {
+    switch (isa) {
+        case Isa::SSE2: return "sse2";
+        case Isa::AVX2: return "avx2";
+        default:        return "scalar";
+    }
+}
+
+// the best ISA level this CPU (and OS) can run
+inline Isa supportedIsa() {
+    static const Isa supported {[]() {
+#if defined(SJD_SIMD_X86) && defined(_MSC_VER)
+        int info[4] {};
+        __cpuid(info, 1);
+        bool sse2 {(info[3] & (1 << 26)) != 0};
+        bool osxsave {(info[2] & (1 << 27)) != 0};
+        bool avx {(info[2] & (1 << 28)) != 0};
+        // the OS must save the ymm registers too
+        bool ymmEnabled {osxsave && (_xgetbv(0) & 0x6) == 0x6};
+        __cpuidex(info, 7, 0);
+        bool avx2 {(info[1] & (1 << 5)) != 0};
+        if (avx && ymmEnabled && avx2) return Isa::AVX2;
+        return sse2 ? Isa::SSE2 : Isa::SCALAR;
+#elif defined(SJD_SIMD_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return Isa::AVX2;
+        return __builtin_cpu_supports("sse2") ? Isa::SSE2 : Isa::SCALAR;
+#else
+        return Isa::SCALAR;
+#endif
+    }()};
+    return supported;
+}
+
+namespace detail {
+    inline Isa& activeIsa() {
+        static Isa isa {supportedIsa()};
+        return isa;
+    }
+}
+
+inline Isa activeIsa() {
+    return detail::activeIsa();
+}
+
+// Force a lower ISA level, e.g. to compare them. Levels the CPU can't run fall
+// back to the best one it can.
+inline void setIsa(Isa isa) {
+    detail::activeIsa() = (static_cast<int>(isa) <= static_cast<int>(supportedIsa())) ? isa : supportedIsa();
+}
+
+// Translation, rotation (unit quaternion) and scale of many transforms, one array
+// per component.
+struct TRSArrays {
+    const float* px;
+    const float* py;
+    const float* pz;
+    const float* qx;
+    const float* qy;
+    const float* qz;
+    const float* qw;
+    const float* sx;
+    const float* sy;
+    const float* sz;
+
+    // the same arrays starting n elements later
+    TRSArrays offset(size_t n) const {
+        return {px + n, py + n, pz + n, qx + n, qy + n, qz + n, qw + n, sx + n, sy + n, sz + n};
+    }
+};
+
+namespace detail {
+    // sinf/cosf from the Cephes library: reduce to [-pi/4, pi/4] in three steps,
+    // then a short polynomial. Accurate to a couple of ulp for |x| < 8192.
+    namespace sincos_constants {
+        constexpr float fourOverPi {1.27323954473516f};
+        constexpr float dp1 {0.78515625f};
+        constexpr float dp2 {2.4187564849853515625e-4f};
+        constexpr float dp3 {3.77489497744594108e-8f};
+        constexpr float cos0 {2.443315711809948e-5f};
+        constexpr float cos1 {-1.388731625493765e-3f};
+        constexpr float cos2 {4.166664568298827e-2f};
+        constexpr float sin0 {-1.9515295891e-4f};
+        constexpr float sin1 {8.3321608736e-3f};
+        constexpr float sin2 {-1.6666654611e-1f};
+    }
+
+    inline float flipSign(float value, uint32_t signBit) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        bits ^= signBit;
+        std::memcpy(&value, &bits, sizeof(bits));
+        return value;
+    }
+
+    inline void sinCosScalar(const float* x, float* s, float* c, size_t count) {
+        using namespace sincos_constants;
+        for (size_t i = 0; i < count; i++) {
+            float value {x[i]};
+            uint32_t signSin {(value < 0.0f) ? 0x80000000u : 0u};
+            value = (value < 0.0f) ? -value : value;
+            int32_t j {static_cast<int32_t>(value * fourOverPi)};
+            j = (j + 1) & ~1;
+            float y {static_cast<float>(j)};
+            signSin ^= static_cast<uint32_t>(j & 4) << 29;
+            uint32_t signCos {static_cast<uint32_t>(~(j - 2) & 4) << 29};
+            bool sinPoly {(j & 2) == 0};
+            value = ((value - y * dp1) - y * dp2) - y * dp3;
+            float z {value * value};
+            float cosValue {((cos0 * z + cos1) * z + cos2) * z * z - 0.5f * z + 1.0f};
+            float sinValue {((sin0 * z + sin1) * z + sin2) * z * value + value};
+            s[i] = flipSign(sinPoly ? sinValue : cosValue, signSin);
+            c[i] = flipSign(sinPoly ? cosValue : sinValue, signCos);
+        }
+    }
+
+    inline void composeTRSScalar(const TRSArrays& in, glm::mat4* out, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            float x {in.qx[i]}, y {in.qy[i]}, z {in.qz[i]}, w {in.qw[i]};
+            float xx {x * x}, yy {y * y}, zz {z * z};
+            float xy {x * y}, xz {x * z}, yz {y * z};
+            float wx {w * x}, wy {w * y}, wz {w * z};
+            glm::mat4& m {out[i]};
+            m[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * in.sx[i], 2.0f * (xy + wz) * in.sx[i],
+                             2.0f * (xz - wy) * in.sx[i], 0.0f);
+            m[1] = glm::vec4(2.0f * (xy - wz) * in.sy[i], (1.0f - 2.0f * (xx + zz)) * in.sy[i],
+                             2.0f * (yz + wx) * in.sy[i], 0.0f);
+            m[2] = glm::vec4(2.0f * (xz + wy) * in.sz[i], 2.0f * (yz - wx) * in.sz[i],
+                             (1.0f - 2.0f * (xx + yy)) * in.sz[i], 0.0f);
+            m[3] = glm::vec4(in.px[i], in.py[i], in.pz[i], 1.0f);
+        }
+    }
+
+    inline void multiplyScalar(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            glm::mat4 result;
+            for (int column = 0; column < 4; column++) {
+                result[column] = a[i][0] * b[i][column][0] + a[i][1] * b[i][column][1]
+                               + a[i][2] * b[i][column][2] + a[i][3] * b[i][column][3];
+            }
+            out[i] = result;
+        }
+    }
+
+    inline void transformScalar(const glm::mat4* m, const glm::vec4* v, glm::vec4* out, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            glm::vec4 vector {v[i]};
+            out[i] = m[i][0] * vector.x + m[i][1] * vector.y + m[i][2] * vector.z + m[i][3] * vector.w;
+        }
+    }
+
+#ifdef SJD_SIMD_X86
+    // write one column of four consecutive matrices from four row-vectors holding
+    // that column's x, y, z and w for each of the matrices
+    inline void storeColumn4(glm::mat4* out, int column, __m128 x, __m128 y, __m128 z, __m128 w) {
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(&out[0][column][0], x);
+        _mm_storeu_ps(&out[1][column][0], y);
+        _mm_storeu_ps(&out[2][column][0], z);
+        _mm_storeu_ps(&out[3][column][0], w);
+    }
+
+    inline void sinCosSse2(const float* x, float* s, float* c, size_t count) {
+        using namespace sincos_constants;
+        const __m128 signMask {_mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000u)))};
+        size_t i {0};
+        for (; i + 4 <= count; i += 4) {
+            __m128 value {_mm_loadu_ps(x + i)};
+            __m128 signSin {_mm_and_ps(value, signMask)};
+            value = _mm_andnot_ps(signMask, value);
+            __m128i j {_mm_cvttps_epi32(_mm_mul_ps(value, _mm_set1_ps(fourOverPi)))};
+            j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+            __m128 y {_mm_cvtepi32_ps(j)};
+            signSin = _mm_xor_ps(signSin, _mm_castsi128_ps(
+                _mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29)));
+            __m128 signCos {_mm_castsi128_ps(_mm_slli_epi32(
+                _mm_andnot_si128(_mm_sub_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29))};
+            __m128 sinPoly {_mm_castsi128_ps(_mm_cmpeq_epi32(
+                _mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()))};
+            value = _mm_sub_ps(value, _mm_mul_ps(y, _mm_set1_ps(dp1)));
+            value = _mm_sub_ps(value, _mm_mul_ps(y, _mm_set1_ps(dp2)));
+            value = _mm_sub_ps(value, _mm_mul_ps(y, _mm_set1_ps(dp3)));
+            __m128 z {_mm_mul_ps(value, value)};
+            __m128 cosValue {_mm_add_ps(_mm_mul_ps(_mm_set1_ps(cos0), z), _mm_set1_ps(cos1))};
+            cosValue = _mm_add_ps(_mm_mul_ps(cosValue, z), _mm_set1_ps(cos2));
+            cosValue = _mm_mul_ps(_mm_mul_ps(cosValue, z), z);
+            cosValue = _mm_add_ps(_mm_sub_ps(cosValue, _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_set1_ps(1.0f));
+            __m128 sinValue {_mm_add_ps(_mm_mul_ps(_mm_set1_ps(sin0), z), _mm_set1_ps(sin1))};
+            sinValue = _mm_add_ps(_mm_mul_ps(sinValue, z), _mm_set1_ps(sin2));
+            sinValue = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinValue, z), value), value);
+            __m128 sinResult {_mm_or_ps(_mm_and_ps(sinPoly, sinValue), _mm_andnot_ps(sinPoly, cosValue))};
+            __m128 cosResult {_mm_or_ps(_mm_and_ps(sinPoly, cosValue), _mm_andnot_ps(sinPoly, sinValue))};
+            _mm_storeu_ps(s + i, _mm_xor_ps(sinResult, signSin));
+            _mm_storeu_ps(c + i, _mm_xor_ps(cosResult, signCos));
+        }
+        sinCosScalar(x + i, s + i, c + i, count - i);
+    }
+
+    SJD_TARGET_AVX2
+    inline void sinCosAvx2(const float* x, float* s, float* c, size_t count) {
+        using namespace sincos_constants;
+        const __m256 signMask {_mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(0x80000000u)))};
+        size_t i {0};
+        for (; i + 8 <= count; i += 8) {
+            __m256 value {_mm256_loadu_ps(x + i)};
+            __m256 signSin {_mm256_and_ps(value, signMask)};
+            value = _mm256_andnot_ps(signMask, value);
+            __m256i j {_mm256_cvttps_epi32(_mm256_mul_ps(value, _mm256_set1_ps(fourOverPi)))};
+            j = _mm256_and_si256(_mm256_add_epi32(j, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+            __m256 y {_mm256_cvtepi32_ps(j)};
+            signSin = _mm256_xor_ps(signSin, _mm256_castsi256_ps(
+                _mm256_slli_epi32(_mm256_and_si256(j, _mm256_set1_epi32(4)), 29)));
+            __m256 signCos {_mm256_castsi256_ps(_mm256_slli_epi32(
+                _mm256_andnot_si256(_mm256_sub_epi32(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29))};
+            __m256 sinPoly {_mm256_castsi256_ps(_mm256_cmpeq_epi32(
+                _mm256_and_si256(j, _mm256_set1_epi32(2)), _mm256_setzero_si256()))};
+            value = _mm256_sub_ps(value, _mm256_mul_ps(y, _mm256_set1_ps(dp1)));
+            value = _mm256_sub_ps(value, _mm256_mul_ps(y, _mm256_set1_ps(dp2)));
+            value = _mm256_sub_ps(value, _mm256_mul_ps(y, _mm256_set1_ps(dp3)));
+            __m256 z {_mm256_mul_ps(value, value)};
+            __m256 cosValue {_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(cos0), z), _mm256_set1_ps(cos1))};
+            cosValue = _mm256_add_ps(_mm256_mul_ps(cosValue, z), _mm256_set1_ps(cos2));
+            cosValue = _mm256_mul_ps(_mm256_mul_ps(cosValue, z), z);
+            cosValue = _mm256_add_ps(_mm256_sub_ps(cosValue, _mm256_mul_ps(_mm256_set1_ps(0.5f), z)),
+                                     _mm256_set1_ps(1.0f));
+            __m256 sinValue {_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(sin0), z), _mm256_set1_ps(sin1))};
+            sinValue = _mm256_add_ps(_mm256_mul_ps(sinValue, z), _mm256_set1_ps(sin2));
+            sinValue = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(sinValue, z), value), value);
+            _mm256_storeu_ps(s + i, _mm256_xor_ps(_mm256_blendv_ps(cosValue, sinValue, sinPoly), signSin));
+            _mm256_storeu_ps(c + i, _mm256_xor_ps(_mm256_blendv_ps(sinValue, cosValue, sinPoly), signCos));
+        }
+        sinCosScalar(x + i, s + i, c + i, count - i);
+    }
+
+    inline void composeTRSSse2(const TRSArrays& in, glm::mat4* out, size_t count) {
+        const __m128 one {_mm_set1_ps(1.0f)};
+        const __m128 two {_mm_set1_ps(2.0f)};
+        const __m128 zero {_mm_setzero_ps()};
+        size_t i {0};
+        for (; i + 4 <= count; i += 4) {
+            __m128 x {_mm_loadu_ps(in.qx + i)}, y {_mm_loadu_ps(in.qy + i)};
+            __m128 z {_mm_loadu_ps(in.qz + i)}, w {_mm_loadu_ps(in.qw + i)};
+            __m128 sx {_mm_loadu_ps(in.sx + i)}, sy {_mm_loadu_ps(in.sy + i)}, sz {_mm_loadu_ps(in.sz + i)};
+            __m128 xx {_mm_mul_ps(x, x)}, yy {_mm_mul_ps(y, y)}, zz {_mm_mul_ps(z, z)};
+            __m128 xy {_mm_mul_ps(x, y)}, xz {_mm_mul_ps(x, z)}, yz {_mm_mul_ps(y, z)};
+            __m128 wx {_mm_mul_ps(w, x)}, wy {_mm_mul_ps(w, y)}, wz {_mm_mul_ps(w, z)};
+            storeColumn4(out + i, 0,
+                         _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+                         _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+                         _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx),
+                         zero);
+            storeColumn4(out + i, 1,
+                         _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy),
+                         _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+                         _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy),
+                         zero);
+            storeColumn4(out + i, 2,
+                         _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz),
+                         _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+                         _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz),
+                         zero);
+            storeColumn4(out + i, 3, _mm_loadu_ps(in.px + i), _mm_loadu_ps(in.py + i),
+                         _mm_loadu_ps(in.pz + i), one);
+        }
+        composeTRSScalar(in.offset(i), out + i, count - i);
+    }
+
+    SJD_TARGET_AVX2
+    inline void storeColumn8(glm::mat4* out, int column, __m256 x, __m256 y, __m256 z, __m256 w) {
+        storeColumn4(out, column, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y),
+                     _mm256_castps256_ps128(z), _mm256_castps256_ps128(w));
+        storeColumn4(out + 4, column, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1),
+                     _mm256_extractf128_ps(z, 1), _mm256_extractf128_ps(w, 1));
+    }
+
+    SJD_TARGET_AVX2
+    inline void composeTRSAvx2(const TRSArrays& in, glm::mat4* out, size_t count) {
+        const __m256 one {_mm256_set1_ps(1.0f)};
+        const __m256 two {_mm256_set1_ps(2.0f)};
+        const __m256 zero {_mm256_setzero_ps()};
+        size_t i {0};
+        for (; i + 8 <= count; i += 8) {
+            __m256 x {_mm256_loadu_ps(in.qx + i)}, y {_mm256_loadu_ps(in.qy + i)};
+            __m256 z {_mm256_loadu_ps(in.qz + i)}, w {_mm256_loadu_ps(in.qw + i)};
+            __m256 sx {_mm256_loadu_ps(in.sx + i)}, sy {_mm256_loadu_ps(in.sy + i)};
+            __m256 sz {_mm256_loadu_ps(in.sz + i)};
+            __m256 xx {_mm256_mul_ps(x, x)}, yy {_mm256_mul_ps(y, y)}, zz {_mm256_mul_ps(z, z)};
+            __m256 xy {_mm256_mul_ps(x, y)}, xz {_mm256_mul_ps(x, z)}, yz {_mm256_mul_ps(y, z)};
+            __m256 wx {_mm256_mul_ps(w, x)}, wy {_mm256_mul_ps(w, y)}, wz {_mm256_mul_ps(w, z)};
+            storeColumn8(out + i, 0,
+                         _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx),
+                         _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx),
+                         _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx),
+                         zero);
+            storeColumn8(out + i, 1,
+                         _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy),
+                         _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy),
+                         _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy),
+                         zero);
+            storeColumn8(out + i, 2,
+                         _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz),
+                         _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz),
+                         _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz),
+                         zero);
+            storeColumn8(out + i, 3, _mm256_loadu_ps(in.px + i), _mm256_loadu_ps(in.py + i),
+                         _mm256_loadu_ps(in.pz + i), one);
+        }
+        composeTRSScalar(in.offset(i), out + i, count - i);
+    }
+
+    inline void multiplySse2(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            __m128 a0 {_mm_loadu_ps(&a[i][0][0])}, a1 {_mm_loadu_ps(&a[i][1][0])};
+            __m128 a2 {_mm_loadu_ps(&a[i][2][0])}, a3 {_mm_loadu_ps(&a[i][3][0])};
+            __m128 columns[4];
+            for (int column = 0; column < 4; column++) {
+                __m128 bc {_mm_loadu_ps(&b[i][column][0])};
+                __m128 result {_mm_mul_ps(a0, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(0, 0, 0, 0)))};
+                result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(1, 1, 1, 1))));
+                result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(2, 2, 2, 2))));
+                result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(3, 3, 3, 3))));
+                columns[column] = result;
+            }
+            // stored last so out may alias a or b
+            for (int column = 0; column < 4; column++) _mm_storeu_ps(&out[i][column][0], columns[column]);
+        }
+    }
+
+    // two columns per 256 bit register, so a matrix is two halves of the work
+    SJD_TARGET_AVX2
+    inline void multiplyAvx2(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            __m256 a0 {_mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[i][0][0]))};
+            __m256 a1 {_mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[i][1][0]))};
+            __m256 a2 {_mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[i][2][0]))};
+            __m256 a3 {_mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[i][3][0]))};
+            __m256 columns[2];
+            for (int half = 0; half < 2; half++) {
+                __m256 bc {_mm256_loadu_ps(&b[i][2 * half][0])};
+                __m256 result {_mm256_mul_ps(a0, _mm256_shuffle_ps(bc, bc, _MM_SHUFFLE(0, 0, 0, 0)))};
+                result = _mm256_add_ps(result, _mm256_mul_ps(a1, _mm256_shuffle_ps(bc, bc, _MM_SHUFFLE(1, 1, 1, 1))));
+                result = _mm256_add_ps(result, _mm256_mul_ps(a2, _mm256_shuffle_ps(bc, bc, _MM_SHUFFLE(2, 2, 2, 2))));
+                result = _mm256_add_ps(result, _mm256_mul_ps(a3, _mm256_shuffle_ps(bc, bc, _MM_SHUFFLE(3, 3, 3, 3))));
+                columns[half] = result;
+            }
+            _mm256_storeu_ps(&out[i][0][0], columns[0]);
+            _mm256_storeu_ps(&out[i][2][0], columns[1]);
+        }
+    }
+
+    inline void transformSse2(const glm::mat4* m, const glm::vec4* v, glm::vec4* out, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            __m128 vector {_mm_loadu_ps(&v[i][0])};
+            __m128 result {_mm_mul_ps(_mm_loadu_ps(&m[i][0][0]), _mm_shuffle_ps(vector, vector, _MM_SHUFFLE(0, 0, 0, 0)))};
+            result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(&m[i][1][0]), _mm_shuffle_ps(vector, vector, _MM_SHUFFLE(1, 1, 1, 1))));
+            result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(&m[i][2][0]), _mm_shuffle_ps(vector, vector, _MM_SHUFFLE(2, 2, 2, 2))));
+            result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(&m[i][3][0]), _mm_shuffle_ps(vector, vector, _MM_SHUFFLE(3, 3, 3, 3))));
+            _mm_storeu_ps(&out[i][0], result);
+        }
+    }
+
+    // two matrix-vector pairs per iteration, one in each 128 bit half
+    SJD_TARGET_AVX2
+    inline void transformAvx2(const glm::mat4* m, const glm::vec4* v, glm::vec4* out, size_t count) {
+        size_t i {0};
+        for (; i + 2 <= count; i += 2) {
+            __m256 vectors {_mm256_loadu_ps(&v[i][0])};
+            __m256 result {_mm256_setzero_ps()};
+            for (int column = 0; column < 4; column++) {
+                __m256 columns {_mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&m[i][column][0])),
+                                                     _mm_loadu_ps(&m[i + 1][column][0]), 1)};
+                __m256 component;
+                switch (column) {
+                    case 0:  component = _mm256_shuffle_ps(vectors, vectors, _MM_SHUFFLE(0, 0, 0, 0)); break;
+                    case 1:  component = _mm256_shuffle_ps(vectors, vectors, _MM_SHUFFLE(1, 1, 1, 1)); break;
+                    case 2:  component = _mm256_shuffle_ps(vectors, vectors, _MM_SHUFFLE(2, 2, 2, 2)); break;
+                    default: component = _mm256_shuffle_ps(vectors, vectors, _MM_SHUFFLE(3, 3, 3, 3)); break;
+                }
+                result = _mm256_add_ps(result, _mm256_mul_ps(columns, component));
+            }
+            _mm256_storeu_ps(&out[i][0], result);
+        }
+        transformSse2(m + i, v + i, out + i, count - i);
+    }
+#endif
+}
+
+// sin and cos of every x; accurate for |x| < 8192
+inline void sinCos(const float* x, float* s, float* c, size_t count) {
+#ifdef SJD_SIMD_X86
+    switch (activeIsa()) {
+        case Isa::AVX2: detail::sinCosAvx2(x, s, c, count); return;
+        case Isa::SSE2: detail::sinCosSse2(x, s, c, count); return;
+        default: break;
+    }
+#endif
+    detail::sinCosScalar(x, s, c, count);
+}
+
+// out[i] = translate(p[i]) * mat4_cast(q[i]) * scale(s[i])
+inline void composeTRS(const TRSArrays& in, glm::mat4* out, size_t count) {
+#ifdef SJD_SIMD_X86
+    switch (activeIsa()) {
+        case Isa::AVX2: detail::composeTRSAvx2(in, out, count); return;
+        case Isa::SSE2: detail::composeTRSSse2(in, out, count); return;
+        default: break;
+    }
+#endif
+    detail::composeTRSScalar(in, out, count);
+}
+
+// out[i] = a[i] * b[i]; out may be a or b
+inline void multiply(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, size_t count) {
+#ifdef SJD_SIMD_X86
+    switch (activeIsa()) {
+        case Isa::AVX2: detail::multiplyAvx2(a, b, out, count); return;
+        case Isa::SSE2: detail::multiplySse2(a, b, out, count); return;
+        default: break;
+    }
+#endif
+    detail::multiplyScalar(a, b, out, count);
+}
+
+// out[i] = m[i] * v[i]
+inline void transform(const glm::mat4* m, const glm::vec4* v, glm::vec4* out, size_t count) {
+#ifdef SJD_SIMD_X86
+    switch (activeIsa()) {
+        case Isa::AVX2: detail::transformAvx2(m, v, out, count); return;
+        case Isa::SSE2: detail::transformSse2(m, v, out, count); return;
+        default: break;
+    }
+#endif
+    detail::transformScalar(m, v, out, count);
+}
+
+// xoshiro128+ run as eight independent streams side by side, which maps onto one
+// AVX2 register, two SSE2 registers or a plain loop. The streams are always eight
+// wide, so a seed gives the same numbers whichever ISA level runs it. Good enough
+// for scattering rocks, not for anything that needs real statistical quality.
+class Random {
+public:
+    static constexpr unsigned int lanes {8};
+
+    Random(uint64_t seed=1) {
+        // splitmix64 to spread the seed over the whole state
+        for (unsigned int word = 0; word < 4; word++) {
+            for (unsigned int lane = 0; lane < lanes; lane++) {
+                seed += 0x9E3779B97F4A7C15ull;
+                uint64_t z {seed};
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                z ^= z >> 31;
+                m_state[word][lane] = static_cast<uint32_t>(z) | 1u;
+            }
+        }
+    }
+
+    // count uniform floats in [low, high)
+    void uniform(float* out, size_t count, float low, float high) {
+        float block[lanes];
+        size_t i {0};
+        for (; i + lanes <= count; i += lanes) next(out + i, low, high);
+        if (i < count) {
+            next(block, low, high);
+            for (size_t lane = 0; i < count; i++, lane++) out[i] = block[lane];
+        }
+    }
+
+private:
+    void next(float* out, float low, float high) {
+#ifdef SJD_SIMD_X86
+        switch (activeIsa()) {
+            case Isa::AVX2: nextAvx2(out, low, high); return;
+            case Isa::SSE2: nextSse2(out, low, high, 0); nextSse2(out, low, high, 4); return;
+            default: break;
+        }
+#endif
+        nextScalar(out, low, high);
+    }
+
+    // top 24 bits of each output, scaled to [low, high)
+    static constexpr float unitScale {1.0f / 16777216.0f};
+
+    void nextScalar(float* out, float low, float high) {
+        for (unsigned int lane = 0; lane < lanes; lane++) {
+            uint32_t* s[4] {&m_state[0][lane], &m_state[1][lane], &m_state[2][lane], &m_state[3][lane]};
+            uint32_t result {*s[0] + *s[3]};
+            uint32_t t {*s[1] << 9};
+            *s[2] ^= *s[0];
+            *s[3] ^= *s[1];
+            *s[1] ^= *s[2];
+            *s[0] ^= *s[3];
+            *s[2] ^= t;
+            *s[3] = (*s[3] << 11) | (*s[3] >> 21);
+            out[lane] = low + static_cast<float>(result >> 8) * unitScale * (high - low);
+        }
+    }
+
+#ifdef SJD_SIMD_X86
+    void nextSse2(float* out, float low, float high, unsigned int lane) {
+        __m128i s0 {_mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_state[0][lane]))};
+        __m128i s1 {_mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_state[1][lane]))};
+        __m128i s2 {_mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_state[2][lane]))};
+        __m128i s3 {_mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_state[3][lane]))};
+        __m128i result {_mm_add_epi32(s0, s3)};
+        __m128i t {_mm_slli_epi32(s1, 9)};
+        s2 = _mm_xor_si128(s2, s0);
+        s3 = _mm_xor_si128(s3, s1);
+        s1 = _mm_xor_si128(s1, s2);
+        s0 = _mm_xor_si128(s0, s3);
+        s2 = _mm_xor_si128(s2, t);
+        s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&m_state[0][lane]), s0);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&m_state[1][lane]), s1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&m_state[2][lane]), s2);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&m_state[3][lane]), s3);
+        __m128 unit {_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(result, 8)), _mm_set1_ps(unitScale))};
+        _mm_storeu_ps(out + lane, _mm_add_ps(_mm_set1_ps(low), _mm_mul_ps(unit, _mm_set1_ps(high - low))));
+    }
+
+    SJD_TARGET_AVX2
+    void nextAvx2(float* out, float low, float high) {
+        __m256i s0 {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_state[0]))};
+        __m256i s1 {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_state[1]))};
+        __m256i s2 {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_state[2]))};
+        __m256i s3 {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_state[3]))};
+        __m256i result {_mm256_add_epi32(s0, s3)};
+        __m256i t {_mm256_slli_epi32(s1, 9)};
+        s2 = _mm256_xor_si256(s2, s0);
+        s3 = _mm256_xor_si256(s3, s1);
+        s1 = _mm256_xor_si256(s1, s2);
+        s0 = _mm256_xor_si256(s0, s3);
+        s2 = _mm256_xor_si256(s2, t);
+        s3 = _mm256_or_si256(_mm256_slli_epi32(s3, 11), _mm256_srli_epi32(s3, 21));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(m_state[0]), s0);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(m_state[1]), s1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(m_state[2]), s2);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(m_state[3]), s3);
+        __m256 unit {_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(result, 8)), _mm256_set1_ps(unitScale))};
+        _mm256_storeu_ps(out, _mm256_add_ps(_mm256_set1_ps(low), _mm256_mul_ps(unit, _mm256_set1_ps(high - low))));
+    }
+#endif
+
+    uint32_t m_state[4][lanes];
+};
+
+}
+}
+#endif
@@ -104,6 +104,8 @@ public:
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_CUBE_MAP, m_id);
         glDrawArrays(GL_TRIANGLES, 0, 36);
+        stats::stateChange(2);
+        stats::drawCall(12);
         glBindVertexArray(0);
         glDepthFunc(GL_LESS);
 
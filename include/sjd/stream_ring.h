@@ -0,0 +1,137 @@
+#ifndef STREAM_RING_H
+#define STREAM_RING_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <glad/glad.h>
+#include <sjd/profiling.h>
+
+namespace sjd {
+
+// Per-frame vertex data streamed to the GPU without stalling. One buffer holds
+// `regions` copies of the frame's data; each frame writes the next region while
+// the GPU may still be drawing from the previous ones, and a fence per region
+// makes sure a region isn't overwritten before the draws reading it are done.
+//
+// Persistent mapping (glBufferStorage) needs GL 4.4, and these demos make 3.3
+// contexts, so instead each frame maps just its region unsynchronized, which
+// costs a map call but no waiting as long as the fences say the region is free.
+//
+//     void* data {ring.map()};        // waits only if the GPU is 3 frames behind
+//     ... fill data (any thread) ...
+//     ring.unmap();
+//     ... point attributes at ring.offset(), draw ...
+//     ring.fence();
+class StreamRing {
+public:
+    static constexpr unsigned int maxRegions {4};
+
+    StreamRing(GLenum target, GLsizeiptr regionSize, unsigned int regions=3)
+    :   m_target {target}
+    ,   m_regionSize {alignedSize(regionSize)}
+    ,   m_regions {std::min(std::max(regions, 1u), maxRegions)}
+    ,   m_current {0}
+    ,   m_mapped {false}
+    {
+        glGenBuffers(1, &m_id);
+        glBindBuffer(m_target, m_id);
+        glBufferData(m_target, m_regionSize * m_regions, NULL, GL_STREAM_DRAW);
+        glBindBuffer(m_target, 0);
+        m_fences.fill(nullptr);
+    }
+
+    ~StreamRing() {
+        for (GLsync& fence : m_fences) {
+            if (fence) glDeleteSync(fence);
+        }
+        glDeleteBuffers(1, &m_id);
+    }
+
+    StreamRing(const StreamRing&) = delete;
+    StreamRing& operator=(const StreamRing&) = delete;
+
+    unsigned int id() const {
+        return m_id;
+    }
+
+    // byte offset of the region being written this frame
+    GLintptr offset() const {
+        return m_regionSize * m_current;
+    }
+
+    // Move on to the next region and map it for writing. Leaves the buffer bound.
+    void* map() {
+        m_current = (m_current + 1) % m_regions;
+        waitForRegion(m_current);
+        glBindBuffer(m_target, m_id);
+        stats::stateChange();
+        void* data {glMapBufferRange(m_target, offset(), m_regionSize,
+                                     GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT)};
+        if (!data) {
+            std::cout << "ERROR::STREAM_RING::MAP_FAILED" << std::endl;
+            return nullptr;
+        }
+        m_mapped = true;
+        return data;
+    }
+
+    void unmap() {
+        if (!m_mapped) return;
+        glBindBuffer(m_target, m_id);
+        if (glUnmapBuffer(m_target) == GL_FALSE) {
+            std::cout << "ERROR::STREAM_RING::DATA_LOST" << std::endl;
+        }
+        m_mapped = false;
+    }
+
+    // call after the last draw that reads this frame's region
+    void fence() {
+        m_fences[m_current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    // nanoseconds the last map() spent waiting on the GPU; nonzero means the
+    // ring needs more regions or the GPU is the bottleneck
+    uint64_t lastWaitNs() const {
+        return m_lastWaitNs;
+    }
+
+private:
+    // keep regions aligned so every region starts suitably for any attribute type
+    static GLsizeiptr alignedSize(GLsizeiptr size) {
+        constexpr GLsizeiptr alignment {256};
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    void waitForRegion(unsigned int region) {
+        m_lastWaitNs = 0;
+        GLsync& fence {m_fences[region]};
+        if (!fence) return;
+        // a zero timeout first, so the common case of an already finished frame
+        // doesn't go through the flush
+        GLenum status {glClientWaitSync(fence, 0, 0)};
+        if (status == GL_TIMEOUT_EXPIRED) {
+            auto start {std::chrono::steady_clock::now()};
+            while ((status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000)) == GL_TIMEOUT_EXPIRED) {}
+            auto end {std::chrono::steady_clock::now()};
+            m_lastWaitNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        }
+        if (status == GL_WAIT_FAILED) std::cout << "ERROR::STREAM_RING::WAIT_FAILED" << std::endl;
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    GLenum m_target;
+    unsigned int m_id;
+    GLsizeiptr m_regionSize;
+    unsigned int m_regions;
+    unsigned int m_current;
+    bool m_mapped;
+    std::array<GLsync, maxRegions> m_fences {};
+    uint64_t m_lastWaitNs {0};
+};
+
+}
+#endif
@@ -0,0 +1,235 @@
+#ifndef TEMPORAL_AA_H
+#define TEMPORAL_AA_H
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <sjd/camera.h>
+#include <sjd/profiling.h>
+#include <sjd/render_target.h>
+#include <sjd/shader.h>
+
+namespace sjd {
+
+struct TemporalAASettings {
+    float blend {0.1f};                 // weight of each new frame in the history
+    unsigned int jitterPhases {8};      // Halton offsets before the pattern repeats
+    float sharpness {0.25f};            // of the copy to the output, against the softening
+};
+
+// Temporal anti-aliasing: every frame is drawn single sampled with the
+// projection moved by a different fraction of a pixel, and blended into a
+// history of the frames before, so edges get the coverage of many samples over
+// a few frames instead of four samples every frame.
+//
+// Against 4x MSAA at the same size: the scene's colour and depth are written
+// once per pixel rather than four times, and the extras are a motion target
+// (4 bytes a pixel), two RGBA16F histories and a full-screen resolve. It also
+// smooths what MSAA can't (shader aliasing, alpha tested edges), at the cost of
+// some softness, which the copy to the output sharpens back.
+//
+//     scene.setTemporalAA(&taa);   // for the motion of meshes that move
+//     scene.m_projection = taa.begin(camera, projection, width, height);
+//     scene.draw(shader);
+//     taa.end();                   // resolve into what was bound before begin()
+//
+// Without Scene (or for anything it doesn't draw) the motion comes from the
+// camera alone, worked out from the depth.
+class TemporalAA {
+public:
+    TemporalAA(TemporalAASettings settings={})
+    :   m_settings {settings}
+    ,   m_target {1, 1, {{RenderTarget::R11G11B10F, RenderTarget::RG16F}, RenderTarget::DEPTH24, true}}
+    ,   m_motionShader {"../code/shaders/motion_vectors.vert.glsl", "../code/shaders/motion_vectors.frag.glsl"}
+    ,   m_resolveShader {"../code/shaders/deferred_fullscreen.vert.glsl", "../code/shaders/taa_resolve.frag.glsl"}
+    ,   m_outputShader {"../code/shaders/deferred_fullscreen.vert.glsl", "../code/shaders/upscale_sharpen.frag.glsl"}
+    ,   m_camera {nullptr}
+    ,   m_frame {0}
+    ,   m_history {0}
+    ,   m_historyValid {false}
+    ,   m_viewProjection {1.0f}
+    ,   m_jitteredViewProjection {1.0f}
+    ,   m_previousViewProjection {1.0f}
+    ,   m_savedDepthFunc {GL_LESS}
+    ,   m_savedDepthMask {GL_TRUE}
+    {
+        if (m_settings.jitterPhases == 0) m_settings.jitterPhases = 1;
+        for (std::unique_ptr<RenderTarget>& history : m_histories) {
+            history = std::make_unique<RenderTarget>(1, 1, RenderTarget::Description {{RenderTarget::RGBA16F},
+                                                                                        RenderTarget::NO_DEPTH});
+        }
+        glGenVertexArrays(1, &m_emptyVao);
+    }
+
+    ~TemporalAA() {
+        glDeleteVertexArrays(1, &m_emptyVao);
+    }
+
+    TemporalAA(const TemporalAA&) = delete;
+    TemporalAA& operator=(const TemporalAA&) = delete;
+
+    // Draw into the anti-aliased target from here on, `width` by `height` and
+    // cleared to `clearColour`. Moves `camera`'s jitter on and returns
+    // `projection` with it applied, which is what the scene has to be drawn with.
+    glm::mat4 begin(Camera& camera, const glm::mat4& projection, unsigned int width, unsigned int height,
+                    glm::vec4 clearColour=glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)) {
+        if (width != m_target.width() || height != m_target.height()) {
+            m_target.resize(width, height);
+            for (std::unique_ptr<RenderTarget>& history : m_histories) history->resize(width, height);
+            m_historyValid = false;
+        }
+        m_camera = &camera;
+        camera.jitter = Camera::haltonJitter(m_frame % m_settings.jitterPhases);
+        glm::mat4 jittered {camera.jitterProjection(projection, glm::vec2(m_target.width(), m_target.height()))};
+        glm::mat4 view {camera.getViewMatrix()};
+        m_viewProjection = projection * view;
+        m_jitteredViewProjection = jittered * view;
+        if (!m_historyValid) m_previousViewProjection = m_viewProjection;
+
+        m_target.bind();
+        _draw_buffers(GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1);
+        glClearBufferfv(GL_COLOR, 0, &clearColour[0]);
+        const float noMotion[] {-1000.0f, -1000.0f, 0.0f, 0.0f};
+        glClearBufferfv(GL_COLOR, 1, noMotion);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        // scene shaders only write colour; the motion attachment is the motion pass's
+        _draw_buffers(GL_COLOR_ATTACHMENT0, GL_NONE);
+        return jittered;
+    }
+
+    // Between begin() and end(), after the scene: the shader for meshes that
+    // moved this frame, each drawn with "previousModel" set to where it was.
+    // Only writes motion, and only where the mesh is in front.
+    Shader& beginMotion() {
+        m_motionTimer.begin();
+        _draw_buffers(GL_NONE, GL_COLOR_ATTACHMENT1);
+        glGetIntegerv(GL_DEPTH_FUNC, &m_savedDepthFunc);
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &m_savedDepthMask);
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_FALSE);
+        m_motionShader.use();
+        m_motionShader.setMat4("viewProjection", m_viewProjection);
+        m_motionShader.setMat4("previousViewProjection", m_previousViewProjection);
+        return m_motionShader;
+    }
+
+    void endMotion() {
+        glDepthFunc(static_cast<GLenum>(m_savedDepthFunc));
+        glDepthMask(m_savedDepthMask);
+        _draw_buffers(GL_COLOR_ATTACHMENT0, GL_NONE);
+        m_motionTimer.end();
+    }
+
+    // blend this frame into the history and draw the result into the
+    // framebuffer and viewport bound at begin()
+    void end() {
+        m_target.release();
+        m_resolveTimer.begin();
+        GLboolean depthTest {glIsEnabled(GL_DEPTH_TEST)};
+        GLboolean blend {glIsEnabled(GL_BLEND)};
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+        glBindVertexArray(m_emptyVao);
+
+        RenderTarget& previous {*m_histories[m_history]};
+        RenderTarget& next {*m_histories[1 - m_history]};
+        glm::vec2 size {static_cast<float>(m_target.width()), static_cast<float>(m_target.height())};
+        next.bind();
+        m_target.bindTexture(0, 0);
+        m_target.bindTexture(1, 1);     // motion
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, m_target.depthTexture());
+        previous.bindTexture(3);
+        m_resolveShader.use();
+        m_resolveShader.setInt("current", 0);
+        m_resolveShader.setInt("motion", 1);
+        m_resolveShader.setInt("depth", 2);
+        m_resolveShader.setInt("history", 3);
+        m_resolveShader.setVec2("outputSize", size);
+        m_resolveShader.setMat4("inverseViewProjection", glm::inverse(m_jitteredViewProjection));
+        m_resolveShader.setMat4("viewProjection", m_viewProjection);
+        m_resolveShader.setMat4("previousViewProjection", m_previousViewProjection);
+        m_resolveShader.setFloat("blend", m_settings.blend);
+        m_resolveShader.setBool("historyValid", m_historyValid);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        next.release();
+
+        GLint viewport[4] {};
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        next.bindTexture(0);
+        m_outputShader.use();
+        m_outputShader.setInt("source", 0);
+        m_outputShader.setVec2("outputSize", glm::vec2(static_cast<float>(viewport[2]), static_cast<float>(viewport[3])));
+        m_outputShader.setVec2("uvScale", glm::vec2(1.0f));
+        m_outputShader.setFloat("sharpness", m_settings.sharpness);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        glBindVertexArray(0);
+        if (depthTest) glEnable(GL_DEPTH_TEST);
+        if (blend) glEnable(GL_BLEND);
+        stats::drawCall(2);
+        m_resolveTimer.end();
+
+        m_history = 1 - m_history;
+        m_historyValid = true;
+        m_previousViewProjection = m_viewProjection;
+        m_frame++;
+        if (m_camera) m_camera->jitter = glm::vec2(0.0f);
+    }
+
+    // Start the history over, e.g. after a camera cut, so nothing of the old
+    // view is blended in.
+    void reset() {
+        m_historyValid = false;
+    }
+
+    TemporalAASettings& settings() {
+        return m_settings;
+    }
+
+    // video memory of the target and both histories
+    size_t bytes() const {
+        return m_target.bytes() + m_histories[0]->bytes() + m_histories[1]->bytes();
+    }
+
+    // GPU times, a few frames behind
+    double motionMs() const {
+        return m_motionTimer.lastMs();
+    }
+
+    // the resolve and the copy to the output
+    double resolveMs() const {
+        return m_resolveTimer.lastMs();
+    }
+
+private:
+    void _draw_buffers(GLenum first, GLenum second) {
+        const GLenum buffers[] {first, second};
+        glDrawBuffers(2, buffers);
+        stats::stateChange();
+    }
+
+    TemporalAASettings m_settings;
+    RenderTarget m_target;
+    std::array<std::unique_ptr<RenderTarget>, 2> m_histories;
+    Shader m_motionShader;
+    Shader m_resolveShader;
+    Shader m_outputShader;
+    Camera* m_camera;
+    unsigned int m_frame;
+    unsigned int m_history;
+    bool m_historyValid;
+    glm::mat4 m_viewProjection;
+    glm::mat4 m_jitteredViewProjection;
+    glm::mat4 m_previousViewProjection;
+    GLint m_savedDepthFunc;
+    GLboolean m_savedDepthMask;
+    unsigned int m_emptyVao;
+    GpuTimer m_motionTimer;
+    GpuTimer m_resolveTimer;
+};
+
+}
+#endif
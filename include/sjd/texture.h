@@ -3,8 +3,14 @@
 
 #include <iostream>
 #include <string>
+// only emit the stb implementation once per translation unit so texture.h and
+// model.h can be included together
+#ifndef SJD_STB_IMAGE_IMPLEMENTATION
+#define SJD_STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
+#undef STB_IMAGE_IMPLEMENTATION
+#endif
 #include <glad/glad.h>
 
 namespace sjd {
@@ -26,6 +26,12 @@ public:
         return m_deltaTime;
     }
 
+    // Time each frame gets at the fps limit, 0 without one; a budget to hold
+    // the renderer to (e.g. DynamicResolutionSettings::targetFrameMs)
+    float getFrameTime() {
+        return m_frameTime;
+    }
+
     // return true if frame should be rendered
     bool shouldRender() {
         if (m_deltaTime < m_frameTime) {
@@ -0,0 +1,196 @@
+#ifndef TRANSFORM_HIERARCHY_H
+#define TRANSFORM_HIERARCHY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace sjd {
+
+// Parent/child transforms for many objects at once. Local translation, rotation
+// and scale are kept in separate arrays (structure of arrays) ordered so every
+// parent comes before its children. update() then walks the arrays once, front
+// to back, recomputing a world matrix only if its node was changed or its
+// parent's world matrix was just recomputed, so untouched subtrees cost one flag
+// check per node.
+//
+// Nodes are referred to by the handle create() returns, which stays valid when
+// setParent() has to reorder the arrays.
+class TransformHierarchy {
+public:
+    using Node = uint32_t;
+    static constexpr Node noParent {UINT32_MAX};
+
+    TransformHierarchy(size_t reserve=0) {
+        m_positions.reserve(reserve);
+        m_rotations.reserve(reserve);
+        m_scales.reserve(reserve);
+        m_parents.reserve(reserve);
+        m_dirty.reserve(reserve);
+        m_changed.reserve(reserve);
+        m_world.reserve(reserve);
+        m_handles.reserve(reserve);
+        m_index.reserve(reserve);
+    }
+
+    // a new node at the identity; parents must already exist, so creation order
+    // is already a valid parent-first order
+    Node create(Node parent=noParent) {
+        Node handle {static_cast<Node>(m_index.size())};
+        uint32_t index {static_cast<uint32_t>(m_positions.size())};
+        m_index.push_back(index);
+        m_handles.push_back(handle);
+        m_positions.push_back(glm::vec3(0.0f));
+        m_rotations.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+        m_scales.push_back(glm::vec3(1.0f));
+        m_parents.push_back((parent == noParent) ? noIndex : m_index[parent]);
+        m_dirty.push_back(1);
+        m_changed.push_back(0);
+        m_world.push_back(glm::mat4(1.0f));
+        return handle;
+    }
+
+    size_t size() const {
+        return m_positions.size();
+    }
+
+    void setPosition(Node node, glm::vec3 position) {
+        uint32_t i {m_index[node]};
+        m_positions[i] = position;
+        m_dirty[i] = 1;
+    }
+
+    void setRotation(Node node, glm::quat rotation) {
+        uint32_t i {m_index[node]};
+        m_rotations[i] = rotation;
+        m_dirty[i] = 1;
+    }
+
+    void setScale(Node node, glm::vec3 scale) {
+        uint32_t i {m_index[node]};
+        m_scales[i] = scale;
+        m_dirty[i] = 1;
+    }
+
+    glm::vec3 position(Node node) const {
+        return m_positions[m_index[node]];
+    }
+
+    glm::quat rotation(Node node) const {
+        return m_rotations[m_index[node]];
+    }
+
+    glm::vec3 scale(Node node) const {
+        return m_scales[m_index[node]];
+    }
+
+    // Reattach a node (and its subtree). Moving under a node that comes later in
+    // the arrays re-sorts them, which costs a pass over every node.
+    void setParent(Node node, Node parent) {
+        uint32_t i {m_index[node]};
+        uint32_t p {(parent == noParent) ? noIndex : m_index[parent]};
+        for (uint32_t ancestor = p; ancestor != noIndex; ancestor = m_parents[ancestor]) {
+            if (ancestor == i) {
+                std::cout << "ERROR::TRANSFORM_HIERARCHY::CYCLE" << std::endl;
+                return;
+            }
+        }
+        m_parents[i] = p;
+        m_dirty[i] = 1;
+        if (p != noIndex && p > i) sortParentsFirst();
+    }
+
+    // Recompute world matrices of changed nodes and their descendants.
+    // Returns how many were recomputed.
+    size_t update() {
+        size_t updated {0};
+        size_t count {m_positions.size()};
+        for (size_t i = 0; i < count; i++) {
+            uint32_t parent {m_parents[i]};
+            bool recompute {m_dirty[i] || (parent != noIndex && m_changed[parent])};
+            m_changed[i] = recompute;
+            if (!recompute) continue;
+            glm::mat4 local {compose(m_positions[i], m_rotations[i], m_scales[i])};
+            m_world[i] = (parent != noIndex) ? m_world[parent] * local : local;
+            m_dirty[i] = 0;
+            updated++;
+        }
+        return updated;
+    }
+
+    const glm::mat4& world(Node node) const {
+        return m_world[m_index[node]];
+    }
+
+    // true if the node's world matrix was recomputed by the last update()
+    bool changed(Node node) const {
+        return m_changed[m_index[node]] != 0;
+    }
+
+    // translate * rotate * scale, without the three full matrix products
+    static glm::mat4 compose(glm::vec3 position, glm::quat rotation, glm::vec3 scale) {
+        glm::mat3 r {glm::mat3_cast(rotation)};
+        return glm::mat4(glm::vec4(r[0] * scale.x, 0.0f),
+                         glm::vec4(r[1] * scale.y, 0.0f),
+                         glm::vec4(r[2] * scale.z, 0.0f),
+                         glm::vec4(position, 1.0f));
+    }
+
+private:
+    static constexpr uint32_t noIndex {UINT32_MAX};
+
+    // stable sort by depth: parents are always one level shallower, so they land first
+    void sortParentsFirst() {
+        size_t count {m_positions.size()};
+        std::vector<uint32_t> depth(count, 0);
+        for (size_t i = 0; i < count; i++) {
+            for (uint32_t p = m_parents[i]; p != noIndex; p = m_parents[p]) depth[i]++;
+        }
+        std::vector<uint32_t> order(count);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [&](uint32_t a, uint32_t b) { return depth[a] < depth[b]; });
+        std::vector<uint32_t> newIndex(count);
+        for (uint32_t i = 0; i < count; i++) newIndex[order[i]] = i;
+
+        permute(m_positions, order);
+        permute(m_rotations, order);
+        permute(m_scales, order);
+        permute(m_dirty, order);
+        permute(m_changed, order);
+        permute(m_world, order);
+        permute(m_handles, order);
+        permute(m_parents, order);
+        for (uint32_t& parent : m_parents) {
+            if (parent != noIndex) parent = newIndex[parent];
+        }
+        for (uint32_t i = 0; i < count; i++) m_index[m_handles[i]] = i;
+    }
+
+    template <typename T>
+    static void permute(std::vector<T>& values, const std::vector<uint32_t>& order) {
+        std::vector<T> sorted;
+        sorted.reserve(values.size());
+        for (uint32_t i : order) sorted.push_back(values[i]);
+        values.swap(sorted);
+    }
+
+    // per node, in parent-first order
+    std::vector<glm::vec3> m_positions;
+    std::vector<glm::quat> m_rotations;
+    std::vector<glm::vec3> m_scales;
+    std::vector<uint32_t> m_parents;
+    std::vector<uint8_t> m_dirty;
+    std::vector<uint8_t> m_changed;
+    std::vector<glm::mat4> m_world;
+    std::vector<Node> m_handles;
+    // per handle
+    std::vector<uint32_t> m_index;
+};
+
+}
+#endif
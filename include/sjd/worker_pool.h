@@ -0,0 +1,116 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sjd {
+
+// A fixed set of threads for splitting one big loop per frame into pieces.
+// parallelFor() hands out ranges of the loop to the workers and to the calling
+// thread, and returns once every range is done. There's no task queue beyond
+// that: one loop at a time, from one thread.
+class WorkerPool {
+public:
+    // threads counts the calling thread, so 1 runs everything inline; 0 uses every core
+    WorkerPool(unsigned int threads=0)
+    :   m_generation {0}
+    ,   m_stopping {false}
+    ,   m_busy {0}
+    ,   m_next {0}
+    {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int i = 1; i < threads; i++) {
+            m_workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock {m_mutex};
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (std::thread& worker : m_workers) worker.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    unsigned int threadCount() const {
+        return static_cast<unsigned int>(m_workers.size()) + 1;
+    }
+
+    // Run body(first, count) over [0, total) in ranges of `grain` items.
+    void parallelFor(size_t total, size_t grain, const std::function<void(size_t, size_t)>& body) {
+        if (total == 0) return;
+        grain = std::max<size_t>(grain, 1);
+        if (m_workers.empty() || total <= grain) {
+            body(0, total);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock {m_mutex};
+            m_body = &body;
+            m_total = total;
+            m_grain = grain;
+            m_next = 0;
+            m_busy = static_cast<unsigned int>(m_workers.size());
+            m_generation++;
+        }
+        m_wake.notify_all();
+        runRanges();
+        std::unique_lock<std::mutex> lock {m_mutex};
+        m_done.wait(lock, [this]() { return m_busy == 0; });
+        m_body = nullptr;
+    }
+
+private:
+    void workerLoop() {
+        size_t seen {0};
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock {m_mutex};
+                m_wake.wait(lock, [&]() { return m_stopping || m_generation != seen; });
+                if (m_stopping) return;
+                seen = m_generation;
+            }
+            runRanges();
+            {
+                std::lock_guard<std::mutex> lock {m_mutex};
+                m_busy--;
+            }
+            m_done.notify_one();
+        }
+    }
+
+    void runRanges() {
+        while (true) {
+            size_t first {m_next.fetch_add(m_grain)};
+            if (first >= m_total) return;
+            (*m_body)(first, std::min(m_grain, m_total - first));
+        }
+    }
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    size_t m_generation;
+    bool m_stopping;
+    unsigned int m_busy;
+    // the current loop, written under m_mutex before the workers are woken
+    const std::function<void(size_t, size_t)>* m_body {nullptr};
+    size_t m_total {0};
+    size_t m_grain {1};
+    std::atomic<size_t> m_next;
+};
+
+}
+#endif